@@ -0,0 +1,132 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_attribute_table.h"
+
+struct AdAttributeTableSnapshot {
+    QHash<QString, int> id_map;
+    QList<QString> name_list;
+};
+
+static thread_local AdAttributeTableSnapshot snapshot;
+
+// Returns name without range suffix
+QString strip_range(const QString &name) {
+    const int range_index = name.indexOf(";range=", 0, Qt::CaseInsensitive);
+
+    if (range_index != -1) {
+        return name.left(range_index);
+    } else {
+        return name;
+    }
+}
+
+AdAttributeTable *AdAttributeTable::instance() {
+    static AdAttributeTable table;
+
+    return &table;
+}
+
+AdAttributeTable::AdAttributeTable() {
+}
+
+int AdAttributeTable::intern(const QString &name) {
+    const int id = find_in_snapshot(name);
+    if (id != ATTRIBUTE_ID_NONE) {
+        return id;
+    }
+
+    // NOTE: strip only on a miss, so that plain names,
+    // which is nearly all of them, skip the extra search
+    const QString base_name = strip_range(name);
+    if (base_name != name) {
+        return intern(base_name);
+    }
+
+    QMutexLocker locker(&mutex);
+
+    // NOTE: name might've been added by another thread
+    // after snapshot was updated
+    const int existing_id = id_map.value(name, ATTRIBUTE_ID_NONE);
+    if (existing_id != ATTRIBUTE_ID_NONE) {
+        return existing_id;
+    }
+
+    const int new_id = name_list.size();
+    name_list.append(name);
+    id_map[name] = new_id;
+    published_size.storeRelease(name_list.size());
+
+    return new_id;
+}
+
+int AdAttributeTable::find(const QString &name) const {
+    const int id = find_in_snapshot(name);
+    if (id != ATTRIBUTE_ID_NONE) {
+        return id;
+    }
+
+    const QString base_name = strip_range(name);
+    if (base_name != name) {
+        return find_in_snapshot(base_name);
+    }
+
+    return ATTRIBUTE_ID_NONE;
+}
+
+QString AdAttributeTable::name(const int id) const {
+    if (id >= snapshot.name_list.size()) {
+        update_snapshot();
+    }
+
+    return snapshot.name_list.value(id);
+}
+
+int AdAttributeTable::size() const {
+    return published_size.loadAcquire();
+}
+
+int AdAttributeTable::find_in_snapshot(const QString &name) const {
+    const int id = snapshot.id_map.value(name, ATTRIBUTE_ID_NONE);
+
+    if (id == ATTRIBUTE_ID_NONE && update_snapshot()) {
+        return snapshot.id_map.value(name, ATTRIBUTE_ID_NONE);
+    } else {
+        return id;
+    }
+}
+
+// Copies names that were added since last update. Returns
+// false if snapshot was already up to date.
+bool AdAttributeTable::update_snapshot() const {
+    if (snapshot.name_list.size() == published_size.loadAcquire()) {
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+
+    for (int id = snapshot.name_list.size(); id < name_list.size(); id++) {
+        const QString &name = name_list[id];
+
+        snapshot.name_list.append(name);
+        snapshot.id_map[name] = id;
+    }
+
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_ATTRIBUTE_TABLE_H
+#define AD_ATTRIBUTE_TABLE_H
+
+/**
+ * Process-wide table of interned attribute names. Each
+ * name is given a small integer id once and keeps it for
+ * the lifetime of the process, so that objects can store
+ * id's instead of repeating the same name strings. Names
+ * are case sensitive, same as keys in AdObject. Range
+ * suffixes, as in "member;range=0-1499", are stripped, so
+ * ranged names share the id of the attribute.
+ */
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#define ATTRIBUTE_ID_NONE -1
+
+class AdAttributeTable {
+
+public:
+    static AdAttributeTable *instance();
+
+    // Returns id of the name, adding it to the table if
+    // needed
+    int intern(const QString &name);
+
+    // Returns ATTRIBUTE_ID_NONE if name was never interned
+    int find(const QString &name) const;
+
+    QString name(const int id) const;
+    int size() const;
+
+private:
+    // NOTE: lookups are done on a per-thread copy of the
+    // table, so they don't lock. Copy is updated only when
+    // it's behind, which is rare because table stops
+    // growing after schema is loaded.
+    mutable QMutex mutex;
+    QHash<QString, int> id_map;
+    QList<QString> name_list;
+    // Size of name_list, readable without locking
+    QAtomicInt published_size;
+
+    AdAttributeTable();
+
+    int find_in_snapshot(const QString &name) const;
+    bool update_snapshot() const;
+};
+
+#endif /* AD_ATTRIBUTE_TABLE_H */
@@ -0,0 +1,69 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_bulk.h"
+
+AdBulkMod ad_bulk_mod(const AdBulkModType type, const QString &attribute, const QList<QByteArray> &values) {
+    AdBulkMod out;
+    out.type = type;
+    out.attribute = attribute;
+    out.values = values;
+
+    return out;
+}
+
+AdBulkOp ad_bulk_modify(const QString &dn, const QList<AdBulkMod> &mod_list) {
+    AdBulkOp out;
+    out.type = AdBulkOpType_Modify;
+    out.dn = dn;
+    out.tree_delete = false;
+    out.mod_list = mod_list;
+
+    return out;
+}
+
+AdBulkOp ad_bulk_add(const QString &dn, const QList<AdBulkMod> &mod_list) {
+    AdBulkOp out;
+    out.type = AdBulkOpType_Add;
+    out.dn = dn;
+    out.tree_delete = false;
+    out.mod_list = mod_list;
+
+    return out;
+}
+
+AdBulkOp ad_bulk_delete(const QString &dn, const bool tree_delete) {
+    AdBulkOp out;
+    out.type = AdBulkOpType_Delete;
+    out.dn = dn;
+    out.tree_delete = tree_delete;
+
+    return out;
+}
+
+AdBulkOp ad_bulk_rename(const QString &dn, const QString &new_rdn, const QString &new_superior) {
+    AdBulkOp out;
+    out.type = AdBulkOpType_Rename;
+    out.dn = dn;
+    out.tree_delete = false;
+    out.new_rdn = new_rdn;
+    out.new_superior = new_superior;
+
+    return out;
+}
@@ -0,0 +1,93 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_BULK_H
+#define AD_BULK_H
+
+/**
+ * Operations for AdInterface::bulk_run(), which sends
+ * modify/add/delete/rename requests for many objects
+ * without waiting for each one to finish. Use the
+ * ad_bulk_*() f-ns to create operations.
+ */
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+enum AdBulkOpType {
+    AdBulkOpType_Modify,
+    AdBulkOpType_Add,
+    AdBulkOpType_Delete,
+    AdBulkOpType_Rename,
+};
+
+enum AdBulkModType {
+    AdBulkModType_Replace,
+    AdBulkModType_Add,
+    AdBulkModType_Delete,
+};
+
+class AdBulkMod {
+public:
+    AdBulkModType type;
+    QString attribute;
+    QList<QByteArray> values;
+};
+
+class AdBulkOp {
+public:
+    AdBulkOpType type;
+    QString dn;
+
+    // For modify and add
+    QList<AdBulkMod> mod_list;
+
+    // For delete. If set, children of the object are
+    // deleted too, using tree delete control.
+    bool tree_delete;
+
+    // For rename. Empty new superior means that object
+    // stays in the same container.
+    QString new_rdn;
+    QString new_superior;
+};
+
+class AdBulkResult {
+public:
+    // False for operations that weren't sent because
+    // bulk was stopped on error
+    bool done;
+    bool success;
+    int ldap_result;
+    QString error;
+};
+
+// Called after each finished operation
+typedef std::function<void(const int done_count, const int total_count)> AdBulkProgress;
+
+AdBulkMod ad_bulk_mod(const AdBulkModType type, const QString &attribute, const QList<QByteArray> &values);
+AdBulkOp ad_bulk_modify(const QString &dn, const QList<AdBulkMod> &mod_list);
+AdBulkOp ad_bulk_add(const QString &dn, const QList<AdBulkMod> &mod_list);
+AdBulkOp ad_bulk_delete(const QString &dn, const bool tree_delete = false);
+AdBulkOp ad_bulk_rename(const QString &dn, const QString &new_rdn, const QString &new_superior = QString());
+
+#endif /* AD_BULK_H */
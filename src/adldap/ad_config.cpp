@@ -21,19 +21,29 @@
 #include "ad_config.h"
 #include "ad_config_p.h"
 
+#include "ad_attribute_table.h"
+#include "ad_config_cache.h"
 #include "ad_filter.h"
 #include "ad_interface.h"
+#include "ad_metrics.h"
 #include "ad_object.h"
 #include "ad_security.h"
+#include "ad_trace.h"
 #include "ad_utils.h"
 #include "ad_display.h"
 
 #include "samba/ndr_security.h"
 
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QLocale>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
 #include <algorithm>
+#include <ldap.h>
 
 #define ATTRIBUTE_ATTRIBUTE_DISPLAY_NAMES "attributeDisplayNames"
 #define ATTRIBUTE_EXTRA_COLUMNS "extraColumns"
@@ -59,6 +69,11 @@
 #define ATTRIBUTE_POSSIBLE_INFERIORS "possibleInferiors"
 #define ATTRIBUTE_ALLOWED_ATTRIBUTES "allowedAttributes"
 #define ATTRIBUTE_ALLOWED_ATTRIBUTES_EFFECTIVE "allowedAttributesEffective"
+
+// NOTE: deferred phases hold a thread while waiting for
+// core phases, so there should be enough threads for
+// that and all download phases
+#define PHASE_THREAD_MAX 6
 #define ATTRIBUTE_OBJECT_CLASS_CATEGORY "objectClassCategory"
 
 #define CLASS_ATTRIBUTE_SCHEMA "attributeSchema"
@@ -67,7 +82,51 @@
 
 #define FLAG_ATTR_IS_CONSTRUCTED 0x00000004
 
+AttributeType attribute_type_from_schema(const AdObject &schema);
+
+AttributeInfo::AttributeInfo() {
+    is_loaded = false;
+    type = AttributeType_StringCase;
+    large_integer_subtype = LargeIntegerSubtype_Integer;
+    is_single_valued = false;
+    is_system_only = false;
+    range_upper = 0;
+    is_backlink = false;
+    is_constructed = false;
+}
+
 AdConfigPrivate::AdConfigPrivate() {
+    skip_cache = false;
+    deferred_download_extended_rights = false;
+    deferred_running = false;
+}
+
+void AdConfigPrivate::run_phase(const QString &name, const std::function<void()> &function) {
+    QElapsedTimer timer;
+    timer.start();
+
+    function();
+
+    QMutexLocker locker(&phase_mutex);
+    phase_time_map[name] = timer.elapsed();
+}
+
+void AdConfigPrivate::wait_for_deferred_phases() {
+    QMutexLocker locker(&phase_mutex);
+
+    while (deferred_running) {
+        deferred_wait_condition.wait(&phase_mutex);
+    }
+}
+
+const AttributeInfo &AdConfigPrivate::get_attribute_info(const int attribute_id) const {
+    static const AttributeInfo default_info;
+
+    if (attribute_id >= 0 && attribute_id < attribute_info_list.size()) {
+        return attribute_info_list[attribute_id];
+    } else {
+        return default_info;
+    }
 }
 
 AdConfig::AdConfig() {
@@ -75,10 +134,138 @@ AdConfig::AdConfig() {
 }
 
 AdConfig::~AdConfig() {
+    d->wait_for_deferred_phases();
+
     delete d;
 }
 
+QString AdConfig::cache_path = QString();
+bool AdConfig::parallel_load_enabled = false;
+
+// NOTE: phases run in a separate pool, so that they don't
+// queue behind unrelated tasks and so that refresh task,
+// which runs in global pool, can't block all threads
+// while waiting for its own phases
+QThreadPool *config_thread_pool() {
+    static QThreadPool *pool = []() {
+        QThreadPool *out = new QThreadPool();
+        out->setMaxThreadCount(PHASE_THREAD_MAX);
+
+        return out;
+    }();
+
+    return pool;
+}
+
+// Runs one download phase of AdConfig::load() on a
+// separate connection. Connection is to the same DC as the
+// one passed to load(), because the DC is remembered by
+// the first connection.
+class AdConfigPhaseTask final : public QRunnable {
+public:
+    AdConfigPhaseTask(const QString &name_arg, const std::function<void(AdInterface &ad)> &function_arg, AdConfigPrivate *d_arg, bool *success_arg, QSemaphore *done_arg) {
+        name = name_arg;
+        function = function_arg;
+        d = d_arg;
+        success = success_arg;
+        done = done_arg;
+    }
+
+    void run() override {
+        const AdMetricsAction metrics_action(QCoreApplication::translate("AdConfig", "Load configuration"));
+
+        {
+            AdInterface ad;
+
+            *success = ad.is_connected();
+
+            if (*success) {
+                d->run_phase(name, [&]() {
+                    function(ad);
+                });
+            }
+        }
+
+        done->release();
+    }
+
+private:
+    QString name;
+    std::function<void(AdInterface &ad)> function;
+    AdConfigPrivate *d;
+    bool *success;
+    QSemaphore *done;
+};
+
+class AdConfigDeferredTask final : public QRunnable {
+public:
+    AdConfigDeferredTask(AdConfig *config_arg) {
+        config = config_arg;
+    }
+
+    void run() override {
+        const AdMetricsAction metrics_action(QCoreApplication::translate("AdConfig", "Load configuration"));
+
+        config->run_deferred_phases(nullptr);
+    }
+
+private:
+    AdConfig *config;
+};
+
+// Downloads config into a separate AdConfig and saves it
+// to cache, for next launch. Data of the running app is
+// not touched.
+class AdConfigRefreshTask final : public QRunnable {
+public:
+    AdConfigRefreshTask(const QLocale &locale_arg) {
+        locale = locale_arg;
+    }
+
+    void run() override {
+        AdInterface ad;
+        if (!ad.is_connected()) {
+            return;
+        }
+
+        AdConfig config;
+        config.d->skip_cache = true;
+        config.load(ad, locale);
+    }
+
+private:
+    QLocale locale;
+};
+
+void AdConfig::set_cache_path(const QString &path) {
+    cache_path = path;
+}
+
+void AdConfig::set_parallel_load_enabled(const bool enabled) {
+    parallel_load_enabled = enabled;
+}
+
+QHash<QString, qint64> AdConfig::get_phase_times() const {
+    QMutexLocker locker(&d->phase_mutex);
+
+    return d->phase_time_map;
+}
+
 void AdConfig::load(AdInterface &ad, const QLocale &locale) {
+    const AdTraceSpan trace_span("AdConfig::load", "config", ad.get_dc());
+
+    // NOTE: deferred phases of previous load write to the
+    // same data, so they need to finish first
+    d->wait_for_deferred_phases();
+
+    QElapsedTimer load_timer;
+    load_timer.start();
+
+    {
+        QMutexLocker locker(&d->phase_mutex);
+        d->phase_time_map.clear();
+    }
+
     d->domain = ad.get_domain();
 
     d->filter_containers.clear();
@@ -89,8 +276,14 @@ void AdConfig::load(AdInterface &ad, const QLocale &locale) {
     d->attribute_display_names.clear();
     d->attribute_schemas.clear();
     d->class_schemas.clear();
+    d->attribute_info_list.clear();
+    d->column_ids.clear();
+
+    const AdObject rootDSE_object = [&]() {
+        const AdTraceSpan rootdse_span("load_root_dse", "config");
 
-    const AdObject rootDSE_object = ad.search_object(ROOT_DSE);
+        return ad.search_object(ROOT_DSE);
+    }();
     d->domain_dn = rootDSE_object.get_string(ATTRIBUTE_DEFAULT_NAMING_CONTEXT);
     d->schema_dn = rootDSE_object.get_string(ATTRIBUTE_SCHEMA_NAMING_CONTEXT);
     d->configuration_dn = rootDSE_object.get_string(ATTRIBUTE_CONFIGURATION_NAMING_CONTEXT);
@@ -100,34 +293,257 @@ void AdConfig::load(AdInterface &ad, const QLocale &locale) {
     const AdObject domain_object = ad.search_object(domain_dn());
     d->domain_sid = object_sid_display_value(domain_object.get_value(ATTRIBUTE_OBJECT_SID));
 
-    const QString locale_dir = [this, locale]() {
-        const QString locale_code = [locale]() {
-            if (locale.language() == QLocale::Russian) {
-                return "419";
-            } else {
-                // English
-                return "409";
-            }
-        }();
+    const QString locale_code = [locale]() {
+        if (locale.language() == QLocale::Russian) {
+            return "419";
+        } else {
+            // English
+            return "409";
+        }
+    }();
+
+    const QString locale_dir = QString("CN=%1,CN=DisplaySpecifiers,%2").arg(locale_code, configuration_dn());
 
-        return QString("CN=%1,CN=DisplaySpecifiers,%2").arg(locale_code, configuration_dn());
+    // NOTE: objectVersion changes when schema is upgraded
+    // and modifyTimeStamp when schema is extended, so
+    // together they identify schema contents
+    const QString cache_key = [&]() {
+        if (cache_path.isEmpty()) {
+            return QString();
+        }
+
+        const AdObject schema_object = ad.search_object(schema_dn(), {ATTRIBUTE_OBJECT_VERSION, ATTRIBUTE_MODIFY_TIMESTAMP});
+        const QString object_version = schema_object.get_string(ATTRIBUTE_OBJECT_VERSION);
+        const QString modify_timestamp = schema_object.get_string(ATTRIBUTE_MODIFY_TIMESTAMP);
+
+        // NOTE: without version, schema changes can't be
+        // detected, so cache isn't used
+        if (object_version.isEmpty() || modify_timestamp.isEmpty()) {
+            return QString();
+        }
+
+        return QString("%1|%2|%3|%4").arg(d->domain.toLower(), locale_code, object_version, modify_timestamp);
     }();
 
-    load_attribute_schemas(ad);
+    const QString cache_file = [&]() {
+        if (cache_key.isEmpty()) {
+            return QString();
+        }
 
-    load_class_schemas(ad);
+        return QString("%1/%2_%3").arg(cache_path, d->domain.toLower(), locale_code);
+    }();
 
-    load_display_names(ad, locale_dir);
+    d->load_data = AdConfigCache();
+    const bool loaded_from_cache = [&]() {
+        if (cache_file.isEmpty() || d->skip_cache) {
+            return false;
+        }
 
-    load_columns(ad, locale_dir);
+        const AdTraceSpan cache_span("load_cache", "config", cache_file);
 
-    load_filter_containers(ad, locale_dir);
+        return d->load_data.load(cache_file, cache_key);
+    }();
 
-    load_extended_rights(ad);
+    if (!loaded_from_cache) {
+        d->load_data.key = cache_key;
+        d->load_data.downloaded_at = QDateTime::currentMSecsSinceEpoch();
+    }
 
-    load_permissionable_attributes(CLASS_DOMAIN, ad);
+    d->deferred_download_extended_rights = !loaded_from_cache;
+    d->deferred_cache_file = [&]() {
+        if (loaded_from_cache) {
+            return QString();
+        } else {
+            return cache_file;
+        }
+    }();
+
+    // Phases depend on each other like this:
+    //
+    // download core  -> apply core -> (load() returns)
+    //                              \
+    // download rights ------------> apply rights,
+    //                               permissionable attributes,
+    //                               save cache
+    //
+    // Downloads are independent searches, so they run in
+    // parallel. Deferred phases start right away, so that
+    // extended rights download together with the rest,
+    // then wait until core data is applied.
+    {
+        QMutexLocker locker(&d->phase_mutex);
+        d->deferred_running = true;
+    }
+
+    const bool parallel = parallel_load_enabled;
+
+    if (parallel) {
+        config_thread_pool()->start(new AdConfigDeferredTask(this));
+    }
+
+    if (!loaded_from_cache) {
+        download_core_phases(ad, locale_dir);
+    }
+
+    d->run_phase("apply_core", [&]() {
+        const AdTraceSpan apply_span("apply_core", "config");
+
+        apply_attribute_schemas(d->load_data.attribute_schema_list);
+        apply_class_schemas(d->load_data.class_schema_list);
+        apply_display_names(d->load_data.display_specifier_list);
+        apply_columns(d->load_data.columns_object);
+
+        d->filter_containers = d->load_data.filter_container_list;
+    });
+
+    {
+        QMutexLocker locker(&d->phase_mutex);
+        d->phase_time_map["core_total"] = load_timer.elapsed();
+    }
+
+    d->core_semaphore.release();
+
+    if (!parallel) {
+        run_deferred_phases(&ad);
+    }
+
+    if (loaded_from_cache && d->load_data.is_old()) {
+        QThreadPool::globalInstance()->start(new AdConfigRefreshTask(locale));
+    }
 }
 
+// NOTE: attribute schemas are the largest download, so
+// they use the connection of the caller while other
+// phases run on pool connections. If a pool connection
+// fails, that phase is retried on the caller's connection.
+void AdConfig::download_core_phases(AdInterface &ad, const QString &locale_dir) {
+    AdConfigCache &data = d->load_data;
+
+    auto download_attribute_schemas_phase = [this, &data](AdInterface &phase_ad) {
+        data.attribute_schema_list = download_attribute_schemas(phase_ad);
+    };
+
+    const QList<QString> pool_phase_name_list = {
+        "download_class_schemas",
+        "download_display_specifiers",
+        "download_columns",
+        "download_filter_containers",
+    };
+
+    const QList<std::function<void(AdInterface &)>> pool_phase_list = {
+        [this, &data](AdInterface &phase_ad) {
+            data.class_schema_list = download_class_schemas(phase_ad);
+        },
+        [this, &data, &locale_dir](AdInterface &phase_ad) {
+            data.display_specifier_list = download_display_specifiers(phase_ad, locale_dir);
+        },
+        [this, &data, &locale_dir](AdInterface &phase_ad) {
+            data.columns_object = download_columns(phase_ad, locale_dir);
+        },
+        [this, &data, &locale_dir](AdInterface &phase_ad) {
+            data.filter_container_list = download_filter_containers(phase_ad, locale_dir);
+        },
+    };
+
+    if (!parallel_load_enabled) {
+        d->run_phase("download_attribute_schemas", [&]() {
+            download_attribute_schemas_phase(ad);
+        });
+
+        for (int i = 0; i < pool_phase_list.size(); i++) {
+            d->run_phase(pool_phase_name_list[i], [&]() {
+                pool_phase_list[i](ad);
+            });
+        }
+
+        return;
+    }
+
+    QSemaphore done_semaphore;
+    QVector<bool> success_list(pool_phase_list.size(), false);
+
+    for (int i = 0; i < pool_phase_list.size(); i++) {
+        config_thread_pool()->start(new AdConfigPhaseTask(pool_phase_name_list[i], pool_phase_list[i], d, &success_list[i], &done_semaphore));
+    }
+
+    d->run_phase("download_attribute_schemas", [&]() {
+        download_attribute_schemas_phase(ad);
+    });
+
+    done_semaphore.acquire(pool_phase_list.size());
+
+    for (int i = 0; i < pool_phase_list.size(); i++) {
+        if (!success_list[i]) {
+            qDebug() << "Failed to connect for config phase" << pool_phase_name_list[i] << ", retrying on main connection";
+
+            d->run_phase(pool_phase_name_list[i], [&]() {
+                pool_phase_list[i](ad);
+            });
+        }
+    }
+}
+
+// Extended rights and permissionable attributes are only
+// needed for security tab and permission dialogs, so they
+// don't delay main window. If ad is null, opens a separate
+// connection to download extended rights.
+void AdConfig::run_deferred_phases(AdInterface *ad) {
+    const AdTraceSpan trace_span("run_deferred_phases", "config");
+
+    QElapsedTimer deferred_timer;
+    deferred_timer.start();
+
+    AdConfigCache &data = d->load_data;
+
+    if (d->deferred_download_extended_rights) {
+        auto download_phase = [&](AdInterface &phase_ad) {
+            d->run_phase("download_extended_rights", [&]() {
+                data.extended_right_list = download_extended_rights(phase_ad);
+            });
+        };
+
+        if (ad != nullptr) {
+            download_phase(*ad);
+        } else {
+            AdInterface phase_ad;
+
+            if (phase_ad.is_connected()) {
+                download_phase(phase_ad);
+            } else {
+                qDebug() << "Failed to connect to download extended rights";
+            }
+        }
+    }
+
+    d->core_semaphore.acquire();
+
+    d->run_phase("apply_deferred", [&]() {
+        d->right_to_guid_map.clear();
+        d->right_guid_to_cn_map.clear();
+        d->rights_guid_to_name_map.clear();
+        d->rights_name_to_guid_map.clear();
+        d->rights_applies_to_map.clear();
+        d->extended_rights_list.clear();
+        d->rights_valid_accesses_map.clear();
+        d->class_permissionable_attributes_map.clear();
+
+        apply_extended_rights(data.extended_right_list);
+
+        // NOTE: permissionable attributes depend on
+        // schema, so they are loaded after schema is
+        // applied
+        apply_permissionable_attributes();
+    });
+
+    if (!d->deferred_cache_file.isEmpty()) {
+        data.save(d->deferred_cache_file);
+    }
+
+    QMutexLocker locker(&d->phase_mutex);
+    d->phase_time_map["deferred_total"] = deferred_timer.elapsed();
+    d->deferred_running = false;
+    d->deferred_wait_condition.wakeAll();
+}
 QString AdConfig::domain() const {
     return d->domain;
 }
@@ -162,6 +578,13 @@ bool AdConfig::control_is_supported(const QString &control_oid) const {
     return supported;
 }
 
+bool AdConfig::window_search_supported() const {
+    const bool sort_supported = control_is_supported(LDAP_CONTROL_SORTREQUEST);
+    const bool vlv_supported = control_is_supported(LDAP_CONTROL_VLVREQUEST);
+
+    return (sort_supported && vlv_supported);
+}
+
 QString AdConfig::domain_sid() const
 {
     return d->domain_sid;
@@ -208,6 +631,10 @@ QList<QString> AdConfig::get_columns() const {
     return d->columns;
 }
 
+QList<int> AdConfig::get_column_ids() const {
+    return d->column_ids;
+}
+
 QString AdConfig::get_column_display_name(const Attribute &attribute) const {
     return d->column_display_names.value(attribute, attribute);
 }
@@ -225,17 +652,9 @@ QList<QString> AdConfig::get_filter_containers() const {
 }
 
 QList<QString> AdConfig::get_possible_superiors(const QList<ObjectClass> &object_classes) const {
-    QList<QString> out;
-
-    for (const QString &object_class : object_classes) {
-        const AdObject schema = d->class_schemas[object_class];
-        out += schema.get_strings(ATTRIBUTE_POSSIBLE_SUPERIORS);
-        out += schema.get_strings(ATTRIBUTE_SYSTEM_POSSIBLE_SUPERIORS);
-    }
-
-    out.removeDuplicates();
+    const QBitArray superiors = d->get_class_set_union(object_classes, &ClassInfo::possible_superiors);
 
-    return out;
+    return d->class_set_to_list(superiors);
 }
 
 ObjectClass AdConfig::get_parent_class(const ObjectClass &object_class) const {
@@ -266,36 +685,17 @@ QList<ObjectClass> AdConfig::get_inherit_chain(const ObjectClass &object_class)
     return out;
 }
 
+// NOTE: these include attributes of auxiliary classes
 QList<QString> AdConfig::get_optional_attributes(const QList<QString> &object_classes) const {
-    const QList<QString> all_classes = d->add_auxiliary_classes(object_classes);
-
-    QList<QString> attributes;
-
-    for (const auto &object_class : all_classes) {
-        const AdObject schema = d->class_schemas[object_class];
-        attributes += schema.get_strings(ATTRIBUTE_MAY_CONTAIN);
-        attributes += schema.get_strings(ATTRIBUTE_SYSTEM_MAY_CONTAIN);
-    }
-
-    attributes.removeDuplicates();
+    const QBitArray attributes = d->get_class_set_union(object_classes, &ClassInfo::optional_attributes);
 
-    return attributes;
+    return d->attribute_set_to_list(attributes);
 }
 
 QList<QString> AdConfig::get_mandatory_attributes(const QList<QString> &object_classes) const {
-    const QList<QString> all_classes = d->add_auxiliary_classes(object_classes);
+    const QBitArray attributes = d->get_class_set_union(object_classes, &ClassInfo::mandatory_attributes);
 
-    QList<QString> attributes;
-
-    for (const auto &object_class : all_classes) {
-        const AdObject schema = d->class_schemas[object_class];
-        attributes += schema.get_strings(ATTRIBUTE_MUST_CONTAIN);
-        attributes += schema.get_strings(ATTRIBUTE_SYSTEM_MUST_CONTAIN);
-    }
-
-    attributes.removeDuplicates();
-
-    return attributes;
+    return d->attribute_set_to_list(attributes);
 }
 
 QList<QString> AdConfig::get_find_attributes(const QString &object_class) const {
@@ -303,50 +703,7 @@ QList<QString> AdConfig::get_find_attributes(const QString &object_class) const
 }
 
 AttributeType AdConfig::get_attribute_type(const QString &attribute) const {
-    // NOTE: replica of: https://docs.microsoft.com/en-us/openspecs/windows_protocols/ms-adts/7cda533e-d7a4-4aec-a517-91d02ff4a1aa
-    // syntax -> om syntax list -> type
-    static QHash<QString, QHash<QString, AttributeType>> type_map = {
-        {"2.5.5.8", {{"1", AttributeType_Boolean}}},
-        {"2.5.5.9",
-            {
-                {"10", AttributeType_Enumeration},
-                {"2", AttributeType_Integer},
-            }},
-        {"2.5.5.16", {{"65", AttributeType_LargeInteger}}},
-        {"2.5.5.3", {{"27", AttributeType_StringCase}}},
-        {"2.5.5.5", {{"22", AttributeType_IA5}}},
-        {"2.5.5.15", {{"66", AttributeType_NTSecDesc}}},
-        {"2.5.5.6", {{"18", AttributeType_Numeric}}},
-        {"2.5.5.2", {{"6", AttributeType_ObjectIdentifier}}},
-        {"2.5.5.10",
-            {
-                {"4", AttributeType_Octet},
-                {"127", AttributeType_ReplicaLink},
-            }},
-        {"2.5.5.5", {{"19", AttributeType_Printable}}},
-        {"2.5.5.17", {{"4", AttributeType_Sid}}},
-        {"2.5.5.4", {{"20", AttributeType_Teletex}}},
-        {"2.5.5.12", {{"64", AttributeType_Unicode}}},
-        {"2.5.5.11",
-            {
-                {"23", AttributeType_UTCTime},
-                {"24", AttributeType_GeneralizedTime},
-            }},
-        {"2.5.5.14", {{"127", AttributeType_DNString}}},
-        {"2.5.5.7", {{"127", AttributeType_DNBinary}}},
-        {"2.5.5.1", {{"127", AttributeType_DSDN}}},
-    };
-
-    const AdObject schema = d->attribute_schemas[attribute];
-
-    const QString attribute_syntax = schema.get_string(ATTRIBUTE_ATTRIBUTE_SYNTAX);
-    const QString om_syntax = schema.get_string(ATTRIBUTE_OM_SYNTAX);
-
-    if (type_map.contains(attribute_syntax) && type_map[attribute_syntax].contains(om_syntax)) {
-        return type_map[attribute_syntax][om_syntax];
-    } else {
-        return AttributeType_StringCase;
-    }
+    return get_attribute_type(get_attribute_id(attribute));
 }
 
 LargeIntegerSubtype AdConfig::get_attribute_large_integer_subtype(const QString &attribute) const {
@@ -382,46 +739,86 @@ LargeIntegerSubtype AdConfig::get_attribute_large_integer_subtype(const QString
 }
 
 bool AdConfig::get_attribute_is_number(const QString &attribute) const {
+    return get_attribute_is_number(get_attribute_id(attribute));
+}
+
+bool AdConfig::get_attribute_is_single_valued(const QString &attribute) const {
+    return get_attribute_is_single_valued(get_attribute_id(attribute));
+}
+
+bool AdConfig::get_attribute_is_system_only(const QString &attribute) const {
+    return get_attribute_is_system_only(get_attribute_id(attribute));
+}
+
+int AdConfig::get_attribute_range_upper(const QString &attribute) const {
+    return get_attribute_range_upper(get_attribute_id(attribute));
+}
+
+bool AdConfig::get_attribute_is_backlink(const QString &attribute) const {
+    return get_attribute_is_backlink(get_attribute_id(attribute));
+}
+
+bool AdConfig::get_attribute_is_constructed(const QString &attribute) const {
+    return get_attribute_is_constructed(get_attribute_id(attribute));
+}
+
+int AdConfig::get_attribute_id(const QString &attribute) const {
+    return AdAttributeTable::instance()->find(attribute);
+}
+
+AttributeType AdConfig::get_attribute_type(const int attribute_id) const {
+    return d->get_attribute_info(attribute_id).type;
+}
+
+LargeIntegerSubtype AdConfig::get_attribute_large_integer_subtype(const int attribute_id) const {
+    const AttributeInfo &info = d->get_attribute_info(attribute_id);
+
+    // NOTE: subtypes don't depend on schema, so they can
+    // be determined for attributes outside of it too
+    if (info.is_loaded) {
+        return info.large_integer_subtype;
+    } else {
+        const QString attribute = AdAttributeTable::instance()->name(attribute_id);
+
+        return get_attribute_large_integer_subtype(attribute);
+    }
+}
+
+bool AdConfig::get_attribute_is_number(const int attribute_id) const {
     static const QList<AttributeType> number_types = {
         AttributeType_Integer,
         AttributeType_LargeInteger,
         AttributeType_Enumeration,
         AttributeType_Numeric,
     };
-    const AttributeType type = get_attribute_type(attribute);
+    const AttributeType type = get_attribute_type(attribute_id);
 
     return number_types.contains(type);
 }
 
-bool AdConfig::get_attribute_is_single_valued(const QString &attribute) const {
-    return d->attribute_schemas[attribute].get_bool(ATTRIBUTE_IS_SINGLE_VALUED);
+bool AdConfig::get_attribute_is_single_valued(const int attribute_id) const {
+    return d->get_attribute_info(attribute_id).is_single_valued;
 }
 
-bool AdConfig::get_attribute_is_system_only(const QString &attribute) const {
-    return d->attribute_schemas[attribute].get_bool(ATTRIBUTE_SYSTEM_ONLY);
+bool AdConfig::get_attribute_is_system_only(const int attribute_id) const {
+    return d->get_attribute_info(attribute_id).is_system_only;
 }
 
-int AdConfig::get_attribute_range_upper(const QString &attribute) const {
-    return d->attribute_schemas[attribute].get_int(ATTRIBUTE_RANGE_UPPER);
+int AdConfig::get_attribute_range_upper(const int attribute_id) const {
+    return d->get_attribute_info(attribute_id).range_upper;
 }
 
-bool AdConfig::get_attribute_is_backlink(const QString &attribute) const {
-    if (d->attribute_schemas[attribute].contains(ATTRIBUTE_LINK_ID)) {
-        const int link_id = d->attribute_schemas[attribute].get_int(ATTRIBUTE_LINK_ID);
-        const bool link_id_is_odd = (link_id % 2 != 0);
-
-        return link_id_is_odd;
-    } else {
-        return false;
-    }
+bool AdConfig::get_attribute_is_backlink(const int attribute_id) const {
+    return d->get_attribute_info(attribute_id).is_backlink;
 }
 
-bool AdConfig::get_attribute_is_constructed(const QString &attribute) const {
-    const int system_flags = d->attribute_schemas[attribute].get_int(ATTRIBUTE_SYSTEM_FLAGS);
-    return bitmask_is_set(system_flags, FLAG_ATTR_IS_CONSTRUCTED);
+bool AdConfig::get_attribute_is_constructed(const int attribute_id) const {
+    return d->get_attribute_info(attribute_id).is_constructed;
 }
 
 QByteArray AdConfig::get_right_guid(const QString &right_cn) const {
+    d->wait_for_deferred_phases();
+
     const QByteArray out = d->right_to_guid_map.value(right_cn, QByteArray());
     return out;
 }
@@ -434,6 +831,8 @@ QByteArray AdConfig::get_right_guid(const QString &right_cn) const {
 // dssec.dll. And we don't have dssec.dll, nor do we
 // have the ability to interact with it!
 QString AdConfig::get_right_name(const QByteArray &right_guid, const QLocale::Language language) const {
+    d->wait_for_deferred_phases();
+
     const QHash<QString, QString> cn_to_map_russian = {
         {"DS-Replication-Get-Changes", QCoreApplication::translate("AdConfig", "DS Replication Get Changes")},
         {"DS-Replication-Get-Changes-All", QCoreApplication::translate("AdConfig", "DS Replication Get Changes All")},
@@ -529,6 +928,8 @@ QString AdConfig::get_right_name(const QByteArray &right_guid, const QLocale::La
 }
 
 QList<QString> AdConfig::get_extended_rights_list(const QList<QString> &class_list) const {
+    d->wait_for_deferred_phases();
+
     QList<QString> out;
 
     for (const QString &rights : d->extended_rights_list) {
@@ -542,6 +943,8 @@ QList<QString> AdConfig::get_extended_rights_list(const QList<QString> &class_li
 }
 
 int AdConfig::get_rights_valid_accesses(const QString &rights_cn) const {
+    d->wait_for_deferred_phases();
+
     // NOTE: awkward exception. Can't write group
     // membership because target attribute is
     // constructed. For some reason valid accesses for
@@ -561,7 +964,7 @@ QString AdConfig::guid_to_attribute(const QByteArray &guid) const {
 }
 
 QByteArray AdConfig::attribute_to_guid(const QString &attr) const {
-    const QByteArray attr_guid = d->guid_to_attribute_map.key(attr, QByteArray());
+    const QByteArray attr_guid = d->get_attribute_info(get_attribute_id(attr)).guid;
     return attr_guid;
 }
 
@@ -583,6 +986,8 @@ QList<QString> AdConfig::get_noncontainer_classes() {
 }
 
 bool AdConfig::rights_applies_to_class(const QString &rights_cn, const QList<QString> &class_list) const {
+    d->wait_for_deferred_phases();
+
     const QByteArray rights_guid = d->rights_name_to_guid_map[rights_cn];
 
     const QList<QString> applies_to_list = d->rights_applies_to_map[rights_guid];
@@ -600,6 +1005,8 @@ QStringList AdConfig::get_possible_inferiors(const QString &obj_class) const {
 }
 
 QStringList AdConfig::get_permissionable_attributes(const QString &obj_class) const {
+    d->wait_for_deferred_phases();
+
     return d->class_permissionable_attributes_map[obj_class];
 }
 
@@ -614,18 +1021,20 @@ bool AdConfig::class_is_auxiliary(const QString &obj_class) const {
 }
 
 QList<QString> AdConfig::all_inferiors_list(const QString &obj_class) const {
-    QList<QString> out;
-    for (const QString &inferior_class : get_possible_inferiors(obj_class)) {
-        out.append(inferior_class);
-        out.append(get_possible_inferiors(inferior_class));
-    }
-    // Remove duplicates with converting to set and back
-    out = QSet<QString>(out.begin(), out.end()).values();
+    const QBitArray all_inferiors = d->get_class_set_union({obj_class}, &ClassInfo::all_inferiors);
 
-    return out;
+    return d->class_set_to_list(all_inferiors);
+}
+
+QList<QString> AdConfig::transitive_inferiors_list(const QString &obj_class) const {
+    const QBitArray transitive_inferiors = d->get_class_set_union({obj_class}, &ClassInfo::transitive_inferiors);
+
+    return d->class_set_to_list(transitive_inferiors);
 }
 
 QList<QString> AdConfig::all_extended_right_classes() const {
+    d->wait_for_deferred_phases();
+
     QList<QString> out;
     for (auto obj_classes : d->rights_applies_to_map.values()) {
         out.append(obj_classes);
@@ -635,8 +1044,9 @@ QList<QString> AdConfig::all_extended_right_classes() const {
     return out;
 }
 
-void AdConfig::load_extended_rights(AdInterface &ad)
-{
+QList<AdObject> AdConfig::download_extended_rights(AdInterface &ad) {
+    const AdTraceSpan trace_span("download_extended_rights", "config");
+
     const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_CONTROL_ACCESS_RIGHT);
 
     const QList<QString> attributes = {
@@ -651,7 +1061,11 @@ void AdConfig::load_extended_rights(AdInterface &ad)
 
     const QHash<QString, AdObject> search_results = ad.search(search_base, SearchScope_Children, filter, attributes);
 
-    for (const AdObject &object : search_results.values()) {
+    return search_results.values();
+}
+
+void AdConfig::apply_extended_rights(const QList<AdObject> &object_list) {
+    for (const AdObject &object : object_list) {
         const QString cn = object.get_string(ATTRIBUTE_CN);
         const QString guid_string = object.get_string(ATTRIBUTE_RIGHTS_GUID);
         const QByteArray guid = guid_string_to_bytes(guid_string);
@@ -681,7 +1095,9 @@ void AdConfig::load_extended_rights(AdInterface &ad)
     }
 }
 
-void AdConfig::load_attribute_schemas(AdInterface &ad) {
+QList<AdObject> AdConfig::download_attribute_schemas(AdInterface &ad) {
+    const AdTraceSpan trace_span("download_attribute_schemas", "config");
+
     const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_ATTRIBUTE_SCHEMA);
 
     const QList<QString> attributes = {
@@ -698,16 +1114,99 @@ void AdConfig::load_attribute_schemas(AdInterface &ad) {
 
     const QHash<QString, AdObject> results = ad.search(schema_dn(), SearchScope_Children, filter, attributes);
 
-    for (const AdObject &object : results.values()) {
+    return results.values();
+}
+
+void AdConfig::apply_attribute_schemas(const QList<AdObject> &object_list) {
+    AdAttributeTable *attribute_table = AdAttributeTable::instance();
+
+    for (const AdObject &object : object_list) {
         const QString attribute = object.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
         d->attribute_schemas[attribute] = object;
 
         const QByteArray guid = object.get_value(ATTRIBUTE_SCHEMA_ID_GUID);
         d->guid_to_attribute_map[guid] = attribute;
+
+        AttributeInfo info;
+        info.is_loaded = true;
+        info.type = attribute_type_from_schema(object);
+        info.large_integer_subtype = get_attribute_large_integer_subtype(attribute);
+        info.is_single_valued = object.get_bool(ATTRIBUTE_IS_SINGLE_VALUED);
+        info.is_system_only = object.get_bool(ATTRIBUTE_SYSTEM_ONLY);
+        info.range_upper = object.get_int(ATTRIBUTE_RANGE_UPPER);
+        info.is_backlink = [&]() {
+            if (object.contains(ATTRIBUTE_LINK_ID)) {
+                const int link_id = object.get_int(ATTRIBUTE_LINK_ID);
+                const bool link_id_is_odd = (link_id % 2 != 0);
+
+                return link_id_is_odd;
+            } else {
+                return false;
+            }
+        }();
+        info.is_constructed = [&]() {
+            const int system_flags = object.get_int(ATTRIBUTE_SYSTEM_FLAGS);
+
+            return bitmask_is_set(system_flags, FLAG_ATTR_IS_CONSTRUCTED);
+        }();
+        info.guid = guid;
+
+        const int attribute_id = attribute_table->intern(attribute);
+        if (attribute_id >= d->attribute_info_list.size()) {
+            d->attribute_info_list.resize(attribute_id + 1);
+        }
+        d->attribute_info_list[attribute_id] = info;
     }
 }
 
-void AdConfig::load_class_schemas(AdInterface &ad) {
+AttributeType attribute_type_from_schema(const AdObject &schema) {
+    // NOTE: replica of: https://docs.microsoft.com/en-us/openspecs/windows_protocols/ms-adts/7cda533e-d7a4-4aec-a517-91d02ff4a1aa
+    // syntax -> om syntax list -> type
+    static QHash<QString, QHash<QString, AttributeType>> type_map = {
+        {"2.5.5.8", {{"1", AttributeType_Boolean}}},
+        {"2.5.5.9",
+            {
+                {"10", AttributeType_Enumeration},
+                {"2", AttributeType_Integer},
+            }},
+        {"2.5.5.16", {{"65", AttributeType_LargeInteger}}},
+        {"2.5.5.3", {{"27", AttributeType_StringCase}}},
+        {"2.5.5.5", {{"22", AttributeType_IA5}}},
+        {"2.5.5.15", {{"66", AttributeType_NTSecDesc}}},
+        {"2.5.5.6", {{"18", AttributeType_Numeric}}},
+        {"2.5.5.2", {{"6", AttributeType_ObjectIdentifier}}},
+        {"2.5.5.10",
+            {
+                {"4", AttributeType_Octet},
+                {"127", AttributeType_ReplicaLink},
+            }},
+        {"2.5.5.5", {{"19", AttributeType_Printable}}},
+        {"2.5.5.17", {{"4", AttributeType_Sid}}},
+        {"2.5.5.4", {{"20", AttributeType_Teletex}}},
+        {"2.5.5.12", {{"64", AttributeType_Unicode}}},
+        {"2.5.5.11",
+            {
+                {"23", AttributeType_UTCTime},
+                {"24", AttributeType_GeneralizedTime},
+            }},
+        {"2.5.5.14", {{"127", AttributeType_DNString}}},
+        {"2.5.5.7", {{"127", AttributeType_DNBinary}}},
+        {"2.5.5.1", {{"127", AttributeType_DSDN}}},
+    };
+
+    const QString attribute_syntax = schema.get_string(ATTRIBUTE_ATTRIBUTE_SYNTAX);
+    const QString om_syntax = schema.get_string(ATTRIBUTE_OM_SYNTAX);
+
+    if (type_map.contains(attribute_syntax) && type_map[attribute_syntax].contains(om_syntax)) {
+        return type_map[attribute_syntax][om_syntax];
+    } else {
+        return AttributeType_StringCase;
+    }
+}
+
+QList<AdObject> AdConfig::download_class_schemas(AdInterface &ad) {
+    const AdTraceSpan trace_span("download_class_schemas", "config");
+
     const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_CLASS_SCHEMA);
 
     const QList<QString> attributes = {
@@ -728,7 +1227,11 @@ void AdConfig::load_class_schemas(AdInterface &ad) {
 
     const QHash<QString, AdObject> results = ad.search(schema_dn(), SearchScope_Children, filter, attributes);
 
-    for (const AdObject &object : results.values()) {
+    return results.values();
+}
+
+void AdConfig::apply_class_schemas(const QList<AdObject> &object_list) {
+    for (const AdObject &object : object_list) {
         const QString object_class = object.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
         d->class_schemas[object_class] = object;
 
@@ -741,9 +1244,13 @@ void AdConfig::load_class_schemas(AdInterface &ad) {
         const QStringList possible_inferiors = bytearray_list_to_string_list(object.get_values(ATTRIBUTE_POSSIBLE_INFERIORS));
         d->class_possible_inferiors_map[object_class] = possible_inferiors;
     }
+
+    d->build_class_index();
 }
 
-void AdConfig::load_display_names(AdInterface &ad, const QString &locale_dir) {
+QList<AdObject> AdConfig::download_display_specifiers(AdInterface &ad, const QString &locale_dir) {
+    const AdTraceSpan trace_span("download_display_specifiers", "config");
+
     const QString filter = QString();
 
     const QList<QString> search_attributes = {
@@ -753,7 +1260,11 @@ void AdConfig::load_display_names(AdInterface &ad, const QString &locale_dir) {
 
     const QHash<QString, AdObject> results = ad.search(locale_dir, SearchScope_Children, filter, search_attributes);
 
-    for (const AdObject &object : results) {
+    return results.values();
+}
+
+void AdConfig::apply_display_names(const QList<AdObject> &object_list) {
+    for (const AdObject &object : object_list) {
         const QString dn = object.get_dn();
 
         // Display specifier DN is "CN=object-class-Display,CN=..."
@@ -798,11 +1309,17 @@ void AdConfig::load_display_names(AdInterface &ad, const QString &locale_dir) {
     }
 }
 
-void AdConfig::load_columns(AdInterface &ad, const QString &locale_dir) {
-    const QList<QString> columns_values = [&] {
-        const QString dn = QString("CN=default-Display,%1").arg(locale_dir);
-        const AdObject object = ad.search_object(dn, {ATTRIBUTE_EXTRA_COLUMNS});
+AdObject AdConfig::download_columns(AdInterface &ad, const QString &locale_dir) {
+    const AdTraceSpan trace_span("download_columns", "config");
 
+    const QString dn = QString("CN=default-Display,%1").arg(locale_dir);
+    const AdObject object = ad.search_object(dn, {ATTRIBUTE_EXTRA_COLUMNS});
+
+    return object;
+}
+
+void AdConfig::apply_columns(const AdObject &object) {
+    const QList<QString> columns_values = [&] {
         // NOTE: order as stored in attribute is reversed. Order is not sorted alphabetically so can't just sort.
         QList<QString> extra_columns = object.get_strings(ATTRIBUTE_EXTRA_COLUMNS);
         std::reverse(extra_columns.begin(), extra_columns.end());
@@ -837,9 +1354,19 @@ void AdConfig::load_columns(AdInterface &ad, const QString &locale_dir) {
     add_custom(ATTRIBUTE_DESCRIPTION, QCoreApplication::translate("AdConfig", "Description"));
     add_custom(ATTRIBUTE_OBJECT_CLASS, QCoreApplication::translate("AdConfig", "Class"));
     add_custom(ATTRIBUTE_NAME, QCoreApplication::translate("AdConfig", "Name"));
+
+    AdAttributeTable *attribute_table = AdAttributeTable::instance();
+    for (const QString &attribute : d->columns) {
+        const int attribute_id = attribute_table->intern(attribute);
+        d->column_ids.append(attribute_id);
+    }
 }
 
-void AdConfig::load_filter_containers(AdInterface &ad, const QString &locale_dir) {
+QList<ObjectClass> AdConfig::download_filter_containers(AdInterface &ad, const QString &locale_dir) {
+    const AdTraceSpan trace_span("download_filter_containers", "config");
+
+    QList<ObjectClass> out;
+
     const QString ui_settings_dn = QString("CN=DS-UI-Default-Settings,%1").arg(locale_dir);
     const AdObject object = ad.search_object(ui_settings_dn, {ATTRIBUTE_FILTER_CONTAINERS});
 
@@ -861,65 +1388,260 @@ void AdConfig::load_filter_containers(AdInterface &ad, const QString &locale_dir
         const AdObject category_object = ad.search_object(category_dn, {ATTRIBUTE_LDAP_DISPLAY_NAME});
         const QString object_class = category_object.get_string(ATTRIBUTE_LDAP_DISPLAY_NAME);
 
-        d->filter_containers.append(object_class);
+        out.append(object_class);
     }
 
     // NOTE: domain not included for some reason, so add it manually
-    d->filter_containers.append(CLASS_DOMAIN);
+    out.append(CLASS_DOMAIN);
 
     // Make configuration and schema pass filter in dev mode so they are visible and can be fetched
-    d->filter_containers.append({CLASS_CONFIGURATION, CLASS_dMD});
+    out.append({CLASS_CONFIGURATION, CLASS_dMD});
+
+    return out;
 }
 
-void AdConfig::load_permissionable_attributes(const QString &obj_class, AdInterface &ad) {
-    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_LDAP_DISPLAY_NAME, obj_class);
-    QHash<QString, AdObject> results = ad.search(schema_dn(), SearchScope_Children, filter,
-                                             {ATTRIBUTE_ALLOWED_ATTRIBUTES, ATTRIBUTE_SYSTEM_MAY_CONTAIN});
-    if (results.isEmpty()) {
-        return;
+// NOTE: permissionable attributes are computed for domain
+// and all classes that can be created under it, directly
+// or indirectly. Attributes are derived from loaded class
+// schemas instead of requesting constructed
+// allowedAttributes from server for every class.
+void AdConfig::apply_permissionable_attributes() {
+    const AdTraceSpan trace_span("apply_permissionable_attributes", "config");
+
+    QHash<QString, QSet<QString>> allowed_attributes_map;
+
+    QList<QString> class_queue = {CLASS_DOMAIN};
+    QSet<QString> visited_set = {CLASS_DOMAIN};
+
+    while (!class_queue.isEmpty()) {
+        const QString obj_class = class_queue.takeFirst();
+
+        if (!d->class_schemas.contains(obj_class)) {
+            continue;
+        }
+
+        const QSet<QString> allowed_attrs_set = d->get_allowed_attributes(obj_class, &allowed_attributes_map);
+
+        QStringList permissionable_attrs;
+        // Remove backlinks, constructed and system-only attributes
+        for (const QString &attr : allowed_attrs_set) {
+            if (get_attribute_is_backlink(attr) || get_attribute_is_constructed(attr) || get_attribute_is_system_only(attr)) {
+                continue;
+            }
+
+            permissionable_attrs.append(attr);
+        }
+
+        permissionable_attrs.sort();
+        d->class_permissionable_attributes_map[obj_class] = permissionable_attrs;
+
+        for (const QString &inferior : d->class_possible_inferiors_map.value(obj_class, QStringList())) {
+            if (!visited_set.contains(inferior)) {
+                visited_set.insert(inferior);
+                class_queue.append(inferior);
+            }
+        }
     }
-    const AdObject class_schema_object = results.values()[0];
+}
 
-    const QStringList allowed_attrs = bytearray_list_to_string_list(class_schema_object.get_values(ATTRIBUTE_ALLOWED_ATTRIBUTES));
-    const QStringList attrs_system_may_contain = bytearray_list_to_string_list(class_schema_object.get_values(ATTRIBUTE_SYSTEM_MAY_CONTAIN));
+// Returns same attributes as allowedAttributes of class
+// schema: may and must contain attributes of the class, its
+// parent classes and auxiliary classes. Results are
+// memoized in given map, because most classes share parents
+// and auxiliary classes.
+QSet<QString> AdConfigPrivate::get_allowed_attributes(const QString &obj_class, QHash<QString, QSet<QString>> *allowed_attributes_map) const {
+    if (allowed_attributes_map->contains(obj_class)) {
+        return allowed_attributes_map->value(obj_class);
+    }
+
+    // NOTE: insert empty set first to stop recursion if
+    // schema has a loop
+    allowed_attributes_map->insert(obj_class, QSet<QString>());
 
-    // Use set to remove duplicates (just in case)
-    QSet<QString> allowed_attrs_set = QSet<QString>(allowed_attrs.begin(), allowed_attrs.end());
-    QSet<QString> may_contain_attrs_set = QSet<QString>(attrs_system_may_contain.begin(), attrs_system_may_contain.end());
-    allowed_attrs_set |= may_contain_attrs_set;
+    const AdObject schema = class_schemas.value(obj_class);
 
-    QSet<QString> permissionable_attrs_set = allowed_attrs_set;
-    // Remove backlinks, constructed and system-only attributes
-    for (const QString &attr : allowed_attrs_set) {
-        if (get_attribute_is_backlink(attr) || get_attribute_is_constructed(attr) || get_attribute_is_system_only(attr)) {
-            permissionable_attrs_set.remove(attr);
+    QSet<QString> out;
+
+    const QList<QString> contain_attributes = {
+        ATTRIBUTE_MAY_CONTAIN,
+        ATTRIBUTE_SYSTEM_MAY_CONTAIN,
+        ATTRIBUTE_MUST_CONTAIN,
+        ATTRIBUTE_SYSTEM_MUST_CONTAIN,
+    };
+
+    for (const QString &attribute : contain_attributes) {
+        for (const QString &value : schema.get_strings(attribute)) {
+            out.insert(value);
         }
     }
 
-    QStringList permissionable_attrs = QStringList(permissionable_attrs_set.begin(), permissionable_attrs_set.end());
-    permissionable_attrs.sort();
-    d->class_permissionable_attributes_map[obj_class] = permissionable_attrs;
+    QList<QString> related_classes;
+    related_classes += schema.get_strings(ATTRIBUTE_AUXILIARY_CLASS);
+    related_classes += schema.get_strings(ATTRIBUTE_SYSTEM_AUXILIARY_CLASS);
 
-    for (const QString &inferior : d->class_possible_inferiors_map.value(obj_class, QStringList())) {
-        if (inferior == obj_class || d->class_permissionable_attributes_map.contains(inferior)) {
-            continue;
+    // NOTE: top is a subclass of itself
+    const QString parent_class = sub_class_of_map.value(obj_class);
+    if (!parent_class.isEmpty() && parent_class != obj_class) {
+        related_classes.append(parent_class);
+    }
+
+    for (const QString &related_class : related_classes) {
+        out |= get_allowed_attributes(related_class, allowed_attributes_map);
+    }
+
+    allowed_attributes_map->insert(obj_class, out);
+
+    return out;
+}
+
+void AdConfigPrivate::build_class_index() {
+    const AdTraceSpan trace_span("build_class_index", "config");
+
+    class_name_list = class_schemas.keys();
+    class_id_map.clear();
+    for (int i = 0; i < class_name_list.size(); i++) {
+        class_id_map[class_name_list[i]] = i;
+    }
+
+    const int class_count = class_name_list.size();
+
+    AdAttributeTable *attribute_table = AdAttributeTable::instance();
+
+    // NOTE: attribute id's can be added to the table while
+    // set is filled, so set grows as needed
+    auto get_attribute_set = [&](const AdObject &schema, const QList<QString> &attribute_list) {
+        QBitArray out;
+
+        for (const QString &attribute : attribute_list) {
+            for (const QString &value : schema.get_strings(attribute)) {
+                const int id = attribute_table->intern(value);
+
+                if (id >= out.size()) {
+                    out.resize(id + 1);
+                }
+
+                out.setBit(id);
+            }
+        }
+
+        return out;
+    };
+
+    auto get_class_set = [&](const QList<QString> &class_list) {
+        QBitArray out(class_count);
+
+        for (const QString &object_class : class_list) {
+            if (class_id_map.contains(object_class)) {
+                out.setBit(class_id_map[object_class]);
+            }
+        }
+
+        return out;
+    };
+
+    // Sets of the class itself, without auxiliary classes
+    // and transitive inferiors
+    QVector<QBitArray> own_optional_list(class_count);
+    QVector<QBitArray> own_mandatory_list(class_count);
+    QVector<QBitArray> auxiliary_list(class_count);
+    QVector<QBitArray> inferiors_list(class_count);
+
+    class_info_list = QVector<ClassInfo>(class_count);
+
+    for (int i = 0; i < class_count; i++) {
+        const QString &object_class = class_name_list[i];
+        const AdObject &schema = class_schemas[object_class];
+
+        own_optional_list[i] = get_attribute_set(schema, {ATTRIBUTE_MAY_CONTAIN, ATTRIBUTE_SYSTEM_MAY_CONTAIN});
+        own_mandatory_list[i] = get_attribute_set(schema, {ATTRIBUTE_MUST_CONTAIN, ATTRIBUTE_SYSTEM_MUST_CONTAIN});
+        auxiliary_list[i] = get_class_set(schema.get_strings(ATTRIBUTE_AUXILIARY_CLASS) + schema.get_strings(ATTRIBUTE_SYSTEM_AUXILIARY_CLASS));
+        inferiors_list[i] = get_class_set(class_possible_inferiors_map.value(object_class));
+
+        class_info_list[i].possible_superiors = get_class_set(schema.get_strings(ATTRIBUTE_POSSIBLE_SUPERIORS) + schema.get_strings(ATTRIBUTE_SYSTEM_POSSIBLE_SUPERIORS));
+    }
+
+    for (int i = 0; i < class_count; i++) {
+        ClassInfo &info = class_info_list[i];
+
+        info.optional_attributes = own_optional_list[i];
+        info.mandatory_attributes = own_mandatory_list[i];
+
+        for (int aux = 0; aux < class_count; aux++) {
+            if (auxiliary_list[i].testBit(aux)) {
+                info.optional_attributes |= own_optional_list[aux];
+                info.mandatory_attributes |= own_mandatory_list[aux];
+            }
+        }
+
+        QBitArray all_inferiors = inferiors_list[i];
+        for (int inferior = 0; inferior < class_count; inferior++) {
+            if (inferiors_list[i].testBit(inferior)) {
+                all_inferiors |= inferiors_list[inferior];
+            }
         }
-        load_permissionable_attributes(inferior, ad);
+
+        info.all_inferiors = all_inferiors;
+
+        // NOTE: inferiors can form loops, for example
+        // container inside container, so expand each
+        // class only once
+        QBitArray transitive_inferiors = inferiors_list[i];
+        QBitArray expanded(class_count);
+
+        while (true) {
+            const QBitArray pending = transitive_inferiors & ~expanded;
+            if (pending.count(true) == 0) {
+                break;
+            }
+
+            for (int inferior = 0; inferior < class_count; inferior++) {
+                if (pending.testBit(inferior)) {
+                    transitive_inferiors |= inferiors_list[inferior];
+                    expanded.setBit(inferior);
+                }
+            }
+        }
+
+        info.transitive_inferiors = transitive_inferiors;
     }
 }
 
-QList<QString> AdConfigPrivate::add_auxiliary_classes(const QList<QString> &object_classes) const {
-    QList<QString> out;
+QBitArray AdConfigPrivate::get_class_set_union(const QList<ObjectClass> &object_classes, QBitArray ClassInfo::*set) const {
+    QBitArray out;
+
+    for (const QString &object_class : object_classes) {
+        const int class_id = class_id_map.value(object_class, -1);
+
+        if (class_id != -1) {
+            out |= class_info_list[class_id].*set;
+        }
+    }
 
-    out += object_classes;
+    return out;
+}
 
-    for (const auto &object_class : object_classes) {
-        const AdObject schema = class_schemas[object_class];
-        out += schema.get_strings(ATTRIBUTE_AUXILIARY_CLASS);
-        out += schema.get_strings(ATTRIBUTE_SYSTEM_AUXILIARY_CLASS);
+QList<Attribute> AdConfigPrivate::attribute_set_to_list(const QBitArray &set) const {
+    AdAttributeTable *attribute_table = AdAttributeTable::instance();
+
+    QList<Attribute> out;
+
+    for (int id = 0; id < set.size(); id++) {
+        if (set.testBit(id)) {
+            out.append(attribute_table->name(id));
+        }
     }
 
-    out.removeDuplicates();
+    return out;
+}
+
+QList<ObjectClass> AdConfigPrivate::class_set_to_list(const QBitArray &set) const {
+    QList<ObjectClass> out;
+
+    for (int class_id = 0; class_id < set.size(); class_id++) {
+        if (set.testBit(class_id)) {
+            out.append(class_name_list[class_id]);
+        }
+    }
 
     return out;
 }
@@ -24,7 +24,10 @@
 /**
  * Provides access to constant server data, which includes
  * configuration data and some DN's. All of the data is
- * loaded once to avoid unnecessary server requests.
+ * loaded once to avoid unnecessary server requests. If
+ * cache path is set, downloaded data is also saved to
+ * disk and reused by next load while schema version stays
+ * the same, see ad_config_cache.h.
  */
 
 #include "ad_defines.h"
@@ -33,12 +36,15 @@
 
 class AdConfigPrivate;
 class AdInterface;
+class AdObject;
 class QLocale;
 class QString;
 class QLineEdit;
 class QByteArray;
 template <typename T>
 class QList;
+template <typename Key, typename T>
+class QHash;
 
 // NOTE: name strings to reduce confusion
 typedef QString ObjectClass;
@@ -50,8 +56,24 @@ public:
     AdConfig();
     ~AdConfig();
 
+    // Directory for cache files. Pass empty path to
+    // disable cache.
+    static void set_cache_path(const QString &path);
+
+    // If enabled, independent phases of load() run in
+    // parallel on separate connections. Phases that are
+    // not needed to show main window, extended rights and
+    // permissionable attributes, finish after load()
+    // returns. Accessors for their data wait until they
+    // are done.
+    static void set_parallel_load_enabled(const bool enabled);
+
     void load(AdInterface &ad, const QLocale &locale);
 
+    // Time in msec that each phase of last load() took.
+    // Deferred phases are added when they finish.
+    QHash<QString, qint64> get_phase_times() const;
+
     QString domain() const;
     QString domain_dn() const;
     QString configuration_dn() const;
@@ -60,6 +82,9 @@ public:
     QString extended_rights_dn() const;
     QString policies_dn() const;
     bool control_is_supported(const QString &control_oid) const;
+    // Server supports sort and virtual list view controls,
+    // needed for AdInterface::search_window()
+    bool window_search_supported() const;
     QString domain_sid() const;
     QString root_domain_dn() const;
 
@@ -68,6 +93,8 @@ public:
     QString get_class_display_name(const ObjectClass &objectClass) const;
 
     QList<Attribute> get_columns() const;
+    // Same as get_columns() but as attribute id's
+    QList<int> get_column_ids() const;
     QString get_column_display_name(const Attribute &attribute) const;
     int get_column_index(const QString &attribute) const;
 
@@ -92,6 +119,21 @@ public:
     bool get_attribute_is_backlink(const Attribute &attribute) const;
     bool get_attribute_is_constructed(const Attribute &attribute) const;
 
+    // Returns id of attribute in AdAttributeTable. All
+    // schema attributes are added to the table when
+    // schema is loaded. Returns ATTRIBUTE_ID_NONE for
+    // unknown attributes. Versions of getters that take
+    // id's are array lookups, use them in hot paths.
+    int get_attribute_id(const Attribute &attribute) const;
+    AttributeType get_attribute_type(const int attribute_id) const;
+    LargeIntegerSubtype get_attribute_large_integer_subtype(const int attribute_id) const;
+    bool get_attribute_is_number(const int attribute_id) const;
+    bool get_attribute_is_single_valued(const int attribute_id) const;
+    bool get_attribute_is_system_only(const int attribute_id) const;
+    int get_attribute_range_upper(const int attribute_id) const;
+    bool get_attribute_is_backlink(const int attribute_id) const;
+    bool get_attribute_is_constructed(const int attribute_id) const;
+
     // Limit's edit's max valid input length based on
     // the upper range defined for attribute in schema
     void limit_edit(QLineEdit *edit, const QString &attribute);
@@ -120,27 +162,49 @@ public:
 
     bool class_is_auxiliary(const QString &obj_class) const;
 
-    // Gets all children class chain for given class
+    // Gets possible inferiors of given class and possible
+    // inferiors of those, two levels deep
     QList<QString> all_inferiors_list(const QString &obj_class) const;
 
+    // Gets classes that can be anywhere below given class,
+    // at any depth
+    QList<QString> transitive_inferiors_list(const QString &obj_class) const;
+
     // Gets all classes, for which there are extended rights
     QList<QString> all_extended_right_classes() const;
 
 private:
-    void load_extended_rights(AdInterface &ad);
-    void load_attribute_schemas(AdInterface &ad);
-    void load_class_schemas(AdInterface &ad);
+    void download_core_phases(AdInterface &ad, const QString &locale_dir);
+    void run_deferred_phases(AdInterface *ad);
+
+    // NOTE: data is loaded in two steps, download and
+    // apply, so that downloaded data can be cached
+    QList<AdObject> download_extended_rights(AdInterface &ad);
+    QList<AdObject> download_attribute_schemas(AdInterface &ad);
+    QList<AdObject> download_class_schemas(AdInterface &ad);
+    QList<AdObject> download_display_specifiers(AdInterface &ad, const QString &locale_dir);
+    AdObject download_columns(AdInterface &ad, const QString &locale_dir);
+    QList<ObjectClass> download_filter_containers(AdInterface &ad, const QString &locale_dir);
+
+    void apply_extended_rights(const QList<AdObject> &object_list);
+    void apply_attribute_schemas(const QList<AdObject> &object_list);
+    void apply_class_schemas(const QList<AdObject> &object_list);
 
     // Loads class and attribute display names
     // NOTE: can't just store objects for these because the values require a decent amount of preprocessing which is best done once here, not everytime value is requested
-    void load_display_names(AdInterface &ad, const QString &locale_dir);
+    void apply_display_names(const QList<AdObject> &object_list);
+
+    void apply_columns(const AdObject &object);
 
-    void load_columns(AdInterface &ad, const QString &locale_dir);
-    void load_filter_containers(AdInterface &ad, const QString &locale_dir);
+    void apply_permissionable_attributes();
 
-    void load_permissionable_attributes(const QString &obj_class, AdInterface &ad);
+    static QString cache_path;
+    static bool parallel_load_enabled;
 
     AdConfigPrivate *d;
+
+    friend class AdConfigRefreshTask;
+    friend class AdConfigDeferredTask;
 };
 
 #endif /* AD_CONFIG_H */
@@ -0,0 +1,137 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_config_cache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+// NOTE: increment this if format of cache file changes
+#define CACHE_FILE_VERSION 2
+
+#define MAX_AGE_MSEC ((qint64) 7 * 24 * 60 * 60 * 1000)
+
+QDataStream &operator<<(QDataStream &stream, const AdObject &object);
+QDataStream &operator>>(QDataStream &stream, AdObject &object);
+
+AdConfigCache::AdConfigCache() {
+    downloaded_at = 0;
+}
+
+bool AdConfigCache::load(const QString &path, const QString &key_arg) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+
+    qint32 version;
+    stream >> version;
+    if (version != CACHE_FILE_VERSION) {
+        return false;
+    }
+
+    // NOTE: check key before reading the rest, so that
+    // outdated cache is rejected quickly
+    QString file_key;
+    stream >> file_key;
+    if (stream.status() != QDataStream::Ok || file_key != key_arg) {
+        return false;
+    }
+
+    AdConfigCache loaded;
+    loaded.key = file_key;
+
+    stream >> loaded.downloaded_at;
+    stream >> loaded.attribute_schema_list;
+    stream >> loaded.class_schema_list;
+    stream >> loaded.display_specifier_list;
+    stream >> loaded.columns_object;
+    stream >> loaded.filter_container_list;
+    stream >> loaded.extended_right_list;
+
+    if (stream.status() != QDataStream::Ok) {
+        qDebug() << "Schema cache file is corrupted:" << path;
+
+        return false;
+    }
+
+    *this = loaded;
+
+    return true;
+}
+
+bool AdConfigCache::save(const QString &path) const {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open schema cache file for writing:" << path;
+
+        return false;
+    }
+
+    QDataStream stream(&file);
+
+    stream << (qint32) CACHE_FILE_VERSION;
+    stream << key;
+    stream << downloaded_at;
+    stream << attribute_schema_list;
+    stream << class_schema_list;
+    stream << display_specifier_list;
+    stream << columns_object;
+    stream << filter_container_list;
+    stream << extended_right_list;
+
+    if (!file.commit()) {
+        qDebug() << "Failed to save schema cache file:" << path;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool AdConfigCache::is_old() const {
+    const qint64 age = QDateTime::currentMSecsSinceEpoch() - downloaded_at;
+
+    return (age > MAX_AGE_MSEC);
+}
+
+QDataStream &operator<<(QDataStream &stream, const AdObject &object) {
+    stream << object.get_dn() << object.get_attributes_data();
+
+    return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, AdObject &object) {
+    QString dn;
+    QHash<QString, QList<QByteArray>> attributes_data;
+    stream >> dn >> attributes_data;
+
+    object.load(dn, attributes_data);
+
+    return stream;
+}
@@ -0,0 +1,65 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_CONFIG_CACHE_H
+#define AD_CONFIG_CACHE_H
+
+/**
+ * Data that AdConfig::load() downloads from server, before
+ * it is processed. Can be saved to disk, so that next
+ * launch can skip downloading schema, display specifiers
+ * and extended rights. Cache is valid only for the key it
+ * was saved with, which includes everything that the data
+ * depends on: domain, locale and schema version.
+ */
+
+#include "ad_object.h"
+
+#include <QList>
+#include <QString>
+
+class AdConfigCache {
+
+public:
+    AdConfigCache();
+
+    QString key;
+    // Time when data was downloaded, msecs since epoch
+    qint64 downloaded_at;
+
+    QList<AdObject> attribute_schema_list;
+    QList<AdObject> class_schema_list;
+    QList<AdObject> display_specifier_list;
+    // Display specifier that contains extra columns
+    AdObject columns_object;
+    QList<QString> filter_container_list;
+    QList<AdObject> extended_right_list;
+
+    // Returns false if file doesn't exist, is corrupted,
+    // has an old format or a different key
+    bool load(const QString &path, const QString &key_arg);
+    bool save(const QString &path) const;
+
+    // Data that is older than this may miss changes to
+    // display specifiers and extended rights, which
+    // don't change schema version
+    bool is_old() const;
+};
+
+#endif /* AD_CONFIG_CACHE_H */
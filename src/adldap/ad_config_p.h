@@ -21,17 +21,63 @@
 #ifndef AD_CONFIG_P_H
 #define AD_CONFIG_P_H
 
+#include "ad_config_cache.h"
 #include "ad_object.h"
 
+#include <QBitArray>
 #include <QByteArray>
 #include <QHash>
 #include <QList>
+#include <QMutex>
+#include <QSemaphore>
+#include <QSet>
 #include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <functional>
 
 // NOTE: name strings to reduce confusion
 typedef QString ObjectClass;
 typedef QString Attribute;
 
+// Schema data of an attribute, computed once when schema
+// is loaded
+class AttributeInfo {
+
+public:
+    AttributeInfo();
+
+    bool is_loaded;
+    AttributeType type;
+    LargeIntegerSubtype large_integer_subtype;
+    bool is_single_valued;
+    bool is_system_only;
+    int range_upper;
+    bool is_backlink;
+    bool is_constructed;
+    QByteArray guid;
+};
+
+// Schema data of a class, computed once when schema is
+// loaded. Attribute sets are indexed by attribute id's
+// from AdAttributeTable, class sets by class id's.
+class ClassInfo {
+
+public:
+    // Attributes of the class and its auxiliary classes
+    QBitArray optional_attributes;
+    QBitArray mandatory_attributes;
+
+    QBitArray possible_superiors;
+
+    // Possible inferiors and their possible inferiors
+    QBitArray all_inferiors;
+
+    // Possible inferiors, their possible inferiors and
+    // so on
+    QBitArray transitive_inferiors;
+};
+
 class AdConfigPrivate {
 
 public:
@@ -56,7 +102,31 @@ public:
     QHash<Attribute, AdObject> attribute_schemas;
     QHash<ObjectClass, AdObject> class_schemas;
 
-    QList<ObjectClass> add_auxiliary_classes(const QList<QString> &object_classes) const;
+    // NOTE: indexed by attribute id's from
+    // AdAttributeTable, so lookups don't need to hash
+    // attribute names
+    QVector<AttributeInfo> attribute_info_list;
+    QList<int> column_ids;
+
+    // Returns default info for attributes that are not
+    // in schema
+    const AttributeInfo &get_attribute_info(const int attribute_id) const;
+
+    // NOTE: class id's are dense, so that sets of classes
+    // can be bit arrays
+    QHash<ObjectClass, int> class_id_map;
+    QList<ObjectClass> class_name_list;
+    QVector<ClassInfo> class_info_list;
+
+    void build_class_index();
+
+    // Returns union of given set of all classes. Classes
+    // that are not in schema are skipped.
+    QBitArray get_class_set_union(const QList<ObjectClass> &object_classes, QBitArray ClassInfo::*set) const;
+    QList<Attribute> attribute_set_to_list(const QBitArray &set) const;
+    QList<ObjectClass> class_set_to_list(const QBitArray &set) const;
+
+    QSet<QString> get_allowed_attributes(const QString &obj_class, QHash<QString, QSet<QString>> *allowed_attributes_map) const;
 
     QHash<QString, QByteArray> right_to_guid_map;
     QHash<QByteArray, QString> right_guid_to_cn_map;
@@ -79,6 +149,35 @@ public:
     // Contains editable attributes for the object class and its child classes.
     // Used when assigning custom permissions.
     QHash<QString, QStringList> class_permissionable_attributes_map;
+
+    // Always download data and overwrite cache. Used to
+    // refresh cache in background.
+    bool skip_cache;
+
+    // Data of current load(), downloaded or read from
+    // cache. Shared with deferred phases.
+    AdConfigCache load_data;
+    bool deferred_download_extended_rights;
+    // Deferred phases save cache to this file when they
+    // are done. Empty if cache shouldn't be saved.
+    QString deferred_cache_file;
+    // Released by load() when core phases are applied, so
+    // that deferred phases can use schema
+    QSemaphore core_semaphore;
+
+    // NOTE: protects phase times and deferred state,
+    // which are accessed by multiple threads
+    QMutex phase_mutex;
+    QWaitCondition deferred_wait_condition;
+    bool deferred_running;
+    QHash<QString, qint64> phase_time_map;
+
+    // Runs f-n and records how long it took
+    void run_phase(const QString &name, const std::function<void()> &function);
+
+    // Accessors for data loaded by deferred phases call
+    // this before reading it
+    void wait_for_deferred_phases();
 };
 
 #endif /* AD_CONFIG_P_H */
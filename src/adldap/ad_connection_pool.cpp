@@ -0,0 +1,281 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_connection_pool.h"
+
+#include <ldap.h>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+// NOTE: handles that were returned very recently are
+// trusted without a health check, to avoid an extra
+// round trip when AdInterface's are created in quick
+// succession
+#define TRUST_WITHOUT_CHECK_MSEC (5 * 1000)
+
+// NOTE: AD drops connections that are idle for longer than
+// MaxConnIdleTime, which is 15 minutes by default. Don't
+// bother checking handles that are older than that.
+#define MAX_IDLE_AGE_MSEC (10 * 60 * 1000)
+
+#define HEALTH_CHECK_TIMEOUT_SEC 2
+#define DEFAULT_MAX_IDLE 4
+
+AdConnectionPoolStats::AdConnectionPoolStats() {
+    idle_count = 0;
+    in_use_count = 0;
+    hit_count = 0;
+    miss_count = 0;
+    connect_count = 0;
+    discard_count = 0;
+    wait_msec_total = 0;
+    connect_msec_total = 0;
+}
+
+double AdConnectionPoolStats::hit_rate() const {
+    const int total = hit_count + miss_count;
+
+    if (total > 0) {
+        return (double) hit_count / total;
+    } else {
+        return 0;
+    }
+}
+
+double AdConnectionPoolStats::wait_msec_average() const {
+    if (hit_count > 0) {
+        return (double) wait_msec_total / hit_count;
+    } else {
+        return 0;
+    }
+}
+
+double AdConnectionPoolStats::connect_msec_average() const {
+    if (connect_count > 0) {
+        return (double) connect_msec_total / connect_count;
+    } else {
+        return 0;
+    }
+}
+
+AdConnectionPool *AdConnectionPool::instance() {
+    static AdConnectionPool pool;
+
+    return &pool;
+}
+
+AdConnectionPool::AdConnectionPool() {
+    m_enabled = true;
+    m_max_idle = DEFAULT_MAX_IDLE;
+}
+
+AdConnectionPool::~AdConnectionPool() {
+    clear();
+}
+
+LDAP *AdConnectionPool::acquire(const QString &key, QString *client_user_out) {
+    QElapsedTimer timer;
+    timer.start();
+
+    while (true) {
+        IdleHandle handle;
+
+        {
+            QMutexLocker locker(&mutex);
+
+            if (!m_enabled) {
+                return NULL;
+            }
+
+            if (!idle_map.contains(key) || idle_map[key].isEmpty()) {
+                idle_map.remove(key);
+                m_stats.miss_count++;
+
+                return NULL;
+            }
+
+            // NOTE: take most recently used handle because
+            // it's the one most likely to still be alive
+            handle = idle_map[key].takeLast();
+        }
+
+        // NOTE: health check is done outside of lock
+        // because it involves a server request
+        const qint64 idle_msec = QDateTime::currentMSecsSinceEpoch() - handle.released_at;
+        const bool is_healthy = [&]() {
+            if (idle_msec > MAX_IDLE_AGE_MSEC) {
+                return false;
+            } else if (idle_msec < TRUST_WITHOUT_CHECK_MSEC) {
+                return true;
+            } else {
+                return ldap_handle_is_healthy(handle.ld, HEALTH_CHECK_TIMEOUT_SEC);
+            }
+        }();
+
+        if (!is_healthy) {
+            ldap_unbind_ext(handle.ld, NULL, NULL);
+
+            QMutexLocker locker(&mutex);
+            m_stats.discard_count++;
+
+            continue;
+        }
+
+        QMutexLocker locker(&mutex);
+        m_stats.hit_count++;
+        m_stats.in_use_count++;
+        m_stats.wait_msec_total += timer.elapsed();
+
+        *client_user_out = handle.client_user;
+
+        return handle.ld;
+    }
+}
+
+void AdConnectionPool::release(const QString &key, LDAP *ld, const QString &client_user) {
+    if (ld == NULL) {
+        return;
+    }
+
+    bool keep_handle;
+
+    {
+        QMutexLocker locker(&mutex);
+
+        m_stats.in_use_count--;
+
+        keep_handle = (m_enabled && idle_count() < m_max_idle);
+
+        if (keep_handle) {
+            IdleHandle handle;
+            handle.ld = ld;
+            handle.client_user = client_user;
+            handle.released_at = QDateTime::currentMSecsSinceEpoch();
+
+            idle_map[key].append(handle);
+        }
+    }
+
+    if (!keep_handle) {
+        ldap_unbind_ext(ld, NULL, NULL);
+    }
+}
+
+void AdConnectionPool::discard(LDAP *ld) {
+    if (ld == NULL) {
+        return;
+    }
+
+    ldap_unbind_ext(ld, NULL, NULL);
+
+    QMutexLocker locker(&mutex);
+    m_stats.in_use_count--;
+    m_stats.discard_count++;
+}
+
+void AdConnectionPool::add_connected(const qint64 connect_msec) {
+    QMutexLocker locker(&mutex);
+
+    m_stats.in_use_count++;
+    m_stats.connect_count++;
+    m_stats.connect_msec_total += connect_msec;
+}
+
+void AdConnectionPool::clear() {
+    QList<LDAP *> handle_list;
+
+    {
+        QMutexLocker locker(&mutex);
+
+        for (const QList<IdleHandle> &list : idle_map) {
+            for (const IdleHandle &handle : list) {
+                handle_list.append(handle.ld);
+            }
+        }
+
+        idle_map.clear();
+    }
+
+    for (LDAP *ld : handle_list) {
+        ldap_unbind_ext(ld, NULL, NULL);
+    }
+}
+
+void AdConnectionPool::set_enabled(const bool enabled) {
+    {
+        QMutexLocker locker(&mutex);
+        m_enabled = enabled;
+    }
+
+    if (!enabled) {
+        clear();
+    }
+}
+
+bool AdConnectionPool::enabled() const {
+    QMutexLocker locker(&mutex);
+
+    return m_enabled;
+}
+
+void AdConnectionPool::set_max_idle(const int max_idle) {
+    QMutexLocker locker(&mutex);
+
+    m_max_idle = max_idle;
+}
+
+AdConnectionPoolStats AdConnectionPool::stats() const {
+    QMutexLocker locker(&mutex);
+
+    AdConnectionPoolStats out = m_stats;
+    out.idle_count = idle_count();
+
+    return out;
+}
+
+// NOTE: mutex must be locked when calling this
+int AdConnectionPool::idle_count() const {
+    int out = 0;
+
+    for (const QList<IdleHandle> &list : idle_map) {
+        out += list.size();
+    }
+
+    return out;
+}
+
+bool ldap_handle_is_healthy(LDAP *ld, const int timeout_sec) {
+    struct timeval timeout;
+    timeout.tv_sec = timeout_sec;
+    timeout.tv_usec = 0;
+
+    // NOTE: "1.1" means "no attributes", so server sends
+    // back only the entry itself
+    char *attributes[] = {(char *) LDAP_NO_ATTRS, NULL};
+    const int attrsonly = 1;
+    const int size_limit = 1;
+
+    LDAPMessage *res = NULL;
+    const int result = ldap_search_ext_s(ld, "", LDAP_SCOPE_BASE, "(objectClass=*)", attributes, attrsonly, NULL, NULL, &timeout, size_limit, &res);
+    ldap_msgfree(res);
+
+    return (result == LDAP_SUCCESS);
+}
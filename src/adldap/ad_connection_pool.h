@@ -0,0 +1,131 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_CONNECTION_POOL_H
+#define AD_CONNECTION_POOL_H
+
+/**
+ * Pool of already bound LDAP handles. AdInterface takes a
+ * handle from the pool when it is constructed and gives it
+ * back when it is destroyed, so that DNS discovery and
+ * GSSAPI bind are only performed when there are no idle
+ * handles left. Handles are keyed by connection options
+ * (domain, DC, port, etc), so a handle is never reused
+ * after connection options change. Pool is shared by all
+ * threads, but each handle is only used by one AdInterface
+ * at a time.
+ */
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+typedef struct ldap LDAP;
+
+class AdConnectionPoolStats {
+public:
+    AdConnectionPoolStats();
+
+    // Handles that are bound and waiting to be reused
+    int idle_count;
+    // Handles that are currently owned by AdInterface's
+    int in_use_count;
+    // Number of times AdInterface got a handle from pool
+    int hit_count;
+    // Number of times AdInterface asked pool for a handle
+    // and pool had none
+    int miss_count;
+    // Number of handles that were connected and bound
+    // outside of the pool. Not the same as misses, because
+    // AdInterface also connects without asking pool, for
+    // example when switching DC's.
+    int connect_count;
+    // Handles dropped because they failed health check
+    // or idled for too long
+    int discard_count;
+    // Total time spent getting handles from the pool,
+    // including health checks
+    qint64 wait_msec_total;
+    // Total time spent connecting and binding new handles
+    qint64 connect_msec_total;
+
+    double hit_rate() const;
+    double wait_msec_average() const;
+    double connect_msec_average() const;
+};
+
+class AdConnectionPool {
+
+public:
+    static AdConnectionPool *instance();
+
+    ~AdConnectionPool();
+
+    // Returns a healthy bound handle for given key or NULL
+    // if there are none. Client user that was saved
+    // together with the handle is written to
+    // "client_user_out".
+    LDAP *acquire(const QString &key, QString *client_user_out);
+
+    // Returns handle to the pool. If pool already holds
+    // max amount of idle handles, then handle is unbound
+    // instead.
+    void release(const QString &key, LDAP *ld, const QString &client_user);
+
+    // Handle is broken or was never bound, so unbind it
+    // without returning to pool
+    void discard(LDAP *ld);
+
+    // Call this after a new handle was bound outside of the
+    // pool, so that it's counted as in use
+    void add_connected(const qint64 connect_msec);
+
+    void clear();
+
+    void set_enabled(const bool enabled);
+    bool enabled() const;
+    void set_max_idle(const int max_idle);
+
+    AdConnectionPoolStats stats() const;
+
+private:
+    class IdleHandle {
+    public:
+        LDAP *ld;
+        QString client_user;
+        qint64 released_at;
+    };
+
+    mutable QMutex mutex;
+    QHash<QString, QList<IdleHandle>> idle_map;
+    AdConnectionPoolStats m_stats;
+    bool m_enabled;
+    int m_max_idle;
+
+    AdConnectionPool();
+
+    int idle_count() const;
+};
+
+// Performs a cheap rootDSE read to check that handle is
+// still usable
+bool ldap_handle_is_healthy(LDAP *ld, const int timeout_sec);
+
+#endif /* AD_CONNECTION_POOL_H */
@@ -0,0 +1,392 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_dc_cache.h"
+
+#include <resolv.h>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThreadPool>
+
+#ifdef __GNUC__
+#define UNUSED(x) x __attribute__((unused))
+#else
+#define UNUSED(x) x
+#endif
+
+// NOTE: increment this if format of cache file changes
+#define CACHE_FILE_VERSION 1
+
+// NOTE: SRV records for DC's in AD have TTL of 600 by
+// default. Clamp TTL from below so that misconfigured
+// records with TTL of 0 don't disable caching.
+#define MIN_TTL_SEC 60
+
+// NOTE: if entry is expired for longer than this, it's
+// considered too old to be returned while refreshing in
+// background, so caller has to wait for DNS
+#define MAX_STALE_SEC (24 * 60 * 60)
+
+class AdDcCacheRefreshTask final : public QRunnable {
+public:
+    AdDcCacheRefreshTask(const QString &srv_name_arg) {
+        srv_name = srv_name_arg;
+    }
+
+    void run() override {
+        AdDcCache::instance()->refresh(srv_name);
+    }
+
+private:
+    QString srv_name;
+};
+
+AdDcCache *AdDcCache::instance() {
+    static AdDcCache cache;
+
+    return &cache;
+}
+
+AdDcCache::AdDcCache() {
+    save_generation = 0;
+    saved_generation = 0;
+}
+
+QList<QString> AdDcCache::get_hosts(const QString &srv_name) {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    {
+        QMutexLocker locker(&mutex);
+
+        if (entry_map.contains(srv_name)) {
+            const Entry entry = entry_map[srv_name];
+
+            const bool is_fresh = (now < entry.expires_at);
+            if (is_fresh) {
+                return entry.hosts;
+            }
+
+            const bool too_stale = (now - entry.expires_at > (qint64) MAX_STALE_SEC * 1000);
+            if (!too_stale) {
+                locker.unlock();
+
+                start_background_refresh(srv_name);
+
+                return entry.hosts;
+            }
+        }
+    }
+
+    return refresh(srv_name);
+}
+
+QList<QString> AdDcCache::refresh(const QString &srv_name) {
+    {
+        QMutexLocker locker(&mutex);
+
+        // NOTE: when there's no entry, every connection
+        // made at the same time ends up here, so only one
+        // of them sends the query
+        if (query_set.contains(srv_name)) {
+            while (query_set.contains(srv_name)) {
+                query_done.wait(&mutex);
+            }
+
+            return entry_map.value(srv_name).hosts;
+        }
+
+        query_set.insert(srv_name);
+    }
+
+    int ttl;
+    const QByteArray srv_name_bytes = srv_name.toUtf8();
+    const QList<QString> hosts = query_server_for_hosts(srv_name_bytes.constData(), &ttl);
+
+    QMutexLocker locker(&mutex);
+
+    refreshing_set.remove(srv_name);
+    query_set.remove(srv_name);
+    query_done.wakeAll();
+
+    // NOTE: don't cache failed queries. If there's an old
+    // entry, keep it, because it's better than nothing.
+    if (hosts.isEmpty()) {
+        if (entry_map.contains(srv_name)) {
+            return entry_map[srv_name].hosts;
+        } else {
+            return hosts;
+        }
+    }
+
+    Entry entry;
+    entry.hosts = hosts;
+    entry.expires_at = QDateTime::currentMSecsSinceEpoch() + (qint64) qMax(ttl, MIN_TTL_SEC) * 1000;
+
+    entry_map[srv_name] = entry;
+
+    // NOTE: save a copy after unlocking, so that other
+    // threads don't wait for file I/O
+    const QHash<QString, Entry> entry_map_copy = entry_map;
+    const QString path = persist_path;
+    save_generation++;
+    const int generation = save_generation;
+
+    locker.unlock();
+
+    save(path, entry_map_copy, generation);
+
+    return hosts;
+}
+
+void AdDcCache::set_persist_path(const QString &path) {
+    QMutexLocker locker(&mutex);
+
+    persist_path = path;
+
+    if (!persist_path.isEmpty()) {
+        load();
+    }
+}
+
+void AdDcCache::clear() {
+    QMutexLocker locker(&mutex);
+
+    entry_map.clear();
+
+    const QString path = persist_path;
+    save_generation++;
+    const int generation = save_generation;
+
+    locker.unlock();
+
+    save(path, QHash<QString, Entry>(), generation);
+}
+
+void AdDcCache::start_background_refresh(const QString &srv_name) {
+    {
+        QMutexLocker locker(&mutex);
+
+        if (refreshing_set.contains(srv_name)) {
+            return;
+        }
+
+        refreshing_set.insert(srv_name);
+    }
+
+    QThreadPool::globalInstance()->start(new AdDcCacheRefreshTask(srv_name));
+}
+
+// NOTE: mutex must be locked when calling this
+void AdDcCache::load() {
+    QFile file(persist_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+
+    qint32 version;
+    stream >> version;
+    if (version != CACHE_FILE_VERSION) {
+        return;
+    }
+
+    qint32 count;
+    stream >> count;
+
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString srv_name;
+        Entry entry;
+        stream >> srv_name >> entry.hosts >> entry.expires_at;
+
+        // NOTE: entries that were updated in this session
+        // are newer than what's on disk
+        if (stream.status() == QDataStream::Ok && !entry_map.contains(srv_name)) {
+            entry_map[srv_name] = entry;
+        }
+    }
+}
+
+// NOTE: mutex must NOT be locked when calling this. Saves
+// from different threads may finish out of order, so a
+// save is skipped if a newer one was already done.
+// Saving an empty map removes the file.
+void AdDcCache::save(const QString &path, const QHash<QString, Entry> &entry_map_arg, const int generation) {
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker save_locker(&save_mutex);
+
+    if (generation <= saved_generation) {
+        return;
+    }
+
+    saved_generation = generation;
+
+    if (entry_map_arg.isEmpty()) {
+        QFile::remove(path);
+
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open DC cache file for writing:" << path;
+
+        return;
+    }
+
+    QDataStream stream(&file);
+
+    stream << (qint32) CACHE_FILE_VERSION;
+    stream << (qint32) entry_map_arg.size();
+
+    for (auto it = entry_map_arg.begin(); it != entry_map_arg.end(); it++) {
+        const Entry &entry = it.value();
+
+        stream << it.key() << entry.hosts << entry.expires_at;
+    }
+
+    if (!file.commit()) {
+        qDebug() << "Failed to save DC cache file:" << path;
+    }
+}
+
+/**
+ * Perform a query for dname and output hosts
+ * dname is a combination of protocols (d->ldap, tcp), domain and site
+ * NOTE: this is rewritten from
+ * https://github.com/paleg/libadclient/blob/master/adclient.cpp
+ * which itself is copied from
+ * https://www.ccnx.org/releases/latest/doc/ccode/html/ccndc-srv_8c_source.html
+ * Another example of similar procedure:
+ * https://www.gnu.org/software/shishi/coverage/shishi/lib/resolv.c.gcov.html
+ */
+QList<QString> query_server_for_hosts(const char *dname, int *ttl_out) {
+    union dns_msg {
+        HEADER header;
+        unsigned char buf[NS_MAXMSG];
+    } msg;
+
+    *ttl_out = 0;
+
+    const int msg_len = res_search(dname, ns_c_in, ns_t_srv, msg.buf, sizeof(msg.buf));
+
+    // NOTE: res_search() returns -1 on error
+    const bool message_error = (msg_len < (int) sizeof(HEADER));
+    if (message_error) {
+        return QList<QString>();
+    }
+
+    const int packet_count = ntohs(msg.header.qdcount);
+    const int answer_count = ntohs(msg.header.ancount);
+
+    unsigned char *curr = msg.buf + sizeof(msg.header);
+    const unsigned char *eom = msg.buf + msg_len;
+
+    // Skip over packet records
+    for (int i = packet_count; i > 0 && curr < eom; i--) {
+        const int packet_len = dn_skipname(curr, eom);
+
+        const bool packet_error = (packet_len < 0);
+        if (packet_error) {
+            return QList<QString>();
+        }
+
+        curr = curr + packet_len + QFIXEDSZ;
+    }
+
+    QList<QString> hosts;
+    int min_ttl = -1;
+
+    // Process answers by collecting hosts into list
+    for (int i = 0; i < answer_count; i++) {
+        // Get server
+        char server[NS_MAXDNAME];
+        const int server_len = dn_expand(msg.buf, eom, curr, server, sizeof(server));
+
+        const bool server_error = (server_len < 0);
+        if (server_error) {
+            break;
+        }
+
+        curr = curr + server_len;
+
+        int record_type;
+        int UNUSED(record_class);
+        int ttl;
+        int record_len;
+        GETSHORT(record_type, curr);
+        GETSHORT(record_class, curr);
+        GETLONG(ttl, curr);
+        GETSHORT(record_len, curr);
+
+        unsigned char *record_end = curr + record_len;
+        if (record_end > eom) {
+            break;
+        }
+
+        // Skip non-server records
+        if (record_type != ns_t_srv) {
+            curr = record_end;
+
+            continue;
+        }
+
+        int UNUSED(priority);
+        int UNUSED(weight);
+        int UNUSED(port);
+        GETSHORT(priority, curr);
+        GETSHORT(weight, curr);
+        GETSHORT(port, curr);
+
+        // Get host
+        char host[NS_MAXDNAME];
+        const int host_len = dn_expand(msg.buf, eom, curr, host, sizeof(host));
+        const bool host_error = (host_len < 0);
+        if (host_error) {
+            break;
+        }
+
+        hosts.append(QString(host));
+
+        if (min_ttl < 0 || ttl < min_ttl) {
+            min_ttl = ttl;
+        }
+
+        curr = record_end;
+    }
+
+    if (min_ttl > 0) {
+        *ttl_out = min_ttl;
+    }
+
+    return hosts;
+}
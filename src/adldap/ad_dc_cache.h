@@ -0,0 +1,96 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_DC_CACHE_H
+#define AD_DC_CACHE_H
+
+/**
+ * Cache for results of DNS SRV queries used to discover
+ * domain controllers. Entries expire according to TTL's of
+ * SRV records. Expired entries are still returned, but a
+ * refresh is started in the background, so that callers
+ * only wait for DNS when there is no entry at all.
+ * Optionally, cache is saved to disk so that entries
+ * survive app restarts.
+ */
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QWaitCondition>
+
+class AdDcCache {
+
+public:
+    static AdDcCache *instance();
+
+    // Returns hosts for given SRV record name, for
+    // example "_ldap._tcp.domain.com"
+    QList<QString> get_hosts(const QString &srv_name);
+
+    // Performs DNS query and updates cache entry. Blocks
+    // until query is finished. If a query for same name is
+    // already in progress, waits for it and returns it's
+    // result instead of sending another query.
+    QList<QString> refresh(const QString &srv_name);
+
+    // Setting a path loads cache from that file, if it
+    // exists, and saves to it after every update. Pass
+    // empty path to disable persistence.
+    void set_persist_path(const QString &path);
+
+    void clear();
+
+private:
+    class Entry {
+    public:
+        QList<QString> hosts;
+        qint64 expires_at;
+    };
+
+    QMutex mutex;
+    QHash<QString, Entry> entry_map;
+    // Names for which background refresh was started
+    QSet<QString> refreshing_set;
+    // Names for which DNS query is in progress
+    QSet<QString> query_set;
+    QWaitCondition query_done;
+    QString persist_path;
+    // Saves are numbered, so that an older save that
+    // finishes late doesn't overwrite a newer one.
+    // "saved_generation" is guarded by "save_mutex", which
+    // is separate so that file I/O doesn't block lookups.
+    int save_generation;
+    QMutex save_mutex;
+    int saved_generation;
+
+    AdDcCache();
+
+    void start_background_refresh(const QString &srv_name);
+    void load();
+    void save(const QString &path, const QHash<QString, Entry> &entry_map_arg, const int generation);
+};
+
+// Performs a DNS SRV query and returns target hosts.
+// "ttl_out" is set to the smallest TTL among answers.
+QList<QString> query_server_for_hosts(const char *dname, int *ttl_out);
+
+#endif /* AD_DC_CACHE_H */
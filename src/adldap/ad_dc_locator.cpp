@@ -0,0 +1,305 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_dc_locator.h"
+
+#include "ad_interface.h"
+
+#include <ldap.h>
+#include <resolv.h>
+
+#include <QDateTime>
+#include <QDebug>
+#include <QMutexLocker>
+
+// NOTE: site of a client only changes if it moves to
+// another subnet, so cache it for a long time. Failures
+// are cached for a shorter time so that a temporary outage
+// doesn't disable site awareness for long.
+#define SITE_TTL_MSEC (60 * 60 * 1000)
+#define SITE_FAILURE_TTL_MSEC (5 * 60 * 1000)
+#define DC_FAILURE_TTL_MSEC (5 * 60 * 1000)
+
+#define PING_TIMEOUT_SEC 1
+#define PING_MAX_DC_COUNT 3
+
+// NOTE: NtVer flags, see MS-ADTS 6.3.1.1. V5EX is required
+// to get NETLOGON_SAM_LOGON_RESPONSE_EX, which contains
+// client site.
+#define NETLOGON_NT_VERSION_5 0x00000002
+#define NETLOGON_NT_VERSION_5EX 0x00000004
+
+#define LOGON_SAM_LOGON_RESPONSE_EX 23
+#define LOGON_SAM_USER_UNKNOWN_EX 25
+
+// Opcode, Sbz, Flags and DomainGuid
+#define NETLOGON_HEADER_SIZE (2 + 2 + 4 + 16)
+// NtVersion, LmNtToken and Lm20Token
+#define NETLOGON_TRAILER_SIZE (4 + 2 + 2)
+
+AdNetlogonResponse::AdNetlogonResponse() {
+    flags = 0;
+}
+
+AdDcLocator *AdDcLocator::instance() {
+    static AdDcLocator locator;
+
+    return &locator;
+}
+
+AdDcLocator::AdDcLocator() {
+    m_enabled = false;
+}
+
+QString AdDcLocator::get_client_site(const QString &domain) {
+    if (!enabled() || domain.isEmpty()) {
+        return QString();
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    {
+        QMutexLocker locker(&mutex);
+
+        while (pending_set.contains(domain)) {
+            pending_done.wait(&mutex);
+        }
+
+        if (entry_map.contains(domain) && now < entry_map[domain].expires_at) {
+            return entry_map[domain].site;
+        }
+
+        pending_set.insert(domain);
+    }
+
+    // NOTE: any DC can answer the ping, because all of
+    // them know the site topology. Try a few of them in
+    // case some are down.
+    const QList<QString> dc_list = get_domain_hosts(domain, QString()).mid(0, PING_MAX_DC_COUNT);
+
+    // NOTE: each DC that doesn't reply costs a full ping
+    // timeout, so skip DC's that recently failed to reply
+    const QList<QString> ping_dc_list = [&]() {
+        QMutexLocker locker(&mutex);
+
+        QList<QString> out;
+
+        for (const QString &dc : dc_list) {
+            if (now >= failed_dc_map.value(dc, 0)) {
+                out.append(dc);
+            }
+        }
+
+        return out;
+    }();
+
+    bool ping_success = false;
+    AdNetlogonResponse response;
+    for (const QString &dc : ping_dc_list) {
+        ping_success = cldap_netlogon_ping(dc, domain, PING_TIMEOUT_SEC, &response);
+
+        if (ping_success) {
+            break;
+        }
+
+        QMutexLocker locker(&mutex);
+        failed_dc_map[dc] = now + DC_FAILURE_TTL_MSEC;
+    }
+
+    if (!ping_success) {
+        qDebug() << "Failed to determine client site for domain" << domain;
+    }
+
+    Entry entry;
+    entry.site = response.client_site;
+    entry.expires_at = now + (ping_success ? SITE_TTL_MSEC : SITE_FAILURE_TTL_MSEC);
+
+    QMutexLocker locker(&mutex);
+    entry_map[domain] = entry;
+    pending_set.remove(domain);
+    pending_done.wakeAll();
+
+    return entry.site;
+}
+
+void AdDcLocator::clear() {
+    QMutexLocker locker(&mutex);
+
+    entry_map.clear();
+    failed_dc_map.clear();
+}
+
+void AdDcLocator::set_enabled(const bool enabled) {
+    QMutexLocker locker(&mutex);
+
+    m_enabled = enabled;
+}
+
+bool AdDcLocator::enabled() const {
+    QMutexLocker locker(&mutex);
+
+    return m_enabled;
+}
+
+bool cldap_netlogon_ping(const QString &dc, const QString &domain, const int timeout_sec, AdNetlogonResponse *out) {
+    // NOTE: "cldap" scheme makes libldap use UDP. Netlogon
+    // ping is an anonymous rootDSE search, so no bind is
+    // needed.
+    const QByteArray uri = QString("cldap://%1").arg(dc).toUtf8();
+
+    LDAP *ld = NULL;
+    int result = ldap_initialize(&ld, uri.constData());
+    if (result != LDAP_SUCCESS) {
+        return false;
+    }
+
+    const int version = LDAP_VERSION3;
+    ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+
+    const int nt_version = NETLOGON_NT_VERSION_5 | NETLOGON_NT_VERSION_5EX;
+    const QString nt_version_escaped = QString("\\%1\\00\\00\\00").arg(nt_version, 2, 16, QChar('0'));
+    const QByteArray filter = QString("(&(DnsDomain=%1)(NtVer=%2))").arg(domain, nt_version_escaped).toUtf8();
+
+    char *attributes[] = {(char *) "NetLogon", NULL};
+    const int attrsonly = 0;
+
+    int msgid;
+    result = ldap_search_ext(ld, "", LDAP_SCOPE_BASE, filter.constData(), attributes, attrsonly, NULL, NULL, NULL, 1, &msgid);
+    if (result != LDAP_SUCCESS) {
+        ldap_unbind_ext(ld, NULL, NULL);
+
+        return false;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = timeout_sec;
+    timeout.tv_usec = 0;
+
+    LDAPMessage *res = NULL;
+    const int wait_result = ldap_result(ld, msgid, LDAP_MSG_ALL, &timeout, &res);
+
+    const QByteArray blob = [&]() {
+        QByteArray blob_out;
+
+        if (wait_result <= 0) {
+            return blob_out;
+        }
+
+        LDAPMessage *entry = ldap_first_entry(ld, res);
+        if (entry == NULL) {
+            return blob_out;
+        }
+
+        struct berval **values = ldap_get_values_len(ld, entry, "NetLogon");
+        if (values != NULL && ldap_count_values_len(values) > 0) {
+            blob_out = QByteArray(values[0]->bv_val, values[0]->bv_len);
+        }
+
+        ldap_value_free_len(values);
+
+        return blob_out;
+    }();
+
+    ldap_msgfree(res);
+    ldap_unbind_ext(ld, NULL, NULL);
+
+    if (blob.isEmpty()) {
+        return false;
+    }
+
+    return netlogon_response_parse(blob, out);
+}
+
+bool netlogon_response_parse(const QByteArray &blob, AdNetlogonResponse *out) {
+    if (blob.size() < NETLOGON_HEADER_SIZE) {
+        return false;
+    }
+
+    const unsigned char *start = (const unsigned char *) blob.constData();
+    const unsigned char *end = start + blob.size();
+
+    // NOTE: integers are little endian
+    const int opcode = start[0] | (start[1] << 8);
+    if (opcode != LOGON_SAM_LOGON_RESPONSE_EX && opcode != LOGON_SAM_USER_UNKNOWN_EX) {
+        return false;
+    }
+
+    out->flags = (int) (start[4] | (start[5] << 8) | (start[6] << 16) | ((unsigned) start[7] << 24));
+
+    // NOTE: names are compressed the same way as in DNS
+    // messages, with pointers relative to start of the
+    // structure, so dn_expand() can decode them
+    const unsigned char *curr = start + NETLOGON_HEADER_SIZE;
+    bool parse_error = false;
+
+    auto read_name = [&]() {
+        if (parse_error) {
+            return QString();
+        }
+
+        char name[NS_MAXDNAME];
+        const int name_len = dn_expand(start, end, curr, name, sizeof(name));
+        if (name_len < 0) {
+            parse_error = true;
+
+            return QString();
+        }
+
+        curr += name_len;
+
+        // NOTE: empty names are encoded as root, which
+        // some resolver libraries decode as "."
+        const QString out = QString::fromUtf8(name);
+        if (out == ".") {
+            return QString();
+        }
+
+        return out;
+    };
+
+    // NOTE: order of reads matters
+    out->forest = read_name();
+    out->domain = read_name();
+    out->dc_host = read_name();
+    out->netbios_domain = read_name();
+    out->netbios_computer = read_name();
+    // NOTE: user name is skipped, it's only set when
+    // ping includes a user
+    read_name();
+    out->dc_site = read_name();
+    out->client_site = read_name();
+
+    if (parse_error) {
+        return false;
+    }
+
+    // NOTE: DcSockAddr and NextClosestSiteName are only
+    // included if they were requested, which ping doesn't
+    // do, so version follows client site
+    if (end - curr < NETLOGON_TRAILER_SIZE) {
+        return false;
+    }
+
+    const unsigned int nt_version = curr[0] | (curr[1] << 8) | (curr[2] << 16) | ((unsigned) curr[3] << 24);
+    if (!(nt_version & NETLOGON_NT_VERSION_5EX)) {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,103 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_DC_LOCATOR_H
+#define AD_DC_LOCATOR_H
+
+/**
+ * Finds out which AD site the client belongs to, the same
+ * way Windows DsGetDcName() does it. A "netlogon ping" is
+ * sent to a DC over connectionless LDAP (UDP). DC replies
+ * with information about itself, including the name of
+ * the site that contains client's subnet. That site is
+ * then used to prefer DC's in the same site.
+ */
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QWaitCondition>
+
+class AdNetlogonResponse {
+public:
+    AdNetlogonResponse();
+
+    int flags;
+    QString forest;
+    QString domain;
+    QString dc_host;
+    QString netbios_domain;
+    QString netbios_computer;
+    QString dc_site;
+    // NOTE: empty if client's subnet isn't assigned to
+    // any site
+    QString client_site;
+};
+
+class AdDcLocator {
+
+public:
+    static AdDcLocator *instance();
+
+    // Returns client site for domain or empty string if it
+    // couldn't be determined. Result is cached, so the
+    // ping is only done once in a while. DC's that didn't
+    // reply are also remembered and skipped for a while.
+    QString get_client_site(const QString &domain);
+
+    void clear();
+
+    void set_enabled(const bool enabled);
+    bool enabled() const;
+
+private:
+    class Entry {
+    public:
+        QString site;
+        qint64 expires_at;
+    };
+
+    mutable QMutex mutex;
+    QHash<QString, Entry> entry_map;
+    // DC => time until which it's skipped
+    QHash<QString, qint64> failed_dc_map;
+    // Domains for which a ping is in progress. Other
+    // callers wait for it's result instead of pinging
+    // again.
+    QSet<QString> pending_set;
+    QWaitCondition pending_done;
+    bool m_enabled;
+
+    AdDcLocator();
+};
+
+// Sends netlogon ping to DC and waits for reply. Returns
+// false if DC didn't reply within timeout or reply
+// couldn't be parsed.
+bool cldap_netlogon_ping(const QString &dc, const QString &domain, const int timeout_sec, AdNetlogonResponse *out);
+
+// Parses NETLOGON_SAM_LOGON_RESPONSE_EX structure, see
+// MS-ADTS 6.3.1.9. Returns false if response is truncated
+// or isn't of version 5EX.
+bool netlogon_response_parse(const QByteArray &blob, AdNetlogonResponse *out);
+
+#endif /* AD_DC_LOCATOR_H */
@@ -0,0 +1,331 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_dc_selector.h"
+
+#include "ad_connection_pool.h"
+
+#include <ldap.h>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <limits>
+
+// NOTE: probe results are reused for this long, so that
+// DC's are probed at most once per this period no matter
+// how many connections are made
+#define PROBE_MAX_AGE_MSEC (10 * 60 * 1000)
+
+#define PROBE_TIMEOUT_SEC 2
+#define MAX_PROBE_THREADS 8
+
+// NOTE: percentile based hedge delay is only used once
+// there are enough samples for it to be meaningful,
+// before that a multiple of probe time is used
+#define SAMPLES_MAX 100
+#define SAMPLES_MIN_FOR_PERCENTILE 20
+#define HEDGE_DELAY_DEFAULT_MSEC 500
+#define HEDGE_DELAY_MIN_MSEC 20
+#define HEDGE_DELAY_PROBE_MULTIPLIER 4
+#define HEDGE_DELAY_PROBE_MIN_MSEC 100
+#define HEDGE_PERCENTILE_DEFAULT 95
+
+// NOTE: AD replicates changes within a site in about 15
+// seconds by default. Use a bigger margin to also cover
+// the case where the other DC is in another site.
+#define WRITE_GUARD_MSEC (60 * 1000)
+
+class AdDcProbeTask final : public QRunnable {
+public:
+    AdDcProbeTask(const QString &dc_arg, const int port_arg, QHash<QString, qint64> *result_map_arg, QMutex *result_mutex_arg) {
+        dc = dc_arg;
+        port = port_arg;
+        result_map = result_map_arg;
+        result_mutex = result_mutex_arg;
+    }
+
+    void run() override {
+        const qint64 probe_msec = ldap_probe_dc(dc, port, PROBE_TIMEOUT_SEC);
+
+        QMutexLocker locker(result_mutex);
+        result_map->insert(dc, probe_msec);
+    }
+
+private:
+    QString dc;
+    int port;
+    QHash<QString, qint64> *result_map;
+    QMutex *result_mutex;
+};
+
+AdDcSelector::DcInfo::DcInfo() {
+    probe_msec = -1;
+    probed_at = 0;
+    next_sample = 0;
+}
+
+AdDcSelector *AdDcSelector::instance() {
+    static AdDcSelector selector;
+
+    return &selector;
+}
+
+AdDcSelector::AdDcSelector() {
+    last_write_at = 0;
+    m_ranking_enabled = false;
+    m_hedging_enabled = false;
+    m_hedge_percentile = HEDGE_PERCENTILE_DEFAULT;
+}
+
+QList<QString> AdDcSelector::rank(const QList<QString> &dc_list, const int port) {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    const QList<QString> probe_list = [&]() {
+        QMutexLocker locker(&mutex);
+
+        QList<QString> out;
+
+        for (const QString &dc : dc_list) {
+            const bool probe_is_old = (!info_map.contains(dc) || now - info_map[dc].probed_at > PROBE_MAX_AGE_MSEC);
+
+            if (probe_is_old) {
+                out.append(dc);
+            }
+        }
+
+        return out;
+    }();
+
+    // NOTE: probing a single DC is pointless, it's going
+    // to be used anyway
+    if (dc_list.size() > 1 && !probe_list.isEmpty()) {
+        QHash<QString, qint64> result_map;
+        QMutex result_mutex;
+
+        QThreadPool probe_pool;
+        probe_pool.setMaxThreadCount(qMin(probe_list.size(), MAX_PROBE_THREADS));
+
+        for (const QString &dc : probe_list) {
+            probe_pool.start(new AdDcProbeTask(dc, port, &result_map, &result_mutex));
+        }
+
+        probe_pool.waitForDone();
+
+        QMutexLocker locker(&mutex);
+
+        for (const QString &dc : result_map.keys()) {
+            DcInfo &info = info_map[dc];
+            info.probe_msec = result_map[dc];
+            info.probed_at = now;
+        }
+    }
+
+    return sorted_by_latency(dc_list);
+}
+
+QList<QString> AdDcSelector::sorted_by_latency(const QList<QString> &dc_list) const {
+    QMutexLocker locker(&mutex);
+
+    // NOTE: unknown and unreachable DC's are sorted last,
+    // stable sort keeps them in DNS order
+    auto get_key = [&](const QString &dc) -> qint64 {
+        if (info_map.contains(dc) && info_map[dc].probe_msec >= 0) {
+            return info_map[dc].probe_msec;
+        } else {
+            return std::numeric_limits<qint64>::max();
+        }
+    };
+
+    QList<QString> out = dc_list;
+    std::stable_sort(out.begin(), out.end(),
+        [&](const QString &a, const QString &b) {
+            return get_key(a) < get_key(b);
+        });
+
+    return out;
+}
+
+bool AdDcSelector::is_reachable(const QString &dc) const {
+    QMutexLocker locker(&mutex);
+
+    if (info_map.contains(dc)) {
+        const DcInfo &info = info_map[dc];
+        const bool was_probed = (info.probed_at > 0);
+
+        return (!was_probed || info.probe_msec >= 0);
+    } else {
+        return true;
+    }
+}
+
+void AdDcSelector::record_latency(const QString &dc, const qint64 msec) {
+    QMutexLocker locker(&mutex);
+
+    DcInfo &info = info_map[dc];
+
+    // NOTE: samples is a ring buffer of most recent
+    // latencies
+    if (info.samples.size() < SAMPLES_MAX) {
+        info.samples.append(msec);
+    } else {
+        info.samples[info.next_sample] = msec;
+    }
+
+    info.next_sample = (info.next_sample + 1) % SAMPLES_MAX;
+}
+
+qint64 AdDcSelector::latency_percentile(const QString &dc, const int percentile) const {
+    QMutexLocker locker(&mutex);
+
+    if (!info_map.contains(dc) || info_map[dc].samples.isEmpty()) {
+        return -1;
+    }
+
+    QList<qint64> sorted = info_map[dc].samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    const int percentile_bounded = qBound(0, percentile, 100);
+    const int index = qMin(sorted.size() - 1, sorted.size() * percentile_bounded / 100);
+
+    return sorted[index];
+}
+
+qint64 AdDcSelector::hedge_delay_msec(const QString &dc) const {
+    const qint64 delay = [&]() -> qint64 {
+        int sample_count;
+        qint64 probe_msec;
+        int percentile;
+        {
+            QMutexLocker locker(&mutex);
+
+            const DcInfo info = info_map.value(dc);
+            sample_count = info.samples.size();
+            probe_msec = info.probe_msec;
+            percentile = m_hedge_percentile;
+        }
+
+        if (sample_count >= SAMPLES_MIN_FOR_PERCENTILE) {
+            return latency_percentile(dc, percentile);
+        } else if (probe_msec >= 0) {
+            return qMax(probe_msec * HEDGE_DELAY_PROBE_MULTIPLIER, (qint64) HEDGE_DELAY_PROBE_MIN_MSEC);
+        } else {
+            return HEDGE_DELAY_DEFAULT_MSEC;
+        }
+    }();
+
+    return qMax(delay, (qint64) HEDGE_DELAY_MIN_MSEC);
+}
+
+void AdDcSelector::notify_write() {
+    QMutexLocker locker(&mutex);
+
+    last_write_at = QDateTime::currentMSecsSinceEpoch();
+}
+
+bool AdDcSelector::recent_write() const {
+    QMutexLocker locker(&mutex);
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    return (now - last_write_at < WRITE_GUARD_MSEC);
+}
+
+void AdDcSelector::clear() {
+    QMutexLocker locker(&mutex);
+
+    info_map.clear();
+}
+
+void AdDcSelector::set_ranking_enabled(const bool enabled) {
+    QMutexLocker locker(&mutex);
+
+    m_ranking_enabled = enabled;
+}
+
+bool AdDcSelector::ranking_enabled() const {
+    QMutexLocker locker(&mutex);
+
+    return m_ranking_enabled;
+}
+
+void AdDcSelector::set_hedging_enabled(const bool enabled) {
+    QMutexLocker locker(&mutex);
+
+    m_hedging_enabled = enabled;
+}
+
+bool AdDcSelector::hedging_enabled() const {
+    QMutexLocker locker(&mutex);
+
+    return m_hedging_enabled;
+}
+
+void AdDcSelector::set_hedge_percentile(const int percentile) {
+    QMutexLocker locker(&mutex);
+
+    m_hedge_percentile = percentile;
+}
+
+qint64 ldap_probe_dc(const QString &dc, const int port, const int timeout_sec) {
+    const QString uri = [&]() {
+        QString out = "ldap://" + dc;
+
+        if (port > 0) {
+            out = out + ":" + QString::number(port);
+        }
+
+        return out;
+    }();
+    const QByteArray uri_bytes = uri.toUtf8();
+
+    LDAP *ld = NULL;
+    const int init_result = ldap_initialize(&ld, uri_bytes.constData());
+    if (init_result != LDAP_SUCCESS) {
+        return -1;
+    }
+
+    const int version = LDAP_VERSION3;
+    ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+
+    struct timeval network_timeout;
+    network_timeout.tv_sec = timeout_sec;
+    network_timeout.tv_usec = 0;
+    ldap_set_option(ld, LDAP_OPT_NETWORK_TIMEOUT, &network_timeout);
+
+    // NOTE: connection is established lazily, so this
+    // includes TCP connect time, which is what we want
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool is_healthy = ldap_handle_is_healthy(ld, timeout_sec);
+    const qint64 elapsed = timer.elapsed();
+
+    ldap_unbind_ext(ld, NULL, NULL);
+
+    if (is_healthy) {
+        return elapsed;
+    } else {
+        return -1;
+    }
+}
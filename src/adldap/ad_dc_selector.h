@@ -0,0 +1,108 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_DC_SELECTOR_H
+#define AD_DC_SELECTOR_H
+
+/**
+ * Chooses domain controllers based on measured latency.
+ * DC's are probed in parallel with a cheap rootDSE read and
+ * ranked by round trip time, so that the fastest reachable
+ * DC is used instead of whichever DNS returned first.
+ * Latencies of real requests are also recorded, which is
+ * used to decide when a slow read should be duplicated
+ * ("hedged") to the next best DC.
+ */
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+class AdDcSelector {
+
+public:
+    static AdDcSelector *instance();
+
+    // Returns given DC's sorted by round trip time, fastest
+    // first. Unreachable DC's are moved to the end. DC's
+    // that weren't probed recently are probed in parallel,
+    // so this may block for a couple of seconds.
+    QList<QString> rank(const QList<QString> &dc_list, const int port);
+
+    // Same as rank() but only uses results of previous
+    // probes, so it never blocks
+    QList<QString> sorted_by_latency(const QList<QString> &dc_list) const;
+
+    // Returns true if DC responded to last probe or wasn't
+    // probed yet
+    bool is_reachable(const QString &dc) const;
+
+    void record_latency(const QString &dc, const qint64 msec);
+
+    // Returns latency of recent requests to DC at given
+    // percentile (0-100) or -1 if there are no samples
+    qint64 latency_percentile(const QString &dc, const int percentile) const;
+
+    // Returns how long to wait for a response from DC
+    // before sending the same request to another DC
+    qint64 hedge_delay_msec(const QString &dc) const;
+
+    // Hedged reads are suspended for a while after a
+    // write, because other DC's may not have replicated
+    // the change yet
+    void notify_write();
+    bool recent_write() const;
+
+    void clear();
+
+    void set_ranking_enabled(const bool enabled);
+    bool ranking_enabled() const;
+    void set_hedging_enabled(const bool enabled);
+    bool hedging_enabled() const;
+    void set_hedge_percentile(const int percentile);
+
+private:
+    class DcInfo {
+    public:
+        DcInfo();
+
+        // -1 if DC didn't respond to probe
+        qint64 probe_msec;
+        qint64 probed_at;
+        QList<qint64> samples;
+        int next_sample;
+    };
+
+    mutable QMutex mutex;
+    QHash<QString, DcInfo> info_map;
+    qint64 last_write_at;
+    bool m_ranking_enabled;
+    bool m_hedging_enabled;
+    int m_hedge_percentile;
+
+    AdDcSelector();
+};
+
+// Connects to DC without binding and performs a rootDSE
+// read. Returns round trip time in milliseconds or -1 if
+// DC is unreachable.
+qint64 ldap_probe_dc(const QString &dc, const int port, const int timeout_sec);
+
+#endif /* AD_DC_SELECTOR_H */
@@ -123,7 +123,9 @@ enum SystemFlagsBit {
 #define ATTRIBUTE_OBJECT_CLASS "objectClass"
 #define ATTRIBUTE_WHEN_CREATED "whenCreated"
 #define ATTRIBUTE_WHEN_CHANGED "whenChanged"
+#define ATTRIBUTE_MODIFY_TIMESTAMP "modifyTimeStamp"
 #define ATTRIBUTE_USN_CHANGED "uSNChanged"
+#define ATTRIBUTE_IS_DELETED "isDeleted"
 #define ATTRIBUTE_USN_CREATED "uSNCreated"
 #define ATTRIBUTE_OBJECT_CATEGORY "objectCategory"
 #define ATTRIBUTE_MEMBER "member"
@@ -301,6 +303,9 @@ const long long MILLIS_TO_100_NANOS = 10000LL;
 #define MATCHING_RULE_IN_CHAIN_OID "1.2.840.113556.1.4.1941"
 
 #define LDAP_SERVER_SD_FLAGS_OID "1.2.840.113556.1.4.801"
+#define LDAP_SERVER_SHOW_DELETED_OID "1.2.840.113556.1.4.417"
+#define LDAP_SERVER_NOTIFICATION_OID "1.2.840.113556.1.4.528"
+#define LDAP_SERVER_DOMAIN_SCOPE_OID "1.2.840.113556.1.4.1339"
 #define OWNER_SECURITY_INFORMATION 0x01
 #define GROUP_SECURITY_INFORMATION 0x02
 #define SACL_SECURITY_INFORMATION 0x08
@@ -373,6 +378,17 @@ enum SearchScope {
     SearchScope_All,
 };
 
+// Server that AdInterface connects to. Global catalog has
+// a read-only partial replica of all domains of the forest,
+// so one search covers the whole forest, but objects only
+// have attributes from the partial attribute set.
+enum AdServer {
+    AdServer_DomainController,
+    AdServer_GlobalCatalog,
+};
+
+#define GLOBAL_CATALOG_PORT 3268
+
 enum CertStrategy {
     CertStrategy_Never,
     CertStrategy_Hard,
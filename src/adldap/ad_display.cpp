@@ -20,6 +20,7 @@
 
 #include "ad_display.h"
 
+#include "ad_attribute_table.h"
 #include "ad_config.h"
 #include "ad_defines.h"
 #include "ad_utils.h"
@@ -47,13 +48,30 @@ QString samaccounttype_to_display_value(const QByteArray &bytes);
 QString primarygrouptype_to_display_value(const QByteArray &bytes);
 QString msds_supported_etypes_to_display_value(const QByteArray &bytes);
 QString attribute_hex_displayed_value(const QString &attribute, const QByteArray &bytes);
+QString attribute_display_value(const QString &attribute, const int attribute_id, const QByteArray &value, const AdConfig *adconfig);
 
 QString attribute_display_value(const QString &attribute, const QByteArray &value, const AdConfig *adconfig) {
     if (adconfig == nullptr) {
         return value;
     }
 
-    const AttributeType type = adconfig->get_attribute_type(attribute);
+    const int attribute_id = adconfig->get_attribute_id(attribute);
+
+    return attribute_display_value(attribute, attribute_id, value, adconfig);
+}
+
+QString attribute_display_value(const int attribute_id, const QByteArray &value, const AdConfig *adconfig) {
+    if (adconfig == nullptr) {
+        return value;
+    }
+
+    const QString attribute = AdAttributeTable::instance()->name(attribute_id);
+
+    return attribute_display_value(attribute, attribute_id, value, adconfig);
+}
+
+QString attribute_display_value(const QString &attribute, const int attribute_id, const QByteArray &value, const AdConfig *adconfig) {
+    const AttributeType type = adconfig->get_attribute_type(attribute_id);
 
     switch (type) {
         case AttributeType_Integer: {
@@ -72,7 +90,7 @@ QString attribute_display_value(const QString &attribute, const QByteArray &valu
             }
         }
         case AttributeType_LargeInteger: {
-            const LargeIntegerSubtype subtype = adconfig->get_attribute_large_integer_subtype(attribute);
+            const LargeIntegerSubtype subtype = adconfig->get_attribute_large_integer_subtype(attribute_id);
 
             switch (subtype) {
                 case LargeIntegerSubtype_Datetime: return large_integer_datetime_display_value(attribute, value, adconfig);
@@ -107,6 +125,14 @@ QString attribute_display_values(const QString &attribute, const QList<QByteArra
     } else {
         QString out;
 
+        const int attribute_id = [&]() {
+            if (adconfig != nullptr) {
+                return adconfig->get_attribute_id(attribute);
+            } else {
+                return ATTRIBUTE_ID_NONE;
+            }
+        }();
+
         // Convert values list to
         // "display_value1;display_value2;display_value3..."
         for (int i = 0; i < values.size(); i++) {
@@ -115,7 +141,13 @@ QString attribute_display_values(const QString &attribute, const QList<QByteArra
             }
 
             const QByteArray value = values[i];
-            const QString display_value = attribute_display_value(attribute, value, adconfig);
+            const QString display_value = [&]() {
+                if (adconfig != nullptr) {
+                    return attribute_display_value(attribute, attribute_id, value, adconfig);
+                } else {
+                    return QString(value);
+                }
+            }();
 
             out += display_value;
         }
@@ -33,6 +33,8 @@ template <typename T>
 class QList;
 
 QString attribute_display_value(const QString &attribute, const QByteArray &value, const AdConfig *adconfig);
+// NOTE: takes attribute id from AdConfig::get_attribute_id()
+QString attribute_display_value(const int attribute_id, const QByteArray &value, const AdConfig *adconfig);
 QString attribute_display_values(const QString &attribute, const QList<QByteArray> &values, const AdConfig *adconfig);
 QString object_sid_display_value(const QByteArray &sid_bytes);
 bool attribute_value_is_hex_displayed(const QString &attribute);
@@ -0,0 +1,230 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_entry_view.h"
+
+#include "ad_object.h"
+#include "ad_object_p.h"
+
+#include <lber.h>
+#include <ldap.h>
+
+
+AdEntryView::AdEntryView(LDAP *ld, LDAPMessage *entry) {
+    // NOTE: "_ber" f-ns decode the entry in place, so dn,
+    // attribute names and values point into the message
+    // buffer instead of being copied. Only the arrays of
+    // values are allocated. See print_entry() in
+    // ldapsearch.c for reference.
+    BerElement *ber = NULL;
+    struct berval dn_bv;
+    int result = ldap_get_dn_ber(ld, entry, &ber, &dn_bv);
+    if (result != LDAP_SUCCESS) {
+        ber_free(ber, 0);
+
+        return;
+    }
+
+    dn = QString::fromUtf8(dn_bv.bv_val, dn_bv.bv_len);
+
+    while (true) {
+        struct berval name_bv;
+        struct berval *values = NULL;
+        result = ldap_get_attribute_ber(ld, entry, ber, &name_bv, &values);
+
+        const bool done = (result != LDAP_SUCCESS || name_bv.bv_val == NULL);
+        if (done) {
+            ber_memfree(values);
+
+            break;
+        }
+
+        Attribute attribute;
+        attribute.name = QByteArray::fromRawData(name_bv.bv_val, name_bv.bv_len);
+        attribute.values = values;
+        attribute.value_count = 0;
+
+        if (values != NULL) {
+            while (values[attribute.value_count].bv_val != NULL) {
+                attribute.value_count++;
+            }
+        }
+
+        attribute_list.append(attribute);
+    }
+
+    // NOTE: don't free the buffer, it belongs to the
+    // message
+    ber_free(ber, 0);
+}
+
+AdEntryView::~AdEntryView() {
+    for (const Attribute &attribute : attribute_list) {
+        ber_memfree(attribute.values);
+    }
+}
+
+QString AdEntryView::get_dn() const {
+    return dn;
+}
+
+bool AdEntryView::contains(const QString &attribute) const {
+    return (find(attribute) != nullptr);
+}
+
+QList<QString> AdEntryView::attributes() const {
+    QList<QString> out;
+
+    for (const Attribute &attribute : attribute_list) {
+        out.append(QString::fromUtf8(attribute.name));
+    }
+
+    return out;
+}
+
+// NOTE: attribute options are case insensitive. Names
+// are byte arrays, which don't have case insensitive
+// search, so each option is compared separately.
+bool AdEntryView::has_ranged_attribute() const {
+    const char range_option[] = ";range=";
+
+    for (const Attribute &attribute : attribute_list) {
+        int option_index = attribute.name.indexOf(';');
+
+        while (option_index != -1) {
+            if (qstrnicmp(attribute.name.constData() + option_index, range_option, sizeof(range_option) - 1) == 0) {
+                return true;
+            }
+
+            option_index = attribute.name.indexOf(';', option_index + 1);
+        }
+    }
+
+    return false;
+}
+
+qint64 AdEntryView::value_size() const {
+    qint64 out = 0;
+
+    for (const Attribute &attribute : attribute_list) {
+        for (int i = 0; i < attribute.value_count; i++) {
+            out += attribute.values[i].bv_len;
+        }
+    }
+
+    return out;
+}
+
+int AdEntryView::value_count(const QString &attribute) const {
+    const Attribute *found = find(attribute);
+
+    if (found != nullptr) {
+        return found->value_count;
+    } else {
+        return 0;
+    }
+}
+
+QByteArray AdEntryView::get_value(const QString &attribute, const int index) const {
+    const Attribute *found = find(attribute);
+
+    if (found != nullptr && index >= 0 && index < found->value_count) {
+        const struct berval &value = found->values[index];
+
+        return QByteArray::fromRawData(value.bv_val, value.bv_len);
+    } else {
+        return QByteArray();
+    }
+}
+
+QList<QByteArray> AdEntryView::get_values(const QString &attribute) const {
+    const Attribute *found = find(attribute);
+
+    QList<QByteArray> out;
+
+    if (found != nullptr) {
+        for (int i = 0; i < found->value_count; i++) {
+            const struct berval &value = found->values[i];
+
+            out.append(QByteArray::fromRawData(value.bv_val, value.bv_len));
+        }
+    }
+
+    return out;
+}
+
+// NOTE: unlike AdObject::get_string(), this doesn't
+// special case objectClass, because view is meant for
+// plain single-valued attributes
+QString AdEntryView::get_string(const QString &attribute) const {
+    const QByteArray value = get_value(attribute);
+
+    return QString::fromUtf8(value.constData(), value.size());
+}
+
+int AdEntryView::get_int(const QString &attribute) const {
+    const QString string = get_string(attribute);
+
+    return string.toInt();
+}
+
+AdObject AdEntryView::to_object() const {
+    AdObjectData *data = new AdObjectData();
+    data->dn = dn;
+
+    int value_count = 0;
+    int buffer_size = 0;
+    for (const Attribute &attribute : attribute_list) {
+        value_count += attribute.value_count;
+
+        for (int i = 0; i < attribute.value_count; i++) {
+            buffer_size += attribute.values[i].bv_len;
+        }
+    }
+
+    data->reserve(attribute_list.size(), value_count, buffer_size);
+
+    // NOTE: values are copied straight from the message
+    // into object's buffer
+    for (const Attribute &attribute : attribute_list) {
+        data->add_attribute(QString::fromUtf8(attribute.name));
+
+        for (int i = 0; i < attribute.value_count; i++) {
+            const struct berval &value = attribute.values[i];
+
+            data->add_value(value.bv_val, value.bv_len);
+        }
+    }
+
+    return AdObject(data);
+}
+
+// NOTE: entries usually have a handful of attributes, so
+// linear search is faster than building a hash
+const AdEntryView::Attribute *AdEntryView::find(const QString &attribute) const {
+    for (const Attribute &entry_attribute : attribute_list) {
+        const QLatin1String name(entry_attribute.name.constData(), entry_attribute.name.size());
+
+        if (QString::compare(attribute, name, Qt::CaseInsensitive) == 0) {
+            return &entry_attribute;
+        }
+    }
+
+    return nullptr;
+}
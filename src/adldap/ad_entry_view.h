@@ -0,0 +1,89 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_ENTRY_VIEW_H
+#define AD_ENTRY_VIEW_H
+
+/**
+ * Read-only view of a search result entry, passed to
+ * visitors of AdInterface::search_visit(). Values are not
+ * copied out of the LDAP message, so the view and any
+ * QByteArray's returned by it are only valid during the
+ * visitor call. Use to_object() or copy values to keep
+ * them.
+ */
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+class AdObject;
+typedef struct ldap LDAP;
+typedef struct ldapmsg LDAPMessage;
+struct berval;
+
+class AdEntryView {
+
+public:
+    AdEntryView(LDAP *ld, LDAPMessage *entry);
+    ~AdEntryView();
+
+    AdEntryView(const AdEntryView &) = delete;
+    AdEntryView &operator=(const AdEntryView &) = delete;
+
+    QString get_dn() const;
+    bool contains(const QString &attribute) const;
+    QList<QString> attributes() const;
+
+    // Returns true if some attribute was returned
+    // partially by range retrieval, like
+    // "member;range=0-1499"
+    bool has_ranged_attribute() const;
+
+    // Sum of sizes of all values
+    qint64 value_size() const;
+
+    int value_count(const QString &attribute) const;
+
+    // NOTE: returned byte arrays point into LDAP message
+    QByteArray get_value(const QString &attribute, const int index = 0) const;
+    QList<QByteArray> get_values(const QString &attribute) const;
+
+    QString get_string(const QString &attribute) const;
+    int get_int(const QString &attribute) const;
+
+    // Copies entry into an object that can be kept
+    AdObject to_object() const;
+
+private:
+    class Attribute {
+    public:
+        QByteArray name;
+        struct berval *values;
+        int value_count;
+    };
+
+    QString dn;
+    QVector<Attribute> attribute_list;
+
+    const Attribute *find(const QString &attribute) const;
+};
+
+#endif /* AD_ENTRY_VIEW_H */
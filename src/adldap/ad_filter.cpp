@@ -136,6 +136,11 @@ QString filter_dn_list(const QList<QString> &dn_list) {
     return out;
 }
 
+QString filter_changed_after(const qint64 usn) {
+    const QString filter = QString(ATTRIBUTE_USN_CHANGED) + ">=" + QString::number(usn + 1);
+    return QString("(" + filter + ")");
+}
+
 QString filter_matching_rule_in_chain(const QString &attribute, const QString &dn_value) {
     const QString filter = attribute + ":" + QString(MATCHING_RULE_IN_CHAIN_OID) + ":=" + dn_value;
     return QString("(" + filter + ")");
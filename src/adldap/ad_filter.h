@@ -60,4 +60,9 @@ QString filter_matching_rule_in_chain(const QString &attribute, const QString &d
 // Filter that accepts any DN from given list
 QString filter_dn_list(const QList<QString> &dn_list);
 
+// Filter that accepts objects changed after given update
+// sequence number. LDAP has no "greater than" operator, so
+// this is (uSNChanged>=usn+1)
+QString filter_changed_after(const qint64 usn);
+
 #endif /* AD_FILTER_H */
@@ -21,10 +21,19 @@
 #include "ad_interface.h"
 #include "ad_interface_p.h"
 
+#include "ad_bulk.h"
 #include "ad_config.h"
+#include "ad_connection_pool.h"
+#include "ad_dc_cache.h"
+#include "ad_dc_locator.h"
+#include "ad_dc_selector.h"
 #include "ad_display.h"
+#include "ad_entry_view.h"
+#include "ad_metrics.h"
 #include "ad_object.h"
+#include "ad_page_size.h"
 #include "ad_security.h"
+#include "ad_trace.h"
 #include "ad_utils.h"
 #include "gplink.h"
 #include "samba/dom_sid.h"
@@ -39,33 +48,59 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <errno.h>
 #include <krb5.h>
 #include <lber.h>
 #include <ldap.h>
 #include <libsmbclient.h>
+#include <poll.h>
 #include <resolv.h>
 #include <sasl/sasl.h>
+#include <strings.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <uuid/uuid.h>
 
+#include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QSet>
 #include <QTextCodec>
+#include <QThreadPool>
+#include <QVector>
 
 // NOTE: LDAP library char* inputs are non-const in the API
 // but are const for practical purposes so we use forced
 // casts (const char *) -> (char *)
 
-#ifdef __GNUC__
-#define UNUSED(x) x __attribute__((unused))
-#else
-#define UNUSED(x) x
-#endif
-
 #define UNUSED_ARG(x) (void) (x)
 
 #define MAX_DN_LENGTH 1024
 #define MAX_PASSWORD_LENGTH 255
+
+// NOTE: max amount of entries returned by one call of
+// search_async_poll()
+#define ASYNC_POLL_MAX_ENTRIES 500
+
+// NOTE: max amount of searches that search_objects() keeps
+// outstanding at the same time
+#define SEARCH_OBJECTS_WINDOW 100
+
+// NOTE: max amount of requests that bulk_run() keeps
+// outstanding at the same time
+#define BULK_WINDOW 64
+
+// NOTE: upper bound for one wait on both connections
+// during a hedged read. Wait ends as soon as either
+// connection has data, this only limits how long a missed
+// wakeup can stall the read.
+#define HEDGE_POLL_TIMEOUT_MSEC 1000
+
+// NOTE: if connecting to hedge DC in the background
+// failed, don't try again for this long
+#define HEDGE_CONNECT_RETRY_SEC 60
+
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37
 #endif
@@ -83,10 +118,11 @@ enum AceMaskFormat {
     AceMaskFormat_Decimal,
 };
 
-QList<QString> query_server_for_hosts(const char *dname);
 int sasl_interact_gssapi(LDAP *ld, unsigned flags, void *indefaults, void *in);
 QString get_gpt_sd_string(const AdObject &gpc_object, const AceMaskFormat format);
 int create_sd_control(bool get_sacl, int is_critical, LDAPControl **ctrlp, bool set_dacl = false);
+int search_scope_to_ldap(const SearchScope scope);
+int bulk_send(LDAP *ld, const AdBulkOp &op, int *msgid);
 
 AdConfig *AdInterfacePrivate::adconfig = nullptr;
 bool AdInterfacePrivate::s_log_searches = false;
@@ -98,6 +134,7 @@ int AdInterfacePrivate::s_port = 0;
 CertStrategy AdInterfacePrivate::s_cert_strat = CertStrategy_Never;
 SMBCCTX *AdInterfacePrivate::smbc = NULL;
 QMutex AdInterfacePrivate::mutex;
+QMutex AdInterfacePrivate::shared_mutex;
 
 void get_auth_data_fn(const char *pServer, const char *pShare, char *pWorkgroup, int maxLenWorkgroup, char *pUsername, int maxLenUsername, char *pPassword, int maxLenPassword) {
     UNUSED_ARG(pServer);
@@ -110,12 +147,18 @@ void get_auth_data_fn(const char *pServer, const char *pShare, char *pWorkgroup,
     UNUSED_ARG(maxLenPassword);
 }
 
-AdInterface::AdInterface() {
+AdInterface::AdInterface(const AdServer server) {
     d = new AdInterfacePrivate(this);
 
     d->is_connected = false;
+    d->server = server;
 
     d->ld = NULL;
+    d->ld_is_bound = false;
+    d->ld_is_broken = false;
+    d->hedge_ld = NULL;
+    d->hedge_ld_broken = false;
+    d->async_search_id_max = 0;
 
     const QString connect_error_context = tr("Failed to connect.");
 
@@ -129,31 +172,108 @@ AdInterface::AdInterface() {
         return;
     }
 
+    // NOTE: forest root is known only after config is
+    // loaded. Before that, assume that domain is the
+    // forest root.
+    d->forest = [&]() {
+        const QString root_domain_dn = [&]() {
+            QMutexLocker locker(&AdInterfacePrivate::shared_mutex);
+
+            if (AdInterfacePrivate::adconfig != nullptr) {
+                return AdInterfacePrivate::adconfig->root_domain_dn();
+            } else {
+                return QString();
+            }
+        }();
+
+        if (!root_domain_dn.isEmpty()) {
+            const QString root_canonical = dn_canonical(root_domain_dn);
+
+            return root_canonical.section('/', 0, 0);
+        } else {
+            return d->domain;
+        }
+    }();
+
+    if (d->server == AdServer_GlobalCatalog) {
+        d->is_connected = d->connect_gc();
+
+        return;
+    }
+
     //
     // Connect via LDAP
     //
 
+    // NOTE: copy shared DC once, so that it doesn't change
+    // between checks below if another thread sets it
+    const QString shared_dc = AdInterfacePrivate::get_shared_dc();
+
+    // Reuse a bound connection to the DC that was used
+    // before, if pool has one. This skips DC discovery
+    // and bind.
+    if (!shared_dc.isEmpty()) {
+        d->dc = shared_dc;
+        d->ld_key = d->connection_key(d->dc);
+        d->ld = AdConnectionPool::instance()->acquire(d->ld_key, &d->client_user);
+        d->ld_is_bound = (d->ld != NULL);
+    }
+
+    if (d->ld_is_bound) {
+        if (!init_smb_context()) {
+            return;
+        }
+
+        d->is_connected = true;
+
+        return;
+    }
+
+    // NOTE: site is empty if locator is disabled or ping
+    // failed, in which case domain-wide DC's are used
+    const QString site = AdDcLocator::instance()->get_client_site(d->domain);
+
     d->dc = [&]() {
-        const QList<QString> dc_list = get_domain_hosts(d->domain, QString());
+        const QList<QString> dc_list = get_domain_hosts(d->domain, site);
         if (dc_list.isEmpty()) {
             d->error_message_plain(tr("Failed to find domain controllers. Make sure your computer is in the domain and that domain controllers are operational."));
 
             return QString();
         }
 
-        if (!AdInterfacePrivate::s_dc.isEmpty()) {
-            if (dc_list.contains(AdInterfacePrivate::s_dc)) {
-                return AdInterfacePrivate::s_dc;
+        if (!shared_dc.isEmpty()) {
+            if (dc_list.contains(shared_dc)) {
+                return shared_dc;
             } else {
                 return dc_list[0];
             }
+        } else if (AdDcSelector::instance()->ranking_enabled()) {
+            // NOTE: DC's in client's site are preferred even
+            // if a DC in another site responds faster, so
+            // only rank those if there are any
+            const QList<QString> site_dc_list = get_site_hosts(d->domain, site);
+            const QList<QString> candidate_list = [&]() {
+                if (!site_dc_list.isEmpty()) {
+                    return site_dc_list;
+                } else {
+                    return dc_list;
+                }
+            }();
+
+            const QList<QString> ranked_list = AdDcSelector::instance()->rank(candidate_list, AdInterfacePrivate::s_port);
+
+            return ranked_list[0];
         } else {
             return dc_list[0];
         }
     }();
 
-    if (AdInterfacePrivate::s_dc.isEmpty()) {
-        AdInterfacePrivate::s_dc = d->dc;
+    {
+        QMutexLocker locker(&AdInterfacePrivate::shared_mutex);
+
+        if (AdInterfacePrivate::s_dc.isEmpty()) {
+            AdInterfacePrivate::s_dc = d->dc;
+        }
     }
 
     if (!ldap_init()) {
@@ -178,6 +298,8 @@ AdInterface::~AdInterface() {
 }
 
 void AdInterface::set_config(AdConfig *config_arg) {
+    QMutexLocker locker(&AdInterfacePrivate::shared_mutex);
+
     AdInterfacePrivate::adconfig = config_arg;
 }
 
@@ -186,6 +308,8 @@ void AdInterface::set_log_searches(const bool enabled) {
 }
 
 void AdInterface::set_dc(const QString &dc) {
+    QMutexLocker locker(&AdInterfacePrivate::shared_mutex);
+
     AdInterfacePrivate::s_dc = dc;
 }
 
@@ -216,12 +340,58 @@ void AdInterface::set_custom_domain(const QString &domain)
     AdInterfacePrivate::s_custom_domain = domain;
 }
 
+void AdInterface::set_connection_pool_enabled(const bool enabled) {
+    AdConnectionPool::instance()->set_enabled(enabled);
+}
+
+void AdInterface::clear_connection_pool() {
+    AdConnectionPool::instance()->clear();
+}
+
+AdConnectionPoolStats AdInterface::connection_pool_stats() {
+    return AdConnectionPool::instance()->stats();
+}
+
+void AdInterface::set_dc_cache_path(const QString &path) {
+    AdDcCache::instance()->set_persist_path(path);
+}
+
+void AdInterface::clear_dc_cache() {
+    AdDcCache::instance()->clear();
+}
+
+void AdInterface::set_site_aware_enabled(const bool enabled) {
+    AdDcLocator::instance()->set_enabled(enabled);
+}
+
+void AdInterface::set_page_size(const int page_size) {
+    AdPageSizeTuner::instance()->set_page_size(page_size);
+}
+
+void AdInterface::set_adaptive_page_size(const bool adaptive) {
+    AdPageSizeTuner::instance()->set_adaptive(adaptive);
+}
+
+void AdInterface::set_dc_ranking_enabled(const bool enabled) {
+    AdDcSelector::instance()->set_ranking_enabled(enabled);
+}
+
+void AdInterface::set_hedged_reads_enabled(const bool enabled) {
+    AdDcSelector::instance()->set_hedging_enabled(enabled);
+}
+
 AdInterfacePrivate::AdInterfacePrivate(AdInterface *q_arg) {
     mutex.lock();
     q = q_arg;
     mutex.unlock();
 }
 
+QString AdInterfacePrivate::get_shared_dc() {
+    QMutexLocker locker(&shared_mutex);
+
+    return s_dc;
+}
+
 bool AdInterface::is_connected() const {
     return d->is_connected;
 }
@@ -252,55 +422,335 @@ QString AdInterface::client_user() const {
     return d->client_user;
 }
 
+void AdInterfacePrivate::record_operation(const AdMetricsOp op, const qint64 elapsed_msec, const int result) {
+    AdMetricsSample sample(op);
+    sample.elapsed_msec = elapsed_msec;
+    sample.success = (result == LDAP_SUCCESS);
+    AdMetrics::instance()->record(sample);
+}
+
+// Reads values of attribute starting from "start" index,
+// one range per request, until server returns the last
+// range
+bool AdInterfacePrivate::visit_range(const QString &dn, const QString &attribute, const int start, const std::function<bool(const QList<QByteArray> &values)> &visitor) {
+    const AdCString base_string(dn);
+    const char *base_cstr = base_string.get();
+
+    int low = start;
+
+    while (true) {
+        QByteArray range_attribute = QString("%1;range=%2-*").arg(attribute).arg(low).toUtf8();
+        char *attributes[2] = {range_attribute.data(), NULL};
+
+        LDAPMessage *res = NULL;
+        const int result = ldap_search_ext_s(ld, base_cstr, LDAP_SCOPE_BASE, NULL, attributes, 0, NULL, NULL, NULL, LDAP_NO_LIMIT, &res);
+        check_ld_result(result);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Error in ranged ldap_search_ext_s: " << ldap_err2string(result);
+
+            ldap_msgfree(res);
+
+            return false;
+        }
+
+        LDAPMessage *entry = ldap_first_entry(ld, res);
+        if (entry == NULL) {
+            ldap_msgfree(res);
+
+            return false;
+        }
+
+        // NOTE: server returns values under a name that
+        // contains the range which was actually returned.
+        // Small attributes may be returned under the plain
+        // name. Values are copied because view points into
+        // the message.
+        QList<QByteArray> values;
+        bool is_last_range = true;
+        {
+            const AdEntryView entry_view(ld, entry);
+
+            for (const QString &name : entry_view.attributes()) {
+                QString name_attribute;
+                int name_low;
+                int name_high;
+                const bool is_ranged = attribute_parse_range(name, &name_attribute, &name_low, &name_high);
+
+                const bool is_match = [&]() {
+                    if (is_ranged) {
+                        return (QString::compare(name_attribute, attribute, Qt::CaseInsensitive) == 0);
+                    } else {
+                        return (QString::compare(name, attribute, Qt::CaseInsensitive) == 0);
+                    }
+                }();
+
+                if (!is_match) {
+                    continue;
+                }
+
+                for (const QByteArray &value : entry_view.get_values(name)) {
+                    values.append(QByteArray(value.constData(), value.size()));
+                }
+
+                if (is_ranged && name_high != -1) {
+                    is_last_range = false;
+                    low = name_high + 1;
+                }
+
+                break;
+            }
+        }
+
+        ldap_msgfree(res);
+
+        if (values.isEmpty()) {
+            return true;
+        }
+
+        const bool should_continue = visitor(values);
+        if (!should_continue || is_last_range) {
+            return true;
+        }
+    }
+}
+
+// Converts entry to object and loads values of attributes
+// that were only returned partially, so that objects
+// always contain all values
+AdObject AdInterfacePrivate::entry_to_complete_object(LDAP *entry_ld, LDAPMessage *entry, qint64 *byte_count) {
+    const AdEntryView entry_view(entry_ld, entry);
+
+    if (byte_count != nullptr) {
+        *byte_count += entry_view.value_size();
+    }
+
+    // NOTE: checking the view is cheap, so objects without
+    // ranged attributes, which is nearly all of them, skip
+    // the copying below
+    if (!entry_view.has_ranged_attribute()) {
+        return entry_view.to_object();
+    }
+
+    // NOTE: ranged objects are built from the view instead
+    // of through an intermediate object, so that ranged
+    // names like "member;range=0-1499" never end up as
+    // attributes of an object
+    const QString dn = entry_view.get_dn();
+    QHash<QString, QList<QByteArray>> attributes_data;
+
+    for (const QString &name : entry_view.attributes()) {
+        QList<QByteArray> values = entry_view.get_values(name);
+
+        QString attribute;
+        int low;
+        int high;
+        const bool is_ranged = attribute_parse_range(name, &attribute, &low, &high);
+        if (!is_ranged) {
+            attributes_data[name] = values;
+
+            continue;
+        }
+
+        if (high != -1) {
+            visit_range(dn, attribute, high + 1, [&](const QList<QByteArray> &range_values) {
+                values.append(range_values);
+
+                return true;
+            });
+        }
+
+        attributes_data[attribute] = values;
+    }
+
+    AdObject out;
+    out.load(dn, attributes_data);
+
+    return out;
+}
+
 // Helper f-n for search()
 // NOTE: cookie is starts as NULL. Then after each while
 // loop, it is set to the value returned by
 // ldap_search_ext_s(). At the end cookie is set back to
 // NULL.
-bool AdInterfacePrivate::search_paged_internal(const char *base, const int scope, const char *filter, char **attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const bool get_sacl) {
+bool AdInterfacePrivate::search_paged_internal(const char *base, const int scope, const char *filter, char **attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const SearchOptions &options) {
     int result;
     LDAPMessage *res = NULL;
-    LDAPControl *page_control = NULL;
-    LDAPControl *sd_control = NULL;
+    QList<LDAPControl *> control_list;
     LDAPControl **returned_controls = NULL;
     struct berval *prev_cookie = cookie->cookie;
     struct berval *new_cookie = NULL;
 
+    // NOTE: libldap sends time limit from handle options
+    // unless a client timeout is given, so it's set for the
+    // duration of the search
+    int prev_time_limit = 0;
+    const bool set_time_limit = (options.time_limit > 0 && options.timeout_msec <= 0);
+    if (set_time_limit) {
+        ldap_get_option(ld, LDAP_OPT_TIMELIMIT, &prev_time_limit);
+        ldap_set_option(ld, LDAP_OPT_TIMELIMIT, &options.time_limit);
+    }
+
     auto cleanup = [&]() {
         ldap_msgfree(res);
-        ldap_control_free(page_control);
-        ldap_control_free(sd_control);
+        for (LDAPControl *control : control_list) {
+            ldap_control_free(control);
+        }
         ldap_controls_free(returned_controls);
         ber_bvfree(prev_cookie);
         ber_bvfree(new_cookie);
+
+        if (set_time_limit) {
+            ldap_set_option(ld, LDAP_OPT_TIMELIMIT, &prev_time_limit);
+        }
     };
 
     const int is_critical = 1;
 
-    result = create_sd_control(get_sacl, is_critical, &sd_control);
+    // Create page control
+    const bool is_first_page = (prev_cookie == NULL);
+    const ber_int_t page_size = [&]() {
+        const int tuned_size = [&]() {
+            if (options.page_size > 0) {
+                return options.page_size;
+            } else if (is_first_page || cookie->page_size <= 0) {
+                return AdPageSizeTuner::instance()->first_page_size();
+            } else {
+                return cookie->page_size;
+            }
+        }();
+
+        // NOTE: don't ask for a page bigger than what
+        // server is allowed to return
+        if (options.size_limit > 0) {
+            return qMin(tuned_size, options.size_limit);
+        } else {
+            return tuned_size;
+        }
+    }();
+    LDAPControl *page_control = NULL;
+    result = ldap_create_page_control(ld, page_size, prev_cookie, is_critical, &page_control);
     if (result != LDAP_SUCCESS) {
-        qDebug() << "Failed to create sd control: " << ldap_err2string(result);
+        qDebug() << "Failed to create page control: " << ldap_err2string(result);
 
         cleanup();
         return false;
     }
+    control_list.append(page_control);
 
-    // Create page control
-    const ber_int_t page_size = 100;
-    result = ldap_create_page_control(ld, page_size, prev_cookie, is_critical, &page_control);
-    if (result != LDAP_SUCCESS) {
-        qDebug() << "Failed to create page control: " << ldap_err2string(result);
+    // NOTE: sd control only affects the security
+    // descriptor, so it's skipped if descriptor isn't
+    // requested
+    const bool sd_requested = [&]() {
+        if (attributes == NULL) {
+            return true;
+        }
+
+        for (int i = 0; attributes[i] != NULL; i++) {
+            if (strcasecmp(attributes[i], ATTRIBUTE_SECURITY_DESCRIPTOR) == 0) {
+                return true;
+            }
+        }
 
-        cleanup();
         return false;
+    }();
+    if (sd_requested) {
+        LDAPControl *sd_control = NULL;
+        result = create_sd_control(options.get_sacl, is_critical, &sd_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create sd control: " << ldap_err2string(result);
+
+            cleanup();
+            return false;
+        }
+        control_list.append(sd_control);
     }
-    LDAPControl *server_controls[3] = {page_control, sd_control, NULL};
+
+    if (options.domain_scope) {
+        LDAPControl *domain_scope_control = NULL;
+        result = ldap_control_create(LDAP_SERVER_DOMAIN_SCOPE_OID, 0, NULL, 0, &domain_scope_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create domain scope control: " << ldap_err2string(result);
+
+            cleanup();
+            return false;
+        }
+        control_list.append(domain_scope_control);
+    }
+
+    for (const SearchControl &extra : options.controls) {
+        const QByteArray oid = extra.oid.toUtf8();
+        struct berval value;
+        value.bv_val = (char *) extra.value.constData();
+        value.bv_len = extra.value.size();
+        struct berval *value_ptr = (extra.value.isNull() ? NULL : &value);
+
+        // NOTE: value is duplicated, so it doesn't need to
+        // outlive this loop
+        const int dup_value = 1;
+
+        LDAPControl *extra_control = NULL;
+        result = ldap_control_create(oid.constData(), extra.is_critical, value_ptr, dup_value, &extra_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create control " << extra.oid << ": " << ldap_err2string(result);
+
+            cleanup();
+            return false;
+        }
+        control_list.append(extra_control);
+    }
+
+    QVector<LDAPControl *> server_controls = control_list.toVector();
+    server_controls.append(NULL);
+
+    struct timeval timeout;
+    timeout.tv_sec = options.timeout_msec / 1000;
+    timeout.tv_usec = (options.timeout_msec % 1000) * 1000;
+    struct timeval *timeout_ptr = (options.timeout_msec > 0 ? &timeout : NULL);
+
+    const int size_limit = (options.size_limit > 0 ? options.size_limit : LDAP_NO_LIMIT);
 
     // Perform search
-    const int attrsonly = 0;
-    result = ldap_search_ext_s(ld, base, scope, filter, attributes, attrsonly, server_controls, NULL, NULL, LDAP_NO_LIMIT, &res);
+    //
+    // NOTE: only base scope reads are hedged because they
+    // are cheap for the server and return a single page.
+    // Paged searches can't be hedged because cookie is only
+    // valid on the DC that returned it. Hedging doesn't
+    // apply limits, so searches with limits are not hedged.
+    const int attrsonly = (options.attrs_only ? 1 : 0);
+    const bool is_base_read = (scope == LDAP_SCOPE_BASE && is_first_page);
+    const bool has_limits = (options.size_limit > 0 || options.time_limit > 0 || options.timeout_msec > 0);
+    const bool do_hedge = (is_base_read && !has_limits && AdDcSelector::instance()->hedging_enabled() && !AdDcSelector::instance()->recent_write());
+
+    // NOTE: results are parsed using the handle that
+    // returned them, which is not "ld" if hedge won
+    LDAP *res_ld = ld;
+
+    QElapsedTimer search_timer;
+    search_timer.start();
+
+    if (do_hedge) {
+        result = search_hedged(base, scope, filter, attributes, attrsonly, server_controls.data(), &res, &res_ld);
+    } else {
+        result = ldap_search_ext_s(ld, base, scope, filter, attributes, attrsonly, server_controls.data(), NULL, timeout_ptr, size_limit, &res);
+    }
+
+    if (res_ld == ld) {
+        check_ld_result(result);
+    }
+
+    // NOTE: hedged reads record latencies themselves,
+    // because the response may come from the other DC
+    if (is_base_read && !do_hedge && result == LDAP_SUCCESS) {
+        AdDcSelector::instance()->record_latency(dc, search_timer.elapsed());
+    }
+
+    // NOTE: when a limit is exceeded, server still returns
+    // entries found up to that point, so they are kept and
+    // search ends
+    const bool hit_limit = (result == LDAP_SIZELIMIT_EXCEEDED || result == LDAP_TIMELIMIT_EXCEEDED);
 
-    if ((result != LDAP_SUCCESS) && (result != LDAP_PARTIAL_RESULTS)) {
+    if ((result != LDAP_SUCCESS) && (result != LDAP_PARTIAL_RESULTS) && !hit_limit) {
         // NOTE: it's not really an error for an object to
         // not exist. For example, sometimes it's needed to
         // check whether an object exists. Not sure how to
@@ -313,52 +763,35 @@ bool AdInterfacePrivate::search_paged_internal(const char *base, const int scope
         return false;
     }
 
-    // Collect results for this search
-    for (LDAPMessage *entry = ldap_first_entry(ld, res); entry != NULL; entry = ldap_next_entry(ld, entry)) {
-        char *dn_cstr = ldap_get_dn(ld, entry);
-        const QString dn(dn_cstr);
-        ldap_memfree(dn_cstr);
-
-        QHash<QString, QList<QByteArray>> object_attributes;
-
-        BerElement *berptr;
-        for (char *attr = ldap_first_attribute(ld, entry, &berptr); attr != NULL; attr = ldap_next_attribute(ld, entry, berptr)) {
-            struct berval **values_ldap = ldap_get_values_len(ld, entry, attr);
-
-            const QList<QByteArray> values_bytes = [=]() {
-                QList<QByteArray> out;
+    const qint64 search_elapsed = search_timer.elapsed();
 
-                if (values_ldap != NULL) {
-                    const int values_count = ldap_count_values_len(values_ldap);
-                    for (int i = 0; i < values_count; i++) {
-                        struct berval value_berval = *values_ldap[i];
-                        const QByteArray value_bytes(value_berval.bv_val, value_berval.bv_len);
-
-                        out.append(value_bytes);
-                    }
-                }
+    // Collect results for this search
+    int entry_count = 0;
+    for (LDAPMessage *entry = ldap_first_entry(res_ld, res); entry != NULL; entry = ldap_next_entry(res_ld, entry)) {
+        const AdObject object = entry_to_complete_object(res_ld, entry, &cookie->metrics_byte_count);
 
-                return out;
-            }();
+        results->insert(object.get_dn(), object);
 
-            const QString attribute(attr);
+        entry_count++;
+    }
 
-            object_attributes[attribute] = values_bytes;
+    cookie->metrics_page_count++;
+    cookie->metrics_entry_count += entry_count;
 
-            ldap_value_free_len(values_ldap);
-            ldap_memfree(attr);
-        }
-        ber_free(berptr, 0);
+    if (options.page_size <= 0) {
+        cookie->page_size = AdPageSizeTuner::instance()->next_page_size(is_first_page, page_size, entry_count, search_elapsed, &cookie->msec_per_entry);
+    }
 
-        AdObject object;
-        object.load(dn, object_attributes);
+    if (hit_limit) {
+        cookie->cookie = NULL;
 
-        results->insert(dn, object);
+        cleanup();
+        return true;
     }
 
     // Parse the results to retrieve returned controls
     int errcodep;
-    result = ldap_parse_result(ld, res, &errcodep, NULL, NULL, NULL, &returned_controls, false);
+    result = ldap_parse_result(res_ld, res, &errcodep, NULL, NULL, NULL, &returned_controls, false);
     if (result != LDAP_SUCCESS) {
         qDebug() << "Failed to parse result: " << ldap_err2string(result);
 
@@ -377,7 +810,7 @@ bool AdInterfacePrivate::search_paged_internal(const char *base, const int scope
         // there are more pages
         ber_int_t total_count;
         new_cookie = (struct berval *) malloc(sizeof(struct berval));
-        result = ldap_parse_pageresponse_control(ld, pageresponse_control, &total_count, new_cookie);
+        result = ldap_parse_pageresponse_control(res_ld, pageresponse_control, &total_count, new_cookie);
         if (result != LDAP_SUCCESS) {
             qDebug() << "Failed to parse pageresponse control: " << ldap_err2string(result);
 
@@ -403,11 +836,20 @@ bool AdInterfacePrivate::search_paged_internal(const char *base, const int scope
 }
 
 QHash<QString, AdObject> AdInterface::search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const bool get_sacl) {
+    SearchOptions options;
+    options.get_sacl = get_sacl;
+
+    return search(base, scope, filter, attributes, options);
+}
+
+QHash<QString, AdObject> AdInterface::search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const SearchOptions &options) {
+    const AdTraceSpan trace_span("search", "ldap", AD_TRACE_DETAIL(base + " " + filter));
+
     AdCookie cookie;
     QHash<QString, AdObject> results;
 
     while (true) {
-        const bool success = search_paged(base, scope, filter, attributes, &results, &cookie, get_sacl);
+        const bool success = search_paged(base, scope, filter, attributes, &results, &cookie, options);
 
         if (!success) {
             break;
@@ -422,46 +864,35 @@ QHash<QString, AdObject> AdInterface::search(const QString &base, const SearchSc
 }
 
 bool AdInterface::search_paged(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const bool get_sacl) {
+    SearchOptions options;
+    options.get_sacl = get_sacl;
+
+    return search_paged(base, scope, filter, attributes, results, cookie, options);
+}
+
+bool AdInterface::search_paged(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const SearchOptions &options) {
+    const AdTraceSpan trace_span("search_paged", "ldap", AD_TRACE_DETAIL(base + " " + filter));
+
     // NOTE: only log once per cycle of search pages,
     // to avoid duplicate messages
     const bool is_first_page = results->isEmpty();
-    const bool need_to_log = (AdInterfacePrivate::s_log_searches && is_first_page);
-    if (need_to_log) {
-        const QString attributes_string = "{" + attributes.join(",") + "}";
-
-        const QString scope_string = [&scope]() -> QString {
-            switch (scope) {
-                case SearchScope_Object: return "object";
-                case SearchScope_Children: return "children";
-                case SearchScope_Descendants: return "descendants";
-                case SearchScope_All: return "all";
-                default: break;
-            }
-            return QString();
-        }();
-
-        d->success_message(QString(tr("Search:\n\tfilter = \"%1\"\n\tattributes = %2\n\tscope = \"%3\"\n\tbase = \"%4\"")).arg(filter, attributes_string, scope_string, base));
+    if (is_first_page) {
+        d->log_search(base, scope, filter, attributes);
     }
 
-    const char *base_cstr = cstr(base);
+    const AdCString base_string(base);
+    const char *base_cstr = base_string.get();
 
-    const int scope_int = [&]() {
-        switch (scope) {
-            case SearchScope_Object: return LDAP_SCOPE_BASE;
-            case SearchScope_Children: return LDAP_SCOPE_ONELEVEL;
-            case SearchScope_All: return LDAP_SCOPE_SUBTREE;
-            case SearchScope_Descendants: return LDAP_SCOPE_CHILDREN;
-        }
-        return 0;
-    }();
+    const int scope_int = search_scope_to_ldap(scope);
 
+    const AdCString filter_string(filter);
     const char *filter_cstr = [&]() {
         if (filter.isEmpty()) {
             // NOTE: need to pass NULL instead of empty
             // string to denote "no filter"
             return (const char *) NULL;
         } else {
-            return cstr(filter);
+            return filter_string.get();
         }
     }();
 
@@ -482,11 +913,27 @@ bool AdInterface::search_paged(const QString &base, const SearchScope scope, con
         }
     }
 
-    const bool search_success = d->search_paged_internal(base_cstr, scope_int, filter_cstr, attributes_array, results, cookie, get_sacl);
-    if (!search_success) {
-        results->clear();
-
-        return false;
+    QElapsedTimer timer;
+    timer.start();
+
+    const bool search_success = d->search_paged_internal(base_cstr, scope_int, filter_cstr, attributes_array, results, cookie, options);
+
+    // NOTE: pages are summed up and recorded as one
+    // search when the last page arrives
+    cookie->metrics_elapsed_msec += timer.elapsed();
+    if (!search_success || !cookie->more_pages()) {
+        AdMetricsSample sample(AdMetricsOp_Search);
+        sample.base = base;
+        sample.scope = scope;
+        sample.filter = filter;
+        sample.elapsed_msec = cookie->metrics_elapsed_msec;
+        sample.success = search_success;
+        sample.page_count = cookie->metrics_page_count;
+        sample.entry_count = cookie->metrics_entry_count;
+        sample.byte_count = cookie->metrics_byte_count;
+        AdMetrics::instance()->record(sample);
+
+        cookie->reset_metrics();
     }
 
     if (attributes_array != NULL) {
@@ -496,39 +943,582 @@ bool AdInterface::search_paged(const QString &base, const SearchScope scope, con
         free(attributes_array);
     }
 
+    if (!search_success) {
+        results->clear();
+
+        return false;
+    }
+
     return true;
 }
 
-AdObject AdInterface::search_object(const QString &dn, const QList<QString> &attributes, const bool get_sacl) {
-    const QString base = dn;
-    const SearchScope scope = SearchScope_Object;
-    const QString filter = QString();
-    const QHash<QString, AdObject> results = search(base, scope, filter, attributes, get_sacl);
+bool AdInterface::search_visit(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const std::function<bool(const AdEntryView &entry)> &visitor, const bool get_sacl) {
+    const AdTraceSpan trace_span("search_visit", "ldap", AD_TRACE_DETAIL(base + " " + filter));
 
-    if (results.contains(dn)) {
-        return results[dn];
-    } else {
-        return AdObject();
-    }
+    d->log_search(base, scope, filter, attributes);
+
+    AdAsyncSearch search(base, scope, filter, attributes, get_sacl);
+
+    return d->visit_search(&search, visitor);
 }
 
-bool AdInterface::attribute_replace_values(const QString &dn, const QString &attribute, const QList<QByteArray> &values, const DoStatusMsg do_msg, const bool set_dacl) {
-    const AdObject object = search_object(dn, {attribute});
-    const QList<QByteArray> old_values = object.get_values(attribute);
-    const QString name = dn_get_name(dn);
-    const QString values_display = attribute_display_values(attribute, values, d->adconfig);
-    const QString old_values_display = attribute_display_values(attribute, old_values, d->adconfig);
+bool AdInterface::search_visit_deleted(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const std::function<bool(const AdEntryView &entry)> &visitor) {
+    const AdTraceSpan trace_span("search_visit_deleted", "ldap", AD_TRACE_DETAIL(base + " " + filter));
 
-    // Do nothing if both new and old values are empty
-    if (old_values.isEmpty() && values.isEmpty()) {
-        return true;
-    }
+    d->log_search(base, scope, filter, attributes);
 
-    // NOTE: store bvalues in array instead of dynamically allocating ptrs
-    struct berval bvalues_storage[values.size()];
-    struct berval *bvalues[values.size() + 1];
-    bvalues[values.size()] = NULL;
-    for (int i = 0; i < values.size(); i++) {
+    AdAsyncSearch search(base, scope, filter, attributes, false);
+    search.show_deleted = true;
+
+    return d->visit_search(&search, visitor);
+}
+
+int AdInterface::search_async(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const bool get_sacl) {
+    const AdTraceSpan trace_span("search_async", "ldap", AD_TRACE_DETAIL(base + " " + filter));
+
+    d->log_search(base, scope, filter, attributes);
+
+    AdAsyncSearch *search = new AdAsyncSearch(base, scope, filter, attributes, get_sacl);
+
+    return d->async_start(search);
+}
+
+int AdInterface::search_async_notify(const QString &base, const SearchScope scope, const QList<QString> &attributes) {
+    const AdTraceSpan trace_span("search_async_notify", "ldap", base);
+
+    // NOTE: server only accepts this filter for
+    // notification searches
+    const QString filter = filter_CONDITION(Condition_Set, ATTRIBUTE_OBJECT_CLASS);
+
+    d->log_search(base, scope, filter, attributes);
+
+    AdAsyncSearch *search = new AdAsyncSearch(base, scope, filter, attributes, false);
+    search->notify = true;
+    search->show_deleted = true;
+
+    return d->async_start(search);
+}
+
+void AdInterface::search_async_poll(const int timeout_msec, QHash<int, QHash<QString, AdObject>> *results_map, QHash<int, bool> *finished_map, const int wake_fd) {
+    if (d->async_search_map.isEmpty()) {
+        return;
+    }
+
+    const AdTraceSpan trace_span("search_async_poll", "ldap", AD_TRACE_DETAIL(QString::number(d->async_search_map.size())));
+
+    auto finish_search = [&](const int search_id, const bool success) {
+        AdAsyncSearch *search = d->async_search_map.take(search_id);
+        d->async_msgid_map.remove(search->msgid);
+
+        if (search->is_window && success) {
+            d->async_window_map[search_id] = search->window_results;
+            d->async_window_count_map[search_id] = search->window_content_count;
+        }
+
+        delete search;
+
+        finished_map->insert(search_id, success);
+    };
+
+    // NOTE: wait only for the first message. After that,
+    // collect messages that already arrived without
+    // waiting, so that caller gets results in batches
+    // instead of one entry at a time. Batch size is
+    // limited so that caller stays responsive.
+    struct timeval first_timeout;
+    first_timeout.tv_sec = timeout_msec / 1000;
+    first_timeout.tv_usec = (timeout_msec % 1000) * 1000;
+
+    struct timeval zero_timeout;
+    zero_timeout.tv_sec = 0;
+    zero_timeout.tv_usec = 0;
+
+    struct timeval *first_timeout_ptr = (timeout_msec < 0 ? NULL : &first_timeout);
+
+    int entry_count = 0;
+    bool is_first_message = true;
+    bool got_message = false;
+    bool waited_for_wake = false;
+
+    // NOTE: if there's a wake fd, libldap can't wait on
+    // it, so the wait is done by poll() on both the wake
+    // fd and the socket of the connection. Messages that
+    // libldap already read from the socket and buffered
+    // don't show up in poll(), so check for them first,
+    // without waiting.
+    const bool use_wake_fd = (wake_fd != -1);
+
+    while (entry_count < ASYNC_POLL_MAX_ENTRIES && !d->async_search_map.isEmpty()) {
+        const bool wait_in_ldap = (is_first_message && !use_wake_fd);
+        struct timeval *timeout = (wait_in_ldap ? first_timeout_ptr : &zero_timeout);
+        is_first_message = false;
+
+        LDAPMessage *message = NULL;
+        const int message_type = ldap_result(d->ld, LDAP_RES_ANY, LDAP_MSG_ONE, timeout, &message);
+
+        const bool timed_out = (message_type == 0);
+        if (timed_out) {
+            const bool need_wait = (use_wake_fd && !got_message && !waited_for_wake);
+            if (!need_wait) {
+                break;
+            }
+
+            waited_for_wake = true;
+
+            int ld_fd = -1;
+            ldap_get_option(d->ld, LDAP_OPT_DESC, &ld_fd);
+
+            struct pollfd fds[2];
+            fds[0].fd = ld_fd;
+            fds[0].events = POLLIN;
+            fds[0].revents = 0;
+            fds[1].fd = wake_fd;
+            fds[1].events = POLLIN;
+            fds[1].revents = 0;
+
+            const int poll_result = poll(fds, 2, timeout_msec);
+            const bool ld_ready = (poll_result > 0 && fds[0].revents != 0);
+            if (!ld_ready) {
+                break;
+            }
+
+            continue;
+        }
+
+        got_message = true;
+
+        // NOTE: error here means that connection is
+        // broken, so all searches fail
+        const bool result_error = (message_type < 0);
+        if (result_error) {
+            qDebug() << "Error in ldap_result: " << ldap_err2string(d->get_ldap_result());
+
+            d->check_ld_result(d->get_ldap_result());
+
+            for (const int search_id : d->async_search_map.keys()) {
+                d->async_search_map[search_id]->failed = true;
+                finish_search(search_id, false);
+            }
+
+            break;
+        }
+
+        const int msgid = ldap_msgid(message);
+
+        // NOTE: messages of abandoned searches may still
+        // arrive, ignore them
+        if (!d->async_msgid_map.contains(msgid)) {
+            ldap_msgfree(message);
+
+            continue;
+        }
+
+        const int search_id = d->async_msgid_map[msgid];
+        AdAsyncSearch *search = d->async_search_map[search_id];
+
+        switch (message_type) {
+            case LDAP_RES_SEARCH_ENTRY: {
+                // NOTE: ranged attributes are completed here,
+                // so that consumers of async searches never
+                // get a partial list of values
+                const AdObject object = d->entry_to_complete_object(d->ld, message, &search->total_byte_count);
+
+                // NOTE: window entries arrive in sorted
+                // order, so they are collected into a list
+                // instead of a hash
+                if (search->is_window) {
+                    search->window_results.append(object);
+                } else {
+                    (*results_map)[search_id].insert(object.get_dn(), object);
+                }
+
+                search->page_entry_count++;
+                search->total_entry_count++;
+                entry_count++;
+
+                break;
+            }
+            case LDAP_RES_SEARCH_RESULT: {
+                d->async_msgid_map.remove(msgid);
+
+                bool more_pages = false;
+                const bool page_success = d->async_handle_page_result(search, message, &more_pages);
+
+                if (page_success && more_pages) {
+                    const bool send_success = d->async_send_page(search);
+
+                    if (send_success) {
+                        d->async_msgid_map[search->msgid] = search_id;
+                    } else {
+                        finish_search(search_id, false);
+                    }
+                } else {
+                    finish_search(search_id, page_success);
+                }
+
+                break;
+            }
+            default: {
+                // NOTE: referrals are disabled, so references
+                // are ignored
+                break;
+            }
+        }
+
+        ldap_msgfree(message);
+    }
+}
+
+void AdInterface::search_async_abandon(const int search_id) {
+    d->async_window_map.remove(search_id);
+    d->async_window_count_map.remove(search_id);
+
+    if (!d->async_search_map.contains(search_id)) {
+        return;
+    }
+
+    AdAsyncSearch *search = d->async_search_map.take(search_id);
+
+    ldap_abandon_ext(d->ld, search->msgid, NULL, NULL);
+    d->async_msgid_map.remove(search->msgid);
+
+    delete search;
+}
+
+int AdInterface::search_async_count() const {
+    return d->async_search_map.size();
+}
+
+bool AdInterface::search_window(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const QString &sort_attribute, const int offset, const int count, QList<AdObject> *results, int *content_count) {
+    const AdTraceSpan trace_span("search_window", "ldap", AD_TRACE_DETAIL(base + " " + filter));
+
+    // NOTE: only log first window, to avoid a message for
+    // every scroll
+    if (offset == 0) {
+        d->log_search(base, scope, filter, attributes);
+    }
+
+    // NOTE: same request as the async version, but only
+    // messages of this request are read, so that results
+    // of other async searches are left alone
+    AdAsyncSearch search(base, scope, filter, attributes, false);
+    search.is_window = true;
+    search.sort_attribute = sort_attribute.toUtf8();
+    search.window_offset = offset;
+    search.window_count = count;
+    search.window_content_count = *content_count;
+
+    const bool send_success = d->async_send_page(&search);
+    if (!send_success) {
+        return false;
+    }
+
+    LDAPMessage *res = NULL;
+    const int result_type = ldap_result(d->ld, search.msgid, LDAP_MSG_ALL, NULL, &res);
+    if (result_type == -1) {
+        qDebug() << "Error in window ldap_result: " << ldap_err2string(d->get_ldap_result());
+
+        d->check_ld_result(d->get_ldap_result());
+
+        search.failed = true;
+
+        ldap_msgfree(res);
+        return false;
+    }
+
+    for (LDAPMessage *entry = ldap_first_entry(d->ld, res); entry != NULL; entry = ldap_next_entry(d->ld, entry)) {
+        const AdObject object = d->entry_to_complete_object(d->ld, entry, &search.total_byte_count);
+
+        search.window_results.append(object);
+        search.total_entry_count++;
+    }
+
+    bool more_pages;
+    const bool success = d->async_handle_page_result(&search, res, &more_pages);
+
+    ldap_msgfree(res);
+
+    if (!success) {
+        return false;
+    }
+
+    *results = search.window_results;
+    *content_count = search.window_content_count;
+
+    return true;
+}
+
+int AdInterface::search_async_window(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const QString &sort_attribute, const int offset, const int count, const int content_count) {
+    const AdTraceSpan trace_span("search_async_window", "ldap", AD_TRACE_DETAIL(base + " " + filter));
+
+    if (offset == 0) {
+        d->log_search(base, scope, filter, attributes);
+    }
+
+    AdAsyncSearch *search = new AdAsyncSearch(base, scope, filter, attributes, false);
+    search->is_window = true;
+    search->sort_attribute = sort_attribute.toUtf8();
+    search->window_offset = offset;
+    search->window_count = count;
+    search->window_content_count = content_count;
+
+    return d->async_start(search);
+}
+
+bool AdInterface::search_async_take_window(const int search_id, QList<AdObject> *results, int *content_count) {
+    if (!d->async_window_map.contains(search_id)) {
+        return false;
+    }
+
+    *results = d->async_window_map.take(search_id);
+    *content_count = d->async_window_count_map.take(search_id);
+
+    return true;
+}
+
+bool AdInterface::window_search_supported() const {
+    if (d->adconfig == nullptr) {
+        return false;
+    }
+
+    return d->adconfig->window_search_supported();
+}
+
+AdObject AdInterface::search_object(const QString &dn, const QList<QString> &attributes, const bool get_sacl) {
+    SearchOptions options;
+    options.get_sacl = get_sacl;
+
+    return search_object(dn, attributes, options);
+}
+
+AdObject AdInterface::search_object(const QString &dn, const QList<QString> &attributes, const SearchOptions &options) {
+    const AdTraceSpan trace_span("search_object", "ldap", dn);
+
+    const QString base = dn;
+    const SearchScope scope = SearchScope_Object;
+    const QString filter = QString();
+    const QHash<QString, AdObject> results = search(base, scope, filter, attributes, options);
+
+    if (results.contains(dn)) {
+        return results[dn];
+    } else {
+        return AdObject();
+    }
+}
+
+QList<AdBulkResult> AdInterface::bulk_run(const QList<AdBulkOp> &op_list, const bool stop_on_error, const AdBulkProgress &progress) {
+    QList<AdBulkResult> out;
+    for (int i = 0; i < op_list.size(); i++) {
+        AdBulkResult result;
+        result.done = false;
+        result.success = false;
+        result.ldap_result = LDAP_SUCCESS;
+
+        out.append(result);
+    }
+
+    AdDcSelector::instance()->notify_write();
+
+    // Pairs of message id and operation index
+    QList<QPair<int, int>> pending_list;
+    int next_index = 0;
+    int done_count = 0;
+    bool stopped = false;
+
+    auto finish = [&](const int index, const int ldap_result) {
+        AdBulkResult &result = out[index];
+        result.done = true;
+        result.success = (ldap_result == LDAP_SUCCESS);
+        result.ldap_result = ldap_result;
+
+        if (!result.success) {
+            result.error = d->error_string(ldap_result);
+
+            if (stop_on_error) {
+                stopped = true;
+            }
+        }
+
+        done_count++;
+
+        if (progress) {
+            progress(done_count, op_list.size());
+        }
+    };
+
+    auto send_next = [&]() {
+        while (!stopped && next_index < op_list.size() && pending_list.size() < BULK_WINDOW) {
+            const int index = next_index;
+            next_index++;
+
+            int msgid;
+            const int send_result = bulk_send(d->ld, op_list[index], &msgid);
+            d->check_ld_result(send_result);
+
+            if (send_result == LDAP_SUCCESS) {
+                pending_list.append({msgid, index});
+            } else {
+                finish(index, send_result);
+            }
+        }
+    };
+
+    send_next();
+
+    // NOTE: when stopping on error, requests that were
+    // already sent still finish and are reported
+    while (!pending_list.isEmpty()) {
+        const QPair<int, int> pending = pending_list.takeFirst();
+        const int msgid = pending.first;
+        const int index = pending.second;
+
+        LDAPMessage *res = NULL;
+        const int message_type = ldap_result(d->ld, msgid, LDAP_MSG_ALL, NULL, &res);
+
+        const int ldap_result = [&]() {
+            if (message_type > 0) {
+                return ldap_result2error(d->ld, res, 0);
+            } else {
+                return d->get_ldap_result();
+            }
+        }();
+        d->check_ld_result(ldap_result);
+
+        ldap_msgfree(res);
+
+        finish(index, ldap_result);
+
+        send_next();
+    }
+
+    return out;
+}
+
+QHash<QString, AdObject> AdInterface::search_objects(const QList<QString> &dn_list, const QList<QString> &attributes, const bool get_sacl) {
+    const AdTraceSpan trace_span("search_objects", "ldap", AD_TRACE_DETAIL(QString::number(dn_list.size())));
+
+    QHash<QString, AdObject> out;
+
+    AdMetricsSample sample(AdMetricsOp_SearchObjects);
+    QElapsedTimer timer;
+    timer.start();
+
+    // NOTE: log once for the whole batch, to avoid a
+    // message per object
+    d->log_search(dn_list.join("; "), SearchScope_Object, QString(), attributes);
+
+    // NOTE: it's not an error for an object to not exist,
+    // those are just left out of results, same as in
+    // search()
+    auto search_error = [&](const QString &dn, const int ldap_result) {
+        if (ldap_result == LDAP_NO_SUCH_OBJECT) {
+            return;
+        }
+
+        sample.success = false;
+
+        qDebug() << "Error in search_objects() for" << dn << ":" << ldap_err2string(ldap_result);
+
+        const QString context = QString(tr("Failed to load object %1.")).arg(dn_get_name(dn));
+        d->error_message(context, d->error_string(ldap_result));
+    };
+
+    // NOTE: searches are sent in a sliding window, so that
+    // a big batch doesn't flood the server with requests
+    QList<AdAsyncSearch *> pending_list;
+    int next_index = 0;
+
+    auto send_next = [&]() {
+        while (next_index < dn_list.size() && pending_list.size() < SEARCH_OBJECTS_WINDOW) {
+            const QString &dn = dn_list[next_index];
+            next_index++;
+
+            AdAsyncSearch *search = new AdAsyncSearch(dn, SearchScope_Object, QString(), attributes, get_sacl);
+            search->in_batch = true;
+
+            const bool send_success = d->async_send_page(search);
+            if (send_success) {
+                pending_list.append(search);
+            } else {
+                // NOTE: result code of failed send is
+                // checked by async_send_page()
+                search_error(dn, d->get_ldap_result());
+
+                delete search;
+            }
+        }
+    };
+
+    send_next();
+
+    // NOTE: results are read in the order that searches
+    // were sent. Server processes the rest of the window
+    // in the meantime, so waiting on one search doesn't
+    // stall others.
+    while (!pending_list.isEmpty()) {
+        AdAsyncSearch *search = pending_list.takeFirst();
+        const QString dn = QString::fromUtf8(search->base);
+
+        LDAPMessage *res = NULL;
+        const int result = ldap_result(d->ld, search->msgid, LDAP_MSG_ALL, NULL, &res);
+
+        if (result > 0) {
+            int errcode = LDAP_SUCCESS;
+            const int parse_result = ldap_parse_result(d->ld, res, &errcode, NULL, NULL, NULL, NULL, 0);
+            const int search_result = (parse_result == LDAP_SUCCESS ? errcode : parse_result);
+
+            if (search_result == LDAP_SUCCESS) {
+                for (LDAPMessage *entry = ldap_first_entry(d->ld, res); entry != NULL; entry = ldap_next_entry(d->ld, entry)) {
+                    out[dn] = d->entry_to_complete_object(d->ld, entry, &search->total_byte_count);
+                    search->total_entry_count++;
+                    sample.entry_count++;
+                }
+                search->total_page_count++;
+                sample.page_count++;
+            } else {
+                search->failed = true;
+                search_error(dn, search_result);
+            }
+        } else {
+            d->check_ld_result(d->get_ldap_result());
+
+            search->failed = true;
+            search_error(dn, d->get_ldap_result());
+        }
+
+        sample.byte_count += search->total_byte_count;
+
+        ldap_msgfree(res);
+        delete search;
+
+        send_next();
+    }
+
+    sample.elapsed_msec = timer.elapsed();
+    AdMetrics::instance()->record(sample);
+
+    return out;
+}
+
+bool AdInterface::attribute_replace_values(const QString &dn, const QString &attribute, const QList<QByteArray> &values, const DoStatusMsg do_msg, const bool set_dacl) {
+    const AdTraceSpan trace_span("attribute_replace_values", "ldap", AD_TRACE_DETAIL(dn + " " + attribute));
+
+    const AdObject object = search_object(dn, {attribute});
+    const QList<QByteArray> old_values = object.get_values(attribute);
+    const QString name = dn_get_name(dn);
+    const QString values_display = attribute_display_values(attribute, values, d->adconfig);
+    const QString old_values_display = attribute_display_values(attribute, old_values, d->adconfig);
+
+    // Do nothing if both new and old values are empty
+    if (old_values.isEmpty() && values.isEmpty()) {
+        return true;
+    }
+
+    // NOTE: store bvalues in array instead of dynamically allocating ptrs
+    struct berval bvalues_storage[values.size()];
+    struct berval *bvalues[values.size() + 1];
+    bvalues[values.size()] = NULL;
+    for (int i = 0; i < values.size(); i++) {
         const QByteArray value = values[i];
         struct berval *bvalue = &(bvalues_storage[i]);
 
@@ -540,7 +1530,8 @@ bool AdInterface::attribute_replace_values(const QString &dn, const QString &att
 
     LDAPMod attr;
     attr.mod_op = (LDAP_MOD_REPLACE | LDAP_MOD_BVALUES);
-    attr.mod_type = (char *) cstr(attribute);
+    const AdCString attribute_cstr(attribute);
+    attr.mod_type = (char *) attribute_cstr.get();
     attr.mod_bvalues = bvalues;
 
     LDAPMod *attrs[] = {&attr, NULL};
@@ -563,7 +1554,12 @@ bool AdInterface::attribute_replace_values(const QString &dn, const QString &att
         server_controls[0] = sd_control;
     }
 
-    result = ldap_modify_ext_s(d->ld, cstr(dn), attrs, server_controls, NULL);
+    AdDcSelector::instance()->notify_write();
+    QElapsedTimer op_timer;
+    op_timer.start();
+    result = ldap_modify_ext_s(d->ld, AdCString(dn).get(), attrs, server_controls, NULL);
+    d->check_ld_result(result);
+    d->record_operation(AdMetricsOp_Modify, op_timer.elapsed(), result);
 
     if (result == LDAP_SUCCESS) {
         d->success_message(QString(tr("Attribute %1 of object %2 was changed from \"%3\" to \"%4\".")).arg(attribute, name, old_values_display, values_display), do_msg);
@@ -591,6 +1587,8 @@ bool AdInterface::attribute_replace_value(const QString &dn, const QString &attr
 }
 
 bool AdInterface::attribute_add_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg) {
+    const AdTraceSpan trace_span("attribute_add_value", "ldap", AD_TRACE_DETAIL(dn + " " + attribute));
+
     char *data_copy = (char *) malloc(value.size());
     if (data_copy == NULL) {
         return false;
@@ -605,12 +1603,18 @@ bool AdInterface::attribute_add_value(const QString &dn, const QString &attribut
 
     LDAPMod attr;
     attr.mod_op = LDAP_MOD_ADD | LDAP_MOD_BVALUES;
-    attr.mod_type = (char *) cstr(attribute);
+    const AdCString attribute_cstr(attribute);
+    attr.mod_type = (char *) attribute_cstr.get();
     attr.mod_bvalues = values;
 
     LDAPMod *attrs[] = {&attr, NULL};
 
-    const int result = ldap_modify_ext_s(d->ld, cstr(dn), attrs, NULL, NULL);
+    AdDcSelector::instance()->notify_write();
+    QElapsedTimer op_timer;
+    op_timer.start();
+    const int result = ldap_modify_ext_s(d->ld, AdCString(dn).get(), attrs, NULL, NULL);
+    d->check_ld_result(result);
+    d->record_operation(AdMetricsOp_Modify, op_timer.elapsed(), result);
     free(data_copy);
 
     const QString name = dn_get_name(dn);
@@ -632,6 +1636,8 @@ bool AdInterface::attribute_add_value(const QString &dn, const QString &attribut
 }
 
 bool AdInterface::attribute_delete_value(const QString &dn, const QString &attribute, const QByteArray &value, const DoStatusMsg do_msg) {
+    const AdTraceSpan trace_span("attribute_delete_value", "ldap", AD_TRACE_DETAIL(dn + " " + attribute));
+
     const QString name = dn_get_name(dn);
     const QString value_display = attribute_display_value(attribute, value, d->adconfig);
 
@@ -648,12 +1654,18 @@ bool AdInterface::attribute_delete_value(const QString &dn, const QString &attri
     LDAPMod attr;
     struct berval *values[] = {&ber_data, NULL};
     attr.mod_op = LDAP_MOD_DELETE | LDAP_MOD_BVALUES;
-    attr.mod_type = (char *) cstr(attribute);
+    const AdCString attribute_cstr(attribute);
+    attr.mod_type = (char *) attribute_cstr.get();
     attr.mod_bvalues = values;
 
     LDAPMod *attrs[] = {&attr, NULL};
 
-    const int result = ldap_modify_ext_s(d->ld, cstr(dn), attrs, NULL, NULL);
+    AdDcSelector::instance()->notify_write();
+    QElapsedTimer op_timer;
+    op_timer.start();
+    const int result = ldap_modify_ext_s(d->ld, AdCString(dn).get(), attrs, NULL, NULL);
+    d->check_ld_result(result);
+    d->record_operation(AdMetricsOp_Modify, op_timer.elapsed(), result);
     free(data_copy);
 
     if (result == LDAP_SUCCESS) {
@@ -692,6 +1704,8 @@ bool AdInterface::attribute_replace_datetime(const QString &dn, const QString &a
 }
 
 bool AdInterface::object_add(const QString &dn, const QHash<QString, QList<QString>> &attrs_map) {
+    const AdTraceSpan trace_span("object_add", "ldap", dn);
+
     LDAPMod **attrs = [&attrs_map]() {
         LDAPMod **out = (LDAPMod **) malloc((attrs_map.size() + 1) * sizeof(LDAPMod *));
 
@@ -705,11 +1719,11 @@ bool AdInterface::object_add(const QString &dn, const QHash<QString, QList<QStri
             char **value_array = (char **) malloc((value_list.size() + 1) * sizeof(char *));
             for (int j = 0; j < value_list.size(); j++) {
                 const QString value = value_list[j];
-                value_array[j] = (char *) strdup(cstr(value));
+                value_array[j] = (char *) strdup(AdCString(value).get());
             }
             value_array[value_list.size()] = NULL;
 
-            attr->mod_type = (char *) strdup(cstr(attr_name));
+            attr->mod_type = (char *) strdup(AdCString(attr_name).get());
             attr->mod_op = LDAP_MOD_ADD;
             attr->mod_values = value_array;
 
@@ -721,7 +1735,12 @@ bool AdInterface::object_add(const QString &dn, const QHash<QString, QList<QStri
         return out;
     }();
 
-    const int result = ldap_add_ext_s(d->ld, cstr(dn), attrs, NULL, NULL);
+    AdDcSelector::instance()->notify_write();
+    QElapsedTimer op_timer;
+    op_timer.start();
+    const int result = ldap_add_ext_s(d->ld, AdCString(dn).get(), attrs, NULL, NULL);
+    d->check_ld_result(result);
+    d->record_operation(AdMetricsOp_Add, op_timer.elapsed(), result);
 
     ldap_mods_free(attrs, 1);
 
@@ -769,6 +1788,8 @@ bool AdInterface::object_add(const QString &dn, const QString &object_class) {
 }
 
 bool AdInterface::object_delete(const QString &dn, const DoStatusMsg do_msg) {
+    const AdTraceSpan trace_span("object_delete", "ldap", dn);
+
     int result;
     LDAPControl *tree_delete_control = NULL;
 
@@ -796,7 +1817,12 @@ bool AdInterface::object_delete(const QString &dn, const DoStatusMsg do_msg) {
         server_controls[0] = tree_delete_control;
     }
 
-    result = ldap_delete_ext_s(d->ld, cstr(dn), server_controls, NULL);
+    AdDcSelector::instance()->notify_write();
+    QElapsedTimer op_timer;
+    op_timer.start();
+    result = ldap_delete_ext_s(d->ld, AdCString(dn).get(), server_controls, NULL);
+    d->check_ld_result(result);
+    d->record_operation(AdMetricsOp_Delete, op_timer.elapsed(), result);
 
     cleanup();
 
@@ -811,13 +1837,53 @@ bool AdInterface::object_delete(const QString &dn, const DoStatusMsg do_msg) {
     }
 }
 
+QList<QString> AdInterface::object_delete_list(const QList<QString> &dn_list) {
+    const AdTraceSpan trace_span("object_delete_list", "ldap", AD_TRACE_DETAIL(QString::number(dn_list.size())));
+
+    const bool tree_delete_is_supported = adconfig()->control_is_supported(LDAP_CONTROL_X_TREE_DELETE);
+
+    QList<AdBulkOp> op_list;
+    for (const QString &dn : dn_list) {
+        op_list.append(ad_bulk_delete(dn, tree_delete_is_supported));
+    }
+
+    const QList<AdBulkResult> result_list = bulk_run(op_list);
+
+    QList<QString> out;
+
+    for (int i = 0; i < dn_list.size(); i++) {
+        const QString &dn = dn_list[i];
+        const AdBulkResult &result = result_list[i];
+        const QString name = dn_get_name(dn);
+
+        if (result.success) {
+            d->success_message(QString(tr("Object %1 was deleted.")).arg(name));
+
+            out.append(dn);
+        } else {
+            const QString context = QString(tr("Failed to delete object %1.")).arg(name);
+
+            d->error_message(context, result.error);
+        }
+    }
+
+    return out;
+}
+
 bool AdInterface::object_move(const QString &dn, const QString &new_container) {
+    const AdTraceSpan trace_span("object_move", "ldap", dn);
+
     const QString rdn = dn.split(',')[0];
     const QString new_dn = rdn + "," + new_container;
     const QString object_name = dn_get_name(dn);
     const QString container_name = dn_get_name(new_container);
 
-    const int result = ldap_rename_s(d->ld, cstr(dn), cstr(rdn), cstr(new_container), 1, NULL, NULL);
+    AdDcSelector::instance()->notify_write();
+    QElapsedTimer op_timer;
+    op_timer.start();
+    const int result = ldap_rename_s(d->ld, AdCString(dn).get(), AdCString(rdn).get(), AdCString(new_container).get(), 1, NULL, NULL);
+    d->check_ld_result(result);
+    d->record_operation(AdMetricsOp_Rename, op_timer.elapsed(), result);
 
     if (result == LDAP_SUCCESS) {
         d->success_message(QString(tr("Object %1 was moved to %2.")).arg(object_name, container_name));
@@ -833,11 +1899,18 @@ bool AdInterface::object_move(const QString &dn, const QString &new_container) {
 }
 
 bool AdInterface::object_rename(const QString &dn, const QString &new_name) {
+    const AdTraceSpan trace_span("object_rename", "ldap", dn);
+
     const QString new_dn = dn_rename(dn, new_name);
     const QString new_rdn = new_dn.split(",")[0];
     const QString old_name = dn_get_name(dn);
 
-    const int result = ldap_rename_s(d->ld, cstr(dn), cstr(new_rdn), NULL, 1, NULL, NULL);
+    AdDcSelector::instance()->notify_write();
+    QElapsedTimer op_timer;
+    op_timer.start();
+    const int result = ldap_rename_s(d->ld, AdCString(dn).get(), AdCString(new_rdn).get(), NULL, 1, NULL, NULL);
+    d->check_ld_result(result);
+    d->record_operation(AdMetricsOp_Rename, op_timer.elapsed(), result);
 
     if (result == LDAP_SUCCESS) {
         d->success_message(QString(tr("Object %1 was renamed to %2.")).arg(old_name, new_name));
@@ -872,8 +1945,78 @@ bool AdInterface::group_add_member(const QString &group_dn, const QString &user_
     }
 }
 
-bool AdInterface::group_remove_member(const QString &group_dn, const QString &user_dn) {
-    const QByteArray user_dn_bytes = user_dn.toUtf8();
+QList<QString> AdInterface::object_move_list(const QList<QString> &dn_list, const QString &new_container) {
+    const AdTraceSpan trace_span("object_move_list", "ldap", AD_TRACE_DETAIL(QString::number(dn_list.size())));
+
+    const QString container_name = dn_get_name(new_container);
+
+    QList<AdBulkOp> op_list;
+    for (const QString &dn : dn_list) {
+        const QString rdn = dn.split(',')[0];
+
+        op_list.append(ad_bulk_rename(dn, rdn, new_container));
+    }
+
+    const QList<AdBulkResult> result_list = bulk_run(op_list);
+
+    QList<QString> out;
+
+    for (int i = 0; i < dn_list.size(); i++) {
+        const QString &dn = dn_list[i];
+        const AdBulkResult &result = result_list[i];
+        const QString object_name = dn_get_name(dn);
+
+        if (result.success) {
+            d->success_message(QString(tr("Object %1 was moved to %2.")).arg(object_name, container_name));
+
+            out.append(dn);
+        } else {
+            const QString context = QString(tr("Failed to move object %1 to %2.")).arg(object_name, container_name);
+
+            d->error_message(context, result.error);
+        }
+    }
+
+    return out;
+}
+
+bool AdInterface::group_add_member_list(const QList<QString> &group_dn_list, const QList<QString> &user_dn_list) {
+    QList<AdBulkOp> op_list;
+    QList<QPair<QString, QString>> pair_list;
+
+    for (const QString &group_dn : group_dn_list) {
+        for (const QString &user_dn : user_dn_list) {
+            const AdBulkMod mod = ad_bulk_mod(AdBulkModType_Add, ATTRIBUTE_MEMBER, {user_dn.toUtf8()});
+            op_list.append(ad_bulk_modify(group_dn, {mod}));
+            pair_list.append({group_dn, user_dn});
+        }
+    }
+
+    const QList<AdBulkResult> result_list = bulk_run(op_list);
+
+    bool all_success = true;
+
+    for (int i = 0; i < result_list.size(); i++) {
+        const AdBulkResult &result = result_list[i];
+        const QString group_name = dn_get_name(pair_list[i].first);
+        const QString user_name = dn_get_name(pair_list[i].second);
+
+        if (result.success) {
+            d->success_message(QString(tr("Object %1 was added to group %2.")).arg(user_name, group_name));
+        } else {
+            const QString context = QString(tr("Failed to add object %1 to group %2.")).arg(user_name, group_name);
+
+            d->error_message(context, result.error);
+
+            all_success = false;
+        }
+    }
+
+    return all_success;
+}
+
+bool AdInterface::group_remove_member(const QString &group_dn, const QString &user_dn) {
+    const QByteArray user_dn_bytes = user_dn.toUtf8();
     const bool success = attribute_delete_value(group_dn, ATTRIBUTE_MEMBER, user_dn_bytes, DoStatusMsg_No);
 
     const QString user_name = dn_get_name(user_dn);
@@ -996,6 +2139,8 @@ bool AdInterface::user_set_primary_group(const QString &group_dn, const QString
 }
 
 bool AdInterface::user_set_pass(const QString &dn, const QString &password, const DoStatusMsg do_msg) {
+    const AdTraceSpan trace_span("user_set_pass", "ldap", dn);
+
     // NOTE: AD requires that the password:
     // 1. is surrounded by quotes
     // 2. is encoded as UTF16-LE
@@ -1075,59 +2220,67 @@ bool AdInterface::user_set_account_option(const QString &dn, AccountOption optio
         }
     }
 
-    const QString name = dn_get_name(dn);
+    d->account_option_message(dn, option, set, success, d->default_error());
 
-    if (success) {
-        const QString success_context = [option, set, name]() {
-            switch (option) {
-                case AccountOption_Disabled: {
-                    if (set) {
-                        return QString(tr("Object %1 has been disabled.")).arg(name);
-                    } else {
-                        return QString(tr("Object %1 has been enabled.")).arg(name);
-                    }
-                }
-                default: {
-                    const QString description = account_option_string(option);
+    return success;
+}
 
-                    if (set) {
-                        return QString(tr("Account option \"%1\" was turned ON for object %2.")).arg(description, name);
-                    } else {
-                        return QString(tr("Account option \"%1\" was turned OFF for object %2.")).arg(description, name);
-                    }
-                }
+QList<QString> AdInterface::user_set_account_option_list(const QList<QString> &dn_list, AccountOption option, bool set) {
+    QList<QString> out;
+
+    // NOTE: only options that are UAC bits can be changed
+    // in bulk, others are changed one by one
+    const bool is_uac_option = (option != AccountOption_CantChangePassword && option != AccountOption_PasswordExpired);
+    if (!is_uac_option) {
+        for (const QString &dn : dn_list) {
+            const bool success = user_set_account_option(dn, option, set);
+
+            if (success) {
+                out.append(dn);
             }
-        }();
+        }
 
-        d->success_message(success_context);
+        return out;
+    }
 
-        return true;
-    } else {
-        const QString context = [option, set, name]() {
-            switch (option) {
-                case AccountOption_Disabled: {
-                    if (set) {
-                        return QString(tr("Failed to disable object %1.")).arg(name);
-                    } else {
-                        return QString(tr("Failed to enable object %1.")).arg(name);
-                    }
-                }
-                default: {
-                    const QString description = account_option_string(option);
+    const QHash<QString, AdObject> object_map = search_objects(dn_list, {ATTRIBUTE_USER_ACCOUNT_CONTROL});
+    const int bit = account_option_bit(option);
 
-                    if (set) {
-                        return QString(tr("Failed to turn ON account option \"%1\" for object %2.")).arg(description, name);
-                    } else {
-                        return QString(tr("Failed to turn OFF account option \"%1\" for object %2.")).arg(description, name);
-                    }
-                }
-            }
-        }();
+    // NOTE: objects whose UAC couldn't be loaded are
+    // skipped, because writing the bit alone would wipe
+    // the rest of UAC, including account type bits
+    QList<QString> found_dn_list;
+    QList<AdBulkOp> op_list;
+    for (const QString &dn : dn_list) {
+        if (!object_map.contains(dn)) {
+            d->account_option_message(dn, option, set, false, tr("Failed to load object."));
 
-        d->error_message(context, d->default_error());
+            continue;
+        }
 
-        return false;
+        const int uac = object_map[dn].get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL);
+        const int updated_uac = bitmask_set(uac, bit, set);
+        const QByteArray updated_uac_bytes = QByteArray::number(updated_uac);
+
+        const AdBulkMod mod = ad_bulk_mod(AdBulkModType_Replace, ATTRIBUTE_USER_ACCOUNT_CONTROL, {updated_uac_bytes});
+        op_list.append(ad_bulk_modify(dn, {mod}));
+        found_dn_list.append(dn);
+    }
+
+    const QList<AdBulkResult> result_list = bulk_run(op_list);
+
+    for (int i = 0; i < found_dn_list.size(); i++) {
+        const QString &dn = found_dn_list[i];
+        const AdBulkResult &result = result_list[i];
+
+        d->account_option_message(dn, option, set, result.success, result.error);
+
+        if (result.success) {
+            out.append(dn);
+        }
     }
+
+    return out;
 }
 
 bool AdInterface::user_unlock(const QString &dn) {
@@ -1168,6 +2321,8 @@ bool AdInterface::computer_reset_account(const QString &dn) {
 }
 
 bool AdInterface::gpo_add(const QString &display_name, QString &dn_out) {
+    const AdTraceSpan trace_span("gpo_add", "smb", display_name);
+
     const bool is_domain_admin = logged_in_as_domain_admin();
 
     auto error_message = [&](const QString &error) {
@@ -1203,14 +2358,16 @@ bool AdInterface::gpo_add(const QString &display_name, QString &dn_out) {
     // some error cases and that shouldn't print any error
     // messages.
     auto cleanup = [&]() {
-        const AdObject gpc_object = search_object(gpc_dn);
+        SearchOptions exists_options;
+        exists_options.attrs_only = true;
+        const AdObject gpc_object = search_object(gpc_dn, QList<QString>(), exists_options);
         const bool gpc_exists = !gpc_object.is_empty();
         if (gpc_exists) {
             object_delete(gpc_dn);
         }
 
         struct stat filestat;
-        const int stat_result = smbc_stat(cstr(gpt_path), &filestat);
+        const int stat_result = smbc_stat(AdCString(gpt_path).get(), &filestat);
         const bool gpt_exists = (stat_result == 0);
         if (gpt_exists) {
             d->delete_gpt(gpt_path);
@@ -1223,7 +2380,7 @@ bool AdInterface::gpo_add(const QString &display_name, QString &dn_out) {
 
     // Create root dir
     // "smb://domain.alt/sysvol/domain.alt/Policies/{FF7E0880-F3AD-4540-8F1D-4472CB4A7044}"
-    const int result_mkdir_gpt = smbc_mkdir(cstr(gpt_path), 0755);
+    const int result_mkdir_gpt = smbc_mkdir(AdCString(gpt_path).get(), 0755);
     if (result_mkdir_gpt != 0) {
         error_message(tr("Failed to create GPT root dir."));
 
@@ -1233,7 +2390,7 @@ bool AdInterface::gpo_add(const QString &display_name, QString &dn_out) {
     }
 
     const QString gpt_machine_path = gpt_path + "/Machine";
-    const int result_mkdir_machine = smbc_mkdir(cstr(gpt_machine_path), 0755);
+    const int result_mkdir_machine = smbc_mkdir(AdCString(gpt_machine_path).get(), 0755);
     if (result_mkdir_machine != 0) {
         error_message(tr("Failed to create GPT machine dir."));
 
@@ -1243,7 +2400,7 @@ bool AdInterface::gpo_add(const QString &display_name, QString &dn_out) {
     }
 
     const QString gpt_user_path = gpt_path + "/User";
-    const int result_mkdir_user = smbc_mkdir(cstr(gpt_user_path), 0755);
+    const int result_mkdir_user = smbc_mkdir(AdCString(gpt_user_path).get(), 0755);
     if (result_mkdir_user != 0) {
         error_message(tr("Failed to create GPT user dir."));
 
@@ -1253,7 +2410,7 @@ bool AdInterface::gpo_add(const QString &display_name, QString &dn_out) {
     }
 
     const QString gpt_ini_path = gpt_path + "/GPT.INI";
-    const int ini_file = smbc_open(cstr(gpt_ini_path), O_WRONLY | O_CREAT, 0644);
+    const int ini_file = smbc_open(AdCString(gpt_ini_path).get(), O_WRONLY | O_CREAT, 0644);
     if (ini_file < 0) {
         error_message(tr("Failed to open GPT ini file."));
 
@@ -1346,6 +2503,8 @@ bool AdInterface::gpo_add(const QString &display_name, QString &dn_out) {
 }
 
 QList<QString> AdInterfacePrivate::gpo_get_gpt_contents(const QString &gpt_root_path, bool *ok) {
+    const AdTraceSpan trace_span("gpo_get_gpt_contents", "smb", gpt_root_path);
+
     // Collect all contents of the path into a list
     QList<QString> explore_stack;
     QList<QString> seen_stack;
@@ -1358,7 +2517,7 @@ QList<QString> AdInterfacePrivate::gpo_get_gpt_contents(const QString &gpt_root_
     while (!explore_stack.isEmpty()) {
         const QString path = explore_stack.takeLast();
 
-        const int dirp = smbc_opendir(cstr(path));
+        const int dirp = smbc_opendir(AdCString(path).get());
 
         if (dirp < 0) {
             *ok = false;
@@ -1411,6 +2570,8 @@ QList<QString> AdInterfacePrivate::gpo_get_gpt_contents(const QString &gpt_root_
 }
 
 bool AdInterface::gpo_delete(const QString &dn, bool *deleted_object) {
+    const AdTraceSpan trace_span("gpo_delete", "smb", dn);
+
     // NOTE: try to execute both steps, even if first one
     // (deleting gpc) fails
 
@@ -1484,141 +2645,44 @@ QString AdInterface::filesys_path_to_smb_path(const QString &filesys_path) const
 }
 
 bool AdInterface::ldap_init() {
-    const QString connect_error_context = tr("Failed to connect.");
-
-    const QString uri = [&]() {
-        QString out;
-
-        if (!d->dc.isEmpty()) {
-            out = "ldap://" + d->dc;
-
-            if (AdInterfacePrivate::s_port > 0) {
-                out = out + ":" + AdInterfacePrivate::s_port;
-            }
-        }
-
-        return out;
-    }();
-
-    if (uri.isEmpty()) {
-        return false;
-    }
-
-    int result;
-
-    // NOTE: this doesn't leak memory. False positive.
-    result = ldap_initialize(&d->ld, cstr(uri));
-    if (result != LDAP_SUCCESS) {
-        ldap_memfree(d->ld);
-        d->error_message(tr("Failed to initialize LDAP library."), strerror(errno));
-
-        return false;
-    }
-
-    auto option_error = [&](const QString &option) {
-        d->error_message(connect_error_context, QString(tr("Failed to set ldap option %1.")).arg(option));
-    };
-
-    // Set version
-    const int version = LDAP_VERSION3;
-    result = ldap_set_option(d->ld, LDAP_OPT_PROTOCOL_VERSION, &version);
-    if (result != LDAP_OPT_SUCCESS) {
-        option_error("LDAP_OPT_PROTOCOL_VERSION");
-        return false;
-    }
-
-    // Disable referrals
-    result = ldap_set_option(d->ld, LDAP_OPT_REFERRALS, LDAP_OPT_OFF);
-    if (result != LDAP_OPT_SUCCESS) {
-        option_error("LDAP_OPT_REFERRALS");
-        return false;
-    }
-
-    // Set SASL propertry min_ssf to the minimum acceptable security layer strength.
-    // SSF is a rough indication of how secure the connection is. A connection
-    // secured by 56-bit DES would have an SSF of 56.
-    const char *sasl_secprops = "minssf=56";
-    result = ldap_set_option(d->ld, LDAP_OPT_X_SASL_SECPROPS, sasl_secprops);
-    if (result != LDAP_SUCCESS) {
-        option_error("LDAP_OPT_X_SASL_SECPROPS");
-        return false;
-    }
-
-    result = ldap_set_option(d->ld, LDAP_OPT_X_SASL_NOCANON, AdInterfacePrivate::s_sasl_nocanon);
-    if (result != LDAP_SUCCESS) {
-        option_error("LDAP_OPT_X_SASL_NOCANON");
-        return false;
-    }
-
-    const int cert_strategy = [&]() {
-        switch (AdInterfacePrivate::s_cert_strat) {
-            case CertStrategy_Never: return LDAP_OPT_X_TLS_NEVER;
-            case CertStrategy_Hard: return LDAP_OPT_X_TLS_HARD;
-            case CertStrategy_Demand: return LDAP_OPT_X_TLS_DEMAND;
-            case CertStrategy_Allow: return LDAP_OPT_X_TLS_ALLOW;
-            case CertStrategy_Try: return LDAP_OPT_X_TLS_TRY;
-        }
-
-        return LDAP_OPT_X_TLS_NEVER;
-    }();
-
-    ldap_set_option(d->ld, LDAP_OPT_X_TLS_REQUIRE_CERT, &cert_strategy);
-    if (result != LDAP_SUCCESS) {
-        option_error("LDAP_OPT_X_TLS_REQUIRE_CERT");
-        return false;
-    }
-
-    // Setup sasl_defaults_gssapi
-    struct sasl_defaults_gssapi defaults;
-    defaults.mech = (char *) "GSSAPI";
-    ldap_get_option(d->ld, LDAP_OPT_X_SASL_REALM, &defaults.realm);
-    ldap_get_option(d->ld, LDAP_OPT_X_SASL_AUTHCID, &defaults.authcid);
-    ldap_get_option(d->ld, LDAP_OPT_X_SASL_AUTHZID, &defaults.authzid);
-    defaults.passwd = NULL;
+    d->ld_key = d->connection_key(d->dc);
 
-    // Perform bind operation
-    unsigned sasl_flags = LDAP_SASL_QUIET;
-    result = ldap_sasl_interactive_bind_s(d->ld, NULL, defaults.mech, NULL, NULL, sasl_flags, sasl_interact_gssapi, &defaults);
-    ldap_memfree(defaults.realm);
-    ldap_memfree(defaults.authcid);
-    ldap_memfree(defaults.authzid);
-    if (result != LDAP_SUCCESS) {
-        d->error_message_plain(tr("Failed to connect to server. Check your connection and make sure you have initialized your credentials using kinit."));
-        d->error_message_plain(d->default_error());
+    return d->ldap_connect(d->dc, &d->ld, &d->ld_is_bound, &d->client_user, DoStatusMsg_Yes);
+}
 
-        return false;
+void AdInterface::ldap_free() {
+    if (d->ld != NULL) {
+        d->async_abandon_all();
     }
 
-    d->client_user = [&]() {
-        char *out_cstr = NULL;
-        ldap_get_option(d->ld, LDAP_OPT_X_SASL_USERNAME, &out_cstr);
-
-        if (out_cstr == NULL) {
-            return QString();
+    if (d->ld_is_bound) {
+        // Return connection to pool so that it can be
+        // reused by next AdInterface, unless the
+        // connection was lost
+        if (d->ld_is_broken) {
+            AdConnectionPool::instance()->discard(d->ld);
+        } else {
+            AdConnectionPool::instance()->release(d->ld_key, d->ld, d->client_user);
         }
-
-        QString out = QString(out_cstr);
-        out = out.toLower();
-
-        ldap_memfree(out_cstr);
-
-        return out;
-    }();
-
-    return true;
-}
-
-void AdInterface::ldap_free() {
-    if (d->is_connected) {
-        ldap_unbind_ext(d->ld, NULL, NULL);
     } else {
         ldap_memfree(d->ld);
     }
+
+    d->ld = NULL;
+    d->ld_is_bound = false;
+    d->ld_is_broken = false;
+
+    d->free_hedge_ld();
 }
 
 bool AdInterface::init_smb_context() {
     const QString connect_error_context = tr("Failed to connect.");
 
+    // NOTE: context is created once and shared by all
+    // instances, so two instances created at the same time
+    // on different threads must not both create it
+    QMutexLocker locker(&AdInterfacePrivate::shared_mutex);
+
     if (AdInterfacePrivate::smbc == NULL) {
         smbc_init(get_auth_data_fn, 0);
         AdInterfacePrivate::smbc = smbc_new_context();
@@ -1635,6 +2699,8 @@ bool AdInterface::init_smb_context() {
 }
 
 bool AdInterface::gpo_check_perms(const QString &gpo, bool *ok) {
+    const AdTraceSpan trace_span("gpo_check_perms", "smb", gpo);
+
     // NOTE: skip perms check for non-admins, because don't
     // have enough rights to get full sd
     if (!logged_in_as_domain_admin()) {
@@ -1663,7 +2729,10 @@ bool AdInterface::gpo_check_perms(const QString &gpo, bool *ok) {
     const QString gpt_sd = [&]() {
         const QString filesys_path = gpc_object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
         const QString smb_path = filesys_path_to_smb_path(filesys_path);
-        const char *smb_path_cstr = cstr(smb_path);
+        const AdCString smb_path_string(smb_path);
+        const char *smb_path_cstr = smb_path_string.get();
+
+        const AdTraceSpan getxattr_span("smbc_getxattr", "smb", smb_path);
 
         // NOTE: the length of gpt sd string doesn't have a
         // well defined bound, so we have to use an
@@ -1758,6 +2827,8 @@ bool AdInterface::gpo_check_perms(const QString &gpo, bool *ok) {
 }
 
 bool AdInterface::gpo_sync_perms(const QString &dn) {
+    const AdTraceSpan trace_span("gpo_sync_perms", "smb", dn);
+
     // First get GPC descriptor
     const QList<QString> attributes = QList<QString>();
     const bool get_sacl = true;
@@ -1788,124 +2859,1059 @@ bool AdInterface::gpo_sync_perms(const QString &dn) {
     }
 
     // Set descriptor on all GPT contents
+    const AdCString gpt_sd_cstr(gpt_sd_string);
     for (const QString &path : path_list) {
-        const int set_sd_result = smbc_setxattr(cstr(path), "system.nt_sec_desc.*", cstr(gpt_sd_string), strlen(cstr(gpt_sd_string)), 0);
+        const int set_sd_result = smbc_setxattr(AdCString(path).get(), "system.nt_sec_desc.*", gpt_sd_cstr.get(), gpt_sd_cstr.size(), 0);
         if (set_sd_result != 0) {
             const QString error = QString(tr("Failed to set permissions, %1.")).arg(strerror(errno));
             d->error_message(error_context, error);
 
-            return false;
+            return false;
+        }
+    }
+
+    d->success_message(QString(tr("Synced permissions of GPO \"%1\".")).arg(name));
+
+    return true;
+}
+
+bool AdInterface::gpo_get_sysvol_version(const AdObject &gpc_object, int *version_out) {
+    const AdTraceSpan trace_span("gpo_get_sysvol_version", "smb", gpc_object.get_dn());
+
+    const QString error_context = tr("Failed to load GPO's sysvol version.");
+
+    const QString ini_contents = [&]() {
+        const QString filesys_path = gpc_object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
+        const QString smb_path = filesys_path_to_smb_path(filesys_path);
+
+        const QString ini_path = smb_path + "/GPT.INI";
+
+        const int ini_fd = smbc_open(AdCString(ini_path).get(), O_RDONLY, 0);
+
+        if (ini_fd < 0) {
+            const QString error_text = QString(tr("Failed to open GPT.INI, %1.")).arg(strerror(errno));
+            d->error_message(error_context, error_text);
+
+            return QString();
+        }
+
+        const size_t buffer_size = 2000;
+        char buffer[buffer_size];
+        const ssize_t bytes_read = smbc_read(ini_fd, buffer, buffer_size);
+
+        if (bytes_read < 0) {
+            const QString error_text = QString(tr("Failed to open GPT.INI, %1.")).arg(strerror(errno));
+            d->error_message(error_context, error_text);
+
+            return QString();
+        }
+
+        smbc_close(ini_fd);
+
+        return QString(buffer);
+    }();
+
+    if (ini_contents.isEmpty()) {
+        return false;
+    }
+
+    const int version = [&]() {
+        int out;
+
+        const int scan_result = sscanf(AdCString(ini_contents).get(), "[General]\r\nVersion=%i\r\n", &out);
+        const bool scan_success = (scan_result > 0);
+
+        if (!scan_success) {
+            const QString error_text = QString(tr("Failed to extract version from GPT.INI, %1.")).arg(strerror(errno));
+            d->error_message(error_context, error_text);
+
+            return -1;
+        }
+
+        return out;
+    }();
+
+    if (version >= 0) {
+        *version_out = version;
+
+        return true;
+    } else {
+        return false;
+    }
+}
+
+void AdInterfacePrivate::success_message(const QString &msg, const DoStatusMsg do_msg) {
+    if (do_msg == DoStatusMsg_No) {
+        return;
+    }
+
+    const AdMessage message(msg, AdMessageType_Success);
+    messages.append(message);
+}
+
+void AdInterfacePrivate::error_message(const QString &context, const QString &error, const DoStatusMsg do_msg) {
+    if (do_msg == DoStatusMsg_No) {
+        return;
+    }
+
+    QString msg = context;
+    if (!error.isEmpty()) {
+        msg += QString(tr(" Error: \"%1\"")).arg(error);
+
+        // Add period if needed, because some error strings,
+        // like the ones from LDAP, might not have one
+        if (!msg.endsWith(".")) {
+            msg += ".";
+        }
+    }
+
+    const AdMessage message(msg, AdMessageType_Error);
+    messages.append(message);
+}
+
+void AdInterfacePrivate::error_message_plain(const QString &text, const DoStatusMsg do_msg) {
+    if (do_msg == DoStatusMsg_No) {
+        return;
+    }
+
+    const AdMessage message(text, AdMessageType_Error);
+    messages.append(message);
+}
+
+// Helper f-n for search_visit() f-ns
+bool AdInterfacePrivate::visit_search(AdAsyncSearch *search, const std::function<bool(const AdEntryView &entry)> &visitor) {
+    bool send_success = async_send_page(search);
+    if (!send_success) {
+        return false;
+    }
+
+    // NOTE: messages are received one at a time and freed
+    // right after visiting, so memory use doesn't depend
+    // on the amount of results
+    while (true) {
+        LDAPMessage *message = NULL;
+        const int message_type = ldap_result(ld, search->msgid, LDAP_MSG_ONE, NULL, &message);
+
+        if (message_type <= 0) {
+            qDebug() << "Error in ldap_result: " << ldap_err2string(get_ldap_result());
+
+            check_ld_result(get_ldap_result());
+
+            search->failed = true;
+
+            return false;
+        }
+
+        switch (message_type) {
+            case LDAP_RES_SEARCH_ENTRY: {
+                const bool keep_going = [&]() {
+                    const AdEntryView entry(ld, message);
+
+                    search->total_byte_count += entry.value_size();
+
+                    return visitor(entry);
+                }();
+
+                ldap_msgfree(message);
+
+                search->page_entry_count++;
+                search->total_entry_count++;
+
+                if (!keep_going) {
+                    ldap_abandon_ext(ld, search->msgid, NULL, NULL);
+
+                    return true;
+                }
+
+                break;
+            }
+            case LDAP_RES_SEARCH_RESULT: {
+                bool more_pages = false;
+                const bool page_success = async_handle_page_result(search, message, &more_pages);
+
+                ldap_msgfree(message);
+
+                if (!page_success) {
+                    return false;
+                }
+
+                if (!more_pages) {
+                    return true;
+                }
+
+                send_success = async_send_page(search);
+                if (!send_success) {
+                    return false;
+                }
+
+                break;
+            }
+            default: {
+                ldap_msgfree(message);
+
+                break;
+            }
+        }
+    }
+}
+
+int AdInterfacePrivate::async_start(AdAsyncSearch *search) {
+    const bool send_success = async_send_page(search);
+    if (!send_success) {
+        delete search;
+
+        return -1;
+    }
+
+    const int search_id = async_search_id_max;
+    async_search_id_max++;
+
+    async_search_map[search_id] = search;
+    async_msgid_map[search->msgid] = search_id;
+
+    return search_id;
+}
+
+// Sends request for next page of an async search and
+// updates message id of the search
+bool AdInterfacePrivate::async_send_page(AdAsyncSearch *search) {
+    LDAPControl *page_control = NULL;
+    LDAPControl *sd_control = NULL;
+    LDAPControl *show_deleted_control = NULL;
+    LDAPControl *notification_control = NULL;
+    LDAPSortKey **sort_key_list = NULL;
+    LDAPControl *sort_control = NULL;
+    LDAPControl *vlv_control = NULL;
+
+    auto cleanup = [&]() {
+        ldap_control_free(page_control);
+        ldap_control_free(sd_control);
+        ldap_control_free(show_deleted_control);
+        ldap_control_free(notification_control);
+        ldap_free_sort_keylist(sort_key_list);
+        ldap_control_free(sort_control);
+        ldap_control_free(vlv_control);
+    };
+
+    const int is_critical = 1;
+
+    int result;
+    LDAPControl *server_controls[5] = {NULL, NULL, NULL, NULL, NULL};
+    int control_count = 0;
+
+    // NOTE: notification searches can't be combined with
+    // paging or sd flags
+    if (search->notify) {
+        result = ldap_control_create(LDAP_SERVER_NOTIFICATION_OID, is_critical, NULL, 0, &notification_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create notification control: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        server_controls[control_count] = notification_control;
+        control_count++;
+    } else if (search->is_window) {
+        // NOTE: window is a single request, so it's not
+        // paged
+        result = create_sd_control(false, is_critical, &sd_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create sd control: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        result = ldap_create_sort_keylist(&sort_key_list, (char *) search->sort_attribute.constData());
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create sort key list: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        result = ldap_create_sort_control(ld, sort_key_list, is_critical, &sort_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create sort control: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        // NOTE: VLV offsets start from 1. Target entry is
+        // the first entry of the window, so window is made
+        // up of target and entries after it. Content count
+        // of 0 tells the server to use offset as is.
+        LDAPVLVInfo vlv_info;
+        vlv_info.ldvlv_version = 1;
+        vlv_info.ldvlv_before_count = 0;
+        vlv_info.ldvlv_after_count = qMax(search->window_count - 1, 0);
+        vlv_info.ldvlv_offset = search->window_offset + 1;
+        vlv_info.ldvlv_count = search->window_content_count;
+        vlv_info.ldvlv_attrvalue = NULL;
+        vlv_info.ldvlv_context = NULL;
+        vlv_info.ldvlv_extradata = NULL;
+
+        result = ldap_create_vlv_control(ld, &vlv_info, &vlv_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create vlv control: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        server_controls[control_count] = sort_control;
+        control_count++;
+        server_controls[control_count] = vlv_control;
+        control_count++;
+        server_controls[control_count] = sd_control;
+        control_count++;
+    } else {
+        result = create_sd_control(search->get_sacl, is_critical, &sd_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create sd control: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        result = ldap_create_page_control(ld, search->page_size, search->cookie, is_critical, &page_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create page control: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        server_controls[control_count] = page_control;
+        control_count++;
+        server_controls[control_count] = sd_control;
+        control_count++;
+    }
+
+    if (search->show_deleted) {
+        result = ldap_control_create(LDAP_SERVER_SHOW_DELETED_OID, is_critical, NULL, 0, &show_deleted_control);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to create show deleted control: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        server_controls[control_count] = show_deleted_control;
+        control_count++;
+    }
+
+    // NOTE: empty list means "all attributes", which is
+    // denoted by NULL
+    QVector<char *> attributes_list;
+    for (const QByteArray &attribute : search->attributes) {
+        attributes_list.append((char *) attribute.constData());
+    }
+    attributes_list.append(NULL);
+    char **attributes = (search->attributes.isEmpty() ? NULL : attributes_list.data());
+
+    const char *filter = (search->filter.isEmpty() ? NULL : search->filter.constData());
+
+    // NOTE: controls are encoded into the request, so it's
+    // fine to free them right after sending
+    const int attrsonly = 0;
+    result = ldap_search_ext(ld, search->base.constData(), search->scope, filter, attributes, attrsonly, server_controls, NULL, NULL, LDAP_NO_LIMIT, &search->msgid);
+    check_ld_result(result);
+
+    cleanup();
+
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Error in ldap_search_ext: " << ldap_err2string(result);
+
+        search->failed = true;
+
+        return false;
+    }
+
+    search->page_entry_count = 0;
+    search->page_timer.start();
+
+    return true;
+}
+
+// Processes final message of a page. Returns false if
+// search failed. "more_pages" is set if there are more
+// pages to request.
+bool AdInterfacePrivate::async_handle_page_result(AdAsyncSearch *search, LDAPMessage *message, bool *more_pages) {
+    *more_pages = false;
+
+    search->total_page_count++;
+
+    LDAPControl **returned_controls = NULL;
+    struct berval *new_cookie = NULL;
+    struct berval *vlv_context = NULL;
+
+    auto cleanup = [&]() {
+        ldap_controls_free(returned_controls);
+        ber_bvfree(new_cookie);
+        ber_bvfree(vlv_context);
+    };
+
+    // NOTE: ldap_result2error() sets result code of the
+    // handle, so that default_error() works
+    const int search_result = ldap_result2error(ld, message, 0);
+    if ((search_result != LDAP_SUCCESS) && (search_result != LDAP_PARTIAL_RESULTS)) {
+        if (search_result != LDAP_NO_SUCH_OBJECT) {
+            qDebug() << "Error in async search: " << ldap_err2string(search_result);
+        }
+
+        search->failed = true;
+
+        cleanup();
+        return false;
+    }
+
+    int errcodep;
+    int result = ldap_parse_result(ld, message, &errcodep, NULL, NULL, NULL, &returned_controls, false);
+    if (result != LDAP_SUCCESS) {
+        qDebug() << "Failed to parse result: " << ldap_err2string(result);
+
+        search->failed = true;
+
+        cleanup();
+        return false;
+    }
+
+    if (search->is_window) {
+        LDAPControl *vlvresponse_control = ldap_control_find(LDAP_CONTROL_VLVRESPONSE, returned_controls, NULL);
+        if (vlvresponse_control == NULL) {
+            qDebug() << "Server didn't return vlv response control";
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        ber_int_t target_pos;
+        ber_int_t list_count;
+        ber_int_t vlv_result;
+        result = ldap_parse_vlvresponse_control(ld, vlvresponse_control, &target_pos, &list_count, &vlv_context, &vlv_result);
+        if (result != LDAP_SUCCESS || vlv_result != LDAP_SUCCESS) {
+            qDebug() << "Failed to parse vlv response control: " << ldap_err2string(result) << ldap_err2string(vlv_result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        search->window_content_count = list_count;
+
+        cleanup();
+        return true;
+    }
+
+    search->page_size = AdPageSizeTuner::instance()->next_page_size(search->is_first_page, search->page_size, search->page_entry_count, search->page_timer.elapsed(), &search->msec_per_entry);
+    search->is_first_page = false;
+
+    ber_bvfree(search->cookie);
+    search->cookie = NULL;
+
+    // NOTE: rootDSE search doesn't return page response
+    // control, that's not an error
+    LDAPControl *pageresponse_control = ldap_control_find(LDAP_CONTROL_PAGEDRESULTS, returned_controls, NULL);
+    if (pageresponse_control != NULL) {
+        ber_int_t total_count;
+        new_cookie = (struct berval *) malloc(sizeof(struct berval));
+        result = ldap_parse_pageresponse_control(ld, pageresponse_control, &total_count, new_cookie);
+        if (result != LDAP_SUCCESS) {
+            qDebug() << "Failed to parse pageresponse control: " << ldap_err2string(result);
+
+            search->failed = true;
+
+            cleanup();
+            return false;
+        }
+
+        if (new_cookie->bv_len > 0) {
+            search->cookie = ber_bvdup(new_cookie);
+            *more_pages = true;
+        }
+    }
+
+    cleanup();
+    return true;
+}
+
+// NOTE: handle is reused after AdInterface is destroyed,
+// so outstanding requests have to be abandoned first
+void AdInterfacePrivate::async_abandon_all() {
+    for (AdAsyncSearch *search : async_search_map.values()) {
+        ldap_abandon_ext(ld, search->msgid, NULL, NULL);
+        delete search;
+    }
+
+    async_search_map.clear();
+    async_msgid_map.clear();
+    async_window_map.clear();
+    async_window_count_map.clear();
+}
+
+void AdInterfacePrivate::log_search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes) {
+    if (!s_log_searches) {
+        return;
+    }
+
+    const QString attributes_string = "{" + attributes.join(",") + "}";
+
+    const QString scope_string = [&scope]() -> QString {
+        switch (scope) {
+            case SearchScope_Object: return "object";
+            case SearchScope_Children: return "children";
+            case SearchScope_Descendants: return "descendants";
+            case SearchScope_All: return "all";
+            default: break;
+        }
+        return QString();
+    }();
+
+    success_message(QString(AdInterface::tr("Search:\n\tfilter = \"%1\"\n\tattributes = %2\n\tscope = \"%3\"\n\tbase = \"%4\"")).arg(filter, attributes_string, scope_string, base));
+}
+
+// Global catalog servers are found by their own SRV
+// records, under forest root domain. If current DC is also
+// a global catalog, it is preferred, because it's likely to
+// already have a pooled connection and be close to client.
+bool AdInterfacePrivate::connect_gc() {
+    const QString site = AdDcLocator::instance()->get_client_site(domain);
+    const QList<QString> gc_list = get_gc_hosts(forest, site);
+
+    if (gc_list.isEmpty()) {
+        error_message_plain(AdInterface::tr("Failed to find global catalog servers. Make sure that the forest has at least one global catalog."));
+
+        return false;
+    }
+
+    const QString shared_dc = get_shared_dc();
+
+    dc = [&]() {
+        if (gc_list.contains(shared_dc)) {
+            return shared_dc;
+        } else if (AdDcSelector::instance()->ranking_enabled()) {
+            const QList<QString> ranked_list = AdDcSelector::instance()->rank(gc_list, GLOBAL_CATALOG_PORT);
+
+            return ranked_list[0];
+        } else {
+            return gc_list[0];
+        }
+    }();
+
+    ld_key = connection_key(dc);
+    ld = AdConnectionPool::instance()->acquire(ld_key, &client_user);
+    ld_is_bound = (ld != NULL);
+
+    if (ld_is_bound) {
+        return true;
+    }
+
+    return ldap_connect(dc, &ld, &ld_is_bound, &client_user, DoStatusMsg_Yes);
+}
+
+// NOTE: "ld_out" is set once handle is initialized, even if
+// bind fails later, so that caller can free it
+bool AdInterfacePrivate::ldap_connect(const QString &target_dc, LDAP **ld_out, bool *is_bound_out, QString *client_user_out, const DoStatusMsg do_msg) {
+    const AdTraceSpan trace_span("ldap_connect", "ldap", target_dc);
+
+    const QString connect_error_context = AdInterface::tr("Failed to connect.");
+
+    const QString uri = [&]() {
+        QString out;
+
+        if (!target_dc.isEmpty()) {
+            out = "ldap://" + target_dc;
+
+            if (server == AdServer_GlobalCatalog) {
+                out = out + ":" + QString::number(GLOBAL_CATALOG_PORT);
+            } else if (s_port > 0) {
+                out = out + ":" + QString::number(s_port);
+            }
+        }
+
+        return out;
+    }();
+
+    if (uri.isEmpty()) {
+        return false;
+    }
+
+    int result;
+
+    QElapsedTimer connect_timer;
+    connect_timer.start();
+
+    // NOTE: this doesn't leak memory. False positive.
+    LDAP *new_ld = NULL;
+    result = ldap_initialize(&new_ld, AdCString(uri).get());
+    if (result != LDAP_SUCCESS) {
+        ldap_memfree(new_ld);
+        error_message(AdInterface::tr("Failed to initialize LDAP library."), strerror(errno), do_msg);
+
+        return false;
+    }
+
+    *ld_out = new_ld;
+
+    auto option_error = [&](const QString &option) {
+        error_message(connect_error_context, QString(AdInterface::tr("Failed to set ldap option %1.")).arg(option), do_msg);
+    };
+
+    // Set version
+    const int version = LDAP_VERSION3;
+    result = ldap_set_option(new_ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+    if (result != LDAP_OPT_SUCCESS) {
+        option_error("LDAP_OPT_PROTOCOL_VERSION");
+        return false;
+    }
+
+    // Disable referrals
+    result = ldap_set_option(new_ld, LDAP_OPT_REFERRALS, LDAP_OPT_OFF);
+    if (result != LDAP_OPT_SUCCESS) {
+        option_error("LDAP_OPT_REFERRALS");
+        return false;
+    }
+
+    // Set SASL propertry min_ssf to the minimum acceptable security layer strength.
+    // SSF is a rough indication of how secure the connection is. A connection
+    // secured by 56-bit DES would have an SSF of 56.
+    const char *sasl_secprops = "minssf=56";
+    result = ldap_set_option(new_ld, LDAP_OPT_X_SASL_SECPROPS, sasl_secprops);
+    if (result != LDAP_SUCCESS) {
+        option_error("LDAP_OPT_X_SASL_SECPROPS");
+        return false;
+    }
+
+    result = ldap_set_option(new_ld, LDAP_OPT_X_SASL_NOCANON, s_sasl_nocanon);
+    if (result != LDAP_SUCCESS) {
+        option_error("LDAP_OPT_X_SASL_NOCANON");
+        return false;
+    }
+
+    const int cert_strategy = [&]() {
+        switch (s_cert_strat) {
+            case CertStrategy_Never: return LDAP_OPT_X_TLS_NEVER;
+            case CertStrategy_Hard: return LDAP_OPT_X_TLS_HARD;
+            case CertStrategy_Demand: return LDAP_OPT_X_TLS_DEMAND;
+            case CertStrategy_Allow: return LDAP_OPT_X_TLS_ALLOW;
+            case CertStrategy_Try: return LDAP_OPT_X_TLS_TRY;
+        }
+
+        return LDAP_OPT_X_TLS_NEVER;
+    }();
+
+    ldap_set_option(new_ld, LDAP_OPT_X_TLS_REQUIRE_CERT, &cert_strategy);
+    if (result != LDAP_SUCCESS) {
+        option_error("LDAP_OPT_X_TLS_REQUIRE_CERT");
+        return false;
+    }
+
+    // Setup sasl_defaults_gssapi
+    struct sasl_defaults_gssapi defaults;
+    defaults.mech = (char *) "GSSAPI";
+    ldap_get_option(new_ld, LDAP_OPT_X_SASL_REALM, &defaults.realm);
+    ldap_get_option(new_ld, LDAP_OPT_X_SASL_AUTHCID, &defaults.authcid);
+    ldap_get_option(new_ld, LDAP_OPT_X_SASL_AUTHZID, &defaults.authzid);
+    defaults.passwd = NULL;
+
+    // Perform bind operation
+    //
+    // NOTE: ldap_initialize() doesn't connect, connection
+    // is opened by the bind, so connect time includes bind
+    // time
+    QElapsedTimer bind_timer;
+    bind_timer.start();
+    unsigned sasl_flags = LDAP_SASL_QUIET;
+    result = ldap_sasl_interactive_bind_s(new_ld, NULL, defaults.mech, NULL, NULL, sasl_flags, sasl_interact_gssapi, &defaults);
+    record_operation(AdMetricsOp_Bind, bind_timer.elapsed(), result);
+    record_operation(AdMetricsOp_Connect, connect_timer.elapsed(), result);
+    ldap_memfree(defaults.realm);
+    ldap_memfree(defaults.authcid);
+    ldap_memfree(defaults.authzid);
+    if (result != LDAP_SUCCESS) {
+        error_message_plain(AdInterface::tr("Failed to connect to server. Check your connection and make sure you have initialized your credentials using kinit."), do_msg);
+        error_message_plain(default_error(), do_msg);
+
+        return false;
+    }
+
+    *is_bound_out = true;
+    AdConnectionPool::instance()->add_connected(connect_timer.elapsed());
+
+    *client_user_out = [&]() {
+        char *out_cstr = NULL;
+        ldap_get_option(new_ld, LDAP_OPT_X_SASL_USERNAME, &out_cstr);
+
+        if (out_cstr == NULL) {
+            return QString();
+        }
+
+        QString out = QString(out_cstr);
+        out = out.toLower();
+
+        ldap_memfree(out_cstr);
+
+        return out;
+    }();
+
+    return true;
+}
+
+// Performs search on primary DC and if it doesn't respond
+// within hedge delay, sends same search to second best DC.
+// First successful response is used and the other request
+// is abandoned. Returns result code like
+// ldap_search_ext_s(). Handle which returned the result is
+// written to "res_ld_out". Latency of the DC that
+// responded is recorded.
+int AdInterfacePrivate::search_hedged(const char *base, const int scope, const char *filter, char **attributes, const int attrsonly, LDAPControl **server_controls, LDAPMessage **res_out, LDAP **res_ld_out) {
+    *res_ld_out = ld;
+
+    QElapsedTimer primary_timer;
+    primary_timer.start();
+
+    int primary_msgid = 0;
+    const int send_result = ldap_search_ext(ld, base, scope, filter, attributes, attrsonly, server_controls, NULL, NULL, LDAP_NO_LIMIT, &primary_msgid);
+    if (send_result != LDAP_SUCCESS) {
+        return send_result;
+    }
+
+    // NOTE: ldap_result() returns 0 on timeout, -1 on
+    // error and message type on success
+    auto wait_for_result = [](LDAP *wait_ld, const int msgid, struct timeval *timeout, LDAPMessage **res_wait_out) {
+        return ldap_result(wait_ld, msgid, LDAP_MSG_ALL, timeout, res_wait_out);
+    };
+
+    // NOTE: ldap_result2error() also sets result code of
+    // the handle, same as ldap_search_ext_s() does
+    auto finish_primary = [&](const int wait_result) {
+        if (hedge_ld_broken) {
+            free_hedge_ld();
+        }
+
+        if (wait_result < 0) {
+            return get_ldap_result();
+        }
+
+        const int result = ldap_result2error(ld, *res_out, 0);
+
+        if (result == LDAP_SUCCESS) {
+            AdDcSelector::instance()->record_latency(dc, primary_timer.elapsed());
+        }
+
+        return result;
+    };
+
+    const qint64 hedge_delay = AdDcSelector::instance()->hedge_delay_msec(dc);
+    struct timeval hedge_timeout;
+    hedge_timeout.tv_sec = hedge_delay / 1000;
+    hedge_timeout.tv_usec = (hedge_delay % 1000) * 1000;
+
+    int primary_wait = wait_for_result(ld, primary_msgid, &hedge_timeout, res_out);
+    if (primary_wait != 0) {
+        return finish_primary(primary_wait);
+    }
+
+    // Primary is slow, send hedge request. If there's no
+    // idle handle for the hedge DC, keep waiting for
+    // primary.
+    LDAP *second_ld = get_hedge_ld();
+
+    QElapsedTimer hedge_timer;
+    hedge_timer.start();
+
+    int hedge_msgid = 0;
+    bool hedge_active = [&]() {
+        if (second_ld == NULL) {
+            return false;
+        }
+
+        const int hedge_send_result = ldap_search_ext(second_ld, base, scope, filter, attributes, attrsonly, server_controls, NULL, NULL, LDAP_NO_LIMIT, &hedge_msgid);
+        if (hedge_send_result != LDAP_SUCCESS) {
+            hedge_ld_broken = true;
+
+            return false;
+        }
+
+        return true;
+    }();
+
+    // NOTE: hedge handle that had a request abandoned or
+    // failed may still receive a late response or be
+    // disconnected, so it's not reused
+    auto abandon_hedge = [&]() {
+        ldap_abandon_ext(second_ld, hedge_msgid, NULL, NULL);
+        hedge_ld_broken = true;
+        hedge_active = false;
+    };
+
+    // NOTE: ldap_result() can only wait on one handle, so
+    // sockets of both handles are waited on with poll()
+    // and then messages that arrived are collected without
+    // waiting
+    auto get_fd = [](LDAP *fd_ld) {
+        int fd = -1;
+        ldap_get_option(fd_ld, LDAP_OPT_DESC, &fd);
+
+        return fd;
+    };
+
+    struct pollfd poll_fds[2];
+    poll_fds[0].fd = get_fd(ld);
+    poll_fds[0].events = POLLIN;
+    poll_fds[1].fd = (hedge_active ? get_fd(second_ld) : -1);
+    poll_fds[1].events = POLLIN;
+
+    if ((poll_fds[0].fd < 0 || poll_fds[1].fd < 0) && hedge_active) {
+        abandon_hedge();
+    }
+
+    struct timeval zero_timeout;
+    zero_timeout.tv_sec = 0;
+    zero_timeout.tv_usec = 0;
+
+    // Wait for both requests until one of them responds.
+    // If hedge fails, fall back to waiting for primary
+    // only.
+    while (true) {
+        if (!hedge_active) {
+            primary_wait = wait_for_result(ld, primary_msgid, NULL, res_out);
+
+            return finish_primary(primary_wait);
         }
-    }
 
-    d->success_message(QString(tr("Synced permissions of GPO \"%1\".")).arg(name));
+        primary_wait = wait_for_result(ld, primary_msgid, &zero_timeout, res_out);
+        if (primary_wait != 0) {
+            abandon_hedge();
 
-    return true;
-}
+            return finish_primary(primary_wait);
+        }
 
-bool AdInterface::gpo_get_sysvol_version(const AdObject &gpc_object, int *version_out) {
-    const QString error_context = tr("Failed to load GPO's sysvol version.");
+        LDAPMessage *hedge_res = NULL;
+        const int hedge_wait = wait_for_result(second_ld, hedge_msgid, &zero_timeout, &hedge_res);
+        if (hedge_wait > 0) {
+            const int hedge_result = ldap_result2error(second_ld, hedge_res, 0);
 
-    const QString ini_contents = [&]() {
-        const QString filesys_path = gpc_object.get_string(ATTRIBUTE_GPC_FILE_SYS_PATH);
-        const QString smb_path = filesys_path_to_smb_path(filesys_path);
+            if (hedge_result == LDAP_SUCCESS) {
+                ldap_abandon_ext(ld, primary_msgid, NULL, NULL);
 
-        const QString ini_path = smb_path + "/GPT.INI";
+                // NOTE: primary didn't respond in all this
+                // time, so record that as a lower bound of
+                // it's latency. Otherwise only it's fast
+                // responses would be recorded and it would
+                // keep being ranked above the hedge DC.
+                AdDcSelector::instance()->record_latency(hedge_dc, hedge_timer.elapsed());
+                AdDcSelector::instance()->record_latency(dc, primary_timer.elapsed());
 
-        const int ini_fd = smbc_open(cstr(ini_path), O_RDONLY, 0);
+                *res_out = hedge_res;
+                *res_ld_out = second_ld;
 
-        if (ini_fd < 0) {
-            const QString error_text = QString(tr("Failed to open GPT.INI, %1.")).arg(strerror(errno));
-            d->error_message(error_context, error_text);
+                return hedge_result;
+            } else {
+                ldap_msgfree(hedge_res);
+                hedge_ld_broken = true;
+                hedge_active = false;
+            }
 
-            return QString();
-        }
+            continue;
+        } else if (hedge_wait < 0) {
+            hedge_ld_broken = true;
+            hedge_active = false;
 
-        const size_t buffer_size = 2000;
-        char buffer[buffer_size];
-        const ssize_t bytes_read = smbc_read(ini_fd, buffer, buffer_size);
+            continue;
+        }
 
-        if (bytes_read < 0) {
-            const QString error_text = QString(tr("Failed to open GPT.INI, %1.")).arg(strerror(errno));
-            d->error_message(error_context, error_text);
+        const int poll_result = poll(poll_fds, 2, HEDGE_POLL_TIMEOUT_MSEC);
+        if (poll_result < 0 && errno != EINTR) {
+            qDebug() << "Error in hedged read poll: " << strerror(errno);
 
-            return QString();
+            abandon_hedge();
         }
+    }
+}
 
-        smbc_close(ini_fd);
+// Connects to hedge DC in the background and puts the
+// handle into the pool, so that next hedged reads can use
+// it
+class AdHedgeConnectTask final : public QRunnable {
+public:
+    AdHedgeConnectTask(const AdServer server_arg, const QString &dc_arg, const QString &key_arg) {
+        server = server_arg;
+        dc = dc_arg;
+        key = key_arg;
+    }
 
-        return QString(buffer);
-    }();
+    void run() override;
 
-    if (ini_contents.isEmpty()) {
+    // Returns false if a connect for this key is already
+    // in progress or failed recently
+    static bool begin(const QString &key);
+
+private:
+    static QMutex state_mutex;
+    static QSet<QString> pending_set;
+    static QHash<QString, qint64> failed_at_map;
+
+    AdServer server;
+    QString dc;
+    QString key;
+};
+
+QMutex AdHedgeConnectTask::state_mutex;
+QSet<QString> AdHedgeConnectTask::pending_set;
+QHash<QString, qint64> AdHedgeConnectTask::failed_at_map;
+
+bool AdHedgeConnectTask::begin(const QString &key) {
+    QMutexLocker locker(&state_mutex);
+
+    if (pending_set.contains(key)) {
         return false;
     }
 
-    const int version = [&]() {
-        int out;
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const bool failed_recently = (failed_at_map.contains(key) && now - failed_at_map[key] < HEDGE_CONNECT_RETRY_SEC);
+    if (failed_recently) {
+        return false;
+    }
 
-        const int scan_result = sscanf(cstr(ini_contents), "[General]\r\nVersion=%i\r\n", &out);
-        const bool scan_success = (scan_result > 0);
+    pending_set.insert(key);
 
-        if (!scan_success) {
-            const QString error_text = QString(tr("Failed to extract version from GPT.INI, %1.")).arg(strerror(errno));
-            d->error_message(error_context, error_text);
+    return true;
+}
 
-            return -1;
-        }
+void AdHedgeConnectTask::run() {
+    // NOTE: private part is only used for it's connect
+    // code, this is not a usable AdInterface
+    AdInterfacePrivate connect_d(nullptr);
+    connect_d.server = server;
+    connect_d.ld = NULL;
+
+    LDAP *new_ld = NULL;
+    bool is_bound = false;
+    QString client_user;
+    connect_d.ldap_connect(dc, &new_ld, &is_bound, &client_user, DoStatusMsg_No);
+
+    if (is_bound) {
+        AdConnectionPool::instance()->release(key, new_ld, client_user);
+    } else if (new_ld != NULL) {
+        ldap_unbind_ext(new_ld, NULL, NULL);
+    }
 
-        return out;
-    }();
+    QMutexLocker locker(&state_mutex);
 
-    if (version >= 0) {
-        *version_out = version;
+    pending_set.remove(key);
 
-        return true;
+    if (is_bound) {
+        failed_at_map.remove(key);
     } else {
-        return false;
+        failed_at_map[key] = QDateTime::currentSecsSinceEpoch();
     }
 }
 
-void AdInterfacePrivate::success_message(const QString &msg, const DoStatusMsg do_msg) {
-    if (do_msg == DoStatusMsg_No) {
-        return;
+// Returns handle for the fastest DC other than the current
+// one or NULL if there's no idle handle for it in the
+// pool. Connecting takes DNS lookups and a GSSAPI bind,
+// which would delay the read far more than the primary
+// DC, so a missing handle is connected in the background
+// instead and used by later hedges.
+LDAP *AdInterfacePrivate::get_hedge_ld() {
+    if (hedge_ld != NULL) {
+        return hedge_ld;
     }
 
-    const AdMessage message(msg, AdMessageType_Success);
-    messages.append(message);
-}
+    const QList<QString> dc_list = [&]() {
+        if (server == AdServer_GlobalCatalog) {
+            return get_gc_hosts(forest, QString());
+        } else {
+            return get_domain_hosts(domain, QString());
+        }
+    }();
+    const QList<QString> ranked_list = AdDcSelector::instance()->sorted_by_latency(dc_list);
 
-void AdInterfacePrivate::error_message(const QString &context, const QString &error, const DoStatusMsg do_msg) {
-    if (do_msg == DoStatusMsg_No) {
-        return;
+    hedge_dc = [&]() {
+        for (const QString &other_dc : ranked_list) {
+            if (other_dc != dc && AdDcSelector::instance()->is_reachable(other_dc)) {
+                return other_dc;
+            }
+        }
+
+        return QString();
+    }();
+
+    if (hedge_dc.isEmpty()) {
+        return NULL;
     }
 
-    QString msg = context;
-    if (!error.isEmpty()) {
-        msg += QString(tr(" Error: \"%1\"")).arg(error);
+    hedge_key = connection_key(hedge_dc);
+    hedge_ld = AdConnectionPool::instance()->acquire(hedge_key, &hedge_client_user);
+    hedge_ld_broken = false;
 
-        // Add period if needed, because some error strings,
-        // like the ones from LDAP, might not have one
-        if (!msg.endsWith(".")) {
-            msg += ".";
-        }
+    const bool need_connect = (hedge_ld == NULL && AdConnectionPool::instance()->enabled());
+    if (need_connect && AdHedgeConnectTask::begin(hedge_key)) {
+        QThreadPool::globalInstance()->start(new AdHedgeConnectTask(server, hedge_dc, hedge_key));
     }
 
-    const AdMessage message(msg, AdMessageType_Error);
-    messages.append(message);
+    return hedge_ld;
 }
 
-void AdInterfacePrivate::error_message_plain(const QString &text, const DoStatusMsg do_msg) {
-    if (do_msg == DoStatusMsg_No) {
-        return;
+void AdInterfacePrivate::free_hedge_ld() {
+    if (hedge_ld != NULL) {
+        if (hedge_ld_broken) {
+            AdConnectionPool::instance()->discard(hedge_ld);
+        } else {
+            AdConnectionPool::instance()->release(hedge_key, hedge_ld, hedge_client_user);
+        }
     }
 
-    const AdMessage message(text, AdMessageType_Error);
-    messages.append(message);
+    hedge_ld = NULL;
+    hedge_ld_broken = false;
+}
+
+QString AdInterfacePrivate::connection_key(const QString &target_dc) const {
+    const bool sasl_nocanon = (s_sasl_nocanon == LDAP_OPT_ON);
+
+    const int port = [&]() {
+        if (server == AdServer_GlobalCatalog) {
+            return GLOBAL_CATALOG_PORT;
+        } else {
+            return s_port;
+        }
+    }();
+
+    const QString out = QString("%1|%2|%3|%4|%5").arg(domain, target_dc, QString::number(port), QString::number(sasl_nocanon), QString::number(s_cert_strat));
+
+    return out;
 }
 
 QString AdInterfacePrivate::default_error() const {
     const int ldap_result = get_ldap_result();
+
+    return error_string(ldap_result);
+}
+
+QString AdInterfacePrivate::error_string(const int ldap_result) const {
     switch (ldap_result) {
         case LDAP_NO_SUCH_OBJECT: return tr("No such object");
         case LDAP_CONSTRAINT_VIOLATION: return tr("Constraint violation");
@@ -1919,6 +3925,68 @@ QString AdInterfacePrivate::default_error() const {
     }
 }
 
+void AdInterfacePrivate::account_option_message(const QString &dn, const AccountOption option, const bool set, const bool success, const QString &error) {
+    const QString name = dn_get_name(dn);
+
+    if (success) {
+        const QString success_context = [option, set, name]() {
+            switch (option) {
+                case AccountOption_Disabled: {
+                    if (set) {
+                        return QString(AdInterface::tr("Object %1 has been disabled.")).arg(name);
+                    } else {
+                        return QString(AdInterface::tr("Object %1 has been enabled.")).arg(name);
+                    }
+                }
+                default: {
+                    const QString description = account_option_string(option);
+
+                    if (set) {
+                        return QString(AdInterface::tr("Account option \"%1\" was turned ON for object %2.")).arg(description, name);
+                    } else {
+                        return QString(AdInterface::tr("Account option \"%1\" was turned OFF for object %2.")).arg(description, name);
+                    }
+                }
+            }
+        }();
+
+        success_message(success_context);
+    } else {
+        const QString context = [option, set, name]() {
+            switch (option) {
+                case AccountOption_Disabled: {
+                    if (set) {
+                        return QString(AdInterface::tr("Failed to disable object %1.")).arg(name);
+                    } else {
+                        return QString(AdInterface::tr("Failed to enable object %1.")).arg(name);
+                    }
+                }
+                default: {
+                    const QString description = account_option_string(option);
+
+                    if (set) {
+                        return QString(AdInterface::tr("Failed to turn ON account option \"%1\" for object %2.")).arg(description, name);
+                    } else {
+                        return QString(AdInterface::tr("Failed to turn OFF account option \"%1\" for object %2.")).arg(description, name);
+                    }
+                }
+            }
+        }();
+
+        error_message(context, error);
+    }
+}
+
+// NOTE: result code of the handle can't be used to decide
+// this later, because any following operation overwrites it
+void AdInterfacePrivate::check_ld_result(const int ldap_result) {
+    const bool connection_lost = (ldap_result == LDAP_SERVER_DOWN || ldap_result == LDAP_CONNECT_ERROR || ldap_result == LDAP_TIMEOUT);
+
+    if (connection_lost) {
+        ld_is_broken = true;
+    }
+}
+
 int AdInterfacePrivate::get_ldap_result() const {
     int result;
     ldap_get_option(ld, LDAP_OPT_RESULT_CODE, &result);
@@ -1927,6 +3995,8 @@ int AdInterfacePrivate::get_ldap_result() const {
 }
 
 bool AdInterfacePrivate::delete_gpt(const QString &parent_path) {
+    const AdTraceSpan trace_span("delete_gpt", "smb", parent_path);
+
     bool ok = true;
 
     QList<QString> path_list = gpo_get_gpt_contents(parent_path, &ok);
@@ -1945,7 +4015,7 @@ bool AdInterfacePrivate::delete_gpt(const QString &parent_path) {
         }
 
         if (is_dir) {
-            const int result_rmdir = smbc_rmdir(cstr(path));
+            const int result_rmdir = smbc_rmdir(AdCString(path).get());
 
             if (result_rmdir != 0) {
                 error_message(QString(tr("Failed to delete GPT folder %1.")).arg(path), strerror(errno));
@@ -1953,7 +4023,7 @@ bool AdInterfacePrivate::delete_gpt(const QString &parent_path) {
                 return false;
             }
         } else {
-            const int result_unlink = smbc_unlink(cstr(path));
+            const int result_unlink = smbc_unlink(AdCString(path).get());
 
             if (result_unlink != 0) {
                 error_message(QString(tr("Failed to delete GPT file %1.")).arg(path), strerror(errno));
@@ -1967,8 +4037,10 @@ bool AdInterfacePrivate::delete_gpt(const QString &parent_path) {
 }
 
 bool AdInterfacePrivate::smb_path_is_dir(const QString &path, bool *ok) {
+    const AdTraceSpan trace_span("smb_path_is_dir", "smb", path);
+
     struct stat filestat;
-    const int stat_result = smbc_stat(cstr(path), &filestat);
+    const int stat_result = smbc_stat(AdCString(path).get(), &filestat);
     if (stat_result != 0) {
         error_message(QString(tr("Failed to get filestat for \"%1\".")).arg(path), strerror(errno));
 
@@ -2022,10 +4094,117 @@ int create_sd_control(bool get_sacl, int is_critical, LDAPControl **ctrlp, bool
     return result;
 }
 
+// NOTE: request is encoded when it's sent, so mod arrays
+// only need to live until then
+int bulk_send(LDAP *ld, const AdBulkOp &op, int *msgid) {
+    const QByteArray dn = op.dn.toUtf8();
+
+    const int mod_count = op.mod_list.size();
+
+    QList<QByteArray> attribute_list;
+    QVector<QVector<struct berval>> bvalues_storage_list(mod_count);
+    QVector<QVector<struct berval *>> bvalues_list(mod_count);
+    QVector<LDAPMod> mod_storage_list(mod_count);
+    QVector<LDAPMod *> mods(mod_count + 1);
+    mods[mod_count] = NULL;
+
+    for (int i = 0; i < mod_count; i++) {
+        const AdBulkMod &mod = op.mod_list[i];
+
+        attribute_list.append(mod.attribute.toUtf8());
+
+        QVector<struct berval> &bvalues_storage = bvalues_storage_list[i];
+        QVector<struct berval *> &bvalues = bvalues_list[i];
+        bvalues_storage.resize(mod.values.size());
+        bvalues.resize(mod.values.size() + 1);
+        bvalues[mod.values.size()] = NULL;
+
+        for (int j = 0; j < mod.values.size(); j++) {
+            const QByteArray &value = mod.values[j];
+            struct berval *bvalue = &bvalues_storage[j];
+
+            bvalue->bv_val = (char *) value.constData();
+            bvalue->bv_len = (size_t) value.size();
+
+            bvalues[j] = bvalue;
+        }
+
+        const int mod_op = [&]() {
+            if (op.type == AdBulkOpType_Add) {
+                return LDAP_MOD_ADD;
+            }
+
+            switch (mod.type) {
+                case AdBulkModType_Replace: return LDAP_MOD_REPLACE;
+                case AdBulkModType_Add: return LDAP_MOD_ADD;
+                case AdBulkModType_Delete: return LDAP_MOD_DELETE;
+            }
+
+            return LDAP_MOD_REPLACE;
+        }();
+
+        LDAPMod *ldap_mod = &mod_storage_list[i];
+        ldap_mod->mod_op = (mod_op | LDAP_MOD_BVALUES);
+        ldap_mod->mod_type = (char *) attribute_list[i].constData();
+        ldap_mod->mod_bvalues = bvalues.data();
+
+        mods[i] = ldap_mod;
+    }
+
+    switch (op.type) {
+        case AdBulkOpType_Modify: return ldap_modify_ext(ld, dn.constData(), mods.data(), NULL, NULL, msgid);
+        case AdBulkOpType_Add: return ldap_add_ext(ld, dn.constData(), mods.data(), NULL, NULL, msgid);
+        case AdBulkOpType_Delete: {
+            if (!op.tree_delete) {
+                return ldap_delete_ext(ld, dn.constData(), NULL, NULL, msgid);
+            }
+
+            LDAPControl *tree_delete_control = NULL;
+            const int control_result = ldap_control_create(LDAP_CONTROL_X_TREE_DELETE, 1, NULL, 0, &tree_delete_control);
+            if (control_result != LDAP_SUCCESS) {
+                return control_result;
+            }
+
+            LDAPControl *server_controls[2] = {tree_delete_control, NULL};
+            const int result = ldap_delete_ext(ld, dn.constData(), server_controls, NULL, msgid);
+
+            ldap_control_free(tree_delete_control);
+
+            return result;
+        }
+        case AdBulkOpType_Rename: {
+            const QByteArray new_rdn = op.new_rdn.toUtf8();
+            const QByteArray new_superior = op.new_superior.toUtf8();
+            const char *new_superior_cstr = (op.new_superior.isEmpty() ? NULL : new_superior.constData());
+            const int delete_old_rdn = 1;
+
+            return ldap_rename(ld, dn.constData(), new_rdn.constData(), new_superior_cstr, delete_old_rdn, NULL, NULL, msgid);
+        }
+    }
+
+    return LDAP_PARAM_ERROR;
+}
+
+int search_scope_to_ldap(const SearchScope scope) {
+    switch (scope) {
+        case SearchScope_Object: return LDAP_SCOPE_BASE;
+        case SearchScope_Children: return LDAP_SCOPE_ONELEVEL;
+        case SearchScope_All: return LDAP_SCOPE_SUBTREE;
+        case SearchScope_Descendants: return LDAP_SCOPE_CHILDREN;
+    }
+    return 0;
+}
+
 bool AdInterface::logged_in_as_domain_admin() {
+    // NOTE: these are lookups of single objects, so DC can
+    // stop after the first match
+    SearchOptions lookup_options;
+    lookup_options.size_limit = 1;
+    lookup_options.domain_scope = true;
+
     const QString sam_account_name = d->client_user.split('@')[0];
     const QString client_user_filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_SAM_ACCOUNT_NAME, sam_account_name);
-    const QHash<QString, AdObject> client_user_results = search(adconfig()->domain_dn(), SearchScope_All, client_user_filter, {ATTRIBUTE_PRIMARY_GROUP_ID});
+    const QHash<QString, AdObject> client_user_results = search(adconfig()->domain_dn(), SearchScope_All, client_user_filter, {ATTRIBUTE_PRIMARY_GROUP_ID}, lookup_options);
     if (client_user_results.isEmpty()) {
         return false;
     }
@@ -2045,7 +4224,9 @@ bool AdInterface::logged_in_as_domain_admin() {
     const QString filter_group = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_GROUP);
     const QString filter_sid = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_SID, domain_admins_sid);
     const QString filter = filter_AND({filter_group, filter_sid});
-    const QHash<QString, AdObject> admin_group_results = search(adconfig()->domain_dn(), SearchScope_All, filter, QList<QString>());
+    SearchOptions admin_group_options = lookup_options;
+    admin_group_options.attrs_only = true;
+    const QHash<QString, AdObject> admin_group_results = search(adconfig()->domain_dn(), SearchScope_All, filter, QList<QString>(), admin_group_options);
     if (admin_group_results.isEmpty()) {
         d->error_message(tr("Failed to check user permissions."), tr("Can't find domain admins group with SID ") + domain_admins_sid);
         return false;
@@ -2053,7 +4234,9 @@ bool AdInterface::logged_in_as_domain_admin() {
 
     const AdObject domain_admins_object = admin_group_results.values()[0];
     const QString rule_in_chain_filter = filter_matching_rule_in_chain(ATTRIBUTE_MEMBER_OF, domain_admins_object.get_dn());
-    const QHash<QString, AdObject> res = search(user_dn, SearchScope_Object, rule_in_chain_filter, QList<QString>());
+    SearchOptions exists_options;
+    exists_options.attrs_only = true;
+    const QHash<QString, AdObject> res = search(user_dn, SearchScope_Object, rule_in_chain_filter, QList<QString>(), exists_options);
 
     return res.keys().contains(user_dn);
 }
@@ -2066,8 +4249,17 @@ QString AdInterface::get_domain() const {
     return d->domain;
 }
 
+AdServer AdInterface::server() const {
+    return d->server;
+}
+
 void AdInterface::update_dc() {
-    d->dc = AdInterfacePrivate::s_dc;
+    // NOTE: selected DC might not be a global catalog
+    if (d->server == AdServer_GlobalCatalog) {
+        return;
+    }
+
+    d->dc = AdInterfacePrivate::get_shared_dc();
 
     // Reinit ldap connection with updated DC
     ldap_free();
@@ -2075,23 +4267,34 @@ void AdInterface::update_dc() {
     d->is_connected = init_smb_context();
 }
 
-QList<QString> get_domain_hosts(const QString &domain, const QString &site) {
+QList<QString> get_site_hosts(const QString &domain, const QString &site) {
+    if (site.isEmpty()) {
+        return QList<QString>();
+    }
+
+    // NOTE: records under "dc._msdcs" only contain DC's,
+    // unlike "_ldap._tcp.<site>._sites.<domain>", which may
+    // also contain other LDAP servers
+    const QString dname = QString("_ldap._tcp.%1._sites.dc._msdcs.%2").arg(site, domain);
+
+    const QList<QString> site_hosts = AdDcCache::instance()->get_hosts(dname);
+
+    return site_hosts;
+}
+
+QList<QString> get_gc_hosts(const QString &forest, const QString &site) {
     QList<QString> hosts;
 
-    // Query site hosts
     if (!site.isEmpty()) {
-        char dname[1000];
-        snprintf(dname, sizeof(dname), "_ldap._tcp.%s._sites.%s", cstr(site), cstr(domain));
+        const QString dname_site = QString("_gc._tcp.%1._sites.%2").arg(site, forest);
 
-        const QList<QString> site_hosts = query_server_for_hosts(dname);
+        const QList<QString> site_hosts = AdDcCache::instance()->get_hosts(dname_site);
         hosts.append(site_hosts);
     }
 
-    // Query default hosts
-    char dname_default[1000];
-    snprintf(dname_default, sizeof(dname_default), "_ldap._tcp.%s", cstr(domain));
+    const QString dname_default = QString("_gc._tcp.%1").arg(forest);
 
-    const QList<QString> default_hosts = query_server_for_hosts(dname_default);
+    const QList<QString> default_hosts = AdDcCache::instance()->get_hosts(dname_default);
     hosts.append(default_hosts);
 
     hosts.removeDuplicates();
@@ -2099,106 +4302,20 @@ QList<QString> get_domain_hosts(const QString &domain, const QString &site) {
     return hosts;
 }
 
-/**
- * Perform a query for dname and output hosts
- * dname is a combination of protocols (d->ldap, tcp), domain and site
- * NOTE: this is rewritten from
- * https://github.com/paleg/libadclient/blob/master/adclient.cpp
- * which itself is copied from
- * https://www.ccnx.org/releases/latest/doc/ccode/html/ccndc-srv_8c_source.html
- * Another example of similar procedure:
- * https://www.gnu.org/software/shishi/coverage/shishi/lib/resolv.c.gcov.html
- */
-QList<QString> query_server_for_hosts(const char *dname) {
-    union dns_msg {
-        HEADER header;
-        unsigned char buf[NS_MAXMSG];
-    } msg;
-
-    auto error = []() {
-        return QList<QString>();
-    };
-
-    const long unsigned msg_len = res_search(dname, ns_c_in, ns_t_srv, msg.buf, sizeof(msg.buf));
-
-    const bool message_error = (msg_len < sizeof(HEADER));
-    if (message_error) {
-        error();
-    }
-
-    const int packet_count = ntohs(msg.header.qdcount);
-    const int answer_count = ntohs(msg.header.ancount);
-
-    unsigned char *curr = msg.buf + sizeof(msg.header);
-    const unsigned char *eom = msg.buf + msg_len;
-
-    // Skip over packet records
-    for (int i = packet_count; i > 0 && curr < eom; i--) {
-        const int packet_len = dn_skipname(curr, eom);
-
-        const bool packet_error = (packet_len < 0);
-        if (packet_error) {
-            error();
-        }
-
-        curr = curr + packet_len + QFIXEDSZ;
-    }
-
+QList<QString> get_domain_hosts(const QString &domain, const QString &site) {
     QList<QString> hosts;
 
-    // Process answers by collecting hosts into list
-    for (int i = 0; i < answer_count; i++) {
-        // Get server
-        char server[NS_MAXDNAME];
-        const int server_len = dn_expand(msg.buf, eom, curr, server, sizeof(server));
-
-        const bool server_error = (server_len < 0);
-        if (server_error) {
-            error();
-        }
-
-        curr = curr + server_len;
-
-        int record_type;
-        int UNUSED(record_class);
-        int UNUSED(ttl);
-        int record_len;
-        GETSHORT(record_type, curr);
-        GETSHORT(record_class, curr);
-        GETLONG(ttl, curr);
-        GETSHORT(record_len, curr);
-
-        unsigned char *record_end = curr + record_len;
-        if (record_end > eom) {
-            error();
-        }
-
-        // Skip non-server records
-        if (record_type != ns_t_srv) {
-            curr = record_end;
-
-            continue;
-        }
-
-        int UNUSED(priority);
-        int UNUSED(weight);
-        int UNUSED(port);
-        GETSHORT(priority, curr);
-        GETSHORT(weight, curr);
-        GETSHORT(port, curr);
+    // Query site hosts
+    const QList<QString> site_hosts = get_site_hosts(domain, site);
+    hosts.append(site_hosts);
 
-        // Get host
-        char host[NS_MAXDNAME];
-        const int host_len = dn_expand(msg.buf, eom, curr, host, sizeof(host));
-        const bool host_error = (host_len < 0);
-        if (host_error) {
-            error();
-        }
+    // Query default hosts
+    const QString dname_default = QString("_ldap._tcp.%1").arg(domain);
 
-        hosts.append(QString(host));
+    const QList<QString> default_hosts = AdDcCache::instance()->get_hosts(dname_default);
+    hosts.append(default_hosts);
 
-        curr = record_end;
-    }
+    hosts.removeDuplicates();
 
     return hosts;
 }
@@ -2327,8 +4444,82 @@ QString get_gpt_sd_string(const AdObject &gpc_object, const AceMaskFormat format
     return out;
 }
 
+AdAsyncSearch::AdAsyncSearch(const QString &base_arg, const SearchScope scope_arg, const QString &filter_arg, const QList<QString> &attributes_arg, const bool get_sacl_arg) {
+    msgid = 0;
+    base = base_arg.toUtf8();
+    scope = search_scope_to_ldap(scope_arg);
+    filter = filter_arg.toUtf8();
+    get_sacl = get_sacl_arg;
+    show_deleted = false;
+    notify = false;
+    is_window = false;
+    window_offset = 0;
+    window_count = 0;
+    window_content_count = 0;
+    cookie = NULL;
+    page_size = AdPageSizeTuner::instance()->first_page_size();
+    msec_per_entry = 0;
+    is_first_page = true;
+    page_entry_count = 0;
+    search_scope = scope_arg;
+    action = AdMetricsAction::current();
+    in_batch = false;
+    failed = false;
+    total_page_count = 0;
+    total_entry_count = 0;
+    total_byte_count = 0;
+    total_timer.start();
+
+    for (const QString &attribute : attributes_arg) {
+        attributes.append(attribute.toUtf8());
+    }
+}
+
+AdAsyncSearch::~AdAsyncSearch() {
+    ber_bvfree(cookie);
+
+    // NOTE: notification searches run until they are
+    // abandoned, so their duration means nothing
+    if (notify || in_batch || !AdMetrics::instance()->enabled()) {
+        return;
+    }
+
+    AdMetricsSample sample(AdMetricsOp_Search);
+    sample.action = action;
+    sample.base = QString::fromUtf8(base);
+    sample.scope = search_scope;
+    sample.filter = QString::fromUtf8(filter);
+    sample.elapsed_msec = total_timer.elapsed();
+    sample.success = !failed;
+    sample.page_count = total_page_count;
+    sample.entry_count = total_entry_count;
+    sample.byte_count = total_byte_count;
+    AdMetrics::instance()->record(sample);
+}
+
+SearchOptions::SearchOptions() {
+    size_limit = 0;
+    time_limit = 0;
+    timeout_msec = 0;
+    attrs_only = false;
+    page_size = 0;
+    get_sacl = false;
+    domain_scope = false;
+}
+
 AdCookie::AdCookie() {
     cookie = NULL;
+    page_size = 0;
+    msec_per_entry = 0;
+
+    reset_metrics();
+}
+
+void AdCookie::reset_metrics() {
+    metrics_elapsed_msec = 0;
+    metrics_page_count = 0;
+    metrics_entry_count = 0;
+    metrics_byte_count = 0;
 }
 
 bool AdCookie::more_pages() const {
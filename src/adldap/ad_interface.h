@@ -30,6 +30,9 @@
 #include <QHash>
 #include <QSet>
 
+#include <functional>
+
+#include "ad_bulk.h"
 #include "ad_defines.h"
 
 class AdInterfacePrivate;
@@ -38,6 +41,8 @@ class QByteArray;
 class QDateTime;
 class AdObject;
 class AdConfig;
+class AdConnectionPoolStats;
+class AdEntryView;
 template <typename T>
 class QList;
 typedef void TALLOC_CTX;
@@ -64,11 +69,76 @@ public:
 
 private:
     struct berval *cookie;
+    // Page size state for adaptive paging, see
+    // ad_page_size.h
+    int page_size;
+    double msec_per_entry;
+    // Totals of pages so far, recorded in metrics when
+    // search ends, see ad_metrics.h
+    qint64 metrics_elapsed_msec;
+    int metrics_page_count;
+    int metrics_entry_count;
+    qint64 metrics_byte_count;
+
+    void reset_metrics();
 
     friend class AdInterface;
     friend class AdInterfacePrivate;
 };
 
+// Server control added to a search by SearchOptions.
+// Null value means that control has no value.
+class SearchControl {
+public:
+    QString oid;
+    QByteArray value;
+    bool is_critical;
+};
+
+// Options for search(), search_paged() and
+// search_object(). Defaults match the versions of these
+// f-ns without options, so only set what's needed. Limits
+// and attrs_only let existence checks, counts and quick
+// lookups ask DC for the minimum amount of work.
+class SearchOptions {
+public:
+    SearchOptions();
+
+    // Server stops after returning this many entries.
+    // Entries returned up to that point are kept. 0 for no
+    // limit.
+    int size_limit;
+
+    // Server stops after this many seconds. 0 for no
+    // limit.
+    int time_limit;
+
+    // Client stops waiting for a page after this many
+    // msec and search fails. Server is also told to stop
+    // after that time. 0 to wait forever.
+    int timeout_msec;
+
+    // Only return names of attributes, without values
+    bool attrs_only;
+
+    // Fixed page size. 0 to tune page size automatically,
+    // see ad_page_size.h.
+    int page_size;
+
+    // Also read SACL of security descriptor. Security
+    // descriptor flags control is only sent if security
+    // descriptor is requested, explicitly or by requesting
+    // all attributes.
+    bool get_sacl;
+
+    // Scope hint. Tells DC to not return referrals to
+    // other domains, so that subtree searches from the
+    // domain head stay within this domain.
+    bool domain_scope;
+
+    QList<SearchControl> controls;
+};
+
 class AdMessage {
 
 public:
@@ -86,7 +156,10 @@ class AdInterface {
     Q_DECLARE_TR_FUNCTIONS(AdInterface)
 
 public:
-    AdInterface();
+    // NOTE: global catalog connections are read-only and
+    // don't initialize SMB. Pass empty base to searches on
+    // global catalog to search the whole forest.
+    explicit AdInterface(const AdServer server = AdServer_DomainController);
     ~AdInterface();
 
     /**
@@ -107,6 +180,40 @@ public:
     static void set_domain_is_default(const bool is_default);
     static void set_custom_domain(const QString &domain);
 
+    // AdInterface reuses bound connections of previous
+    // instances instead of connecting every time. See
+    // ad_connection_pool.h. Clear the pool when
+    // connection options change.
+    static void set_connection_pool_enabled(const bool enabled);
+    static void clear_connection_pool();
+    static AdConnectionPoolStats connection_pool_stats();
+
+    // Results of DC discovery are cached according to
+    // TTL's of DNS records. If path is set, cache is also
+    // saved to disk, so it's reused on next launch.
+    static void set_dc_cache_path(const QString &path);
+    static void clear_dc_cache();
+
+    // If enabled, client's AD site is determined using a
+    // netlogon ping and DC's in that site are preferred.
+    // See ad_dc_locator.h.
+    static void set_site_aware_enabled(const bool enabled);
+
+    // If ranking is enabled, DC's are probed and the one
+    // with lowest latency is used, unless a DC was set
+    // explicitly. If hedging is enabled, slow base scope
+    // reads are duplicated to the next best DC and the
+    // first response is used. See ad_dc_selector.h.
+    static void set_dc_ranking_enabled(const bool enabled);
+    static void set_hedged_reads_enabled(const bool enabled);
+
+    // Sets number of entries requested per page of a
+    // search. If adaptive paging is enabled, this is the
+    // size of first page and later pages may be bigger.
+    // See ad_page_size.h.
+    static void set_page_size(const int page_size);
+    static void set_adaptive_page_size(const bool adaptive);
+
     bool is_connected() const;
     QList<AdMessage> messages() const;
     bool any_error_messages() const;
@@ -116,6 +223,7 @@ public:
     bool logged_in_as_domain_admin();
     QString get_dc() const;
     QString get_domain() const;
+    AdServer server() const;
 
     // NOTE: Updates dc for AdInterface instance from static AdInterfacePrivate::s_dc.
     // It is needed when DC changes after AdInterface object was constructed.
@@ -124,9 +232,20 @@ public:
     // NOTE: If request attributes list is empty, all
     // attributes are returned
 
+    // NOTE: server returns at most 1500 values of an
+    // attribute per entry (MaxValRange), rest have to be
+    // requested by range. search(), search_paged(),
+    // search_object(), search_objects(), search_window()
+    // and async searches do this automatically, so objects
+    // returned by them always have all values. Entries
+    // passed to search_visit() visitors are NOT completed,
+    // load such objects with search_object() if all values
+    // are needed.
+
     // This is a simplified version that searches all pages
     // in one go
     QHash<QString, AdObject> search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const bool get_sacl = false);
+    QHash<QString, AdObject> search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const SearchOptions &options);
 
     // This is a more complicated version of search() which
     // separates the search process by pages as they arrive
@@ -135,10 +254,99 @@ public:
     // display search results as they come in instead of all
     // at once.
     bool search_paged(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const bool get_sacl = false);
+    bool search_paged(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const SearchOptions &options);
+
+    // Streaming version of search(). Instead of collecting
+    // results, "visitor" is called for each entry as it
+    // arrives, so memory use doesn't grow with the amount
+    // of results. Entry view is only valid during the
+    // call, see ad_entry_view.h. Return false from visitor
+    // to stop the search early.
+    bool search_visit(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const std::function<bool(const AdEntryView &entry)> &visitor, const bool get_sacl = false);
+
+    // Same as search_visit(), but results also include
+    // deleted objects (tombstones), which are otherwise
+    // hidden. Tombstones have "isDeleted" set to TRUE,
+    // are moved to the "Deleted Objects" container and
+    // keep only a few attributes, like objectGUID and
+    // uSNChanged.
+    bool search_visit_deleted(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const std::function<bool(const AdEntryView &entry)> &visitor);
+
+    // Asynchronous search. search_async() sends the
+    // request and returns immediately with a search id, or
+    // -1 on failure. Results are collected by calling
+    // search_async_poll(), which waits at most
+    // "timeout_msec" (-1 to wait without a timeout) and
+    // then returns whatever arrived, keyed by search id.
+    // If "wake_fd" is given, the wait also ends as soon as
+    // that descriptor becomes readable, so that another
+    // thread can interrupt it, for example to start a new
+    // search. Reading the descriptor is up to the caller.
+    // Pages are requested automatically. Multiple searches
+    // can be outstanding at the same time on one
+    // connection. When a search finishes, it's id is added
+    // to "finished_map" with the value indicating success.
+    // Abandoned searches don't return any more results.
+    int search_async(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const bool get_sacl = false);
+    void search_async_poll(const int timeout_msec, QHash<int, QHash<QString, AdObject>> *results_map, QHash<int, bool> *finished_map, const int wake_fd = -1);
+    void search_async_abandon(const int search_id);
+
+    // Starts a change notification search. It doesn't
+    // finish by itself, instead every time a child of
+    // "base" is added, modified, moved or deleted, it is
+    // returned as a result by search_async_poll(). Deleted
+    // objects are returned as tombstones. Stop it using
+    // search_async_abandon(). Only "base" and "children"
+    // scopes are allowed and server limits the amount of
+    // notification searches per connection, 5 by default.
+    int search_async_notify(const QString &base, const SearchScope scope, const QList<QString> &attributes);
+    int search_async_count() const;
+
+    // Reads one window of results, sorted by
+    // "sort_attribute" on the server. Uses server-side
+    // sort and virtual list view controls, so only
+    // "count" entries starting at "offset" (0-based) are
+    // transferred, no matter how many entries match.
+    // "content_count" should be set to the value returned
+    // by previous window of the same search or to 0 for
+    // the first window. It is set to the total amount of
+    // matching entries as estimated by the server. Check
+    // that server supports both controls before using
+    // this, see window_search_supported().
+    bool search_window(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const QString &sort_attribute, const int offset, const int count, QList<AdObject> *results, int *content_count);
+    // Asynchronous version of search_window(), which runs
+    // together with other async searches. Entries of the
+    // window are not returned in "results_map" of
+    // search_async_poll(). Instead, once the search
+    // finishes successfully, whole window is taken using
+    // search_async_take_window().
+    int search_async_window(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const QString &sort_attribute, const int offset, const int count, const int content_count);
+    bool search_async_take_window(const int search_id, QList<AdObject> *results, int *content_count);
+    bool window_search_supported() const;
+
+    // Runs operations with many requests in flight on
+    // this connection, instead of waiting for each
+    // request before sending the next one. Returns results
+    // in the same order as operations. If
+    // "stop_on_error" is true, no new requests are sent
+    // after first failure, but requests that are already
+    // in flight still finish. Unlike other f-ns, doesn't
+    // add status messages.
+    QList<AdBulkResult> bulk_run(const QList<AdBulkOp> &op_list, const bool stop_on_error = false, const AdBulkProgress &progress = nullptr);
 
     // Simplest search f-n that only searches for attributes
     // of one object
     AdObject search_object(const QString &dn, const QList<QString> &attributes = QList<QString>(), const bool get_sacl = false);
+    AdObject search_object(const QString &dn, const QList<QString> &attributes, const SearchOptions &options);
+
+    // Batch version of search_object(). Searches for all
+    // objects are sent without waiting for previous ones
+    // to finish, so the whole batch costs about as much as
+    // a couple of round trips. Returned map is keyed by
+    // dn's from the list, objects that don't exist are
+    // not included. Other errors are added to messages.
+    QHash<QString, AdObject> search_objects(const QList<QString> &dn_list, const QList<QString> &attributes = QList<QString>(), const bool get_sacl = false);
+
 
     bool attribute_replace_values(const QString &dn, const QString &attribute, const QList<QByteArray> &values, const DoStatusMsg do_msg = DoStatusMsg_Yes, const bool set_dacl = false);
 
@@ -161,9 +369,16 @@ public:
 
     bool object_delete(const QString &dn, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     bool object_move(const QString &dn, const QString &new_container);
+    // Bulk versions of object_delete() and object_move(),
+    // return dn's of objects that were deleted or moved
+    QList<QString> object_delete_list(const QList<QString> &dn_list);
+    QList<QString> object_move_list(const QList<QString> &dn_list, const QString &new_container);
     bool object_rename(const QString &dn, const QString &new_name);
 
     bool group_add_member(const QString &group_dn, const QString &user_dn);
+    // Adds every user to every group, in bulk. Returns
+    // true if all additions succeeded.
+    bool group_add_member_list(const QList<QString> &group_dn_list, const QList<QString> &user_dn_list);
     bool group_remove_member(const QString &group_dn, const QString &user_dn);
     bool group_set_scope(const QString &dn, GroupScope scope, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     bool group_set_type(const QString &dn, GroupType type);
@@ -171,6 +386,9 @@ public:
     bool user_set_primary_group(const QString &group_dn, const QString &user_dn);
     bool user_set_pass(const QString &dn, const QString &password, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     bool user_set_account_option(const QString &dn, AccountOption option, bool set);
+    // Bulk version of user_set_account_option(), returns
+    // dn's of objects that were changed
+    QList<QString> user_set_account_option_list(const QList<QString> &dn_list, AccountOption option, bool set);
     bool user_unlock(const QString &dn);
 
     bool computer_reset_account(const QString &dn);
@@ -192,6 +410,13 @@ private:
     bool init_smb_context();
 };
 
+// Returns DC's of the domain. If site is given, DC's of
+// that site come first.
 QList<QString> get_domain_hosts(const QString &domain, const QString &site);
+// Returns only DC's of given site
+QList<QString> get_site_hosts(const QString &domain, const QString &site);
+// Returns global catalog servers of the forest. If site is
+// given, servers of that site come first.
+QList<QString> get_gc_hosts(const QString &forest, const QString &site);
 
 #endif /* AD_INTERFACE_H */
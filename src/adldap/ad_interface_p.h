@@ -21,38 +21,156 @@
 #ifndef AD_INTERFACE_P_H
 #define AD_INTERFACE_P_H
 
+#include "ad_metrics.h"
+#include "ad_object.h"
+
+#include <QByteArray>
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QList>
 #include <QMutex>
+#include <QString>
+
+#include <functional>
 
 class AdInterface;
 class AdConfig;
-class QString;
+class AdEntryView;
 typedef struct ldap LDAP;
+typedef struct ldapcontrol LDAPControl;
+typedef struct ldapmsg LDAPMessage;
 typedef struct _SMBCCTX SMBCCTX;
+struct berval;
+
+// State of a search started by search_async()
+class AdAsyncSearch {
+public:
+    AdAsyncSearch(const QString &base_arg, const SearchScope scope_arg, const QString &filter_arg, const QList<QString> &attributes_arg, const bool get_sacl_arg);
+    ~AdAsyncSearch();
+
+    int msgid;
+    QByteArray base;
+    int scope;
+    QByteArray filter;
+    QList<QByteArray> attributes;
+    bool get_sacl;
+    // Also return deleted objects (tombstones)
+    bool show_deleted;
+    // Change notification search, see
+    // search_async_notify()
+    bool notify;
+    // Window search, see search_async_window(). Entries
+    // are collected into "window_results" in sorted order.
+    bool is_window;
+    QByteArray sort_attribute;
+    int window_offset;
+    int window_count;
+    int window_content_count;
+    QList<AdObject> window_results;
+    struct berval *cookie;
+    int page_size;
+    double msec_per_entry;
+    bool is_first_page;
+    int page_entry_count;
+    QElapsedTimer page_timer;
+    // Totals for metrics, which are recorded when search
+    // is deleted, see ad_metrics.h
+    SearchScope search_scope;
+    QString action;
+    // Search is part of a batch, which records one sample
+    // for all of it's searches, see search_objects()
+    bool in_batch;
+    bool failed;
+    int total_page_count;
+    int total_entry_count;
+    qint64 total_byte_count;
+    QElapsedTimer total_timer;
+};
 
 class AdInterfacePrivate {
     Q_DECLARE_TR_FUNCTIONS(AdInterfacePrivate)
 
     friend AdInterface;
     static QMutex mutex;
+    // Guards s_dc, adconfig and smbc. AdInterface's are
+    // also created on pool threads, for example when
+    // loading config, so these can't be accessed bare.
+    static QMutex shared_mutex;
 
 public:
     AdInterfacePrivate(AdInterface *q);
 
     LDAP *ld;
+    // NOTE: handle can be bound without AdInterface being
+    // connected, for example if smb init failed
+    bool ld_is_bound;
+    // Set if an operation on "ld" failed because connection
+    // was lost, in which case handle is not returned to the
+    // pool, see check_ld_result()
+    bool ld_is_broken;
+    // Key that bound handle was created for. Saved because
+    // connection options may change while handle is in use.
+    QString ld_key;
+    // Connection to second best DC, used for hedged
+    // reads. Taken from the pool on first hedge, see
+    // get_hedge_ld().
+    LDAP *hedge_ld;
+    // Set if a hedge request failed or was abandoned, in
+    // which case handle is not returned to the pool
+    bool hedge_ld_broken;
+    QString hedge_dc;
+    QString hedge_key;
+    QString hedge_client_user;
     bool is_connected;
+    AdServer server;
     QString domain;
+    // DNS name of forest root domain, used to find global
+    // catalog servers
+    QString forest;
     QString dc;
     QString client_user;
     QList<AdMessage> messages;
+    // Searches started by search_async(), by search id
+    QHash<int, AdAsyncSearch *> async_search_map;
+    // Search id's by message id of their current page
+    QHash<int, int> async_msgid_map;
+    int async_search_id_max;
+    // Finished windows, until they are taken by
+    // search_async_take_window()
+    QHash<int, QList<AdObject>> async_window_map;
+    QHash<int, int> async_window_count_map;
 
     void success_message(const QString &msg, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     void error_message(const QString &context, const QString &error, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     void error_message_plain(const QString &text, const DoStatusMsg do_msg = DoStatusMsg_Yes);
     QString default_error() const;
+    QString error_string(const int ldap_result) const;
+    void check_ld_result(const int ldap_result);
+    void account_option_message(const QString &dn, const AccountOption option, const bool set, const bool success, const QString &error);
+    // Connections from pool are only reused if this key
+    // matches
+    QString connection_key(const QString &target_dc) const;
+    bool ldap_connect(const QString &target_dc, LDAP **ld_out, bool *is_bound_out, QString *client_user_out, const DoStatusMsg do_msg);
+    bool connect_gc();
+    static QString get_shared_dc();
+    LDAP *get_hedge_ld();
+    void free_hedge_ld();
+    int search_hedged(const char *base, const int scope, const char *filter, char **attributes, const int attrsonly, LDAPControl **server_controls, LDAPMessage **res_out, LDAP **res_ld_out);
     int get_ldap_result() const;
-    bool search_paged_internal(const char *base, const int scope, const char *filter, char **attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const bool get_sacl);
+    void record_operation(const AdMetricsOp op, const qint64 elapsed_msec, const int result);
+    void log_search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes);
+    bool async_send_page(AdAsyncSearch *search);
+    // Sends first page of search and adds it to async
+    // searches. Returns search id or -1 on failure, in
+    // which case search is deleted.
+    int async_start(AdAsyncSearch *search);
+    bool async_handle_page_result(AdAsyncSearch *search, LDAPMessage *message, bool *more_pages);
+    bool visit_search(AdAsyncSearch *search, const std::function<bool(const AdEntryView &entry)> &visitor);
+    void async_abandon_all();
+    bool visit_range(const QString &dn, const QString &attribute, const int start, const std::function<bool(const QList<QByteArray> &values)> &visitor);
+    AdObject entry_to_complete_object(LDAP *entry_ld, LDAPMessage *entry, qint64 *byte_count = nullptr);
+    bool search_paged_internal(const char *base, const int scope, const char *filter, char **attributes, QHash<QString, AdObject> *results, AdCookie *cookie, const SearchOptions &options);
     bool connect_via_ldap(const char *uri);
     bool delete_gpt(const QString &parent_path);
     bool smb_path_is_dir(const QString &path, bool *ok);
@@ -62,6 +180,9 @@ public:
     QList<QString> gpo_get_gpt_contents(const QString &gpt_root_path, bool *ok);
 
 private:
+    // NOTE: options other than the ones guarded by
+    // shared_mutex are set once at startup, before any
+    // AdInterface is created on another thread
     static AdConfig *adconfig;
     static bool s_log_searches;
     static QString s_dc;
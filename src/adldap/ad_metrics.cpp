@@ -0,0 +1,224 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_metrics.h"
+
+#include <QMutexLocker>
+
+// NOTE: bounds grow roughly exponentially, so that both
+// fast reads and slow subtree searches get a useful
+// resolution
+static const QList<int> bucket_bound_list = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000};
+
+// NOTE: action is per thread, so that searches in
+// background threads are not attributed to whatever the
+// main thread is doing
+static thread_local QString current_action;
+
+AdMetricsSample::AdMetricsSample(const AdMetricsOp op_arg) {
+    op = op_arg;
+    action = AdMetricsAction::current();
+    scope = SearchScope_Object;
+    elapsed_msec = 0;
+    success = true;
+    page_count = 0;
+    entry_count = 0;
+    byte_count = 0;
+}
+
+qint64 AdMetricsEntry::percentile_msec(const int percentile) const {
+    const QList<int> bounds = AdMetrics::bucket_bounds();
+
+    const int target = (count * percentile + 99) / 100;
+
+    int sum = 0;
+    for (int i = 0; i < histogram.size(); i++) {
+        sum += histogram[i];
+
+        if (sum >= target && sum > 0) {
+            if (i < bounds.size()) {
+                return bounds[i];
+            } else {
+                return max_msec;
+            }
+        }
+    }
+
+    return 0;
+}
+
+AdMetrics *AdMetrics::instance() {
+    static AdMetrics metrics;
+
+    return &metrics;
+}
+
+AdMetrics::AdMetrics() {
+    m_enabled = false;
+}
+
+void AdMetrics::set_enabled(const bool enabled) {
+    QMutexLocker locker(&mutex);
+
+    m_enabled = enabled;
+}
+
+bool AdMetrics::enabled() const {
+    QMutexLocker locker(&mutex);
+
+    return m_enabled;
+}
+
+void AdMetrics::record(const AdMetricsSample &sample) {
+    QMutexLocker locker(&mutex);
+
+    if (!m_enabled) {
+        return;
+    }
+
+    // NOTE: reads of single objects would create a group
+    // per object, so their base is dropped
+    const bool keep_base = (sample.op == AdMetricsOp_Search && sample.scope != SearchScope_Object);
+    const QString base = (keep_base ? sample.base : QString());
+    const QString filter = filter_template(sample.filter);
+
+    const QString key = QString("%1\n%2\n%3\n%4").arg(QString::number(sample.op), sample.action, base, filter);
+
+    if (!entry_map.contains(key)) {
+        AdMetricsEntry entry;
+        entry.op = sample.op;
+        entry.action = sample.action;
+        entry.base = base;
+        entry.filter_template = filter;
+        entry.count = 0;
+        entry.error_count = 0;
+        entry.total_msec = 0;
+        entry.max_msec = 0;
+        entry.page_count = 0;
+        entry.entry_count = 0;
+        entry.byte_count = 0;
+        entry.histogram = QVector<int>(bucket_bound_list.size() + 1, 0);
+
+        entry_map[key] = entry;
+    }
+
+    AdMetricsEntry &entry = entry_map[key];
+    entry.count++;
+    if (!sample.success) {
+        entry.error_count++;
+    }
+    entry.total_msec += sample.elapsed_msec;
+    entry.max_msec = qMax(entry.max_msec, sample.elapsed_msec);
+    entry.page_count += sample.page_count;
+    entry.entry_count += sample.entry_count;
+    entry.byte_count += sample.byte_count;
+
+    const int bucket = [&]() {
+        for (int i = 0; i < bucket_bound_list.size(); i++) {
+            if (sample.elapsed_msec <= bucket_bound_list[i]) {
+                return i;
+            }
+        }
+
+        return bucket_bound_list.size();
+    }();
+    entry.histogram[bucket]++;
+}
+
+QList<AdMetricsEntry> AdMetrics::snapshot() const {
+    QMutexLocker locker(&mutex);
+
+    return entry_map.values();
+}
+
+void AdMetrics::reset() {
+    QMutexLocker locker(&mutex);
+
+    entry_map.clear();
+}
+
+QString AdMetrics::op_name(const AdMetricsOp op) {
+    switch (op) {
+        case AdMetricsOp_Search: return "search";
+        case AdMetricsOp_SearchObjects: return "search_objects";
+        case AdMetricsOp_Add: return "add";
+        case AdMetricsOp_Modify: return "modify";
+        case AdMetricsOp_Delete: return "delete";
+        case AdMetricsOp_Rename: return "rename";
+        case AdMetricsOp_Connect: return "connect";
+        case AdMetricsOp_Bind: return "bind";
+        case AdMetricsOp_COUNT: break;
+    }
+
+    return QString();
+}
+
+// Replaces values in filter by "?". Presence checks like
+// "(mail=*)" are kept as is, because they are a different
+// kind of query. Values can't contain ")", it has to be
+// escaped in filters.
+QString AdMetrics::filter_template(const QString &filter) {
+    QString out;
+    out.reserve(filter.size());
+
+    int i = 0;
+    while (i < filter.size()) {
+        const QChar c = filter[i];
+        out.append(c);
+        i++;
+
+        if (c != '=') {
+            continue;
+        }
+
+        const int value_start = i;
+        while (i < filter.size() && filter[i] != ')') {
+            i++;
+        }
+
+        const QStringRef value = filter.midRef(value_start, i - value_start);
+        if (value == "*") {
+            out.append("*");
+        } else if (!value.isEmpty()) {
+            out.append("?");
+        }
+    }
+
+    return out;
+}
+
+QList<int> AdMetrics::bucket_bounds() {
+    return bucket_bound_list;
+}
+
+AdMetricsAction::AdMetricsAction(const QString &name) {
+    prev_name = current_action;
+
+    if (current_action.isEmpty()) {
+        current_action = name;
+    }
+}
+
+AdMetricsAction::~AdMetricsAction() {
+    current_action = prev_name;
+}
+
+QString AdMetricsAction::current() {
+    return current_action;
+}
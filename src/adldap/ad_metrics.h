@@ -0,0 +1,151 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_METRICS_H
+#define AD_METRICS_H
+
+/**
+ * Registry of timings of LDAP operations done through
+ * AdInterface. Operations are grouped by type, base,
+ * filter template and the UI action which caused them, see
+ * AdMetricsAction. For each group, counts, a latency
+ * histogram and amounts of pages, entries and bytes are
+ * kept. In filter templates values are replaced by "?", so
+ * that searches which only differ by values, like searches
+ * by name, end up in one group. Reads of single objects
+ * are grouped together regardless of dn. Recording is off
+ * by default.
+ */
+
+#include "ad_defines.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+enum AdMetricsOp {
+    AdMetricsOp_Search,
+    AdMetricsOp_SearchObjects,
+    AdMetricsOp_Add,
+    AdMetricsOp_Modify,
+    AdMetricsOp_Delete,
+    AdMetricsOp_Rename,
+    AdMetricsOp_Connect,
+    AdMetricsOp_Bind,
+
+    AdMetricsOp_COUNT,
+};
+
+// One finished operation
+class AdMetricsSample {
+public:
+    AdMetricsSample(const AdMetricsOp op_arg);
+
+    AdMetricsOp op;
+    // Set to current action by constructor
+    QString action;
+    QString base;
+    SearchScope scope;
+    QString filter;
+    qint64 elapsed_msec;
+    bool success;
+    int page_count;
+    int entry_count;
+    // Sum of sizes of values
+    qint64 byte_count;
+};
+
+// Totals of one group of operations
+class AdMetricsEntry {
+public:
+    AdMetricsOp op;
+    QString action;
+    QString base;
+    QString filter_template;
+    int count;
+    int error_count;
+    qint64 total_msec;
+    qint64 max_msec;
+    qint64 page_count;
+    qint64 entry_count;
+    qint64 byte_count;
+    // Counts of operations per bucket, see
+    // AdMetrics::bucket_bounds()
+    QVector<int> histogram;
+
+    // Estimated from histogram, so result is the upper
+    // bound of the bucket that contains the percentile.
+    // "percentile" is from 0 to 100.
+    qint64 percentile_msec(const int percentile) const;
+};
+
+class AdMetrics {
+
+public:
+    static AdMetrics *instance();
+
+    void set_enabled(const bool enabled);
+    bool enabled() const;
+
+    void record(const AdMetricsSample &sample);
+
+    // Returns a copy of current totals, safe to use while
+    // operations keep being recorded
+    QList<AdMetricsEntry> snapshot() const;
+    void reset();
+
+    static QString op_name(const AdMetricsOp op);
+    static QString filter_template(const QString &filter);
+
+    // Upper bounds of histogram buckets in msec. There's
+    // one more bucket, for everything above the last bound.
+    static QList<int> bucket_bounds();
+
+private:
+    mutable QMutex mutex;
+    bool m_enabled;
+    QHash<QString, AdMetricsEntry> entry_map;
+
+    AdMetrics();
+};
+
+// Operations done in the current thread while this object
+// exists are attributed to the given UI action. Create it
+// on the stack at the start of a handler. If an action is
+// already active, it is kept, so that operations are
+// attributed to the outermost action, which is the one
+// that user started.
+class AdMetricsAction {
+
+public:
+    AdMetricsAction(const QString &name);
+    ~AdMetricsAction();
+
+    AdMetricsAction(const AdMetricsAction &) = delete;
+    AdMetricsAction &operator=(const AdMetricsAction &) = delete;
+
+    static QString current();
+
+private:
+    QString prev_name;
+};
+
+#endif /* AD_METRICS_H */
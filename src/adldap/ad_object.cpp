@@ -19,7 +19,9 @@
  */
 
 #include "ad_object.h"
+#include "ad_object_p.h"
 
+#include "ad_attribute_table.h"
 #include "ad_config.h"
 #include "ad_display.h"
 #include "ad_security.h"
@@ -35,74 +37,254 @@
 #include <QString>
 #include <algorithm>
 
+void AdObjectData::reserve(const int attribute_count, const int value_count, const int buffer_size) {
+    attribute_list.reserve(attribute_count);
+    value_list.reserve(value_count);
+    buffer.reserve(buffer_size);
+}
+
+void AdObjectData::add_attribute(const QString &name) {
+    Attribute attribute;
+    attribute.id = AdAttributeTable::instance()->intern(name);
+    attribute.value_start = value_list.size();
+    attribute.value_count = 0;
+
+    attribute_list.append(attribute);
+}
+
+void AdObjectData::add_value(const char *data, const int size) {
+    Value value;
+    value.offset = buffer.size();
+    value.size = size;
+
+    value_list.append(value);
+    buffer.append(data, size);
+
+    attribute_list.last().value_count++;
+}
+
+const AdObjectData::Attribute *AdObjectData::find(const QString &name) const {
+    // NOTE: if name was never interned, then no object
+    // can contain it
+    const int id = AdAttributeTable::instance()->find(name);
+
+    return find(id);
+}
+
+const AdObjectData::Attribute *AdObjectData::find(const int id) const {
+    if (id == ATTRIBUTE_ID_NONE) {
+        return nullptr;
+    }
+
+    for (const Attribute &attribute : attribute_list) {
+        if (attribute.id == id) {
+            return &attribute;
+        }
+    }
+
+    return nullptr;
+}
+
+QByteArray AdObjectData::value_view(const int index) const {
+    const Value &value = value_list[index];
+
+    return QByteArray::fromRawData(buffer.constData() + value.offset, value.size);
+}
+
+// NOTE: QString(QByteArray) stops at first null char, keep
+// that behavior for values that are converted to strings
+QString value_to_string(const QByteArray &value) {
+    const int size = qstrnlen(value.constData(), value.size());
+
+    return QString::fromUtf8(value.constData(), size);
+}
+
 AdObject::AdObject() {
 }
 
+AdObject::AdObject(AdObjectData *data)
+: d(data) {
+}
+
+AdObject::AdObject(const AdObject &other)
+: d(other.d) {
+}
+
+AdObject &AdObject::operator=(const AdObject &other) {
+    d = other.d;
+
+    return *this;
+}
+
+AdObject::~AdObject() {
+}
+
 void AdObject::load(const QString &dn_arg, const QHash<QString, QList<QByteArray>> &attributes_data_arg) {
-    dn = dn_arg;
-    attributes_data = attributes_data_arg;
+    AdObjectData *data = new AdObjectData();
+    data->dn = dn_arg;
+
+    int value_count = 0;
+    int buffer_size = 0;
+    for (const QList<QByteArray> &values : attributes_data_arg) {
+        value_count += values.size();
+
+        for (const QByteArray &value : values) {
+            buffer_size += value.size();
+        }
+    }
+
+    data->reserve(attributes_data_arg.size(), value_count, buffer_size);
+
+    for (auto it = attributes_data_arg.begin(); it != attributes_data_arg.end(); it++) {
+        const QString &attribute = it.key();
+        const QList<QByteArray> &values = it.value();
+
+        data->add_attribute(attribute);
+
+        for (const QByteArray &value : values) {
+            data->add_value(value.constData(), value.size());
+        }
+    }
+
+    d = data;
 }
 
 QString AdObject::get_dn() const {
-    return dn;
+    if (d) {
+        return d->dn;
+    } else {
+        return QString();
+    }
 }
 
 QHash<QString, QList<QByteArray>> AdObject::get_attributes_data() const {
-    return attributes_data;
+    QHash<QString, QList<QByteArray>> out;
+
+    for (const QString &attribute : attributes()) {
+        out[attribute] = get_values(attribute);
+    }
+
+    return out;
 }
 
 bool AdObject::is_empty() const {
-    return attributes_data.isEmpty();
+    return (!d || d->attribute_list.isEmpty());
 }
 
 bool AdObject::contains(const QString &attribute) const {
-    return attributes_data.contains(attribute);
+    return (d && d->find(attribute) != nullptr);
 }
 
 QList<QString> AdObject::attributes() const {
-    return attributes_data.keys();
+    QList<QString> out;
+
+    if (d) {
+        AdAttributeTable *table = AdAttributeTable::instance();
+
+        for (const AdObjectData::Attribute &attribute : d->attribute_list) {
+            out.append(table->name(attribute.id));
+        }
+    }
+
+    return out;
 }
 
-QList<QByteArray> AdObject::get_values(const QString &attribute) const {
-    if (contains(attribute)) {
-        return attributes_data[attribute];
+bool AdObject::contains(const int attribute_id) const {
+    return (d && d->find(attribute_id) != nullptr);
+}
+
+int AdObject::get_value_count(const QString &attribute) const {
+    const int attribute_id = AdAttributeTable::instance()->find(attribute);
+
+    return get_value_count(attribute_id);
+}
+
+int AdObject::get_value_count(const int attribute_id) const {
+    const AdObjectData::Attribute *found = (d ? d->find(attribute_id) : nullptr);
+
+    if (found != nullptr) {
+        return found->value_count;
     } else {
-        return QList<QByteArray>();
+        return 0;
     }
 }
 
-QByteArray AdObject::get_value(const QString &attribute) const {
-    const QList<QByteArray> values = get_values(attribute);
+QByteArray AdObject::get_value_view(const QString &attribute, const int index) const {
+    const int attribute_id = AdAttributeTable::instance()->find(attribute);
+
+    return get_value_view(attribute_id, index);
+}
+
+QByteArray AdObject::get_value_view(const int attribute_id, const int index) const {
+    const AdObjectData::Attribute *found = (d ? d->find(attribute_id) : nullptr);
 
-    if (!values.isEmpty()) {
-        return values.first();
+    if (found != nullptr && index >= 0 && index < found->value_count) {
+        return d->value_view(found->value_start + index);
     } else {
         return QByteArray();
     }
 }
 
+QList<QByteArray> AdObject::get_values(const QString &attribute) const {
+    const int attribute_id = AdAttributeTable::instance()->find(attribute);
+
+    return get_values(attribute_id);
+}
+
+QList<QByteArray> AdObject::get_values(const int attribute_id) const {
+    const AdObjectData::Attribute *found = (d ? d->find(attribute_id) : nullptr);
+
+    QList<QByteArray> out;
+
+    if (found != nullptr) {
+        for (int i = 0; i < found->value_count; i++) {
+            // NOTE: make a real copy, because caller may
+            // keep values after this object is gone
+            const QByteArray view = d->value_view(found->value_start + i);
+            out.append(QByteArray(view.constData(), view.size()));
+        }
+    }
+
+    return out;
+}
+
+QByteArray AdObject::get_value(const QString &attribute) const {
+    const QByteArray view = get_value_view(attribute);
+
+    return QByteArray(view.constData(), view.size());
+}
+
 QList<QString> AdObject::get_strings(const QString &attribute) const {
-    const QList<QByteArray> values = get_values(attribute);
+    const AdObjectData::Attribute *found = (d ? d->find(attribute) : nullptr);
 
     QList<QString> strings;
-    for (const auto &value : values) {
-        const QString string = QString(value);
-        strings.append(string);
+
+    if (found != nullptr) {
+        for (int i = 0; i < found->value_count; i++) {
+            const QByteArray view = d->value_view(found->value_start + i);
+            const QString string = value_to_string(view);
+            strings.append(string);
+        }
     }
 
     return strings;
 }
 
 QString AdObject::get_string(const QString &attribute) const {
-    const QList<QString> strings = get_strings(attribute);
+    const int attribute_id = AdAttributeTable::instance()->find(attribute);
+    const int value_count = get_value_count(attribute_id);
 
     // NOTE: return last object class because that is the most derived one and is what's needed most of the time
-    if (!strings.isEmpty()) {
-        if (attribute == ATTRIBUTE_OBJECT_CLASS) {
-            return strings.last();
-        } else {
-            return strings.first();
-        }
+    if (value_count > 0) {
+        const int index = [&]() {
+            if (attribute == ATTRIBUTE_OBJECT_CLASS) {
+                return value_count - 1;
+            } else {
+                return 0;
+            }
+        }();
+
+        return value_to_string(get_value_view(attribute_id, index));
     } else {
         return QString();
     }
@@ -269,7 +451,7 @@ security_descriptor *AdObject::get_security_descriptor(TALLOC_CTX *mem_ctx_arg)
         }
     }();
 
-    const QByteArray sd_bytes = get_value(ATTRIBUTE_SECURITY_DESCRIPTOR);
+    const QByteArray sd_bytes = get_value_view(ATTRIBUTE_SECURITY_DESCRIPTOR);
     security_descriptor *out = security_descriptor_make_from_bytes(mem_ctx, sd_bytes);
 
     return out;
@@ -34,12 +34,15 @@
 #include "ad_defines.h"
 
 #include <QByteArray>
+#include <QExplicitlySharedDataPointer>
 #include <QHash>
 #include <QList>
 #include <QString>
 
 class QDateTime;
 class AdConfig;
+class AdEntryView;
+class AdObjectData;
 typedef void TALLOC_CTX;
 struct security_descriptor;
 
@@ -47,6 +50,9 @@ class AdObject {
 
 public:
     AdObject();
+    AdObject(const AdObject &other);
+    AdObject &operator=(const AdObject &other);
+    ~AdObject();
 
     void load(const QString &dn_arg, const QHash<QString, QList<QByteArray>> &attributes_data_arg);
 
@@ -59,6 +65,19 @@ public:
     QList<QByteArray> get_values(const QString &attribute) const;
     QByteArray get_value(const QString &attribute) const;
 
+    // Returns value without copying it. Returned array
+    // points into this object's data, so it's only valid
+    // while this object or a copy of it is alive.
+    QByteArray get_value_view(const QString &attribute, const int index = 0) const;
+    int get_value_count(const QString &attribute) const;
+
+    // Versions that take attribute id's from
+    // AdAttributeTable, to skip looking up names
+    bool contains(const int attribute_id) const;
+    QList<QByteArray> get_values(const int attribute_id) const;
+    QByteArray get_value_view(const int attribute_id, const int index = 0) const;
+    int get_value_count(const int attribute_id) const;
+
     QList<QString> get_strings(const QString &attribute) const;
     QString get_string(const QString &attribute) const;
 
@@ -88,8 +107,13 @@ public:
     security_descriptor *get_security_descriptor(TALLOC_CTX *mem_ctx = nullptr) const;
 
 private:
-    QString dn;
-    QHash<QString, QList<QByteArray>> attributes_data;
+    // NOTE: data is shared between copies and is never
+    // modified, load() replaces it with new data. This
+    // makes copies cheap and keeps value views valid.
+    QExplicitlySharedDataPointer<AdObjectData> d;
+
+    friend class AdEntryView;
+    AdObject(AdObjectData *data);
 };
 
 #endif /* AD_OBJECT_H */
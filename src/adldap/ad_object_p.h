@@ -0,0 +1,71 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_OBJECT_P_H
+#define AD_OBJECT_P_H
+
+#include <QByteArray>
+#include <QSharedData>
+#include <QString>
+#include <QVector>
+
+/**
+ * Storage of AdObject. Attribute names are stored as
+ * id's from AdAttributeTable and all values of the object
+ * are packed into one buffer, so an object takes a handful
+ * of allocations no matter how many values it has. Data is
+ * never modified after it's built, so copies of AdObject
+ * share it.
+ */
+
+class AdObjectData : public QSharedData {
+
+public:
+    class Attribute {
+    public:
+        int id;
+        int value_start;
+        int value_count;
+    };
+
+    class Value {
+    public:
+        int offset;
+        int size;
+    };
+
+    QString dn;
+    QByteArray buffer;
+    QVector<Attribute> attribute_list;
+    QVector<Value> value_list;
+
+    // NOTE: reserve before adding values, so that buffer
+    // is allocated once
+    void reserve(const int attribute_count, const int value_count, const int buffer_size);
+    void add_attribute(const QString &name);
+    void add_value(const char *data, const int size);
+
+    const Attribute *find(const QString &name) const;
+    const Attribute *find(const int id) const;
+
+    // NOTE: returned array points into buffer
+    QByteArray value_view(const int index) const;
+};
+
+#endif /* AD_OBJECT_P_H */
@@ -0,0 +1,127 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_page_size.h"
+
+#include <QMutexLocker>
+
+#define PAGE_SIZE_DEFAULT 100
+
+// NOTE: AD doesn't return more than MaxPageSize entries
+// per page, which is 1000 by default, so bigger pages
+// don't do anything
+#define PAGE_SIZE_MIN 10
+#define PAGE_SIZE_MAX 1000
+
+// NOTE: if first page takes longer than this, next
+// searches start with smaller first pages
+#define FIRST_PAGE_TARGET_MSEC 250
+
+// NOTE: page keeps growing while time per entry is within
+// this factor of previous page's time per entry, and
+// shrinks if it gets worse by more than the shrink factor
+#define GROW_MAX_SLOWDOWN 1.25
+#define SHRINK_MIN_SLOWDOWN 2.0
+
+AdPageSizeTuner *AdPageSizeTuner::instance() {
+    static AdPageSizeTuner tuner;
+
+    return &tuner;
+}
+
+AdPageSizeTuner::AdPageSizeTuner() {
+    m_page_size = PAGE_SIZE_DEFAULT;
+    m_first_page_size = PAGE_SIZE_DEFAULT;
+    m_adaptive = false;
+}
+
+int AdPageSizeTuner::first_page_size() const {
+    QMutexLocker locker(&mutex);
+
+    if (m_adaptive) {
+        return m_first_page_size;
+    } else {
+        return m_page_size;
+    }
+}
+
+int AdPageSizeTuner::next_page_size(const bool is_first_page, const int page_size, const int entry_count, const qint64 elapsed_msec, double *msec_per_entry) {
+    QMutexLocker locker(&mutex);
+
+    if (!m_adaptive) {
+        return m_page_size;
+    }
+
+    // NOTE: only full pages say something about server
+    // speed, a partial page is the last one anyway
+    const bool page_is_full = (entry_count >= page_size);
+
+    if (is_first_page && page_is_full) {
+        if (elapsed_msec > FIRST_PAGE_TARGET_MSEC) {
+            m_first_page_size = qMax(m_first_page_size / 2, PAGE_SIZE_MIN);
+        } else if (elapsed_msec < FIRST_PAGE_TARGET_MSEC / 2) {
+            m_first_page_size = qMin(m_first_page_size * 2, m_page_size);
+        }
+    }
+
+    if (!page_is_full || entry_count == 0) {
+        return page_size;
+    }
+
+    const double current_msec_per_entry = (double) elapsed_msec / entry_count;
+    const double prev_msec_per_entry = *msec_per_entry;
+    *msec_per_entry = current_msec_per_entry;
+
+    const int out = [&]() {
+        if (prev_msec_per_entry <= 0 || current_msec_per_entry <= prev_msec_per_entry * GROW_MAX_SLOWDOWN) {
+            return qMin(page_size * 2, PAGE_SIZE_MAX);
+        } else if (current_msec_per_entry > prev_msec_per_entry * SHRINK_MIN_SLOWDOWN) {
+            return qMax(page_size / 2, m_page_size);
+        } else {
+            return page_size;
+        }
+    }();
+
+    return out;
+}
+
+void AdPageSizeTuner::set_page_size(const int page_size) {
+    QMutexLocker locker(&mutex);
+
+    m_page_size = qBound(PAGE_SIZE_MIN, page_size, PAGE_SIZE_MAX);
+    m_first_page_size = m_page_size;
+}
+
+int AdPageSizeTuner::page_size() const {
+    QMutexLocker locker(&mutex);
+
+    return m_page_size;
+}
+
+void AdPageSizeTuner::set_adaptive(const bool adaptive) {
+    QMutexLocker locker(&mutex);
+
+    m_adaptive = adaptive;
+}
+
+bool AdPageSizeTuner::adaptive() const {
+    QMutexLocker locker(&mutex);
+
+    return m_adaptive;
+}
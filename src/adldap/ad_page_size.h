@@ -0,0 +1,65 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_PAGE_SIZE_H
+#define AD_PAGE_SIZE_H
+
+/**
+ * Chooses page sizes for paged searches. In fixed mode,
+ * configured page size is always used. In adaptive mode,
+ * page size grows while time per entry stays flat, so that
+ * big searches take less round trips. First page of a
+ * search is kept small, and is made even smaller if it's
+ * slow to arrive, so that views can display first results
+ * quickly.
+ */
+
+#include <QMutex>
+
+class AdPageSizeTuner {
+
+public:
+    static AdPageSizeTuner *instance();
+
+    int first_page_size() const;
+
+    // Returns size of next page based on how long
+    // previous page took. "msec_per_entry" holds state
+    // between pages of one search, it should start at 0.
+    int next_page_size(const bool is_first_page, const int page_size, const int entry_count, const qint64 elapsed_msec, double *msec_per_entry);
+
+    // Size of first page. In adaptive mode, later pages
+    // may be bigger. Values are clamped to what AD
+    // accepts.
+    void set_page_size(const int page_size);
+    int page_size() const;
+
+    void set_adaptive(const bool adaptive);
+    bool adaptive() const;
+
+private:
+    mutable QMutex mutex;
+    int m_page_size;
+    int m_first_page_size;
+    bool m_adaptive;
+
+    AdPageSizeTuner();
+};
+
+#endif /* AD_PAGE_SIZE_H */
@@ -28,6 +28,7 @@
 #include "samba/security_descriptor.h"
 
 #include "ad_filter.h"
+#include "ad_trustee_resolver.h"
 #include "common_task_manager.h"
 
 #include <QDebug>
@@ -218,40 +219,13 @@ QString ad_security_get_well_known_trustee_name(const QByteArray &trustee) {
 }
 
 QString ad_security_get_trustee_name(AdInterface &ad, const QByteArray &trustee) {
-    const QString trustee_string = object_sid_display_value(trustee);
+    const QHash<QByteArray, QString> name_map = AdTrusteeResolver::instance()->resolve(ad, {trustee});
 
-    if (trustee_name_map.contains(trustee_string)) {
-        return trustee_name_map[trustee_string];
-    } else {
-        // Try to get name of trustee by finding it's DN
-        const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_SID, trustee_string);
-        const QList<QString> attributes = {
-            ATTRIBUTE_DISPLAY_NAME,
-            ATTRIBUTE_SAM_ACCOUNT_NAME,
-        };
-        const auto trustee_search = ad.search(ad.adconfig()->domain_dn(), SearchScope_All, filter, QList<QString>());
-        if (!trustee_search.isEmpty()) {
-            // NOTE: this is some weird name selection logic
-            // but that's how microsoft does it. Maybe need
-            // to use this somewhere else as well?
-            const QString name = [&]() {
-                const AdObject object = trustee_search.values()[0];
-
-                if (object.contains(ATTRIBUTE_DISPLAY_NAME)) {
-                    return object.get_string(ATTRIBUTE_DISPLAY_NAME);
-                } else if (object.contains(ATTRIBUTE_SAM_ACCOUNT_NAME)) {
-                    return object.get_string(ATTRIBUTE_SAM_ACCOUNT_NAME);
-                } else {
-                    return dn_get_name(object.get_dn());
-                }
-            }();
+    return name_map.value(trustee);
+}
 
-            return name;
-        } else {
-            // Return raw sid as last option
-            return trustee_string;
-        }
-    }
+QHash<QByteArray, QString> ad_security_get_trustee_names(AdInterface &ad, const QList<QByteArray> &trustee_list) {
+    return AdTrusteeResolver::instance()->resolve(ad, trustee_list);
 }
 
 bool ad_security_replace_security_descriptor(AdInterface &ad, const QString &dn, security_descriptor *new_sd) {
@@ -292,7 +266,7 @@ dom_sid dom_sid_from_bytes(const QByteArray &bytes) {
 
 QByteArray dom_sid_string_to_bytes(const QString &string) {
     dom_sid sid;
-    dom_sid_parse(cstr(string), &sid);
+    dom_sid_parse(AdCString(string).get(), &sid);
     const QByteArray bytes = dom_sid_to_bytes(sid);
 
     return bytes;
@@ -29,6 +29,7 @@
 #include "ad_defines.h"
 
 #include <QByteArray>
+#include <QHash>
 #include <QLocale>
 
 class AdInterface;
@@ -98,6 +99,9 @@ struct ace_match_flags {
 
 QString ad_security_get_well_known_trustee_name(const QByteArray &trustee);
 QString ad_security_get_trustee_name(AdInterface &ad, const QByteArray &trustee);
+// Resolves all trustees together, which is faster than
+// resolving them one by one. See ad_trustee_resolver.h.
+QHash<QByteArray, QString> ad_security_get_trustee_names(AdInterface &ad, const QList<QByteArray> &trustee_list);
 bool ad_security_get_protected_against_deletion(const AdObject &object);
 bool ad_security_set_protected_against_deletion(AdInterface &ad, const QString dn, const bool enabled);
 bool ad_security_get_user_cant_change_pass(const AdObject *object, AdConfig *adconfig);
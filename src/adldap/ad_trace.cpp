@@ -0,0 +1,197 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_trace.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+
+// NOTE: events are kept in memory until saved, so amount
+// is limited to keep memory use bounded if tracing is left
+// on for a long time. Newer events are dropped.
+#define EVENT_MAX 1000000
+
+AdTrace *AdTrace::instance() {
+    static AdTrace trace;
+
+    return &trace;
+}
+
+AdTrace::AdTrace() {
+    thread_id_max = 0;
+    clock.start();
+    start_nsec.storeRelease(0);
+}
+
+void AdTrace::start() {
+    QMutexLocker locker(&mutex);
+
+    event_list.clear();
+    start_nsec.storeRelease(clock.nsecsElapsed());
+    running.storeRelease(1);
+}
+
+void AdTrace::stop() {
+    running.storeRelease(0);
+}
+
+bool AdTrace::is_running() const {
+    return (running.loadAcquire() == 1);
+}
+
+void AdTrace::add_event(const AdTraceEvent &event) {
+    QMutexLocker locker(&mutex);
+
+    if (event_list.size() < EVENT_MAX) {
+        event_list.append(event);
+    }
+}
+
+qint64 AdTrace::now_usec() const {
+    return (clock.nsecsElapsed() - start_nsec.loadAcquire()) / 1000;
+}
+
+int AdTrace::current_thread_id() {
+    static thread_local int thread_id = -1;
+
+    if (thread_id == -1) {
+        QMutexLocker locker(&mutex);
+
+        thread_id = thread_id_max;
+        thread_id_max++;
+
+        const QString thread_name = [&]() {
+            QThread *thread = QThread::currentThread();
+
+            const bool is_main_thread = (QCoreApplication::instance() != nullptr && thread == QCoreApplication::instance()->thread());
+            if (is_main_thread) {
+                return QString("main");
+            } else if (!thread->objectName().isEmpty()) {
+                return thread->objectName();
+            } else {
+                return QString("thread %1").arg(thread_id);
+            }
+        }();
+
+        thread_name_map[thread_id] = thread_name;
+    }
+
+    return thread_id;
+}
+
+QByteArray AdTrace::to_json() const {
+    QMutexLocker locker(&mutex);
+
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray event_array;
+
+    for (const int thread_id : thread_name_map.keys()) {
+        QJsonObject args;
+        args["name"] = thread_name_map[thread_id];
+
+        QJsonObject metadata;
+        metadata["ph"] = "M";
+        metadata["name"] = "thread_name";
+        metadata["pid"] = pid;
+        metadata["tid"] = thread_id;
+        metadata["args"] = args;
+
+        event_array.append(metadata);
+    }
+
+    // NOTE: "X" is a complete event, which has both start
+    // and duration
+    for (const AdTraceEvent &event : event_list) {
+        QJsonObject object;
+        object["ph"] = "X";
+        object["name"] = event.name;
+        object["cat"] = event.category;
+        object["ts"] = event.start_usec;
+        object["dur"] = event.duration_usec;
+        object["pid"] = pid;
+        object["tid"] = event.thread_id;
+
+        if (!event.detail.isEmpty()) {
+            QJsonObject args;
+            args["detail"] = event.detail;
+            object["args"] = args;
+        }
+
+        event_array.append(object);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = event_array;
+    root["displayTimeUnit"] = "ms";
+
+    const QJsonDocument document(root);
+
+    return document.toJson(QJsonDocument::Compact);
+}
+
+bool AdTrace::save(const QString &path) const {
+    QFile file(path);
+
+    const bool open_success = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!open_success) {
+        return false;
+    }
+
+    const QByteArray json = to_json();
+    const qint64 written = file.write(json);
+
+    return (written == json.size());
+}
+
+AdTraceSpan::AdTraceSpan(const char *name_arg, const char *category_arg, const QString &detail_arg) {
+    active = AdTrace::instance()->is_running();
+
+    if (!active) {
+        return;
+    }
+
+    name = name_arg;
+    category = category_arg;
+    detail = detail_arg;
+    start_usec = AdTrace::instance()->now_usec();
+}
+
+AdTraceSpan::~AdTraceSpan() {
+    if (!active) {
+        return;
+    }
+
+    AdTrace *trace = AdTrace::instance();
+
+    AdTraceEvent event;
+    event.name = QString::fromLatin1(name);
+    event.category = QString::fromLatin1(category);
+    event.detail = detail;
+    event.start_usec = start_usec;
+    event.duration_usec = trace->now_usec() - start_usec;
+    event.thread_id = trace->current_thread_id();
+
+    trace->add_event(event);
+}
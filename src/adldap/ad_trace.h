@@ -0,0 +1,116 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_TRACE_H
+#define AD_TRACE_H
+
+/**
+ * Opt-in span tracing of LDAP, SMB and UI work. Spans are
+ * recorded by creating AdTraceSpan objects on the stack,
+ * which record a complete event when they go out of scope.
+ * Events are kept in memory and written as Chrome Trace
+ * Event JSON, which can be opened in Perfetto or
+ * chrome://tracing. Each event has the id of the thread
+ * that recorded it, so work done by background threads is
+ * shown on separate tracks. When tracing is off, spans
+ * cost one atomic load. Details that have to be built,
+ * like concatenated strings, should be wrapped in
+ * AD_TRACE_DETAIL(), so that they are only built while
+ * tracing.
+ */
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+// NOTE: this adds a second atomic load, but saves building
+// the string when tracing is off
+#define AD_TRACE_DETAIL(detail) (AdTrace::instance()->is_running() ? QString(detail) : QString())
+
+class AdTraceEvent {
+public:
+    QString name;
+    QString category;
+    QString detail;
+    qint64 start_usec;
+    qint64 duration_usec;
+    int thread_id;
+};
+
+class AdTrace {
+
+public:
+    static AdTrace *instance();
+
+    // Starting clears previously recorded events
+    void start();
+    void stop();
+    bool is_running() const;
+
+    void add_event(const AdTraceEvent &event);
+
+    // Returns time since start of tracing
+    qint64 now_usec() const;
+
+    // Id of current thread. Threads are numbered in order
+    // of first use and named after their QThread's object
+    // name.
+    int current_thread_id();
+
+    QByteArray to_json() const;
+    bool save(const QString &path) const;
+
+private:
+    mutable QMutex mutex;
+    QAtomicInt running;
+    // NOTE: clock is started once and never restarted, so
+    // it can be read without the lock. Start of tracing is
+    // stored as an offset into it.
+    QElapsedTimer clock;
+    QAtomicInteger<qint64> start_nsec;
+    QList<AdTraceEvent> event_list;
+    QHash<int, QString> thread_name_map;
+    int thread_id_max;
+
+    AdTrace();
+};
+
+class AdTraceSpan {
+
+public:
+    // NOTE: "detail" is shown in event's args, use it for
+    // dn's, filters and paths
+    AdTraceSpan(const char *name, const char *category, const QString &detail = QString());
+    ~AdTraceSpan();
+
+    AdTraceSpan(const AdTraceSpan &) = delete;
+    AdTraceSpan &operator=(const AdTraceSpan &) = delete;
+
+private:
+    const char *name;
+    const char *category;
+    QString detail;
+    qint64 start_usec;
+    bool active;
+};
+
+#endif /* AD_TRACE_H */
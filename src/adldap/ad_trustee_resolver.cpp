@@ -0,0 +1,206 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ad_trustee_resolver.h"
+
+#include "ad_config.h"
+#include "ad_display.h"
+#include "ad_filter.h"
+#include "ad_interface.h"
+#include "ad_object.h"
+#include "ad_security.h"
+#include "ad_trace.h"
+#include "ad_utils.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+
+// NOTE: names rarely change, so entries are kept for a
+// while. SID's that weren't found are cached too, so that
+// orphaned trustees don't cause a search every time.
+#define ENTRY_TTL_MSEC (10 * 60 * 1000)
+
+#define CACHE_MAX 4096
+
+// NOTE: keeps filters at a reasonable length
+#define BATCH_MAX 100
+
+AdTrusteeResolver *AdTrusteeResolver::instance() {
+    static AdTrusteeResolver resolver;
+
+    return &resolver;
+}
+
+AdTrusteeResolver::AdTrusteeResolver() {
+    cache.setMaxCost(CACHE_MAX);
+}
+
+QHash<QByteArray, QString> AdTrusteeResolver::resolve(AdInterface &ad, const QList<QByteArray> &sid_list) {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    QHash<QByteArray, QString> out;
+    QList<QByteArray> unknown_list;
+
+    const QString domain = ad.adconfig()->domain_dn();
+
+    {
+        QMutexLocker locker(&mutex);
+
+        // NOTE: SID's of trustees from a different domain
+        // may resolve differently, for example after
+        // reconnecting with other connection options, so
+        // entries of previous domain can't be reused
+        if (domain != cache_domain) {
+            cache.clear();
+            cache_domain = domain;
+        }
+
+        for (const QByteArray &sid : sid_list) {
+            if (out.contains(sid) || unknown_list.contains(sid)) {
+                continue;
+            }
+
+            const QString well_known_name = ad_security_get_well_known_trustee_name(sid);
+            if (!well_known_name.isEmpty()) {
+                out[sid] = well_known_name;
+
+                continue;
+            }
+
+            const Entry *entry = cache.object(sid);
+            if (entry != nullptr && entry->expires_at > now) {
+                out[sid] = entry->name;
+            } else {
+                unknown_list.append(sid);
+            }
+        }
+    }
+
+    if (unknown_list.isEmpty()) {
+        return out;
+    }
+
+    const AdTraceSpan trace_span("resolve_trustees", "ldap", AD_TRACE_DETAIL(QString::number(unknown_list.size())));
+
+    QHash<QByteArray, QString> found_map = search_names(ad, domain, unknown_list);
+
+    // NOTE: trustees from other domains of the forest are
+    // not in this domain, so look for them in global
+    // catalog
+    const QList<QByteArray> foreign_list = [&]() {
+        QList<QByteArray> list;
+
+        const QString domain_sid_prefix = ad.adconfig()->domain_sid() + "-";
+
+        for (const QByteArray &sid : unknown_list) {
+            const QString sid_string = object_sid_display_value(sid);
+            const bool is_foreign = (!found_map.contains(sid) && !sid_string.startsWith(domain_sid_prefix));
+
+            if (is_foreign) {
+                list.append(sid);
+            }
+        }
+
+        return list;
+    }();
+
+    if (!foreign_list.isEmpty()) {
+        AdInterface gc(AdServer_GlobalCatalog);
+
+        if (gc.is_connected()) {
+            found_map.unite(search_names(gc, QString(), foreign_list));
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+
+    // NOTE: domain may have changed while searching, in
+    // which case results are not cached
+    const bool same_domain = (domain == cache_domain);
+
+    for (const QByteArray &sid : unknown_list) {
+        // Return raw sid as last option
+        const QString name = found_map.value(sid, object_sid_display_value(sid));
+
+        if (same_domain) {
+            Entry *entry = new Entry();
+            entry->name = name;
+            entry->expires_at = now + ENTRY_TTL_MSEC;
+            cache.insert(sid, entry);
+        }
+
+        out[sid] = name;
+    }
+
+    return out;
+}
+
+void AdTrusteeResolver::clear() {
+    QMutexLocker locker(&mutex);
+
+    cache.clear();
+}
+
+QHash<QByteArray, QString> AdTrusteeResolver::search_names(AdInterface &ad, const QString &base, const QList<QByteArray> &sid_list) {
+    QHash<QByteArray, QString> out;
+
+    const QList<QString> attributes = {
+        ATTRIBUTE_OBJECT_SID,
+        ATTRIBUTE_DISPLAY_NAME,
+        ATTRIBUTE_SAM_ACCOUNT_NAME,
+    };
+
+    for (int i = 0; i < sid_list.size(); i += BATCH_MAX) {
+        const QList<QByteArray> batch = sid_list.mid(i, BATCH_MAX);
+
+        const QString filter = [&]() {
+            QList<QString> subfilter_list;
+
+            for (const QByteArray &sid : batch) {
+                const QString sid_string = object_sid_display_value(sid);
+                subfilter_list.append(filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_SID, sid_string));
+            }
+
+            return filter_OR(subfilter_list);
+        }();
+
+        const QHash<QString, AdObject> results = ad.search(base, SearchScope_All, filter, attributes);
+
+        for (const AdObject &object : results) {
+            const QByteArray sid = object.get_value(ATTRIBUTE_OBJECT_SID);
+
+            // NOTE: this is some weird name selection logic
+            // but that's how microsoft does it. Maybe need
+            // to use this somewhere else as well?
+            const QString name = [&]() {
+                if (object.contains(ATTRIBUTE_DISPLAY_NAME)) {
+                    return object.get_string(ATTRIBUTE_DISPLAY_NAME);
+                } else if (object.contains(ATTRIBUTE_SAM_ACCOUNT_NAME)) {
+                    return object.get_string(ATTRIBUTE_SAM_ACCOUNT_NAME);
+                } else {
+                    return dn_get_name(object.get_dn());
+                }
+            }();
+
+            out[sid] = name;
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,71 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AD_TRUSTEE_RESOLVER_H
+#define AD_TRUSTEE_RESOLVER_H
+
+/**
+ * Resolves SID's of trustees to names for security UI.
+ * SID's that are not cached are resolved together, with
+ * one search per batch instead of one per SID. Results are
+ * kept in an LRU cache that is shared by all dialogs.
+ * Entries expire after a TTL, so that renames are picked
+ * up eventually. Cache is cleared when resolver is used
+ * with a different domain.
+ */
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+class AdInterface;
+
+class AdTrusteeResolver {
+
+public:
+    static AdTrusteeResolver *instance();
+
+    // Returns names for all given SID's. Well-known SID's
+    // get their fixed names. SID's that can't be found
+    // are returned as SID strings.
+    QHash<QByteArray, QString> resolve(AdInterface &ad, const QList<QByteArray> &sid_list);
+
+    void clear();
+
+private:
+    class Entry {
+    public:
+        QString name;
+        qint64 expires_at;
+    };
+
+    QMutex mutex;
+    QCache<QByteArray, Entry> cache;
+    // Domain that cached entries belong to
+    QString cache_domain;
+
+    AdTrusteeResolver();
+
+    QHash<QByteArray, QString> search_names(AdInterface &ad, const QString &base, const QList<QByteArray> &sid_list);
+};
+
+#endif /* AD_TRUSTEE_RESOLVER_H */
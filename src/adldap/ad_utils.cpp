@@ -293,7 +293,7 @@ QString dn_move(const QString &dn, const QString &new_parent_dn) {
 // =>
 // "domain.com/bar/foo"
 QString dn_canonical(const QString &dn) {
-    char *canonical_cstr = ldap_dn2ad_canonical(cstr(dn));
+    char *canonical_cstr = ldap_dn2ad_canonical(AdCString(dn).get());
     const QString canonical = QString(canonical_cstr);
     ldap_memfree(canonical_cstr);
 
@@ -369,19 +369,74 @@ bool bitmask_is_set(const int input_mask, const int mask_to_read) {
     return ((input_mask & mask_to_read) == mask_to_read);
 }
 
-const char *cstr(const QString &qstr) {
-    static QList<QByteArray> buffer;
+AdCString::AdCString(const QString &string) {
+    // NOTE: one UTF-16 unit takes at most 3 bytes in
+    // UTF-8, and surrogate pairs take 4 bytes for 2 units,
+    // so this is enough to fit any string of this length
+    const int length = string.size();
+    const bool fits_in_buffer = (length * 3 < AD_CSTRING_BUFFER_SIZE);
 
-    const QByteArray bytes = qstr.toUtf8();
-    buffer.append(bytes);
+    const bool converted = [&]() {
+        if (!fits_in_buffer) {
+            return false;
+        }
+
+        const QChar *in = string.constData();
+        char *out = buffer;
+
+        for (int i = 0; i < length; i++) {
+            const ushort c = in[i].unicode();
+
+            if (c < 0x80) {
+                *out++ = (char) c;
+            } else if (c < 0x800) {
+                *out++ = (char) (0xC0 | (c >> 6));
+                *out++ = (char) (0x80 | (c & 0x3F));
+            } else if (QChar::isSurrogate(c)) {
+                const bool is_pair = (QChar::isHighSurrogate(c) && i + 1 < length && QChar::isLowSurrogate(in[i + 1].unicode()));
+
+                // NOTE: leave broken surrogates to
+                // toUtf8(), so that they are handled the
+                // same way as everywhere else
+                if (!is_pair) {
+                    return false;
+                }
+
+                const uint code_point = QChar::surrogateToUcs4(c, in[i + 1].unicode());
+                i++;
+
+                *out++ = (char) (0xF0 | (code_point >> 18));
+                *out++ = (char) (0x80 | ((code_point >> 12) & 0x3F));
+                *out++ = (char) (0x80 | ((code_point >> 6) & 0x3F));
+                *out++ = (char) (0x80 | (code_point & 0x3F));
+            } else {
+                *out++ = (char) (0xE0 | (c >> 12));
+                *out++ = (char) (0x80 | ((c >> 6) & 0x3F));
+                *out++ = (char) (0x80 | (c & 0x3F));
+            }
+        }
+
+        *out = '\0';
+        data_size = (int) (out - buffer);
 
-    // Limit buffer to 100 strings
-    if (buffer.size() > 100) {
-        buffer.removeAt(0);
+        return true;
+    }();
+
+    if (converted) {
+        data = buffer;
+    } else {
+        heap_buffer = string.toUtf8();
+        data = heap_buffer.constData();
+        data_size = heap_buffer.size();
     }
+}
 
-    // NOTE: return data of bytes in buffer NOT the temp local bytes
-    return buffer.last().constData();
+const char *AdCString::get() const {
+    return data;
+}
+
+int AdCString::size() const {
+    return data_size;
 }
 
 bool load_adldap_translation(QTranslator &translator, const QLocale &locale) {
@@ -425,7 +480,7 @@ QByteArray guid_string_to_bytes(const QString &guid_string) {
 
 QByteArray sid_string_to_bytes(const QString &sid_string) {
     dom_sid sid;
-    string_to_sid(&sid, cstr(sid_string));
+    string_to_sid(&sid, AdCString(sid_string).get());
 
     const QByteArray sid_bytes = QByteArray((char *) &sid, sizeof(dom_sid));
 
@@ -502,3 +557,42 @@ QList<QString> bytearray_list_to_string_list(const QList<QByteArray> &bytearray_
 
     return out;
 }
+
+bool attribute_parse_range(const QString &name, QString *attribute, int *low, int *high) {
+    const int range_index = name.indexOf(";range=", 0, Qt::CaseInsensitive);
+    if (range_index == -1) {
+        return false;
+    }
+
+    const QString range = name.mid(range_index + QString(";range=").size());
+    const QList<QString> bounds = range.split("-");
+    if (bounds.size() != 2) {
+        return false;
+    }
+
+    bool low_ok;
+    const int low_value = bounds[0].toInt(&low_ok);
+    if (!low_ok) {
+        return false;
+    }
+
+    const int high_value = [&]() {
+        if (bounds[1] == "*") {
+            return -1;
+        } else {
+            bool high_ok;
+            const int out = bounds[1].toInt(&high_ok);
+
+            return (high_ok ? out : -2);
+        }
+    }();
+    if (high_value == -2) {
+        return false;
+    }
+
+    *attribute = name.left(range_index);
+    *low = low_value;
+    *high = high_value;
+
+    return true;
+}
@@ -27,11 +27,11 @@
  */
 
 #include "ad_defines.h"
+#include <QByteArray>
 #include <QHash>
+#include <QString>
 
-class QString;
 class QDateTime;
-class QByteArray;
 class AdConfig;
 class QTranslator;
 class QLocale;
@@ -69,11 +69,33 @@ QString get_default_domain_from_krb5();
 int bitmask_set(const int input_mask, const int mask_to_set, const bool is_set);
 bool bitmask_is_set(const int input_mask, const int mask_to_read);
 
-// NOTE: uses a buffer that is capped at 100 strings, so
-// pointers returned from this become invalid after 99 more
-// calls. Only use this to give cstr args to C routines in
-// the same scope. Keep this far away from any recursion.
-const char *cstr(const QString &qstr);
+#define AD_CSTRING_BUFFER_SIZE 256
+
+// Converts string to UTF-8 for passing to C routines.
+// Short strings are converted into a buffer inside the
+// object itself, so they don't allocate, long strings go
+// to heap. Pointer returned by get() is valid while the
+// object is alive, so either keep the object in a local
+// variable or only use a temporary within one expression:
+// "ldap_f(AdCString(dn).get())". Safe to use from any
+// thread.
+class AdCString {
+
+public:
+    explicit AdCString(const QString &string);
+
+    AdCString(const AdCString &) = delete;
+    AdCString &operator=(const AdCString &) = delete;
+
+    const char *get() const;
+    int size() const;
+
+private:
+    char buffer[AD_CSTRING_BUFFER_SIZE];
+    QByteArray heap_buffer;
+    const char *data;
+    int data_size;
+};
 
 // NOTE: you must call Q_INIT_RESOURCE(adldap) before
 // calling this
@@ -90,4 +112,10 @@ QHash<int, QString> attribute_value_bit_string_map(const QString &attribute);
 
 QList<QString> bytearray_list_to_string_list(const QList<QByteArray> &bytearray_list);
 
+// Parses name of an attribute returned by range
+// retrieval, for example "member;range=0-1499". For the
+// last range, "member;range=1500-*", "high" is set to -1.
+// Returns false if name is not ranged.
+bool attribute_parse_range(const QString &name, QString *attribute, int *low, int *high);
+
 #endif /* AD_UTILS_H */
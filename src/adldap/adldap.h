@@ -21,13 +21,19 @@
 #ifndef ADLDAP_H
 #define ADLDAP_H
 
+#include "ad_attribute_table.h"
+#include "ad_bulk.h"
 #include "ad_config.h"
+#include "ad_connection_pool.h"
 #include "ad_defines.h"
 #include "ad_display.h"
+#include "ad_entry_view.h"
 #include "ad_filter.h"
 #include "ad_interface.h"
+#include "ad_metrics.h"
 #include "ad_object.h"
 #include "ad_security.h"
+#include "ad_trace.h"
 #include "ad_utils.h"
 #include "gplink.h"
 
@@ -43,9 +43,7 @@ ListAttributeDialog::ListAttributeDialog(const QList<QByteArray> &value_list, co
     ui->add_button->setVisible(!read_only);
     ui->remove_button->setVisible(!read_only);
 
-    for (const QByteArray &value : value_list) {
-        add_value(value);
-    }
+    add_values(value_list);
 
     settings_setup_dialog_geometry(SETTING_list_attribute_dialog_geometry, this);
 
@@ -119,6 +117,7 @@ void ListAttributeDialog::on_remove_button() {
     const QList<QListWidgetItem *> selected = ui->list_widget->selectedItems();
 
     for (const auto item : selected) {
+        text_set.remove(item->text());
         delete item;
     }
 }
@@ -142,13 +141,26 @@ void ListAttributeDialog::set_value_max_length(const int max_length_arg) {
 }
 
 void ListAttributeDialog::add_value(const QByteArray value) {
-    const QString text = bytes_to_string(value);
-    const QList<QListWidgetItem *> find_results = ui->list_widget->findItems(text, Qt::MatchExactly);
-    const bool value_already_exists = !find_results.isEmpty();
+    add_values({value});
+}
+
+// NOTE: attributes like "member" can have 100k's of
+// values, so duplicates are found using a set instead of
+// searching the list widget and items are added in one go
+void ListAttributeDialog::add_values(const QList<QByteArray> &value_list) {
+    QStringList new_text_list;
 
-    if (!value_already_exists) {
-        ui->list_widget->addItem(text);
+    for (const QByteArray &value : value_list) {
+        const QString text = bytes_to_string(value);
+        const bool value_already_exists = text_set.contains(text);
+
+        if (!value_already_exists) {
+            text_set.insert(text);
+            new_text_list.append(text);
+        }
     }
+
+    ui->list_widget->addItems(new_text_list);
 }
 
 ListAttributeDialogType ListAttributeDialog::get_type() const {
@@ -23,6 +23,8 @@
 
 #include "attribute_dialogs/attribute_dialog.h"
 
+#include <QSet>
+
 class QListWidgetItem;
 
 enum ListAttributeDialogType {
@@ -58,10 +60,13 @@ public:
 
 private:
     int max_length;
+    // Texts of values in the list widget
+    QSet<QString> text_set;
 
     void on_add_button();
     void on_remove_button();
     void add_value(const QByteArray value);
+    void add_values(const QList<QByteArray> &value_list);
     QString bytes_to_string(const QByteArray bytes) const;
     QByteArray string_to_bytes(const QString string) const;
     ListAttributeDialogType get_type() const;
@@ -87,11 +87,15 @@ bool UpnEdit::verify(AdInterface &ad, const QString &dn) const {
 
         return filter_AND({same_upn, not_object_itself});
     }();
-    const QList<QString> attributes = QList<QString>();
+    const QList<QString> attributes = {ATTRIBUTE_DN};
 
-    const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes);
+    // NOTE: one match is enough, so stop at first entry
+    bool upn_not_unique = false;
+    ad.search_visit(base, scope, filter, attributes, [&](const AdEntryView &) {
+        upn_not_unique = true;
 
-    const bool upn_not_unique = (results.size() > 0);
+        return false;
+    });
 
     if (upn_not_unique) {
         const QString text = tr("The specified user logon name already exists.");
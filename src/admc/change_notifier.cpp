@@ -0,0 +1,194 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "change_notifier.h"
+
+#include "adldap.h"
+#include "search_engine.h"
+#include "utils.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTimer>
+
+// NOTE: server allows 5 notification searches per
+// connection by default (MaxNotificationPerConn)
+#define SUBSCRIPTION_MAX 5
+
+// NOTE: delay is doubled for each failed retry in a row
+#define RETRY_DELAY_MSEC 1000
+#define RETRY_MAX 5
+
+ChangeNotifier *ChangeNotifier::instance() {
+    static ChangeNotifier *notifier = nullptr;
+
+    if (notifier == nullptr) {
+        notifier = new ChangeNotifier(QCoreApplication::instance());
+    }
+
+    return notifier;
+}
+
+ChangeNotifier::ChangeNotifier(QObject *parent)
+: QObject(parent) {
+}
+
+void ChangeNotifier::subscribe(const QString &container_dn) {
+    const int existing = find(container_dn);
+    if (existing != -1) {
+        subscriptions.move(existing, subscriptions.size() - 1);
+
+        return;
+    }
+
+    Subscription subscription;
+    subscription.dn = container_dn;
+    subscription.engine_id = start_notify(container_dn);
+    subscription.retry_count = 0;
+    subscriptions.append(subscription);
+
+    while (subscriptions.size() > SUBSCRIPTION_MAX) {
+        const Subscription oldest = subscriptions.takeFirst();
+
+        if (oldest.engine_id != -1) {
+            SearchEngine::instance()->stop_search(oldest.engine_id);
+        }
+    }
+}
+
+void ChangeNotifier::unsubscribe(const QString &container_dn) {
+    const int index = find(container_dn);
+    if (index == -1) {
+        return;
+    }
+
+    const Subscription subscription = subscriptions.takeAt(index);
+
+    if (subscription.engine_id != -1) {
+        SearchEngine::instance()->stop_search(subscription.engine_id);
+    }
+}
+
+void ChangeNotifier::unsubscribe_all() {
+    for (const Subscription &subscription : subscriptions) {
+        if (subscription.engine_id != -1) {
+            SearchEngine::instance()->stop_search(subscription.engine_id);
+        }
+    }
+
+    subscriptions.clear();
+}
+
+QList<QString> ChangeNotifier::subscription_list() const {
+    QList<QString> out;
+
+    for (const Subscription &subscription : subscriptions) {
+        out.append(subscription.dn);
+    }
+
+    return out;
+}
+
+int ChangeNotifier::find(const QString &container_dn) const {
+    for (int i = 0; i < subscriptions.size(); i++) {
+        if (subscriptions[i].dn == container_dn) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int ChangeNotifier::start_notify(const QString &container_dn) {
+    const QList<QString> attributes = {
+        ATTRIBUTE_OBJECT_GUID,
+        ATTRIBUTE_IS_DELETED,
+    };
+
+    return SearchEngine::instance()->start_notify(container_dn, attributes, this);
+}
+
+// NOTE: container might've been unsubscribed while
+// waiting
+void ChangeNotifier::resubscribe(const QString &container_dn) {
+    const int index = find(container_dn);
+    if (index == -1 || subscriptions[index].engine_id != -1) {
+        return;
+    }
+
+    subscriptions[index].engine_id = start_notify(container_dn);
+}
+
+void ChangeNotifier::on_engine_results(const int id, const QHash<QString, AdObject> &results) {
+    for (Subscription &subscription : subscriptions) {
+        if (subscription.engine_id == id) {
+            subscription.retry_count = 0;
+
+            emit objects_changed(subscription.dn, results.values());
+
+            return;
+        }
+    }
+}
+
+// NOTE: notification searches only finish if they fail,
+// for example if connection was lost or if server limit
+// was reached because of other clients. Changes made
+// until subscribing again are missed, so receivers are
+// told to reload the container. Subscription is dropped
+// if it keeps failing.
+void ChangeNotifier::on_engine_finished(const int id, const int status, const QList<AdMessage> &messages, const QString &dc) {
+    UNUSED_ARG(messages);
+    UNUSED_ARG(dc);
+
+    const int index = [&]() {
+        for (int i = 0; i < subscriptions.size(); i++) {
+            if (subscriptions[i].engine_id == id) {
+                return i;
+            }
+        }
+
+        return -1;
+    }();
+
+    if (index == -1 || status == SearchEngineStatus_Stopped) {
+        return;
+    }
+
+    Subscription &subscription = subscriptions[index];
+    const QString container_dn = subscription.dn;
+
+    qDebug() << "Change notification search failed for" << container_dn;
+
+    if (subscription.retry_count < RETRY_MAX) {
+        const int delay = RETRY_DELAY_MSEC << subscription.retry_count;
+
+        subscription.engine_id = -1;
+        subscription.retry_count++;
+
+        QTimer::singleShot(delay, this,
+            [this, container_dn]() {
+                resubscribe(container_dn);
+            });
+    } else {
+        subscriptions.removeAt(index);
+    }
+
+    emit subscription_failed(container_dn);
+}
@@ -0,0 +1,87 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHANGE_NOTIFIER_H
+#define CHANGE_NOTIFIER_H
+
+/**
+ * Keeps change notification searches running for a few
+ * containers, so that changes made by other clients can be
+ * shown without refreshing. Notifications are received by
+ * SearchEngine in the background. Each changed object is
+ * reported with only dn, objectGUID and isDeleted
+ * attributes, so receivers should load the rest
+ * themselves. Server limits the amount of notification
+ * searches, so only the most recently subscribed
+ * containers are kept subscribed. Subscriptions are
+ * shared between all receivers. If a notification search
+ * fails, subscription_failed() is emitted, because changes
+ * may have been missed, and container is subscribed again
+ * after a delay.
+ */
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+#include "search_engine.h"
+
+class AdObject;
+class AdMessage;
+
+class ChangeNotifier final : public QObject, public SearchEngineReceiver {
+    Q_OBJECT
+
+public:
+    static ChangeNotifier *instance();
+
+    // If container is already subscribed, it becomes the
+    // most recent subscription
+    void subscribe(const QString &container_dn);
+    void unsubscribe(const QString &container_dn);
+    void unsubscribe_all();
+    QList<QString> subscription_list() const;
+
+signals:
+    void objects_changed(const QString &container_dn, const QList<AdObject> &object_list);
+    void subscription_failed(const QString &container_dn);
+
+private:
+    class Subscription {
+    public:
+        QString dn;
+        // NOTE: -1 while waiting to subscribe again
+        int engine_id;
+        int retry_count;
+    };
+
+    // NOTE: ordered from oldest to most recent
+    QList<Subscription> subscriptions;
+
+    ChangeNotifier(QObject *parent);
+
+    int find(const QString &container_dn) const;
+    int start_notify(const QString &container_dn);
+    void resubscribe(const QString &container_dn);
+    void on_engine_results(const int id, const QHash<QString, AdObject> &results) override;
+    void on_engine_finished(const int id, const int status, const QList<AdMessage> &messages, const QString &dc) override;
+};
+
+#endif /* CHANGE_NOTIFIER_H */
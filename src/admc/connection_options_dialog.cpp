@@ -327,4 +327,19 @@ void load_connection_options(const QHash<QString, QVariant> &settings) {
     };
     const CertStrategy cert_strategy = cert_strategy_map.value(cert_strategy_string, CertStrategy_Never);
     AdInterface::set_cert_strategy(cert_strategy);
+
+    // NOTE: these are feature flags, so they are always
+    // loaded from config
+    const bool site_aware_dc = settings_get_variant(SETTING_feature_site_aware_dc).toBool();
+    AdInterface::set_site_aware_enabled(site_aware_dc);
+
+    const bool dc_latency_ranking = settings_get_variant(SETTING_feature_dc_latency_ranking).toBool();
+    AdInterface::set_dc_ranking_enabled(dc_latency_ranking);
+
+    const bool hedged_reads = settings_get_variant(SETTING_feature_hedged_reads).toBool();
+    AdInterface::set_hedged_reads_enabled(hedged_reads);
+
+    // NOTE: pooled connections were made with old
+    // options, so they can't be reused
+    AdInterface::clear_connection_pool();
 }
@@ -22,6 +22,7 @@
 
 #include "adldap.h"
 #include "attribute_dialogs/list_attribute_dialog.h"
+#include "change_notifier.h"
 #include "console_filter_dialog.h"
 #include "console_impls/find_object_impl.h"
 #include "console_impls/item_type.h"
@@ -66,6 +67,14 @@
 
 #include <algorithm>
 
+// NOTE: windows should be big enough to fill the results
+// view, otherwise several windows are loaded in a row
+#define WINDOW_SIZE 200
+
+// NOTE: if more objects than this changed since last
+// fetch, incremental refresh is not worth it
+#define INCREMENTAL_REFRESH_CHANGES_MAX 5000
+
 enum DropType {
     DropType_Move,
     DropType_AddToGroup,
@@ -78,6 +87,13 @@ QString get_selected_target_dn_object(ConsoleWidget *console);
 void console_object_delete_dn_list(ConsoleWidget *console, const QList<QString> &dn_list, const QModelIndex &tree_root, const int type, const int dn_role);
 bool can_create_class_at_parent(const QString &create_class, const QString &parent_class);
 void console_object_move_and_rename(const QList<ConsoleWidget *> &console_list, AdInterface &ad, const QHash<QString, QString> &old_to_new_dn_map_arg, const QString &new_parent_dn);
+bool object_impl_search_id_matches(QStandardItem *item, SearchThread *thread);
+bool object_impl_window_search_enabled();
+void object_impl_probe_windows(ConsoleWidget *console, const QModelIndex &index, const QString &filter, const int fetch_id);
+void object_impl_start_windows(ConsoleWidget *console, const QModelIndex &index, const QString &filter);
+void object_impl_switch_to_windows(ConsoleWidget *console, const QModelIndex &index, const QString &filter);
+void object_impl_load_window(ConsoleWidget *console, const QModelIndex &index);
+bool object_impl_can_refresh_delta(const QModelIndex &container, const QString &filter);
 
 ObjectImpl::ObjectImpl(ConsoleWidget *console_arg)
 : ConsoleImpl(console_arg) {
@@ -106,6 +122,13 @@ ObjectImpl::ObjectImpl(ConsoleWidget *console_arg)
     object_filter = settings_get_variant(SETTING_object_filter).toString();
     object_filter_enabled = settings_get_variant(SETTING_object_filter_enabled).toBool();
 
+    connect(
+        ChangeNotifier::instance(), &ChangeNotifier::objects_changed,
+        this, &ObjectImpl::on_objects_changed);
+    connect(
+        ChangeNotifier::instance(), &ChangeNotifier::subscription_failed,
+        this, &ObjectImpl::on_subscription_failed);
+
     new_action_map[CLASS_USER] = new QAction(tr("User"), this);
     new_action_map[CLASS_COMPUTER] = new QAction(tr("Computer"), this);
     new_action_map[CLASS_OU] = new QAction(tr("OU"), this);
@@ -200,28 +223,27 @@ void ObjectImpl::set_buddy_console(ConsoleWidget *buddy_console) {
 // Load children of this item in scope tree
 // and load results linked to this scope item
 void ObjectImpl::fetch(const QModelIndex &index) {
+    const AdMetricsAction metrics_action(tr("Expand container"));
+
     const QString base = index.data(ObjectRole_DN).toString();
 
+    const AdTraceSpan trace_span("ObjectImpl::fetch", "ui", base);
+
+    // NOTE: refresh fetches the same item again, so clear
+    // window state left from previous fetch
+    QStandardItem *item = console->get_item(index);
+    item->setData(QVariant(), ObjectRole_WindowOffset);
+    item->setData(QVariant(), ObjectRole_Usn);
+    update_results_sorting(index);
+
     const SearchScope scope = SearchScope_Children;
 
     //
     // Search object's children
     //
-    const QString filter = [=]() {
-        QString out;
-
-        // NOTE: OR user filter with containers filter so
-        // that container objects are always shown, even if
-        // they are filtered out by user filter
-        if (object_filter_enabled) {
-            out = filter_OR({is_container_filter(), out});
-            out = filter_OR({object_filter, out});
-        }
+    const QString filter = get_fetch_filter();
 
-        out = advanced_features_filter(out);
-
-        return out;
-    }();
+    item->setData(filter, ObjectRole_FetchFilter);
 
     const QList<QString> attributes = console_object_search_attributes();
 
@@ -238,9 +260,48 @@ void ObjectImpl::fetch(const QModelIndex &index) {
         }
     }
 
+    // NOTE: if container turns out to have too many
+    // children, search switches it to loading by windows,
+    // see console_object_search()
     console_object_search(console, index, base, scope, filter, attributes);
 }
 
+void ObjectImpl::fetch_more(const QModelIndex &index) {
+    const AdTraceSpan trace_span("ObjectImpl::fetch_more", "ui", AD_TRACE_DETAIL(index.data(ObjectRole_DN).toString()));
+
+    update_results_sorting(index);
+
+    object_impl_load_window(console, index);
+}
+
+// NOTE: children loaded by windows are already sorted by
+// name on the server and windows are appended in order,
+// so they are not sorted again by the results view
+void ObjectImpl::update_results_sorting(const QModelIndex &index) {
+    if (index != console->get_current_scope_item()) {
+        return;
+    }
+
+    const bool is_window = index.data(ObjectRole_WindowOffset).isValid();
+    view()->set_sorting_enabled(!is_window);
+}
+
+QString ObjectImpl::get_fetch_filter() const {
+    QString out;
+
+    // NOTE: OR user filter with containers filter so
+    // that container objects are always shown, even if
+    // they are filtered out by user filter
+    if (object_filter_enabled) {
+        out = filter_OR({is_container_filter(), out});
+        out = filter_OR({object_filter, out});
+    }
+
+    out = advanced_features_filter(out);
+
+    return out;
+}
+
 bool ObjectImpl::can_drop(const QList<QPersistentModelIndex> &dropped_list, const QSet<int> &dropped_type_list, const QPersistentModelIndex &target, const int target_type) {
     UNUSED_ARG(target_type);
 
@@ -279,23 +340,23 @@ void ObjectImpl::drop(const QList<QPersistentModelIndex> &dropped_list, const QS
 
     show_busy_indicator();
 
+    // NOTE: dropped objects are sorted by drop type, so
+    // that each type is done in one bulk operation
+    QList<QString> move_list;
+    QList<QString> add_to_group_list;
+
     for (const QPersistentModelIndex &dropped : dropped_list) {
         const QString dropped_dn = dropped.data(ObjectRole_DN).toString();
         const DropType drop_type = console_object_get_drop_type(dropped, target);
 
         switch (drop_type) {
             case DropType_Move: {
-                const bool move_success = ad.object_move(dropped_dn,
-                    target_dn);
-
-                if (move_success) {
-                    move(ad, QList<QString>({dropped_dn}), target_dn);
-                }
+                move_list.append(dropped_dn);
 
                 break;
             }
             case DropType_AddToGroup: {
-                ad.group_add_member(target_dn, dropped_dn);
+                add_to_group_list.append(dropped_dn);
 
                 break;
             }
@@ -305,6 +366,16 @@ void ObjectImpl::drop(const QList<QPersistentModelIndex> &dropped_list, const QS
         }
     }
 
+    if (!move_list.isEmpty()) {
+        const QList<QString> moved_list = ad.object_move_list(move_list, target_dn);
+
+        move(ad, moved_list, target_dn);
+    }
+
+    if (!add_to_group_list.isEmpty()) {
+        ad.group_add_member_list({target_dn}, add_to_group_list);
+    }
+
     hide_busy_indicator();
 
     g_status->display_ad_messages(ad, console);
@@ -688,10 +759,417 @@ void ObjectImpl::refresh(const QList<QModelIndex> &index_list) {
 
     const QModelIndex index = index_list[0];
 
+    const AdMetricsAction metrics_action(tr("Refresh"));
+
+    const bool started_incremental = refresh_incremental(index);
+    if (!started_incremental) {
+        refresh_full(index);
+    }
+
+    update_results_widget(index);
+}
+
+void ObjectImpl::refresh_full(const QModelIndex &index) {
     console->delete_children(index);
     fetch(index);
+}
 
-    update_results_widget(index);
+// Refreshes children of a container and of fetched
+// containers below it, by only loading objects that
+// changed since they were fetched. Changes are found by
+// comparing uSNChanged to the highest value seen during
+// fetch. Searches are done in the background and rows
+// are patched once they finish. Returns false if
+// incremental refresh is not possible, in which case full
+// refresh should be done.
+bool ObjectImpl::refresh_incremental(const QModelIndex &index) {
+    const AdTraceSpan trace_span("ObjectImpl::refresh_incremental", "ui", AD_TRACE_DETAIL(index.data(ObjectRole_DN).toString()));
+
+    const bool enabled = settings_get_variant(SETTING_feature_incremental_refresh).toBool();
+    if (!enabled) {
+        return false;
+    }
+
+    if (!object_impl_can_refresh_delta(index, get_fetch_filter())) {
+        return false;
+    }
+
+    // NOTE: search_items() includes the index itself.
+    // Indexes are made persistent, because containers that
+    // can't be refreshed incrementally are refreshed fully
+    // right away, which removes rows below them.
+    QList<QPersistentModelIndex> container_list;
+    for (const QModelIndex &container : console->search_items(index, {ItemType_Object})) {
+        if (container == index || console_item_get_was_fetched(container)) {
+            container_list.append(container);
+        }
+    }
+
+    for (const QPersistentModelIndex &container : container_list) {
+        if (container.isValid()) {
+            refresh_delta(container);
+        }
+    }
+
+    return true;
+}
+
+// Refreshes one fetched container. First, objectGUID and
+// uSNChanged of all current children are loaded, which is
+// cheap compared to a full fetch. Rows of objects that are
+// not among them anymore were deleted, moved out or don't
+// match the filter. Then children that changed are loaded
+// with all attributes and patched in.
+void ObjectImpl::refresh_delta(const QModelIndex &container) {
+    const QString filter = get_fetch_filter();
+
+    if (!object_impl_can_refresh_delta(container, filter)) {
+        refresh_full(container);
+
+        return;
+    }
+
+    const QString base = container.data(ObjectRole_DN).toString();
+    const qint64 usn = container.data(ObjectRole_Usn).toLongLong();
+    const QString usn_dc = container.data(ObjectRole_UsnDc).toString();
+
+    auto state_thread = new SearchThread(base, SearchScope_Children, filter, {ATTRIBUTE_OBJECT_GUID, ATTRIBUTE_USN_CHANGED});
+
+    // NOTE: if container is fetched again while searches
+    // are running, that fetch replaces this refresh
+    QStandardItem *item = console->get_item(container);
+    item->setData(state_thread->get_id(), MyConsoleRole_SearchThreadId);
+
+    const QPersistentModelIndex persistent_index = container;
+    auto usn_map = new QHash<QByteArray, qint64>();
+    auto changed_count = new int(0);
+
+    connect(
+        state_thread, &SearchThread::results_ready,
+        this,
+        [=](const QHash<QString, AdObject> &results) {
+            for (const AdObject &object : results) {
+                const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+                const qint64 object_usn = object.get_string(ATTRIBUTE_USN_CHANGED).toLongLong();
+
+                usn_map->insert(guid, object_usn);
+
+                if (object_usn > usn) {
+                    (*changed_count)++;
+                }
+            }
+
+            // NOTE: if too many objects changed, full
+            // refresh is faster
+            if (*changed_count > INCREMENTAL_REFRESH_CHANGES_MAX) {
+                state_thread->stop();
+            }
+        });
+    connect(
+        state_thread, &SearchThread::finished,
+        this,
+        [=]() {
+            state_thread->deleteLater();
+
+            const QHash<QByteArray, qint64> current_usn_map = *usn_map;
+            const int current_changed_count = *changed_count;
+            delete usn_map;
+            delete changed_count;
+
+            if (!persistent_index.isValid()) {
+                return;
+            }
+
+            QStandardItem *item_now = console->get_item(persistent_index);
+            const bool thread_id_match = object_impl_search_id_matches(item_now, state_thread);
+            if (!thread_id_match) {
+                return;
+            }
+
+            // NOTE: uSNChanged values are local to each DC,
+            // so they can only be compared if container was
+            // fetched from the same DC
+            const bool same_dc = (state_thread->get_dc() == usn_dc);
+            const bool state_success = (!state_thread->failed() && !state_thread->hit_object_display_limit() && current_changed_count <= INCREMENTAL_REFRESH_CHANGES_MAX && same_dc);
+            if (!state_success) {
+                refresh_full(persistent_index);
+
+                return;
+            }
+
+            qint64 max_usn = usn;
+            QSet<QByteArray> changed_guid_set;
+            for (auto it = current_usn_map.begin(); it != current_usn_map.end(); it++) {
+                max_usn = qMax(max_usn, it.value());
+
+                if (it.value() > usn) {
+                    changed_guid_set.insert(it.key());
+                }
+            }
+
+            // NOTE: rows that are not in the current state
+            // are removed by patch_children(), because they
+            // count as changed but are not in the delta
+            for (int row = 0; row < item_now->rowCount(); row++) {
+                const QByteArray guid = item_now->child(row, 0)->data(ObjectRole_GUID).toByteArray();
+
+                if (!guid.isEmpty() && !current_usn_map.contains(guid)) {
+                    changed_guid_set.insert(guid);
+                }
+            }
+
+            const bool have_changed_objects = (current_changed_count > 0);
+            if (have_changed_objects) {
+                load_delta(persistent_index, changed_guid_set, max_usn);
+            } else {
+                patch_children(persistent_index, QList<AdObject>(), changed_guid_set);
+                item_now->setData(max_usn, ObjectRole_Usn);
+            }
+        });
+
+    state_thread->start();
+}
+
+// Loads objects in container that changed since it was
+// last fetched and patches it's rows with them.
+void ObjectImpl::load_delta(const QModelIndex &container, const QSet<QByteArray> &changed_guid_set, const qint64 max_usn) {
+    const qint64 usn = container.data(ObjectRole_Usn).toLongLong();
+    const QString usn_dc = container.data(ObjectRole_UsnDc).toString();
+    const QString base = container.data(ObjectRole_DN).toString();
+    const QString filter = container.data(ObjectRole_FetchFilter).toString();
+    const QString delta_filter = filter_AND({filter, filter_changed_after(usn)});
+
+    auto search_thread = new SearchThread(base, SearchScope_Children, delta_filter, console_object_search_attributes());
+
+    QStandardItem *item = console->get_item(container);
+    item->setData(search_thread->get_id(), MyConsoleRole_SearchThreadId);
+
+    const QPersistentModelIndex persistent_index = container;
+    auto delta_list = new QList<AdObject>();
+
+    connect(
+        search_thread, &SearchThread::results_ready,
+        this,
+        [=](const QHash<QString, AdObject> &results) {
+            delta_list->append(results.values());
+        });
+    connect(
+        search_thread, &SearchThread::finished,
+        this,
+        [=]() {
+            search_thread->deleteLater();
+
+            const QList<AdObject> object_list = *delta_list;
+            delete delta_list;
+
+            if (!persistent_index.isValid()) {
+                return;
+            }
+
+            // NOTE: container may have been refreshed fully
+            // while this search was running, for example
+            // when it's parent was patched
+            QStandardItem *item_now = console->get_item(persistent_index);
+            const bool thread_id_match = object_impl_search_id_matches(item_now, search_thread);
+            if (!thread_id_match) {
+                return;
+            }
+
+            const bool same_dc = (search_thread->get_dc() == usn_dc);
+            if (search_thread->failed() || search_thread->hit_object_display_limit() || !same_dc) {
+                refresh_full(persistent_index);
+
+                return;
+            }
+
+            patch_children(persistent_index, object_list, changed_guid_set);
+
+            item_now->setData(qMax(usn, max_usn), ObjectRole_Usn);
+        });
+
+    search_thread->start();
+}
+
+// Updates children of a container in place. "object_list"
+// contains current state of changed objects that are in
+// the container. Rows of objects from "changed_guid_set"
+// that are not in the list are removed, because those
+// objects were deleted, moved out or don't match the
+// filter anymore.
+void ObjectImpl::patch_children(const QModelIndex &container, const QList<AdObject> &object_list, const QSet<QByteArray> &changed_guid_set) {
+    const AdTraceSpan trace_span("ObjectImpl::patch_children", "ui", AD_TRACE_DETAIL(QString::number(object_list.size())));
+
+    QStandardItem *container_item = console->get_item(container);
+
+    QHash<QByteArray, QPersistentModelIndex> row_map;
+    for (int row = 0; row < container_item->rowCount(); row++) {
+        QStandardItem *child_item = container_item->child(row, 0);
+        const QByteArray guid = child_item->data(ObjectRole_GUID).toByteArray();
+
+        if (!guid.isEmpty()) {
+            row_map[guid] = child_item->index();
+        }
+    }
+
+    // Update changed rows in place and add new ones
+    QSet<QByteArray> current_guid_set;
+    for (const AdObject &object : object_list) {
+        const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+        current_guid_set.insert(guid);
+
+        if (row_map.contains(guid)) {
+            const QModelIndex child = row_map[guid];
+            const QString old_dn = child.data(ObjectRole_DN).toString();
+
+            const QList<QStandardItem *> row = console->get_row(child);
+            console_object_load(row, object);
+
+            // NOTE: if a fetched container was renamed,
+            // dn's of it's children are out of date
+            const bool renamed = (old_dn != object.get_dn());
+            if (renamed && console_item_get_was_fetched(child)) {
+                refresh_full(child);
+            }
+        } else {
+            object_impl_add_objects_to_console(console, {object}, container);
+        }
+    }
+
+    for (auto it = row_map.begin(); it != row_map.end(); it++) {
+        const QByteArray guid = it.key();
+        const bool removed = (changed_guid_set.contains(guid) && !current_guid_set.contains(guid));
+
+        if (removed) {
+            console->delete_item(it.value());
+        }
+    }
+}
+
+// Expanded containers are subscribed to change
+// notifications, so that changes made by others show up
+// without refreshing
+void ObjectImpl::expanded_changed(const QModelIndex &index, const bool expanded) {
+    const bool enabled = settings_get_variant(SETTING_feature_change_notifications).toBool();
+    if (!enabled) {
+        return;
+    }
+
+    const QString dn = index.data(ObjectRole_DN).toString();
+
+    if (expanded) {
+        ChangeNotifier::instance()->subscribe(dn);
+    } else {
+        ChangeNotifier::instance()->unsubscribe(dn);
+    }
+}
+
+// NOTE: notifications only say which objects changed, so
+// current state of live objects is loaded with one search.
+// Objects that are not found by it were deleted, moved out
+// or don't match the filter.
+void ObjectImpl::on_objects_changed(const QString &container_dn, const QList<AdObject> &object_list) {
+    const QModelIndex container = get_notified_container(container_dn);
+    if (!container.isValid()) {
+        return;
+    }
+
+    QSet<QByteArray> changed_guid_set;
+    QList<QString> live_dn_list;
+    for (const AdObject &object : object_list) {
+        changed_guid_set.insert(object.get_value(ATTRIBUTE_OBJECT_GUID));
+
+        const bool is_deleted = object.get_bool(ATTRIBUTE_IS_DELETED);
+        if (!is_deleted) {
+            live_dn_list.append(object.get_dn());
+        }
+    }
+
+    if (live_dn_list.isEmpty()) {
+        patch_children(container, QList<AdObject>(), changed_guid_set);
+
+        return;
+    }
+
+    const QString fetch_filter = container.data(ObjectRole_FetchFilter).toString();
+    const QString filter = filter_AND({fetch_filter, filter_dn_list(live_dn_list)});
+    const QList<QString> attributes = console_object_search_attributes();
+
+    auto search_thread = new SearchThread(container_dn, SearchScope_Children, filter, attributes);
+
+    auto current_list = new QList<AdObject>();
+
+    connect(
+        search_thread, &SearchThread::results_ready,
+        this,
+        [=](const QHash<QString, AdObject> &results) {
+            current_list->append(results.values());
+        });
+    connect(
+        search_thread, &SearchThread::finished,
+        this,
+        [=]() {
+            search_thread->deleteLater();
+
+            const QList<AdObject> object_list_now = *current_list;
+            delete current_list;
+
+            if (search_thread->failed()) {
+                return;
+            }
+
+            // NOTE: container might've been collapsed,
+            // deleted or started loading again while this
+            // search was running
+            const QModelIndex container_now = get_notified_container(container_dn);
+            if (!container_now.isValid()) {
+                return;
+            }
+
+            patch_children(container_now, object_list_now, changed_guid_set);
+        });
+
+    search_thread->start();
+}
+
+// NOTE: changes made while notifications weren't working
+// are lost, so container is reloaded
+void ObjectImpl::on_subscription_failed(const QString &container_dn) {
+    const QModelIndex container = get_notified_container(container_dn);
+    if (!container.isValid()) {
+        return;
+    }
+
+    const bool started_incremental = refresh_incremental(container);
+    if (!started_incremental) {
+        refresh_full(container);
+    }
+}
+
+// Returns container that can be updated by change
+// notifications, or invalid index if there's none for
+// this dn
+QModelIndex ObjectImpl::get_notified_container(const QString &container_dn) const {
+    const QModelIndex tree_root = get_object_tree_root(console);
+    if (!tree_root.isValid()) {
+        return QModelIndex();
+    }
+
+    const QModelIndex container = console->search_item(tree_root, ObjectRole_DN, container_dn, {ItemType_Object});
+    if (!container.isValid() || !console_item_get_was_fetched(container)) {
+        return QModelIndex();
+    }
+
+    // NOTE: containers that are still loading will get
+    // the changes anyway. Containers loaded by windows are
+    // ordered by position, so objects can't be inserted
+    // into them.
+    const bool fetching = container.data(ObjectRole_Fetching).toBool();
+    const bool is_window = container.data(ObjectRole_WindowOffset).isValid();
+    if (fetching || is_window) {
+        return QModelIndex();
+    }
+
+    return container;
 }
 
 void ObjectImpl::delete_action(const QList<QModelIndex> &index_list) {
@@ -724,6 +1202,7 @@ void ObjectImpl::selected_as_scope(const QModelIndex &index)
     }
     else {
         stacked_widget->setCurrentWidget(view());
+        update_results_sorting(index);
     }
 }
 
@@ -775,21 +1254,8 @@ void console_object_delete(const QList<ConsoleWidget *> &console_list, const QLi
 
     show_busy_indicator();
 
-    const QList<QString> deleted_list = [&]() {
-        QList<QString> out;
-
-        const QList<QString> target_list = index_list_to_dn_list(index_list, dn_role);
-
-        for (const QString &target : target_list) {
-            const bool success = ad.object_delete(target);
-
-            if (success) {
-                out.append(target);
-            }
-        }
-
-        return out;
-    }();
+    const QList<QString> target_list = index_list_to_dn_list(index_list, dn_role);
+    const QList<QString> deleted_list = ad.object_delete_list(target_list);
 
     auto apply_changes = [&deleted_list](ConsoleWidget *target_console) {
         const QList<QModelIndex> root_list = {
@@ -859,7 +1325,11 @@ void ObjectImpl::refresh_tree() {
 
     show_busy_indicator();
 
-    console->refresh_scope(object_tree_root);
+    // NOTE: tree is refreshed when settings that affect
+    // which objects are shown change, so incremental
+    // refresh can't be used here
+    refresh_full(object_tree_root);
+    update_results_widget(object_tree_root);
 
     hide_busy_indicator();
 }
@@ -945,19 +1415,7 @@ void ObjectImpl::on_move() {
             const QString new_parent_dn = dialog->get_selected();
 
             // First move in AD
-            const QList<QString> moved_objects = [&]() {
-                QList<QString> out;
-
-                for (const QString &dn : dn_list) {
-                    const bool success = ad2.object_move(dn, new_parent_dn);
-
-                    if (success) {
-                        out.append(dn);
-                    }
-                }
-
-                return out;
-            }();
+            const QList<QString> moved_objects = ad2.object_move_list(dn_list, new_parent_dn);
 
             g_status->display_ad_messages(ad2, nullptr);
 
@@ -996,11 +1454,7 @@ void ObjectImpl::on_add_to_group() {
 
             const QList<QString> groups = dialog->get_selected();
 
-            for (const QString &target : target_list) {
-                for (auto group : groups) {
-                    ad.group_add_member(group, target);
-                }
-            }
+            ad.group_add_member_list(groups, target_list);
 
             hide_busy_indicator();
 
@@ -1208,19 +1662,9 @@ void ObjectImpl::set_disabled(const bool disabled) {
     show_busy_indicator();
 
     const QList<QString> changed_objects = [&]() {
-        QList<QString> out;
-
         const QList<QString> dn_list = get_selected_dn_list_object(console);
 
-        for (const QString &dn : dn_list) {
-            const bool success = ad.user_set_account_option(dn, AccountOption_Disabled, disabled);
-
-            if (success) {
-                out.append(dn);
-            }
-        }
-
-        return out;
+        return ad.user_set_account_option_list(dn_list, AccountOption_Disabled, disabled);
     }();
 
     auto apply_changes = [&changed_objects, &disabled](ConsoleWidget *target_console) {
@@ -1297,16 +1741,7 @@ void console_object_move_and_rename(const QList<ConsoleWidget *> &console_list,
 
     // NOTE: search for objects once here to reuse them
     // multiple times later
-    const QHash<QString, AdObject> object_map = [&]() {
-        QHash<QString, AdObject> out;
-
-        for (const QString &dn : new_dn_list) {
-            const AdObject object = ad.search_object(dn);
-            out[dn] = object;
-        }
-
-        return out;
-    }();
+    const QHash<QString, AdObject> object_map = ad.search_objects(new_dn_list, console_object_search_attributes());
 
     auto apply_changes = [&old_to_new_dn_map, &old_dn_list, &new_parent_dn, &object_map](ConsoleWidget *target_console) {
         // For object tree, we add items representing
@@ -1499,6 +1934,8 @@ void ObjectImpl::update_toolbar_actions() {
 }
 
 void object_impl_add_objects_to_console(ConsoleWidget *console, const QList<AdObject> &object_list, const QModelIndex &parent) {
+    const AdTraceSpan trace_span("add_objects_to_console", "ui", AD_TRACE_DETAIL(QString::number(object_list.size())));
+
     if (!parent.isValid()) {
         return;
     }
@@ -1547,10 +1984,12 @@ void object_impl_add_objects_to_console(ConsoleWidget *console, const QList<AdOb
 // Helper f-n that searches for objects and then adds them
 void object_impl_add_objects_to_console_from_dns(ConsoleWidget *console, AdInterface &ad, const QList<QString> &dn_list, const QModelIndex &parent) {
     const QList<AdObject> object_list = [&]() {
+        const QHash<QString, AdObject> object_map = ad.search_objects(dn_list, console_object_search_attributes());
+
         QList<AdObject> out;
 
         for (const QString &dn : dn_list) {
-            const AdObject object = ad.search_object(dn);
+            const AdObject object = object_map.value(dn);
             out.append(object);
         }
 
@@ -1562,20 +2001,25 @@ void object_impl_add_objects_to_console_from_dns(ConsoleWidget *console, AdInter
 
 void console_object_load(const QList<QStandardItem *> row, const AdObject &object) {
     // Load attribute columns
-    for (int i = 0; i < g_adconfig->get_columns().count(); i++) {
-        if (g_adconfig->get_columns().count() > row.size()) {
+    // NOTE: this is called for every object in results,
+    // so use attribute id's to avoid hashing names
+    const QList<int> column_id_list = g_adconfig->get_column_ids();
+    const int object_class_id = g_adconfig->get_attribute_id(ATTRIBUTE_OBJECT_CLASS);
+
+    for (int i = 0; i < column_id_list.count(); i++) {
+        if (column_id_list.count() > row.size()) {
             break;
         }
 
-        const QString attribute = g_adconfig->get_columns()[i];
+        const int attribute_id = column_id_list[i];
 
-        if (!object.contains(attribute)) {
+        if (!object.contains(attribute_id)) {
             continue;
         }
 
-        const QString display_value = [attribute, object]() {
-            if (attribute == ATTRIBUTE_OBJECT_CLASS) {
-                const QString object_class = object.get_string(attribute);
+        const QString display_value = [&]() {
+            if (attribute_id == object_class_id) {
+                const QString object_class = object.get_string(ATTRIBUTE_OBJECT_CLASS);
 
                 if (object_class == CLASS_GROUP) {
                     const GroupScope scope = object.get_group_scope();
@@ -1589,8 +2033,8 @@ void console_object_load(const QList<QStandardItem *> row, const AdObject &objec
                     return g_adconfig->get_class_display_name(object_class);
                 }
             } else {
-                const QByteArray value = object.get_value(attribute);
-                return attribute_display_value(attribute, value, g_adconfig);
+                const QByteArray value = object.get_value_view(attribute_id);
+                return attribute_display_value(attribute_id, value, g_adconfig);
             }
         }();
 
@@ -1604,11 +2048,43 @@ void console_object_load(const QList<QStandardItem *> row, const AdObject &objec
     for (auto item : row) {
         item->setDragEnabled(!cannot_move);
     }
+
+    // NOTE: object passed here is complete, unless caller
+    // marks it as partial again after load
+    const bool was_partial = row[0]->data(ObjectRole_Partial).toBool();
+    if (was_partial) {
+        console_object_set_partial(row, false);
+    }
+}
+
+// Partial rows are shown in italics, so that user knows
+// that values may be missing
+void console_object_set_partial(const QList<QStandardItem *> &row, const bool partial) {
+    row[0]->setData(partial, ObjectRole_Partial);
+
+    const QString tooltip = [&]() {
+        if (partial) {
+            return QCoreApplication::translate("object_impl.cpp", "Loaded from global catalog. Some attributes may be missing until object is reloaded.");
+        } else {
+            return QString();
+        }
+    }();
+
+    for (QStandardItem *item : row) {
+        QFont font = item->font();
+        font.setItalic(partial);
+        item->setFont(font);
+
+        item->setToolTip(tooltip);
+    }
 }
 
 void console_object_item_data_load(QStandardItem *item, const AdObject &object) {
     item->setData(object.get_dn(), ObjectRole_DN);
 
+    const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+    item->setData(guid, ObjectRole_GUID);
+
     const QList<QString> object_classes = object.get_strings(ATTRIBUTE_OBJECT_CLASS);
     item->setData(QVariant(object_classes), ObjectRole_ObjectClasses);
 
@@ -1673,6 +2149,10 @@ QList<QString> console_object_search_attributes() {
     // NOTE: needed to know gpo status
     attributes += ATTRIBUTE_FLAGS;
 
+    // NOTE: needed for incremental refresh
+    attributes += ATTRIBUTE_OBJECT_GUID;
+    attributes += ATTRIBUTE_USN_CHANGED;
+
     return attributes;
 }
 
@@ -1681,15 +2161,6 @@ QList<QString> console_object_search_attributes() {
 // contains multiple workarounds for issues caused by that
 // case.
 void console_object_search(ConsoleWidget *console, const QModelIndex &index, const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes) {
-    auto search_id_matches = [](QStandardItem *item, SearchThread *thread) {
-        const int id_from_item = item->data(MyConsoleRole_SearchThreadId).toInt();
-        const int thread_id = thread->get_id();
-
-        const bool match = (id_from_item == thread_id);
-
-        return match;
-    };
-
     QStandardItem *item = console->get_item(index);
 
     // Set icon to indicate that item is in "search" state
@@ -1702,6 +2173,8 @@ void console_object_search(ConsoleWidget *console, const QModelIndex &index, con
 
     auto search_thread = new SearchThread(base, scope, filter, attributes);
 
+    item->setData(0, ObjectRole_FetchCount);
+
     // NOTE: change item's search thread, this will be used
     // later to handle situations where a thread is started
     // while another is running
@@ -1709,6 +2182,8 @@ void console_object_search(ConsoleWidget *console, const QModelIndex &index, con
 
     const QPersistentModelIndex persistent_index = index;
 
+    const bool is_object_children = (console_item_get_type(index) == ItemType_Object && scope == SearchScope_Children);
+
     // NOTE: need to pass console as receiver object to
     // connect() even though we're using lambda as a slot.
     // This is to be able to define queuedconnection type,
@@ -1735,14 +2210,42 @@ void console_object_search(ConsoleWidget *console, const QModelIndex &index, con
 
             // NOTE: if another thread was started for this
             // item, abort this thread
-            const bool thread_id_match = search_id_matches(item_now, search_thread);
+            const bool thread_id_match = object_impl_search_id_matches(item_now, search_thread);
             if (!thread_id_match) {
                 search_thread->stop();
 
                 return;
             }
 
+            // NOTE: remember highest change number seen,
+            // for incremental refresh
+            if (is_object_children) {
+                qint64 usn = item_now->data(ObjectRole_Usn).toLongLong();
+
+                for (const AdObject &object : results) {
+                    usn = qMax(usn, object.get_string(ATTRIBUTE_USN_CHANGED).toLongLong());
+                }
+
+                item_now->setData(usn, ObjectRole_Usn);
+            }
+
             object_impl_add_objects_to_console(console, results.values(), persistent_index);
+
+            // NOTE: once a full window of children has
+            // arrived, container might be too big to load
+            // whole, so ask server for the total count.
+            // Small containers never get here, so they
+            // don't pay for the extra request.
+            if (is_object_children) {
+                const int prev_count = item_now->data(ObjectRole_FetchCount).toInt();
+                const int count = prev_count + results.size();
+                item_now->setData(count, ObjectRole_FetchCount);
+
+                const bool need_probe = (prev_count < WINDOW_SIZE && count >= WINDOW_SIZE && object_impl_window_search_enabled());
+                if (need_probe) {
+                    object_impl_probe_windows(console, persistent_index, filter, search_thread->get_id());
+                }
+            }
         },
         Qt::QueuedConnection);
     QObject::connect(
@@ -1754,18 +2257,44 @@ void console_object_search(ConsoleWidget *console, const QModelIndex &index, con
             }
 
             g_status->display_ad_messages(search_thread->get_ad_messages(), console);
-            search_thread_display_errors(search_thread, console);
 
             QStandardItem *item_now = console->get_item(persistent_index);
 
             // NOTE: if another thread was started for this
             // item, don't change item data. It will be
             // changed by that other thread.
-            const bool thread_id_match = search_id_matches(item_now, search_thread);
+            const bool thread_id_match = object_impl_search_id_matches(item_now, search_thread);
             if (!thread_id_match) {
+                search_thread_display_errors(search_thread, console);
+
                 return;
             }
 
+            // NOTE: hitting the limit means that container
+            // is big, even if probe didn't return yet
+            const bool switch_to_windows = (is_object_children && search_thread->hit_object_display_limit() && object_impl_window_search_enabled());
+            if (switch_to_windows) {
+                object_impl_switch_to_windows(console, persistent_index, filter);
+
+                search_thread->deleteLater();
+
+                return;
+            }
+
+            search_thread_display_errors(search_thread, console);
+
+            // NOTE: incremental refresh is only possible if
+            // all children were loaded
+            if (is_object_children) {
+                const bool loaded_all = (!search_thread->failed() && !search_thread->hit_object_display_limit());
+
+                if (loaded_all) {
+                    item_now->setData(search_thread->get_dc(), ObjectRole_UsnDc);
+                } else {
+                    item_now->setData(QVariant(), ObjectRole_Usn);
+                }
+            }
+
             const bool is_disabled = item_now->data(ObjectRole_AccountDisabled).toBool();
             console_object_item_load_icon(item_now, is_disabled);
 
@@ -1779,6 +2308,213 @@ void console_object_search(ConsoleWidget *console, const QModelIndex &index, con
     search_thread->start();
 }
 
+// NOTE: item stores id of the last search started for
+// it. Results of older searches are ignored.
+bool object_impl_search_id_matches(QStandardItem *item, SearchThread *thread) {
+    const int id_from_item = item->data(MyConsoleRole_SearchThreadId).toInt();
+    const int thread_id = thread->get_id();
+
+    const bool match = (id_from_item == thread_id);
+
+    return match;
+}
+
+// NOTE: containers loaded by windows are not sorted by
+// change, so they are always refreshed fully
+bool object_impl_can_refresh_delta(const QModelIndex &container, const QString &filter) {
+    const bool has_usn = (container.data(ObjectRole_Usn).toLongLong() > 0);
+    const bool same_filter = (container.data(ObjectRole_FetchFilter).toString() == filter);
+    const bool is_window = container.data(ObjectRole_WindowOffset).isValid();
+    const bool fetching = container.data(ObjectRole_Fetching).toBool();
+
+    return (has_usn && same_filter && !is_window && !fetching);
+}
+
+bool object_impl_window_search_enabled() {
+    const bool vlv_enabled = settings_get_variant(SETTING_feature_virtual_list_view).toBool();
+
+    return (vlv_enabled && g_adconfig->window_search_supported());
+}
+
+// Finds out how many children container has by loading a
+// window of one entry, since server returns total amount
+// of entries with every window. Called while the regular
+// fetch with id "fetch_id" is still running. If there are
+// more children than object display limit, fetch is
+// replaced by windows, otherwise fetch continues.
+void object_impl_probe_windows(ConsoleWidget *console, const QModelIndex &index, const QString &filter, const int fetch_id) {
+    const QString base = index.data(ObjectRole_DN).toString();
+
+    auto search_thread = new SearchThread(base, SearchScope_Children, filter, {ATTRIBUTE_OBJECT_GUID});
+    search_thread->set_window(ATTRIBUTE_NAME, 0, 1, 0);
+
+    const QPersistentModelIndex persistent_index = index;
+
+    QObject::connect(
+        search_thread, &SearchThread::finished,
+        console,
+        [=]() {
+            search_thread->deleteLater();
+
+            if (!persistent_index.isValid()) {
+                return;
+            }
+
+            // NOTE: if fetch was replaced by another
+            // search, including windows started after
+            // fetch hit the limit, probe result is not
+            // needed anymore
+            QStandardItem *item_now = console->get_item(persistent_index);
+            const int id_from_item = item_now->data(MyConsoleRole_SearchThreadId).toInt();
+            if (id_from_item != fetch_id) {
+                return;
+            }
+
+            // NOTE: if probe failed, fetch continues and
+            // reports the error if there is one
+            const int object_display_limit = settings_get_variant(SETTING_object_display_limit).toInt();
+            const bool use_windows = (!search_thread->failed() && search_thread->get_window_content_count() > object_display_limit);
+
+            if (use_windows) {
+                object_impl_switch_to_windows(console, persistent_index, filter);
+            }
+        },
+        Qt::QueuedConnection);
+
+    search_thread->start();
+}
+
+// Drops children loaded by regular fetch and reloads them
+// by windows. Fetch is stopped because item's search id
+// changes.
+void object_impl_switch_to_windows(ConsoleWidget *console, const QModelIndex &index, const QString &filter) {
+    QStandardItem *item = console->get_item(index);
+
+    console->delete_children(index);
+    item->setData(QVariant(), ObjectRole_Usn);
+
+    object_impl_start_windows(console, index, filter);
+}
+
+// Switches item to loading children by windows, sorted
+// on the server. First window is loaded right away, others
+// are loaded by fetch_more() when results view is
+// scrolled.
+void object_impl_start_windows(ConsoleWidget *console, const QModelIndex &index, const QString &filter) {
+    QStandardItem *item = console->get_item(index);
+    item->setData(0, ObjectRole_WindowOffset);
+    item->setData(0, ObjectRole_WindowContentCount);
+    item->setData(filter, ObjectRole_FetchFilter);
+
+    // NOTE: item is still marked as fetching by regular
+    // fetch, so clear it to allow the first window to load
+    item->setData(false, ObjectRole_Fetching);
+
+    object_impl_load_window(console, index);
+}
+
+// Loads next window of children, if item is in window mode
+// and not all children were loaded yet
+void object_impl_load_window(ConsoleWidget *console, const QModelIndex &index) {
+    QStandardItem *item = console->get_item(index);
+
+    const QVariant offset_variant = item->data(ObjectRole_WindowOffset);
+    if (!offset_variant.isValid()) {
+        return;
+    }
+
+    // NOTE: adding rows can cause results view to request
+    // next window while this one is still loading
+    const bool fetching = item->data(ObjectRole_Fetching).toBool();
+    if (fetching) {
+        return;
+    }
+
+    const int offset = offset_variant.toInt();
+    const int content_count = item->data(ObjectRole_WindowContentCount).toInt();
+
+    const bool loaded_all = (offset > 0 && offset >= content_count);
+    if (loaded_all) {
+        return;
+    }
+
+    const QString base = item->data(ObjectRole_DN).toString();
+    const QString filter = item->data(ObjectRole_FetchFilter).toString();
+    const QList<QString> attributes = console_object_search_attributes();
+
+    item->setIcon(g_icon_manager->get_indicator_icon(g_icon_manager->search_indicator));
+    item->setData(true, ObjectRole_Fetching);
+    item->setDragEnabled(false);
+
+    auto search_thread = new SearchThread(base, SearchScope_Children, filter, attributes);
+    search_thread->set_window(ATTRIBUTE_NAME, offset, WINDOW_SIZE, content_count);
+
+    item->setData(search_thread->get_id(), MyConsoleRole_SearchThreadId);
+
+    const QPersistentModelIndex persistent_index = index;
+
+    QObject::connect(
+        search_thread, &SearchThread::window_ready,
+        console,
+        [=](const QList<AdObject> &results, const int new_content_count_arg) {
+            if (!persistent_index.isValid()) {
+                return;
+            }
+
+            QStandardItem *item_now = console->get_item(persistent_index);
+            const bool thread_id_match = object_impl_search_id_matches(item_now, search_thread);
+            if (!thread_id_match) {
+                return;
+            }
+
+            // NOTE: if server returned nothing, consider
+            // everything loaded even if content count says
+            // otherwise, because content count is an
+            // estimate
+            const int new_offset = offset + results.size();
+            const int new_content_count = (results.isEmpty() ? new_offset : new_content_count_arg);
+
+            item_now->setData(new_offset, ObjectRole_WindowOffset);
+            item_now->setData(new_content_count, ObjectRole_WindowContentCount);
+
+            object_impl_add_objects_to_console(console, results, persistent_index);
+        },
+        Qt::QueuedConnection);
+    QObject::connect(
+        search_thread, &SearchThread::finished,
+        console,
+        [=]() {
+            search_thread->deleteLater();
+
+            if (!persistent_index.isValid()) {
+                return;
+            }
+
+            g_status->display_ad_messages(search_thread->get_ad_messages(), console);
+
+            QStandardItem *item_now = console->get_item(persistent_index);
+            const bool thread_id_match = object_impl_search_id_matches(item_now, search_thread);
+            if (!thread_id_match) {
+                return;
+            }
+
+            if (search_thread->failed()) {
+                item_now->setData(QVariant(), ObjectRole_WindowOffset);
+
+                error_log({QCoreApplication::translate("object_impl.cpp", "Failed to load objects.")}, console);
+            }
+
+            const bool is_disabled = item_now->data(ObjectRole_AccountDisabled).toBool();
+            console_object_item_load_icon(item_now, is_disabled);
+
+            item_now->setData(false, ObjectRole_Fetching);
+            item_now->setDragEnabled(true);
+        },
+        Qt::QueuedConnection);
+
+    search_thread->start();
+}
+
 void console_object_tree_init(ConsoleWidget *console, AdInterface &ad) {
     const QList<QStandardItem *> row = console->add_scope_item(ItemType_Object, console->domain_info_index());
     auto root = row[0];
@@ -55,6 +55,22 @@ enum ObjectRole {
     ObjectRole_AccountDisabled,
     ObjectRole_Fetching,
     ObjectRole_SearchId,
+    ObjectRole_GUID,
+    // Filter that was used to fetch children
+    ObjectRole_FetchFilter,
+    // Used when children are loaded by windows, see
+    // object_impl_load_window()
+    ObjectRole_WindowOffset,
+    ObjectRole_WindowContentCount,
+    // Amount of children loaded so far by current fetch
+    ObjectRole_FetchCount,
+    // Highest uSNChanged of fetched children and the DC
+    // it came from, used for incremental refresh
+    ObjectRole_Usn,
+    ObjectRole_UsnDc,
+    // Object was loaded from global catalog, so some
+    // attributes may be missing. Cleared by a full load.
+    ObjectRole_Partial,
 
     ObjectRole_LAST,
 };
@@ -73,6 +89,7 @@ public:
     void set_buddy_console(ConsoleWidget *buddy_console);
 
     void fetch(const QModelIndex &index) override;
+    void fetch_more(const QModelIndex &index) override;
     bool can_drop(const QList<QPersistentModelIndex> &dropped_list, const QSet<int> &dropped_type_list, const QPersistentModelIndex &target, const int target_type) override;
     void drop(const QList<QPersistentModelIndex> &dropped_list, const QSet<int> &dropped_type_list, const QPersistentModelIndex &target, const int target_type) override;
     QString get_description(const QModelIndex &index) const override;
@@ -91,6 +108,7 @@ public:
     void delete_action(const QList<QModelIndex> &index_list) override;
 
     void selected_as_scope(const QModelIndex &index) override;
+    void expanded_changed(const QModelIndex &index, const bool expanded) override;
 
     void update_results_widget(const QModelIndex &index) const override;
 
@@ -158,12 +176,23 @@ private:
     void move_and_rename(AdInterface &ad, const QHash<QString, QString> &old_dn_list, const QString &new_parent_dn);
     void move(AdInterface &ad, const QList<QString> &old_dn_list, const QString &new_parent_dn);
     void update_toolbar_actions();
+    void update_results_sorting(const QModelIndex &index);
+    QString get_fetch_filter() const;
+    void refresh_full(const QModelIndex &index);
+    bool refresh_incremental(const QModelIndex &index);
+    void refresh_delta(const QModelIndex &container);
+    void load_delta(const QModelIndex &container, const QSet<QByteArray> &changed_guid_set, const qint64 max_usn);
+    void patch_children(const QModelIndex &container, const QList<AdObject> &object_list, const QSet<QByteArray> &changed_guid_set);
+    void on_objects_changed(const QString &container_dn, const QList<AdObject> &object_list);
+    void on_subscription_failed(const QString &container_dn);
+    QModelIndex get_notified_container(const QString &container_dn) const;
 };
 
 void object_impl_add_objects_to_console(ConsoleWidget *console, const QList<AdObject> &object_list, const QModelIndex &parent);
 void object_impl_add_objects_to_console_from_dns(ConsoleWidget *console, AdInterface &ad, const QList<QString> &dn_list, const QModelIndex &parent);
 void console_object_load(const QList<QStandardItem *> row, const AdObject &object);
 void console_object_item_data_load(QStandardItem *item, const AdObject &object);
+void console_object_set_partial(const QList<QStandardItem *> &row, const bool partial);
 void console_object_item_load_icon(QStandardItem *item, bool disabled);
 QList<QString> object_impl_column_labels();
 QList<int> object_impl_default_columns();
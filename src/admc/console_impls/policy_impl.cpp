@@ -455,7 +455,7 @@ void console_policy_remove_link(const QList<ConsoleWidget *> &console_list, Poli
 
     const QString gplink_new_string = [&]() {
         Gplink gplink = [&]() {
-            const AdObject parent_object = ad.search_object(ou_dn);
+            const AdObject parent_object = ad.search_object(ou_dn, {ATTRIBUTE_GPLINK});
             const QString gplink_old_string = parent_object.get_string(ATTRIBUTE_GPLINK);
             const Gplink out = Gplink(gplink_old_string);
 
@@ -607,8 +607,9 @@ void console_policy_delete(const QList<ConsoleWidget *> &console_list, PolicyRes
                 message += PolicyImpl::tr(": this is a critical policy");
         } else {
             message = PolicyImpl::tr("Failed to delete the following group policies: \n");
+            const QHash<QString, AdObject> not_deleted_object_map = ad.search_objects(not_deleted_dn_list);
             for (QString not_deleted_dn : not_deleted_dn_list) {
-                AdObject not_deleted_object = ad.search_object(not_deleted_dn);
+                AdObject not_deleted_object = not_deleted_object_map.value(not_deleted_dn);
                 message += '\n' + not_deleted_object.get_string("displayName");
                 if (not_deleted_object.get_bool("isCriticalSystemObject"))
                     message += PolicyImpl::tr(" (critical policy)");
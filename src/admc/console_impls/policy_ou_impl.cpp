@@ -345,10 +345,12 @@ void PolicyOUImpl::delete_action(const QList<QModelIndex> &index_list) {
 
 void policy_ou_impl_add_objects_from_dns(ConsoleWidget *console, AdInterface &ad, const QList<QString> &dn_list, const QModelIndex &parent) {
     const QList<AdObject> object_list = [&]() {
+        const QHash<QString, AdObject> object_map = ad.search_objects(dn_list, console_object_search_attributes());
+
         QList<AdObject> out;
 
         for (const QString &dn : dn_list) {
-            const AdObject object = ad.search_object(dn);
+            const AdObject object = object_map.value(dn);
             out.append(object);
         }
 
@@ -402,7 +404,7 @@ void PolicyOUImpl::link_gpo_to_ou(const QModelIndex &ou_index, const QString &ou
     }
 
     const Gplink original_gplink = [&]() {
-        const AdObject target_object = ad.search_object(ou_dn);
+        const AdObject target_object = ad.search_object(ou_dn, {ATTRIBUTE_GPLINK});
         const QString gplink_string = target_object.get_string(ATTRIBUTE_GPLINK);
         const Gplink out = Gplink(gplink_string);
 
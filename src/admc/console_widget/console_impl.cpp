@@ -37,6 +37,10 @@ void ConsoleImpl::fetch(const QModelIndex &index) {
     UNUSED_ARG(index);
 }
 
+void ConsoleImpl::fetch_more(const QModelIndex &index) {
+    UNUSED_ARG(index);
+}
+
 bool ConsoleImpl::can_drop(const QList<QPersistentModelIndex> &dropped_list, const QSet<int> &dropped_type_list, const QPersistentModelIndex &target, const int target_type) {
     UNUSED_ARG(dropped_list);
     UNUSED_ARG(dropped_type_list);
@@ -67,6 +71,11 @@ void ConsoleImpl::selected_as_scope(const QModelIndex &index) {
     UNUSED_ARG(index);
 }
 
+void ConsoleImpl::expanded_changed(const QModelIndex &index, const bool expanded) {
+    UNUSED_ARG(index);
+    UNUSED_ARG(expanded);
+}
+
 QList<QAction *> ConsoleImpl::get_all_custom_actions() const {
     return {};
 }
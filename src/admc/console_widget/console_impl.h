@@ -49,6 +49,13 @@ public:
     // static, you don't need to implement this.
     virtual void fetch(const QModelIndex &index);
 
+    // Called when results view of a scope item of this type
+    // is scrolled close to the end. Implement this if
+    // children of your item type are loaded in parts, on
+    // demand. Note that this is called often, so return
+    // early if there's nothing to load.
+    virtual void fetch_more(const QModelIndex &index);
+
     // Called when items are dragged on top of an item of
     // this type to determine whether dropping is allowed.
     // Note that dragged items may be of any type and even
@@ -74,6 +81,10 @@ public:
     // scope pane.
     virtual void selected_as_scope(const QModelIndex &index);
 
+    // Called when an item of this type is expanded or
+    // collapsed in the scope pane.
+    virtual void expanded_changed(const QModelIndex &index, const bool expanded);
+
     // Return all custom actions that are available for this
     // type. This will be used to determine the order of
     // actions in the menu.
@@ -227,6 +227,8 @@ ConsoleWidget::ConsoleWidget(QWidget *parent)
         const QModelIndex index = d->scope_proxy_model->mapToSource(index_proxy);
         if (index == d->domain_info_index) {
             d->scope_view->expand(index_proxy);
+        } else {
+            d->get_impl(index)->expanded_changed(index, false);
         }
     });
 }
@@ -255,6 +257,9 @@ void ConsoleWidget::register_impl(const int type, ConsoleImpl *impl) {
         connect(
             results_view, &ResultsView::selection_changed,
             this, &ConsoleWidget::selection_changed);
+        connect(
+            results_view, &ResultsView::scrolled_to_end,
+            d, &ConsoleWidgetPrivate::on_results_scrolled_to_end);
     }
 }
 
@@ -1374,6 +1379,9 @@ void ConsoleWidgetPrivate::open_context_menu(const QPoint &global_pos) {
 void ConsoleWidgetPrivate::on_scope_expanded(const QModelIndex &index_proxy) {
     const QModelIndex index = scope_proxy_model->mapToSource(index_proxy);
     fetch_scope(index);
+
+    ConsoleImpl *impl = get_impl(index);
+    impl->expanded_changed(index, true);
 }
 
 void ConsoleWidgetPrivate::on_results_activated(const QModelIndex &index) {
@@ -1388,6 +1396,17 @@ void ConsoleWidgetPrivate::on_results_activated(const QModelIndex &index) {
     }
 }
 
+void ConsoleWidgetPrivate::on_results_scrolled_to_end() {
+    const QModelIndex current_scope = q->get_current_scope_item();
+
+    if (!current_scope.isValid()) {
+        return;
+    }
+
+    ConsoleImpl *impl = get_impl(current_scope);
+    impl->fetch_more(current_scope);
+}
+
 int console_item_get_type(const QModelIndex &index) {
     const int type = index.data(ConsoleRole_Type).toInt();
 
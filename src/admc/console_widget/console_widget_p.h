@@ -128,6 +128,7 @@ public slots:
     void on_scope_context_menu(const QPoint &pos);
     void on_scope_expanded(const QModelIndex &index);
     void on_results_activated(const QModelIndex &index);
+    void on_results_scrolled_to_end();
 };
 
 #endif /* CONSOLE_WIDGET_P_H */
@@ -22,6 +22,7 @@
 
 #include <QHeaderView>
 #include <QListView>
+#include <QScrollBar>
 #include <QSortFilterProxyModel>
 #include <QStackedWidget>
 #include <QTreeView>
@@ -91,6 +92,23 @@ ResultsView::ResultsView(QWidget *parent)
         connect(
             view, &QWidget::customContextMenuRequested,
             this, &ResultsView::context_menu);
+
+        // NOTE: list view scrolls horizontally, so both
+        // scrollbars are checked. Range changes are
+        // included so that if added rows don't fill the
+        // view, more rows are requested right away.
+        const QList<QScrollBar *> scrollbar_list = {
+            view->verticalScrollBar(),
+            view->horizontalScrollBar(),
+        };
+        for (QScrollBar *scrollbar : scrollbar_list) {
+            connect(
+                scrollbar, &QScrollBar::valueChanged,
+                this, &ResultsView::on_scrolled);
+            connect(
+                scrollbar, &QScrollBar::rangeChanged,
+                this, &ResultsView::on_scrolled);
+        }
     }
 
     set_view_type(ResultsViewType_Detail);
@@ -229,3 +247,47 @@ void ResultsView::set_row_hidden(int row, bool hidden)
 {
     m_detail_view->setRowHidden(row, QModelIndex(), hidden);
 }
+
+void ResultsView::set_sorting_enabled(const bool enabled) {
+    if (m_detail_view->isSortingEnabled() == enabled) {
+        return;
+    }
+
+    // NOTE: enabling sorting on the view sorts proxy by
+    // current sort column of the header. Sort column of
+    // -1 returns proxy to the order of the model.
+    m_detail_view->setSortingEnabled(enabled);
+
+    if (!enabled) {
+        proxy_model->sort(-1);
+    }
+}
+
+void ResultsView::on_scrolled() {
+    QAbstractItemView *view = current_view();
+
+    // NOTE: view is "near end" if less than a page is left
+    // to scroll, or if there's nothing to scroll
+    const bool scrollbar_near_end = [&]() {
+        const QList<QScrollBar *> scrollbar_list = {
+            view->verticalScrollBar(),
+            view->horizontalScrollBar(),
+        };
+
+        bool out = true;
+
+        for (QScrollBar *scrollbar : scrollbar_list) {
+            const int remaining = scrollbar->maximum() - scrollbar->value();
+
+            if (remaining > scrollbar->pageStep()) {
+                out = false;
+            }
+        }
+
+        return out;
+    }();
+
+    if (scrollbar_near_end) {
+        emit scrolled_to_end();
+    }
+}
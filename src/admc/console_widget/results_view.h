@@ -72,11 +72,20 @@ public:
 
     void set_row_hidden(int row, bool hidden);
 
+    // If sorting is disabled, rows are shown in the order
+    // of the model. Use this when rows are already sorted,
+    // for example by the server.
+    void set_sorting_enabled(const bool enabled);
+
 signals:
     void activated(const QModelIndex &index);
     void context_menu(const QPoint pos);
     void selection_changed();
 
+    // Emitted when current view is scrolled close to the
+    // end of rows, or when rows don't fill the view
+    void scrolled_to_end();
+
 private:
     QStackedWidget *stacked_widget;
     QHash<ResultsViewType, QAbstractItemView *> views;
@@ -85,6 +94,7 @@ private:
     QTreeView *m_detail_view;
 
     void on_item_activated(const QModelIndex &index);
+    void on_scrolled();
 };
 
 #endif /* RESULTS_VIEW_H */
@@ -44,14 +44,15 @@ CreatePolicyDialog::CreatePolicyDialog(AdInterface &ad, QWidget *parent)
             const SearchScope scope = SearchScope_All;
             const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_GP_CONTAINER);
             const QList<QString> attributes = {ATTRIBUTE_DISPLAY_NAME};
-            const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes);
 
             QList<QString> out;
 
-            for (const AdObject &object : results.values()) {
-                const QString name = object.get_string(ATTRIBUTE_DISPLAY_NAME);
+            ad.search_visit(base, scope, filter, attributes, [&](const AdEntryView &entry) {
+                const QString name = entry.get_string(ATTRIBUTE_DISPLAY_NAME);
                 out.append(name);
-            }
+
+                return true;
+            });
 
             return out;
         }();
@@ -96,10 +97,16 @@ void CreatePolicyDialog::accept() {
         const QString base = g_adconfig->domain_dn();
         const SearchScope scope = SearchScope_All;
         const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_DISPLAY_NAME, name);
-        const QList<QString> attributes = QList<QString>();
-        const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes);
+        const QList<QString> attributes = {ATTRIBUTE_DN};
+
+        bool out = false;
+        ad.search_visit(base, scope, filter, attributes, [&](const AdEntryView &) {
+            out = true;
 
-        return !results.isEmpty();
+            return false;
+        });
+
+        return out;
     }();
 
     if (name_conflict) {
@@ -26,6 +26,8 @@
 #include "select_dialogs/select_container_dialog.h"
 #include "utils.h"
 
+#define GLOBAL_CATALOG_ROLE (Qt::UserRole + 1)
+
 SelectBaseWidget::SelectBaseWidget(QWidget *parent)
 : QWidget(parent) {
     ui = new Ui::SelectBaseWidget();
@@ -53,6 +55,13 @@ void SelectBaseWidget::set_default_base(const QString &default_base) {
     ui->combo->setCurrentIndex(last_index);
 }
 
+void SelectBaseWidget::enable_global_catalog() {
+    ui->combo->addItem(tr("Entire forest (Global Catalog)"), QString());
+
+    const int gc_index = ui->combo->count() - 1;
+    ui->combo->setItemData(gc_index, true, GLOBAL_CATALOG_ROLE);
+}
+
 QString SelectBaseWidget::get_base() const {
     const int index = ui->combo->currentIndex();
     const QVariant item_data = ui->combo->itemData(index);
@@ -60,6 +69,16 @@ QString SelectBaseWidget::get_base() const {
     return item_data.toString();
 }
 
+AdServer SelectBaseWidget::get_server() const {
+    const bool is_gc = ui->combo->currentData(GLOBAL_CATALOG_ROLE).toBool();
+
+    if (is_gc) {
+        return AdServer_GlobalCatalog;
+    } else {
+        return AdServer_DomainController;
+    }
+}
+
 void SelectBaseWidget::open_browse_dialog() {
     AdInterface ad;
     if (ad_failed(ad, this)) {
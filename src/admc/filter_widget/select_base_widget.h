@@ -22,11 +22,15 @@
 #define SELECT_BASE_WIDGET_H
 
 /**
- * Allows user to select a search base object.
+ * Allows user to select a search base object. Optionally,
+ * allows selecting the whole forest, which is searched on
+ * global catalog.
  */
 
 #include <QWidget>
 
+#include "ad_defines.h"
+
 namespace Ui {
 class SelectBaseWidget;
 }
@@ -42,8 +46,15 @@ public:
 
     void set_default_base(const QString &default_base);
 
+    // Adds an option to search whole forest. Base is
+    // empty for that option.
+    void enable_global_catalog();
+
     QString get_base() const;
 
+    // Server that should be searched for selected base
+    AdServer get_server() const;
+
     QVariant save_state() const;
     void restore_state(const QVariant &state);
 
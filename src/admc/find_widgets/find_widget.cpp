@@ -70,6 +70,9 @@ FindWidget::FindWidget(QWidget *parent)
 
     ui->console->set_actions(console_actions);
 
+    ui->select_base_widget->enable_global_catalog();
+    results_server = AdServer_DomainController;
+
     object_impl = new ObjectImpl(ui->console);
     ui->console->register_impl(ItemType_Object, object_impl);
 
@@ -158,9 +161,14 @@ void FindWidget::find() {
     // Prepare search args
     const QString filter = ui->filter_widget->get_filter();
     const QString base = ui->select_base_widget->get_base();
+    const AdServer server = ui->select_base_widget->get_server();
     const QList<QString> search_attributes = console_object_search_attributes();
 
-    auto find_thread = new SearchThread(base, SearchScope_All, filter, search_attributes);
+    const AdMetricsAction metrics_action(tr("Find"));
+
+    auto find_thread = new SearchThread(base, SearchScope_All, filter, search_attributes, server);
+
+    results_server = server;
 
     connect(
         find_thread, &SearchThread::results_ready,
@@ -206,6 +214,10 @@ void FindWidget::handle_find_thread_results(const QHash<QString, AdObject> &resu
         const QList<QStandardItem *> row = ui->console->add_results_item(ItemType_Object, head_index);
 
         console_object_load(row, object);
+
+        if (results_server == AdServer_GlobalCatalog) {
+            console_object_set_partial(row, true);
+        }
     }
 }
 
@@ -216,6 +228,10 @@ QList<QString> FindWidget::get_selected_dns() const {
     return out;
 }
 
+AdServer FindWidget::get_results_server() const {
+    return results_server;
+}
+
 void FindWidget::on_clear_button() {
     ui->filter_widget->clear();
     clear_results();
@@ -29,6 +29,8 @@
 
 #include <QWidget>
 
+#include "ad_defines.h"
+
 class QStandardItem;
 class AdObject;
 class QMenu;
@@ -64,6 +66,9 @@ public:
     // NOTE: returned items need to be re-parented or deleted!
     QList<QString> get_selected_dns() const;
 
+    // Server that selected objects should be loaded from
+    AdServer get_results_server() const;
+
     void enable_filtering_all_classes();
 
 private slots:
@@ -73,6 +78,9 @@ private slots:
 private:
     ObjectImpl *object_impl;
     QStandardItem *head_item;
+    // Server that current results came from. Results of
+    // global catalog searches are partial.
+    AdServer results_server;
 
     QAction *action_view_icons;
     QAction *action_view_list;
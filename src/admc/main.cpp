@@ -34,6 +34,7 @@
 #include <QApplication>
 #include <QDebug>
 #include <QLibraryInfo>
+#include <QStandardPaths>
 #include <QTranslator>
 
 int main(int argc, char **argv) {
@@ -93,6 +94,42 @@ int main(int argc, char **argv) {
         qDebug() << "Failed to load qt base translation";
     }
 
+    // Save discovered DC's to disk so that next launch
+    // doesn't have to wait for DNS
+    const bool dc_cache_on_disk = settings_get_variant(SETTING_feature_dc_cache_on_disk).toBool();
+    if (dc_cache_on_disk) {
+        const QString dc_cache_path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/dc_cache";
+        AdInterface::set_dc_cache_path(dc_cache_path);
+    }
+
+    // Save schema and other config data to disk, so that
+    // next launch only has to check schema version
+    const bool schema_cache_on_disk = settings_get_variant(SETTING_feature_schema_cache_on_disk).toBool();
+    if (schema_cache_on_disk) {
+        const QString schema_cache_path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/schema";
+        AdConfig::set_cache_path(schema_cache_path);
+    }
+
+    const bool parallel_config_load = settings_get_variant(SETTING_feature_parallel_config_load).toBool();
+    AdConfig::set_parallel_load_enabled(parallel_config_load);
+
+    const int search_page_size = settings_get_variant(SETTING_search_page_size).toInt();
+    AdInterface::set_page_size(search_page_size);
+
+    const bool adaptive_page_size = settings_get_variant(SETTING_feature_adaptive_page_size).toBool();
+    AdInterface::set_adaptive_page_size(adaptive_page_size);
+
+    const bool record_metrics = settings_get_variant(SETTING_record_metrics).toBool();
+    AdMetrics::instance()->set_enabled(record_metrics);
+
+    // NOTE: tracing can be enabled through environment to
+    // capture startup, which happens before performance
+    // dialog can be opened. Trace is saved on exit.
+    const QString trace_path = qEnvironmentVariable("ADMC_TRACE_FILE");
+    if (!trace_path.isEmpty()) {
+        AdTrace::instance()->start();
+    }
+
     load_connection_options();
 
     // In case of failure to connect to AD and load
@@ -137,5 +174,12 @@ int main(int argc, char **argv) {
 
     delete first_main_window;
 
+    if (!trace_path.isEmpty()) {
+        const bool save_success = AdTrace::instance()->save(trace_path);
+        if (!save_success) {
+            qDebug() << "Failed to save trace to" << trace_path;
+        }
+    }
+
     return retval;
 }
@@ -39,6 +39,7 @@
 #include "fsmo/fsmo_dialog.h"
 #include "globals.h"
 #include "main_window_connection_error.h"
+#include "performance_dialog.h"
 #include "settings.h"
 #include "status.h"
 #include "utils.h"
@@ -281,6 +282,9 @@ MainWindow::MainWindow(AdInterface &ad, QWidget *parent)
     connect(
         ui->action_edit_fsmo_roles, &QAction::triggered,
         this, &MainWindow::edit_fsmo_roles);
+    connect(
+        ui->action_performance, &QAction::triggered,
+        this, &MainWindow::open_performance);
     connect(
         ui->action_quit, &QAction::triggered,
         this, &MainWindow::close);
@@ -439,6 +443,11 @@ void MainWindow::edit_fsmo_roles() {
     connect(dialog, &FSMODialog::master_changed, ui->console, &ConsoleWidget::fsmo_master_changed);
 }
 
+void MainWindow::open_performance() {
+    auto dialog = new PerformanceDialog(this);
+    dialog->open();
+}
+
 void MainWindow::reload_console_tree() {
     ui->console->refresh_scope(ui->console->domain_info_index());
 }
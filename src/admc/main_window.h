@@ -52,6 +52,7 @@ private:
     void open_changelog();
     void open_about();
     void edit_fsmo_roles();
+    void open_performance();
     void reload_console_tree();
 };
 
@@ -0,0 +1,214 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "performance_dialog.h"
+#include "ui_performance_dialog.h"
+
+#include "adldap.h"
+#include "globals.h"
+#include "settings.h"
+#include "utils.h"
+
+#include <QFileDialog>
+#include <QStandardItemModel>
+#include <QStandardPaths>
+#include <algorithm>
+
+enum PerformanceColumn {
+    PerformanceColumn_Action,
+    PerformanceColumn_Operation,
+    PerformanceColumn_Base,
+    PerformanceColumn_Filter,
+    PerformanceColumn_Count,
+    PerformanceColumn_Errors,
+    PerformanceColumn_Total,
+    PerformanceColumn_Average,
+    PerformanceColumn_Median,
+    PerformanceColumn_P95,
+    PerformanceColumn_Max,
+    PerformanceColumn_Pages,
+    PerformanceColumn_Entries,
+    PerformanceColumn_Bytes,
+
+    PerformanceColumn_COUNT,
+};
+
+PerformanceDialog::PerformanceDialog(QWidget *parent)
+: QDialog(parent) {
+    ui = new Ui::PerformanceDialog();
+    ui->setupUi(this);
+
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    model = new QStandardItemModel(0, PerformanceColumn_COUNT, this);
+    set_horizontal_header_labels_from_map(model,
+        {
+            {PerformanceColumn_Action, tr("Action")},
+            {PerformanceColumn_Operation, tr("Operation")},
+            {PerformanceColumn_Base, tr("Base")},
+            {PerformanceColumn_Filter, tr("Filter")},
+            {PerformanceColumn_Count, tr("Count")},
+            {PerformanceColumn_Errors, tr("Errors")},
+            {PerformanceColumn_Total, tr("Total, ms")},
+            {PerformanceColumn_Average, tr("Average, ms")},
+            {PerformanceColumn_Median, tr("50%, ms")},
+            {PerformanceColumn_P95, tr("95%, ms")},
+            {PerformanceColumn_Max, tr("Max, ms")},
+            {PerformanceColumn_Pages, tr("Pages")},
+            {PerformanceColumn_Entries, tr("Entries")},
+            {PerformanceColumn_Bytes, tr("Bytes")},
+        });
+
+    ui->view->setModel(model);
+
+    ui->record_check->setChecked(AdMetrics::instance()->enabled());
+    ui->trace_check->setChecked(AdTrace::instance()->is_running());
+
+    settings_setup_dialog_geometry(SETTING_performance_dialog_geometry, this);
+
+    connect(
+        ui->refresh_button, &QPushButton::clicked,
+        this, &PerformanceDialog::reload);
+    connect(
+        ui->reset_button, &QPushButton::clicked,
+        this, &PerformanceDialog::reset);
+    connect(
+        ui->record_check, &QCheckBox::toggled,
+        this, &PerformanceDialog::on_record_toggled);
+    connect(
+        ui->trace_check, &QCheckBox::toggled,
+        this, &PerformanceDialog::on_trace_toggled);
+    connect(
+        ui->save_trace_button, &QPushButton::clicked,
+        this, &PerformanceDialog::save_trace);
+
+    reload();
+}
+
+PerformanceDialog::~PerformanceDialog() {
+    delete ui;
+}
+
+void PerformanceDialog::reload() {
+    model->removeRows(0, model->rowCount());
+
+    const QList<AdMetricsEntry> entry_list = AdMetrics::instance()->snapshot();
+
+    for (const AdMetricsEntry &entry : entry_list) {
+        const QList<QStandardItem *> row = make_item_row(PerformanceColumn_COUNT);
+
+        const QString base = [&]() {
+            if (entry.op == AdMetricsOp_Search && entry.base.isEmpty()) {
+                return tr("(single object)");
+            } else {
+                return entry.base;
+            }
+        }();
+
+        row[PerformanceColumn_Action]->setText(entry.action);
+        row[PerformanceColumn_Operation]->setText(AdMetrics::op_name(entry.op));
+        row[PerformanceColumn_Base]->setText(base);
+        row[PerformanceColumn_Filter]->setText(entry.filter_template);
+
+        // NOTE: numbers are set as data instead of text, so
+        // that columns sort numerically
+        const QHash<int, qint64> number_map = {
+            {PerformanceColumn_Count, entry.count},
+            {PerformanceColumn_Errors, entry.error_count},
+            {PerformanceColumn_Total, entry.total_msec},
+            {PerformanceColumn_Average, entry.total_msec / qMax(entry.count, 1)},
+            {PerformanceColumn_Median, entry.percentile_msec(50)},
+            {PerformanceColumn_P95, entry.percentile_msec(95)},
+            {PerformanceColumn_Max, entry.max_msec},
+            {PerformanceColumn_Pages, entry.page_count},
+            {PerformanceColumn_Entries, entry.entry_count},
+            {PerformanceColumn_Bytes, entry.byte_count},
+        };
+
+        for (const int column : number_map.keys()) {
+            row[column]->setData(number_map[column], Qt::DisplayRole);
+        }
+
+        model->appendRow(row);
+    }
+
+    // NOTE: slowest paths first
+    ui->view->sortByColumn(PerformanceColumn_Total, Qt::DescendingOrder);
+
+    const QString config_text = [&]() {
+        const QHash<QString, qint64> phase_time_map = g_adconfig->get_phase_times();
+
+        QList<QString> phase_list = phase_time_map.keys();
+        std::sort(phase_list.begin(), phase_list.end());
+
+        QStringList part_list;
+        for (const QString &phase : phase_list) {
+            part_list.append(tr("%1 %2 ms").arg(phase).arg(phase_time_map[phase]));
+        }
+
+        return tr("Configuration load: %1").arg(part_list.join(", "));
+    }();
+    ui->config_label->setText(config_text);
+}
+
+void PerformanceDialog::reset() {
+    AdMetrics::instance()->reset();
+
+    reload();
+}
+
+void PerformanceDialog::on_record_toggled() {
+    const bool enabled = ui->record_check->isChecked();
+
+    AdMetrics::instance()->set_enabled(enabled);
+    settings_set_variant(SETTING_record_metrics, enabled);
+}
+
+// NOTE: trace is not saved in settings like metrics,
+// because events accumulate in memory
+void PerformanceDialog::on_trace_toggled() {
+    const bool enabled = ui->trace_check->isChecked();
+
+    if (enabled) {
+        AdTrace::instance()->start();
+    } else {
+        AdTrace::instance()->stop();
+    }
+}
+
+void PerformanceDialog::save_trace() {
+    const QString file_path = [&]() {
+        const QString caption = tr("Save Trace");
+        const QString suggested_file = QString("%1/admc_trace.json").arg(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation));
+        const QString filter = tr("JSON (*.json)");
+
+        const QString out = QFileDialog::getSaveFileName(this, caption, suggested_file, filter);
+
+        return out;
+    }();
+
+    if (file_path.isEmpty()) {
+        return;
+    }
+
+    const bool save_success = AdTrace::instance()->save(file_path);
+    if (!save_success) {
+        message_box_warning(this, tr("Error"), tr("Failed to save trace."));
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERFORMANCE_DIALOG_H
+#define PERFORMANCE_DIALOG_H
+
+/**
+ * Displays timings of LDAP operations recorded by
+ * AdMetrics, grouped by UI action, operation, base and
+ * filter. Used to find slow paths in a particular
+ * deployment. Can also record a trace of LDAP, SMB and UI
+ * work and save it in Chrome Trace Event format.
+ */
+
+#include <QDialog>
+
+class QStandardItemModel;
+
+namespace Ui {
+class PerformanceDialog;
+}
+
+class PerformanceDialog final : public QDialog {
+    Q_OBJECT
+
+public:
+    Ui::PerformanceDialog *ui;
+
+    PerformanceDialog(QWidget *parent);
+    ~PerformanceDialog();
+
+private:
+    QStandardItemModel *model;
+
+    void reload();
+    void reset();
+    void on_record_toggled();
+    void on_trace_toggled();
+    void save_trace();
+};
+
+#endif /* PERFORMANCE_DIALOG_H */
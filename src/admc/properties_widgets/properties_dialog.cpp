@@ -139,6 +139,8 @@ PropertiesDialog::PropertiesDialog(AdInterface &ad, const QString &target_arg, C
     }();
     setWindowTitle(title);
 
+    const AdMetricsAction metrics_action(tr("Properties"));
+
     const AdObject object = ad.search_object(target);
 
     const bool is_person = (object.is_class(CLASS_USER) || object.is_class(CLASS_INET_ORG_PERSON));
@@ -0,0 +1,446 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "search_engine.h"
+
+#include "adldap.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// NOTE: only used if wake fd couldn't be created. This
+// is then the max delay for processing new start and
+// stop requests while searches are running.
+#define POLL_TIMEOUT_MSEC 50
+
+// NOTE: engines are created on first use and deleted
+// together with the app object. Should only be called
+// from main thread.
+SearchEngine *SearchEngine::instance(const AdServer server) {
+    static QHash<int, SearchEngine *> engine_map;
+
+    if (!engine_map.contains(server)) {
+        SearchEngine *engine = new SearchEngine(server, QCoreApplication::instance());
+        engine->start();
+
+        engine_map[server] = engine;
+    }
+
+    return engine_map[server];
+}
+
+SearchEngine::SearchEngine(const AdServer server_arg, QObject *parent)
+: QThread(parent) {
+    id_max = 0;
+    quit_flag = false;
+    server = server_arg;
+
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd == -1) {
+        qDebug() << "Failed to create wake fd for search engine";
+    }
+
+    // NOTE: name is shown for this thread in traces
+    if (server == AdServer_GlobalCatalog) {
+        setObjectName("SearchEngine (GC)");
+    } else {
+        setObjectName("SearchEngine");
+    }
+
+    qRegisterMetaType<QHash<QString, AdObject>>("QHash<QString, AdObject>");
+    qRegisterMetaType<QList<AdMessage>>("QList<AdMessage>");
+    qRegisterMetaType<QList<AdObject>>("QList<AdObject>");
+
+    // NOTE: engine object lives in main thread, while
+    // signals are emitted from worker thread, so these
+    // connections are queued and results are dispatched
+    // to receivers in main thread
+    connect(
+        this, &SearchEngine::results_ready,
+        this, &SearchEngine::on_results_ready);
+    connect(
+        this, &SearchEngine::window_ready,
+        this, &SearchEngine::on_window_ready);
+    connect(
+        this, &SearchEngine::search_finished,
+        this, &SearchEngine::on_search_finished);
+}
+
+SearchEngine::~SearchEngine() {
+    shutdown();
+
+    if (wake_fd != -1) {
+        close(wake_fd);
+    }
+}
+
+int SearchEngine::start_search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const int object_display_limit, SearchEngineReceiver *receiver) {
+    QMutexLocker locker(&mutex);
+
+    Request request;
+    request.id = id_max;
+    request.base = base;
+    request.scope = scope;
+    request.filter = filter;
+    request.attributes = attributes;
+    request.object_display_limit = object_display_limit;
+    request.notify = false;
+    request.window_offset = -1;
+    request.action = AdMetricsAction::current();
+
+    id_max++;
+
+    receiver_map[request.id] = receiver;
+    start_queue.append(request);
+    wake();
+
+    return request.id;
+}
+
+int SearchEngine::start_notify(const QString &base, const QList<QString> &attributes, SearchEngineReceiver *receiver) {
+    QMutexLocker locker(&mutex);
+
+    Request request;
+    request.id = id_max;
+    request.base = base;
+    request.scope = SearchScope_Children;
+    request.attributes = attributes;
+    request.object_display_limit = -1;
+    request.notify = true;
+    request.window_offset = -1;
+    request.action = AdMetricsAction::current();
+
+    id_max++;
+
+    receiver_map[request.id] = receiver;
+    start_queue.append(request);
+    wake();
+
+    return request.id;
+}
+
+int SearchEngine::start_window(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const QString &sort_attribute, const int offset, const int count, const int content_count, SearchEngineReceiver *receiver) {
+    QMutexLocker locker(&mutex);
+
+    Request request;
+    request.id = id_max;
+    request.base = base;
+    request.scope = scope;
+    request.filter = filter;
+    request.attributes = attributes;
+    request.object_display_limit = -1;
+    request.notify = false;
+    request.window_offset = offset;
+    request.window_count = count;
+    request.window_content_count = content_count;
+    request.sort_attribute = sort_attribute;
+    request.action = AdMetricsAction::current();
+
+    id_max++;
+
+    receiver_map[request.id] = receiver;
+    start_queue.append(request);
+    wake();
+
+    return request.id;
+}
+
+void SearchEngine::stop_search(const int id) {
+    QMutexLocker locker(&mutex);
+
+    stop_queue.append(id);
+    wake();
+}
+
+void SearchEngine::remove_receiver(const int id) {
+    QMutexLocker locker(&mutex);
+
+    receiver_map.remove(id);
+}
+
+SearchEngineReceiver *SearchEngine::get_receiver(const int id) {
+    QMutexLocker locker(&mutex);
+
+    return receiver_map.value(id, nullptr);
+}
+
+// NOTE: results of searches whose receiver was removed
+// are dropped
+void SearchEngine::on_results_ready(const int id, const QHash<QString, AdObject> &results) {
+    SearchEngineReceiver *receiver = get_receiver(id);
+
+    if (receiver != nullptr) {
+        receiver->on_engine_results(id, results);
+    }
+}
+
+void SearchEngine::on_window_ready(const int id, const QList<AdObject> &results, const int content_count) {
+    SearchEngineReceiver *receiver = get_receiver(id);
+
+    if (receiver != nullptr) {
+        receiver->on_engine_window(id, results, content_count);
+    }
+}
+
+void SearchEngine::on_search_finished(const int id, const int status, const QList<AdMessage> &messages, const QString &dc) {
+    SearchEngineReceiver *receiver = get_receiver(id);
+    remove_receiver(id);
+
+    if (receiver != nullptr) {
+        receiver->on_engine_finished(id, status, messages, dc);
+    }
+}
+
+void SearchEngine::shutdown() {
+    {
+        QMutexLocker locker(&mutex);
+
+        quit_flag = true;
+        wake();
+    }
+
+    wait();
+}
+
+// NOTE: worker thread waits on the condition while there
+// are no searches and on the wake fd while searches are
+// running, so both are signaled. Should be called with
+// mutex locked.
+void SearchEngine::wake() {
+    wait_condition.wakeAll();
+
+    if (wake_fd != -1) {
+        const uint64_t value = 1;
+        const ssize_t written = write(wake_fd, &value, sizeof(value));
+        Q_UNUSED(written);
+    }
+}
+
+void SearchEngine::run() {
+    AdInterface *ad = nullptr;
+
+    // NOTE: this state is only accessed from this thread,
+    // so it's not protected by mutex. Searches are
+    // identified by engine id's, which are mapped to id's
+    // returned by AdInterface.
+    QHash<int, int> ad_id_map;
+    QHash<int, int> engine_id_map;
+    QHash<int, int> count_map;
+    QHash<int, int> limit_map;
+
+    auto take_messages = [&]() {
+        if (ad == nullptr) {
+            return QList<AdMessage>();
+        }
+
+        const QList<AdMessage> out = ad->messages();
+        ad->clear_messages();
+
+        return out;
+    };
+
+    auto get_dc = [&]() {
+        if (ad == nullptr) {
+            return QString();
+        }
+
+        return ad->get_dc();
+    };
+
+    auto remove_search = [&](const int id) {
+        const int ad_id = ad_id_map.take(id);
+        engine_id_map.remove(ad_id);
+        count_map.remove(id);
+        limit_map.remove(id);
+    };
+
+    while (true) {
+        // NOTE: connection is returned to the pool while
+        // there are no searches, so that it's not held for
+        // the whole lifetime of the app and so that new
+        // connection options are picked up
+        if (ad_id_map.isEmpty() && ad != nullptr) {
+            delete ad;
+            ad = nullptr;
+        }
+
+        QList<Request> start_list;
+        QList<int> stop_list;
+
+        // NOTE: drain wake fd before taking the queues, so
+        // that requests added after this point wake up
+        // the next wait
+        if (wake_fd != -1) {
+            uint64_t value;
+            const ssize_t read_size = read(wake_fd, &value, sizeof(value));
+            Q_UNUSED(read_size);
+        }
+
+        {
+            QMutexLocker locker(&mutex);
+
+            while (!quit_flag && ad_id_map.isEmpty() && start_queue.isEmpty() && stop_queue.isEmpty()) {
+                wait_condition.wait(&mutex);
+            }
+
+            if (quit_flag) {
+                break;
+            }
+
+            start_list = start_queue;
+            start_queue.clear();
+            stop_list = stop_queue;
+            stop_queue.clear();
+        }
+
+        // Stop searches
+        for (const int id : stop_list) {
+            if (ad_id_map.contains(id)) {
+                ad->search_async_abandon(ad_id_map[id]);
+                remove_search(id);
+
+                emit search_finished(id, SearchEngineStatus_Stopped, QList<AdMessage>(), get_dc());
+            } else {
+                // NOTE: search might've been stopped before
+                // it was started
+                for (int i = 0; i < start_list.size(); i++) {
+                    if (start_list[i].id == id) {
+                        start_list.removeAt(i);
+
+                        emit search_finished(id, SearchEngineStatus_Stopped, QList<AdMessage>(), get_dc());
+
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Start searches
+        if (!start_list.isEmpty()) {
+            if (ad == nullptr) {
+                ad = new AdInterface(server);
+            }
+
+            if (!ad->is_connected()) {
+                const QList<AdMessage> messages = take_messages();
+
+                for (const Request &request : start_list) {
+                    emit search_finished(request.id, SearchEngineStatus_FailedToConnect, messages, QString());
+                }
+
+                // NOTE: searches that were running on this
+                // connection are lost too
+                for (const int id : ad_id_map.keys()) {
+                    emit search_finished(id, SearchEngineStatus_Failed, messages, QString());
+                }
+
+                ad_id_map.clear();
+                engine_id_map.clear();
+                count_map.clear();
+                limit_map.clear();
+
+                continue;
+            }
+
+            for (const Request &request : start_list) {
+                // NOTE: action is per thread, so it's passed
+                // from the thread that started the search
+                const AdMetricsAction metrics_action(request.action);
+
+                const int ad_id = [&]() {
+                    const bool is_window = (request.window_offset != -1);
+
+                    if (is_window) {
+                        return ad->search_async_window(request.base, request.scope, request.filter, request.attributes, request.sort_attribute, request.window_offset, request.window_count, request.window_content_count);
+                    } else if (request.notify) {
+                        return ad->search_async_notify(request.base, request.scope, request.attributes);
+                    } else {
+                        return ad->search_async(request.base, request.scope, request.filter, request.attributes);
+                    }
+                }();
+
+                if (ad_id == -1) {
+                    emit search_finished(request.id, SearchEngineStatus_Failed, take_messages(), get_dc());
+
+                    continue;
+                }
+
+                ad_id_map[request.id] = ad_id;
+                engine_id_map[ad_id] = request.id;
+                count_map[request.id] = 0;
+                limit_map[request.id] = request.object_display_limit;
+            }
+        }
+
+        if (ad_id_map.isEmpty()) {
+            continue;
+        }
+
+        // Collect results. Waits until results arrive or
+        // until woken up by a new request.
+        const int poll_timeout = (wake_fd != -1 ? -1 : POLL_TIMEOUT_MSEC);
+        QHash<int, QHash<QString, AdObject>> results_map;
+        QHash<int, bool> finished_map;
+        ad->search_async_poll(poll_timeout, &results_map, &finished_map, wake_fd);
+
+        for (const int ad_id : results_map.keys()) {
+            const int id = engine_id_map[ad_id];
+            const QHash<QString, AdObject> &results = results_map[ad_id];
+
+            count_map[id] += results.size();
+
+            const bool has_limit = (limit_map[id] != -1);
+            if (has_limit && count_map[id] > limit_map[id]) {
+                ad->search_async_abandon(ad_id);
+                remove_search(id);
+                finished_map.remove(ad_id);
+
+                emit search_finished(id, SearchEngineStatus_HitObjectDisplayLimit, take_messages(), get_dc());
+
+                continue;
+            }
+
+            emit results_ready(id, results);
+        }
+
+        for (const int ad_id : finished_map.keys()) {
+            const int id = engine_id_map[ad_id];
+            const bool success = finished_map[ad_id];
+            const SearchEngineStatus status = (success ? SearchEngineStatus_Success : SearchEngineStatus_Failed);
+
+            // NOTE: windows are returned whole, when their
+            // search finishes
+            QList<AdObject> window_results;
+            int window_content_count;
+            const bool is_window = ad->search_async_take_window(ad_id, &window_results, &window_content_count);
+            if (is_window) {
+                emit window_ready(id, window_results, window_content_count);
+            }
+
+            remove_search(id);
+
+            emit search_finished(id, status, take_messages(), get_dc());
+        }
+    }
+
+    delete ad;
+}
@@ -0,0 +1,161 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEARCH_ENGINE_H
+#define SEARCH_ENGINE_H
+
+/**
+ * Runs all background searches of the app in one worker
+ * thread over one connection, using async search of
+ * AdInterface. Searches can be started and stopped from any
+ * thread. Stopping a search abandons it on the server
+ * right away, instead of waiting for current page to
+ * finish. Results are emitted by pages as they arrive.
+ * Searches on global catalog are run by a separate engine,
+ * with it's own thread and connection.
+ * Results of each search are delivered only to the
+ * receiver that started it, in main thread.
+ * Don't use this directly, use SearchThread or
+ * ChangeNotifier instead.
+ */
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "ad_defines.h"
+
+class AdObject;
+class AdMessage;
+
+enum SearchEngineStatus {
+    SearchEngineStatus_Success,
+    SearchEngineStatus_Failed,
+    SearchEngineStatus_FailedToConnect,
+    SearchEngineStatus_HitObjectDisplayLimit,
+    SearchEngineStatus_Stopped,
+};
+
+// Interface for objects that start searches on the
+// engine. F-ns are called in main thread.
+class SearchEngineReceiver {
+public:
+    virtual ~SearchEngineReceiver() = default;
+
+    virtual void on_engine_results(const int id, const QHash<QString, AdObject> &results) = 0;
+    // "dc" is the DC that served the search, empty if
+    // failed to connect
+    virtual void on_engine_finished(const int id, const int status, const QList<AdMessage> &messages, const QString &dc) = 0;
+
+    // Only called for window searches, see start_window()
+    virtual void on_engine_window(const int id, const QList<AdObject> &results, const int content_count) {
+        Q_UNUSED(id);
+        Q_UNUSED(results);
+        Q_UNUSED(content_count);
+    }
+};
+
+class SearchEngine final : public QThread {
+    Q_OBJECT
+
+public:
+    static SearchEngine *instance(const AdServer server = AdServer_DomainController);
+
+    ~SearchEngine();
+
+    // Returns id of the search. Results are passed to
+    // "receiver" until it's finish is passed.
+    int start_search(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const int object_display_limit, SearchEngineReceiver *receiver);
+
+    // Starts a change notification search for children of
+    // "base", see AdInterface::search_async_notify().
+    // Changed objects are passed to receiver until the
+    // search is stopped.
+    int start_notify(const QString &base, const QList<QString> &attributes, SearchEngineReceiver *receiver);
+    // Loads one window of results sorted by
+    // "sort_attribute", see AdInterface::search_window().
+    // Window is passed to on_engine_window() of receiver
+    // instead of on_engine_results().
+    int start_window(const QString &base, const SearchScope scope, const QString &filter, const QList<QString> &attributes, const QString &sort_attribute, const int offset, const int count, const int content_count, SearchEngineReceiver *receiver);
+
+    void stop_search(const int id);
+
+    // Stops passing results of search to it's receiver.
+    // Call this before deleting a receiver whose search
+    // hasn't finished yet.
+    void remove_receiver(const int id);
+
+signals:
+    // NOTE: these are only used to pass results from
+    // worker thread to main thread, connect to them
+    // only inside engine
+    void results_ready(const int id, const QHash<QString, AdObject> &results);
+    void window_ready(const int id, const QList<AdObject> &results, const int content_count);
+    // "dc" is the DC that served the search, empty if
+    // failed to connect
+    void search_finished(const int id, const int status, const QList<AdMessage> &messages, const QString &dc);
+
+private:
+    class Request {
+    public:
+        int id;
+        QString base;
+        SearchScope scope;
+        QString filter;
+        QList<QString> attributes;
+        // NOTE: -1 means no limit
+        int object_display_limit;
+        bool notify;
+        // NOTE: -1 if this is not a window search
+        int window_offset;
+        int window_count;
+        int window_content_count;
+        QString sort_attribute;
+        // Action that started the search, for metrics
+        QString action;
+    };
+
+    QMutex mutex;
+    QWaitCondition wait_condition;
+    // Eventfd which wakes up the worker thread while it's
+    // waiting for results of running searches. -1 if
+    // failed to create it, in which case worker thread
+    // checks for new requests periodically.
+    int wake_fd;
+    QList<Request> start_queue;
+    QList<int> stop_queue;
+    QHash<int, SearchEngineReceiver *> receiver_map;
+    int id_max;
+    bool quit_flag;
+    AdServer server;
+
+    SearchEngine(const AdServer server, QObject *parent);
+
+    void run() override;
+    void shutdown();
+    void wake();
+    SearchEngineReceiver *get_receiver(const int id);
+    void on_results_ready(const int id, const QHash<QString, AdObject> &results);
+    void on_window_ready(const int id, const QList<AdObject> &results, const int content_count);
+    void on_search_finished(const int id, const int status, const QList<AdMessage> &messages, const QString &dc);
+};
+
+#endif /* SEARCH_ENGINE_H */
@@ -21,19 +21,25 @@
 #include "search_thread.h"
 
 #include "adldap.h"
+#include "search_engine.h"
 #include "settings.h"
 #include "status.h"
 #include "utils.h"
 
 #include <QHash>
 
-SearchThread::SearchThread(const QString base_arg, const SearchScope scope_arg, const QString &filter_arg, const QList<QString> attributes_arg) {
-    stop_flag = false;
+SearchThread::SearchThread(const QString base_arg, const SearchScope scope_arg, const QString &filter_arg, const QList<QString> attributes_arg, const AdServer server_arg) {
     base = base_arg;
     scope = scope_arg;
     filter = filter_arg;
     attributes = attributes_arg;
+    server = server_arg;
+    window_offset = -1;
+    window_count = 0;
+    window_content_count = 0;
+    engine_id = -1;
     m_failed_to_connect = false;
+    m_failed = false;
     m_hit_object_display_limit = false;
 
     static int id_max = 0;
@@ -41,50 +47,86 @@ SearchThread::SearchThread(const QString base_arg, const SearchScope scope_arg,
     id_max++;
 }
 
-void SearchThread::stop() {
-    stop_flag = true;
+SearchThread::~SearchThread() {
+    if (engine_id != -1) {
+        SearchEngine *engine = SearchEngine::instance(server);
+        engine->stop_search(engine_id);
+        engine->remove_receiver(engine_id);
+    }
+}
+
+void SearchThread::set_window(const QString &sort_attribute_arg, const int offset, const int count, const int content_count) {
+    sort_attribute = sort_attribute_arg;
+    window_offset = offset;
+    window_count = count;
+    window_content_count = content_count;
 }
 
-void SearchThread::run() {
-    AdInterface ad;
-    if (!ad.is_connected()) {
-        m_failed_to_connect = true;
+void SearchThread::start() {
+    SearchEngine *engine = SearchEngine::instance(server);
 
-        return;
+    const bool is_window = (window_offset != -1);
+    if (is_window) {
+        engine_id = engine->start_window(base, scope, filter, attributes, sort_attribute, window_offset, window_count, window_content_count, this);
+    } else {
+        const int object_display_limit = settings_get_variant(SETTING_object_display_limit).toInt();
+
+        engine_id = engine->start_search(base, scope, filter, attributes, object_display_limit, this);
     }
+}
 
-    AdCookie cookie;
+// NOTE: finished() is still emitted after stop, once engine
+// confirms it
+void SearchThread::stop() {
+    if (engine_id != -1) {
+        SearchEngine::instance(server)->stop_search(engine_id);
+    }
+}
 
-    const int object_display_limit = settings_get_variant(SETTING_object_display_limit).toInt();
+void SearchThread::on_engine_results(const int id_arg, const QHash<QString, AdObject> &results) {
+    UNUSED_ARG(id_arg);
 
-    int total_results_count = 0;
+    emit results_ready(results);
+}
 
-    while (true) {
-        QHash<QString, AdObject> results;
+void SearchThread::on_engine_window(const int id_arg, const QList<AdObject> &results, const int content_count) {
+    UNUSED_ARG(id_arg);
 
-        const bool success = ad.search_paged(base, scope, filter, attributes, &results, &cookie);
+    window_content_count = content_count;
 
-        total_results_count += results.count();
+    emit window_ready(results, content_count);
+}
 
-        if (total_results_count > object_display_limit) {
-            m_hit_object_display_limit = true;
+void SearchThread::on_engine_finished(const int id_arg, const int status, const QList<AdMessage> &messages, const QString &dc_arg) {
+    UNUSED_ARG(id_arg);
 
-            break;
-        }
+    engine_id = -1;
+    ad_messages = messages;
+    dc = dc_arg;
 
-        ad_messages = ad.messages();
+    switch (status) {
+        case SearchEngineStatus_FailedToConnect: {
+            m_failed_to_connect = true;
+            m_failed = true;
 
-        emit results_ready(results);
+            break;
+        }
+        case SearchEngineStatus_Failed: {
+            m_failed = true;
 
-        const bool search_interrupted = (!success || stop_flag);
-        if (search_interrupted) {
             break;
         }
+        case SearchEngineStatus_HitObjectDisplayLimit: {
+            m_hit_object_display_limit = true;
+
+            emit over_object_display_limit();
 
-        if (!cookie.more_pages()) {
             break;
         }
+        default: break;
     }
+
+    emit finished();
 }
 
 int SearchThread::get_id() const {
@@ -95,6 +137,10 @@ bool SearchThread::failed_to_connect() const {
     return m_failed_to_connect;
 }
 
+bool SearchThread::failed() const {
+    return m_failed;
+}
+
 bool SearchThread::hit_object_display_limit() const {
     return m_hit_object_display_limit;
 }
@@ -103,6 +149,14 @@ QList<AdMessage> SearchThread::get_ad_messages() const {
     return ad_messages;
 }
 
+QString SearchThread::get_dc() const {
+    return dc;
+}
+
+int SearchThread::get_window_content_count() const {
+    return window_content_count;
+}
+
 void search_thread_display_errors(SearchThread *thread, QWidget *parent) {
     if (thread->failed_to_connect()) {
         error_log({QCoreApplication::translate("object_impl.cpp", "Failed to connect to server while searching for objects.")}, parent);
@@ -22,52 +22,87 @@
 #define SEARCH_THREAD_H
 
 /**
- * A thread that performs an AD search operation. Useful for
+ * Performs an AD search in the background. Useful for
  * searches that are expected to take a long time. For
  * regular small searches this is overkill. results_ready()
  * signal returns search results as they arrive. If search
  * has multiple pages, then results_ready() will be emitted
- * multiple times. Use stop() to stop search. Note that search is
- * not stopped immediately but when current results page is
- * done processing. Note that creator of thread should call
- * thread's deleteLater() in the finished() slot.
+ * multiple times. Use stop() to stop search, search is
+ * abandoned on the server immediately. finished() is
+ * emitted when search is done or stopped. Note that
+ * creator should call deleteLater() in the finished()
+ * slot. Despite the name, this doesn't create a thread.
+ * All searches are multiplexed by SearchEngine over one
+ * connection in one worker thread.
  */
 
-#include <QThread>
+#include <QObject>
 
 #include "ad_defines.h"
+#include "search_engine.h"
 
 class AdObject;
 class AdMessage;
 
-class SearchThread final : public QThread {
+class SearchThread final : public QObject, public SearchEngineReceiver {
     Q_OBJECT
 
 public:
-    SearchThread(const QString base, const SearchScope scope, const QString &filter, const QList<QString> attributes);
+    // NOTE: results of searches on global catalog are
+    // partial, see AdServer
+    SearchThread(const QString base, const SearchScope scope, const QString &filter, const QList<QString> attributes, const AdServer server = AdServer_DomainController);
+    ~SearchThread();
 
+    // Makes this thread load one window of results
+    // instead, see AdInterface::search_window(). Call
+    // before start(). Window is returned by window_ready()
+    // instead of results_ready().
+    void set_window(const QString &sort_attribute, const int offset, const int count, const int content_count);
+
+    void start();
     void stop();
     int get_id() const;
     bool failed_to_connect() const;
+    bool failed() const;
     bool hit_object_display_limit() const;
     QList<AdMessage> get_ad_messages() const;
+    // DC that served the search, valid after finished()
+    QString get_dc() const;
+    // Total amount of entries matching a window search,
+    // as estimated by server. Valid after finished().
+    int get_window_content_count() const;
 
 signals:
     void results_ready(const QHash<QString, AdObject> &results);
+    void window_ready(const QList<AdObject> &results, const int content_count);
     void over_object_display_limit();
+    void finished();
 
 private:
-    bool stop_flag;
     QString base;
     SearchScope scope;
     QString filter;
     QList<QString> attributes;
+    AdServer server;
+    // NOTE: -1 if this is not a window search
+    int window_offset;
+    int window_count;
+    int window_content_count;
+    QString sort_attribute;
     int id;
+    // Id of search in SearchEngine, -1 if not started or
+    // already finished
+    int engine_id;
     bool m_failed_to_connect;
+    bool m_failed;
     bool m_hit_object_display_limit;
     QList<AdMessage> ad_messages;
+    QString dc;
+
+    void on_engine_results(const int id, const QHash<QString, AdObject> &results) override;
+    void on_engine_finished(const int id, const int status, const QList<AdMessage> &messages, const QString &dc_arg) override;
+    void on_engine_window(const int id, const QList<AdObject> &results, const int content_count) override;
 
-    void run() override;
 };
 
 // Call this in your finished() slot to display any
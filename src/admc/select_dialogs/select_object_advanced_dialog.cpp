@@ -57,3 +57,7 @@ SelectObjectAdvancedDialog::~SelectObjectAdvancedDialog() {
 QList<QString> SelectObjectAdvancedDialog::get_selected_dns() const {
     return ui->find_widget->get_selected_dns();
 }
+
+AdServer SelectObjectAdvancedDialog::get_server() const {
+    return ui->find_widget->get_results_server();
+}
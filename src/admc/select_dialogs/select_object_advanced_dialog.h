@@ -27,6 +27,8 @@
 
 #include <QDialog>
 
+#include "ad_defines.h"
+
 namespace Ui {
 class SelectObjectAdvancedDialog;
 }
@@ -41,6 +43,7 @@ public:
     ~SelectObjectAdvancedDialog();
 
     QList<QString> get_selected_dns() const;
+    AdServer get_server() const;
 };
 
 #endif /* SELECT_OBJECT_ADVANCED_DIALOG_H */
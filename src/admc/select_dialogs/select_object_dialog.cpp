@@ -52,6 +52,8 @@ SelectObjectDialog::SelectObjectDialog(const QList<QString> class_list_arg, cons
 
     ui->select_classes_widget->set_classes(class_list, selected_list);
 
+    ui->select_base_widget->enable_global_catalog();
+
     model = new QStandardItemModel(this);
     model->setHorizontalHeaderLabels(header_labels());
 
@@ -140,7 +142,12 @@ void SelectObjectDialog::on_add_button() {
         return;
     }
 
-    AdInterface ad;
+    // NOTE: objects found on global catalog are also
+    // loaded from it, because they may be in other
+    // domains
+    const AdServer server = ui->select_base_widget->get_server();
+
+    AdInterface ad(server);
     if (ad_failed(ad, this)) {
         return;
     }
@@ -180,10 +187,10 @@ void SelectObjectDialog::on_add_button() {
         connect(
             dialog, &QDialog::accepted,
             this,
-            [this, dialog]() {
+            [this, dialog, server]() {
                 const QList<QString> selected_matches = dialog->get_selected();
 
-                add_objects_to_list(selected_matches);
+                add_objects_to_list(selected_matches, server);
             });
     } else if (search_results.size() == 0) {
         // Warn about failing to find any matches
@@ -208,13 +215,14 @@ void SelectObjectDialog::open_advanced_dialog() {
         this,
         [this, dialog]() {
             const QList<QString> selected = dialog->get_selected_dns();
+            const AdServer server = dialog->get_server();
 
-            add_objects_to_list(selected);
+            add_objects_to_list(selected, server);
         });
 }
 
-void SelectObjectDialog::add_objects_to_list(const QList<QString> &dn_list) {
-    AdInterface ad;
+void SelectObjectDialog::add_objects_to_list(const QList<QString> &dn_list, const AdServer server) {
+    AdInterface ad(server);
     if (ad_failed(ad, this)) {
         return;
     }
@@ -247,6 +255,17 @@ void SelectObjectDialog::add_objects_to_list(const QList<QString> &dn_list, AdIn
             const AdObject object = ad.search_object(dn);
 
             add_select_object_to_model(model, object);
+
+            if (ad.server() == AdServer_GlobalCatalog) {
+                const int last_row = model->rowCount() - 1;
+                const QList<QStandardItem *> row = {
+                    model->item(last_row, SelectColumn_Name),
+                    model->item(last_row, SelectColumn_Type),
+                    model->item(last_row, SelectColumn_Folder),
+                };
+
+                console_object_set_partial(row, true);
+            }
         }
     }
 
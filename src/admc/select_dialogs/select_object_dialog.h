@@ -23,6 +23,8 @@
 
 #include <QDialog>
 
+#include "ad_defines.h"
+
 class QStandardItemModel;
 class AdObject;
 class AdInterface;
@@ -65,7 +67,7 @@ private:
 
     void on_add_button();
     void on_remove_button();
-    void add_objects_to_list(const QList<QString> &dn_list);
+    void add_objects_to_list(const QList<QString> &dn_list, const AdServer server);
     void add_objects_to_list(const QList<QString> &dn_list, AdInterface &ad);
     void open_advanced_dialog();
 };
@@ -43,6 +43,7 @@ const QHash<QString, QVariant> setting_default_map = {
             }
         }()},
     {SETTING_log_searches, false},
+    {SETTING_record_metrics, false},
     {SETTING_timestamp_log, true},
     {SETTING_sasl_nocanon, true},
     {SETTING_show_login, true},
@@ -51,11 +52,22 @@ const QHash<QString, QVariant> setting_default_map = {
     {SETTING_object_filter_enabled, false},
     {SETTING_cert_strategy, CERT_STRATEGY_NEVER_define},
     {SETTING_object_display_limit, 1000},
+    {SETTING_search_page_size, 100},
 
     {SETTING_feature_logon_computers, false},
     {SETTING_feature_profile_tab, false},
     {SETTING_feature_dev_mode, false},
     {SETTING_feature_current_locale_first, false},
+    {SETTING_feature_dc_cache_on_disk, true},
+    {SETTING_feature_site_aware_dc, true},
+    {SETTING_feature_dc_latency_ranking, true},
+    {SETTING_feature_hedged_reads, false},
+    {SETTING_feature_adaptive_page_size, true},
+    {SETTING_feature_virtual_list_view, true},
+    {SETTING_feature_incremental_refresh, true},
+    {SETTING_feature_change_notifications, false},
+    {SETTING_feature_schema_cache_on_disk, true},
+    {SETTING_feature_parallel_config_load, true},
 };
 
 void settings_setup_dialog_geometry(const QString setting, QDialog *dialog) {
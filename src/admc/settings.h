@@ -65,6 +65,7 @@ DEFINE_SETTING(SETTING_object_multi_dialog_geometry);
 DEFINE_SETTING(SETTING_connection_options_dialog_geometry);
 DEFINE_SETTING(SETTING_changelog_dialog_geometry);
 DEFINE_SETTING(SETTING_error_log_dialog_geometry);
+DEFINE_SETTING(SETTING_performance_dialog_geometry);
 DEFINE_SETTING(SETTING_select_well_known_trustee_dialog_geometry);
 DEFINE_SETTING(SETTING_select_object_match_dialog_geometry);
 DEFINE_SETTING(SETTING_edit_query_item_dialog_geometry);
@@ -120,6 +121,7 @@ DEFINE_SETTING(SETTING_confirm_actions);
 DEFINE_SETTING(SETTING_show_non_containers_in_console_tree);
 DEFINE_SETTING(SETTING_last_name_before_first_name);
 DEFINE_SETTING(SETTING_log_searches);
+DEFINE_SETTING(SETTING_record_metrics);
 DEFINE_SETTING(SETTING_timestamp_log);
 DEFINE_SETTING(SETTING_sasl_nocanon);
 DEFINE_SETTING(SETTING_show_login);
@@ -138,6 +140,7 @@ DEFINE_SETTING(SETTING_last_opened_version);
 DEFINE_SETTING(SETTING_object_filter);
 DEFINE_SETTING(SETTING_object_filter_enabled);
 DEFINE_SETTING(SETTING_object_display_limit);
+DEFINE_SETTING(SETTING_search_page_size);
 DEFINE_SETTING(SETTING_custom_domain);
 DEFINE_SETTING(SETTING_current_icon_theme);
 DEFINE_SETTING(SETTING_custom_icon_themes_path)
@@ -154,6 +157,16 @@ DEFINE_SETTING(SETTING_feature_logon_computers);
 DEFINE_SETTING(SETTING_feature_profile_tab);
 DEFINE_SETTING(SETTING_feature_dev_mode);
 DEFINE_SETTING(SETTING_feature_current_locale_first);
+DEFINE_SETTING(SETTING_feature_dc_cache_on_disk);
+DEFINE_SETTING(SETTING_feature_site_aware_dc);
+DEFINE_SETTING(SETTING_feature_dc_latency_ranking);
+DEFINE_SETTING(SETTING_feature_hedged_reads);
+DEFINE_SETTING(SETTING_feature_adaptive_page_size);
+DEFINE_SETTING(SETTING_feature_virtual_list_view);
+DEFINE_SETTING(SETTING_feature_incremental_refresh);
+DEFINE_SETTING(SETTING_feature_change_notifications);
+DEFINE_SETTING(SETTING_feature_schema_cache_on_disk);
+DEFINE_SETTING(SETTING_feature_parallel_config_load);
 
 QVariant settings_get_variant(const QString setting);
 void settings_set_variant(const QString setting, const QVariant &value);
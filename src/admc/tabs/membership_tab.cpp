@@ -135,7 +135,12 @@ void MembershipTabEdit::load(AdInterface &ad, const AdObject &object) {
             const SearchScope scope = SearchScope_All;
             const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_PRIMARY_GROUP_ID, group_rid);
             const QList<QString> attributes = QList<QString>();
-            const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes);
+
+            // NOTE: only dn's are needed
+            SearchOptions options;
+            options.attrs_only = true;
+
+            const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes, options);
 
             for (const QString &user : results.keys()) {
                 original_primary_values.insert(user);
@@ -162,7 +167,14 @@ void MembershipTabEdit::load(AdInterface &ad, const AdObject &object) {
             const SearchScope scope = SearchScope_All;
             const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_SID, group_sid);
             const QList<QString> attributes = QList<QString>();
-            const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes);
+
+            // NOTE: sid is unique, so server can stop after
+            // first match. Only dn is needed.
+            SearchOptions options;
+            options.size_limit = 1;
+            options.attrs_only = true;
+
+            const QHash<QString, AdObject> results = ad.search(base, scope, filter, attributes, options);
 
             if (!results.isEmpty()) {
                 const QString group_dn = results.values()[0].get_dn();
@@ -428,9 +440,31 @@ void MembershipTabEdit::reload_model() {
 
     const QSet<QString> all_values = current_values + current_primary_values;
 
-    for (auto dn : all_values) {
+    append_rows(all_values.values());
+
+    model->sort(MembersColumn_Name);
+}
+
+// NOTE: big groups can have 100k's of members, so rows are
+// inserted in one go instead of one by one, which would
+// update the view for every row
+void MembershipTabEdit::append_rows(const QList<QString> &dn_list) {
+    const int first_row = model->rowCount();
+    model->insertRows(first_row, dn_list.size());
+
+    // NOTE: members are usually concentrated in a few
+    // containers, so reuse canonical names of parents
+    QHash<QString, QString> parent_canonical_cache;
+
+    for (int i = 0; i < dn_list.size(); i++) {
+        const QString &dn = dn_list[i];
         const QString name = dn_get_name(dn);
-        const QString parent = dn_get_parent_canonical(dn);
+
+        const QString parent_dn = dn_get_parent(dn);
+        if (!parent_canonical_cache.contains(parent_dn)) {
+            parent_canonical_cache[parent_dn] = dn_canonical(parent_dn);
+        }
+        const QString parent = parent_canonical_cache[parent_dn];
 
         const QList<QStandardItem *> row = make_item_row(MembersColumn_COUNT);
         row[MembersColumn_Name]->setText(name);
@@ -438,28 +472,49 @@ void MembershipTabEdit::reload_model() {
 
         set_data_for_row(row, dn, MembersRole_DN);
 
-        model->appendRow(row);
+        for (int col = 0; col < MembersColumn_COUNT; col++) {
+            model->setItem(first_row + i, col, row[col]);
+        }
     }
-
-    model->sort(MembersColumn_Name);
 }
 
 void MembershipTabEdit::add_values(QList<QString> values) {
+    QList<QString> new_values;
+
     for (auto value : values) {
+        const bool is_new = !current_values.contains(value) && !current_primary_values.contains(value);
+        if (is_new) {
+            new_values.append(value);
+        }
+
         current_values.insert(value);
     }
 
-    reload_model();
+    // NOTE: only add rows for new values instead of
+    // reloading the whole model
+    append_rows(new_values);
+    model->sort(MembersColumn_Name);
 
     emit edited();
 }
 
 void MembershipTabEdit::remove_values(QList<QString> values) {
+    const QSet<QString> removed_set = QSet<QString>(values.begin(), values.end());
+
     for (auto value : values) {
         current_values.remove(value);
     }
 
-    reload_model();
+    // NOTE: primary values can't be removed, so their rows
+    // stay
+    for (int row = model->rowCount() - 1; row >= 0; row--) {
+        const QString dn = model->item(row, MembersColumn_Name)->data(MembersRole_DN).toString();
+        const bool is_removed = (removed_set.contains(dn) && !current_primary_values.contains(dn));
+
+        if (is_removed) {
+            model->removeRow(row);
+        }
+    }
 
     emit edited();
 }
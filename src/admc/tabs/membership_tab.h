@@ -85,6 +85,7 @@ private:
     void on_properties_button();
     void enable_primary_button_on_valid_selection();
     void reload_model();
+    void append_rows(const QList<QString> &dn_list);
     void add_values(QList<QString> values);
     void remove_values(QList<QString> values);
     QString get_membership_attribute();
@@ -425,6 +425,10 @@ void SecurityTab::add_trustees(const QList<QByteArray> &sid_list, AdInterface &a
         return out;
     }();
 
+    // NOTE: resolve all names at once, so that trustee's
+    // are looked up with one search instead of one each
+    const QHash<QByteArray, QString> name_map = ad_security_get_trustee_names(ad, sid_list);
+
     bool added_anything = false;
     bool failed_to_add_because_already_exists = false;
 
@@ -438,7 +442,7 @@ void SecurityTab::add_trustees(const QList<QByteArray> &sid_list, AdInterface &a
         }
 
         auto item = new QStandardItem();
-        const QString name = ad_security_get_trustee_name(ad, sid);
+        const QString name = name_map.value(sid);
         item->setText(name);
         item->setData(sid, TrusteeItemRole_Sid);
         trustee_model->appendRow(item);
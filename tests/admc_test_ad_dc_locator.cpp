@@ -0,0 +1,141 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "admc_test_ad_dc_locator.h"
+
+#define LOGON_SAM_LOGON_RESPONSE_EX 23
+#define LOGON_SAM_LOGON_RESPONSE 19
+#define NETLOGON_NT_VERSION_1 0x00000001
+#define NETLOGON_NT_VERSION_5 0x00000002
+#define NETLOGON_NT_VERSION_5EX 0x00000004
+
+#define TEST_FLAGS 0x0003f3fd
+
+void append_uint16(QByteArray *out, const unsigned int value) {
+    out->append((char) (value & 0xff));
+    out->append((char) ((value >> 8) & 0xff));
+}
+
+void append_uint32(QByteArray *out, const unsigned int value) {
+    append_uint16(out, value & 0xffff);
+    append_uint16(out, (value >> 16) & 0xffff);
+}
+
+// Encodes name as a sequence of DNS labels, without
+// compression
+void append_name(QByteArray *out, const QString &name) {
+    if (!name.isEmpty()) {
+        for (const QString &label : name.split('.')) {
+            const QByteArray label_bytes = label.toUtf8();
+
+            out->append((char) label_bytes.size());
+            out->append(label_bytes);
+        }
+    }
+
+    out->append('\0');
+}
+
+void ADMCTestAdDcLocator::parse_valid() {
+    const QByteArray blob = make_response(LOGON_SAM_LOGON_RESPONSE_EX, NETLOGON_NT_VERSION_1 | NETLOGON_NT_VERSION_5EX, "Branch");
+
+    AdNetlogonResponse response;
+    QVERIFY(netlogon_response_parse(blob, &response));
+
+    QCOMPARE(response.flags, TEST_FLAGS);
+    QCOMPARE(response.forest, QString("domain.alt"));
+    QCOMPARE(response.domain, QString("domain.alt"));
+    QCOMPARE(response.dc_host, QString("dc0.domain.alt"));
+    QCOMPARE(response.netbios_domain, QString("DOMAIN"));
+    QCOMPARE(response.netbios_computer, QString("DC0"));
+    QCOMPARE(response.dc_site, QString("Default-First-Site-Name"));
+    QCOMPARE(response.client_site, QString("Branch"));
+}
+
+// Client site is empty if client's subnet isn't assigned to
+// any site
+void ADMCTestAdDcLocator::parse_no_client_site() {
+    const QByteArray blob = make_response(LOGON_SAM_LOGON_RESPONSE_EX, NETLOGON_NT_VERSION_1 | NETLOGON_NT_VERSION_5EX, QString());
+
+    AdNetlogonResponse response;
+    QVERIFY(netlogon_response_parse(blob, &response));
+
+    QCOMPARE(response.dc_site, QString("Default-First-Site-Name"));
+    QCOMPARE(response.client_site, QString());
+}
+
+// Response cut at any point should fail to parse
+void ADMCTestAdDcLocator::parse_truncated() {
+    const QByteArray blob = make_response(LOGON_SAM_LOGON_RESPONSE_EX, NETLOGON_NT_VERSION_1 | NETLOGON_NT_VERSION_5EX, "Branch");
+
+    for (int size = 0; size < blob.size(); size++) {
+        AdNetlogonResponse response;
+        const bool parse_success = netlogon_response_parse(blob.left(size), &response);
+
+        QVERIFY2(!parse_success, qPrintable(QString("Parsed response truncated to %1 bytes").arg(size)));
+    }
+}
+
+void ADMCTestAdDcLocator::parse_bad_version() {
+    const QByteArray blob = make_response(LOGON_SAM_LOGON_RESPONSE_EX, NETLOGON_NT_VERSION_1 | NETLOGON_NT_VERSION_5, "Branch");
+
+    AdNetlogonResponse response;
+    QVERIFY(!netlogon_response_parse(blob, &response));
+}
+
+// Older response structures don't contain client site, so
+// they are rejected
+void ADMCTestAdDcLocator::parse_bad_opcode() {
+    const QByteArray blob = make_response(LOGON_SAM_LOGON_RESPONSE, NETLOGON_NT_VERSION_1 | NETLOGON_NT_VERSION_5EX, "Branch");
+
+    AdNetlogonResponse response;
+    QVERIFY(!netlogon_response_parse(blob, &response));
+}
+
+// Builds NETLOGON_SAM_LOGON_RESPONSE_EX, see MS-ADTS
+// 6.3.1.9. Domain name is compressed as a pointer to forest
+// name, like DC's do it.
+QByteArray ADMCTestAdDcLocator::make_response(const int opcode, const unsigned int nt_version, const QString &client_site) const {
+    QByteArray out;
+
+    append_uint16(&out, opcode);
+    append_uint16(&out, 0);
+    append_uint32(&out, TEST_FLAGS);
+    out.append(QByteArray(16, '\x11'));
+
+    const int forest_offset = out.size();
+    append_name(&out, "domain.alt");
+    out.append((char) 0xc0);
+    out.append((char) forest_offset);
+    append_name(&out, "dc0.domain.alt");
+    append_name(&out, "DOMAIN");
+    append_name(&out, "DC0");
+    // User name
+    append_name(&out, QString());
+    append_name(&out, "Default-First-Site-Name");
+    append_name(&out, client_site);
+
+    append_uint32(&out, nt_version);
+    append_uint16(&out, 0xffff);
+    append_uint16(&out, 0xffff);
+
+    return out;
+}
+
+QTEST_MAIN(ADMCTestAdDcLocator)
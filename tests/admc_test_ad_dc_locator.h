@@ -0,0 +1,46 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADMC_TEST_AD_DC_LOCATOR_H
+#define ADMC_TEST_AD_DC_LOCATOR_H
+
+/**
+ * Tests parsing of netlogon ping responses. Uses fixture
+ * responses, so doesn't need a domain to connect to.
+ */
+
+#include <QTest>
+
+#include "ad_dc_locator.h"
+
+class ADMCTestAdDcLocator : public QObject {
+    Q_OBJECT
+
+private slots:
+    void parse_valid();
+    void parse_no_client_site();
+    void parse_truncated();
+    void parse_bad_version();
+    void parse_bad_opcode();
+
+private:
+    QByteArray make_response(const int opcode, const unsigned int nt_version, const QString &client_site) const;
+};
+
+#endif /* ADMC_TEST_AD_DC_LOCATOR_H */
@@ -20,10 +20,22 @@
 
 #include "admc_test_ad_interface.h"
 
+#include "ad_dc_cache.h"
+#include "ad_dc_selector.h"
 #include "globals.h"
 #include "samba/dom_sid.h"
 
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
 #include <QTest>
+#include <QThread>
+#include <QThreadPool>
 
 #define TEST_GPO "ADMCTestAdInterface_TEST_GPO"
 
@@ -166,6 +178,47 @@ void ADMCTestAdInterface::object_move() {
     QVERIFY(object_exists(user_dn_after_move));
 }
 
+void ADMCTestAdInterface::object_delete_list() {
+    const QString user_dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool add_user_success = ad.object_add(user_dn, CLASS_USER);
+    QVERIFY(add_user_success);
+
+    // NOTE: ou has a child to check that it's deleted
+    // together with children
+    const QString ou_dn = test_object_dn(TEST_OU, CLASS_OU);
+    const bool add_ou_success = ad.object_add(ou_dn, CLASS_OU);
+    QVERIFY(add_ou_success);
+    const QString child_dn = dn_from_name_and_parent(TEST_GROUP, ou_dn, CLASS_GROUP);
+    const bool add_child_success = ad.object_add(child_dn, CLASS_GROUP);
+    QVERIFY(add_child_success);
+
+    const QString missing_dn = test_object_dn(TEST_GROUP, CLASS_GROUP);
+
+    const QList<QString> deleted_list = ad.object_delete_list({user_dn, ou_dn, missing_dn});
+    QCOMPARE(deleted_list, QList<QString>({user_dn, ou_dn}));
+    QVERIFY(!object_exists(user_dn));
+    QVERIFY(!object_exists(ou_dn));
+}
+
+void ADMCTestAdInterface::object_move_list() {
+    const QString user_dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool add_user_success = ad.object_add(user_dn, CLASS_USER);
+    QVERIFY(add_user_success);
+
+    const QString group_dn = test_object_dn(TEST_GROUP, CLASS_GROUP);
+    const bool add_group_success = ad.object_add(group_dn, CLASS_GROUP);
+    QVERIFY(add_group_success);
+
+    const QString ou_dn = test_object_dn(TEST_OU, CLASS_OU);
+    const bool add_ou_success = ad.object_add(ou_dn, CLASS_OU);
+    QVERIFY(add_ou_success);
+
+    const QList<QString> moved_list = ad.object_move_list({user_dn, group_dn}, ou_dn);
+    QCOMPARE(moved_list, QList<QString>({user_dn, group_dn}));
+    QVERIFY(object_exists(dn_move(user_dn, ou_dn)));
+    QVERIFY(object_exists(dn_move(group_dn, ou_dn)));
+}
+
 void ADMCTestAdInterface::object_rename() {
     const QString user_dn = test_object_dn(TEST_USER, CLASS_USER);
     const bool add_user_success = ad.object_add(user_dn, CLASS_USER);
@@ -259,4 +312,763 @@ void ADMCTestAdInterface::user_set_account_option() {
     }
 }
 
+void ADMCTestAdInterface::connection_pool_reuse() {
+    // Create and destroy an interface so that it's
+    // connection is returned to pool
+    {
+        AdInterface first_ad;
+        QVERIFY(first_ad.is_connected());
+    }
+
+    const AdConnectionPoolStats stats_before = AdInterface::connection_pool_stats();
+    QVERIFY(stats_before.idle_count > 0);
+
+    AdInterface second_ad;
+    QVERIFY(second_ad.is_connected());
+    QCOMPARE(second_ad.client_user(), ad.client_user());
+
+    const AdConnectionPoolStats stats_after = AdInterface::connection_pool_stats();
+    QCOMPARE(stats_after.hit_count, stats_before.hit_count + 1);
+    QCOMPARE(stats_after.idle_count, stats_before.idle_count - 1);
+    QCOMPARE(stats_after.connect_count, stats_before.connect_count);
+
+    // Pooled connection should be usable
+    const AdObject rootDSE = second_ad.search_object(ROOT_DSE);
+    QVERIFY(!rootDSE.is_empty());
+}
+
+class DcCacheRefreshThread final : public QThread {
+public:
+    QString srv_name;
+    QList<QString> hosts;
+
+    void run() override {
+        hosts = AdDcCache::instance()->refresh(srv_name);
+    }
+};
+
+// Writes a cache file containing one entry, in the format
+// used by AdDcCache
+void write_dc_cache_file(const QString &path, const QString &srv_name, const QList<QString> &hosts, const qint64 expires_at) {
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+
+    QDataStream stream(&file);
+    stream << (qint32) 1;
+    stream << (qint32) 1;
+    stream << srv_name << hosts << expires_at;
+}
+
+void ADMCTestAdInterface::dc_cache_expiry() {
+    AdDcCache *cache = AdDcCache::instance();
+
+    QTemporaryDir temp_dir;
+    QVERIFY(temp_dir.isValid());
+    const QString path = temp_dir.path() + "/dc_cache";
+
+    const QString srv_name = QString("_ldap._tcp.%1").arg(ad.get_domain());
+    const QList<QString> fake_hosts = {"ADMCTEST-dc.invalid"};
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // NOTE: entries are loaded from file, because that's
+    // the only way to set expiry time from outside
+    auto load_entry = [&](const qint64 expires_at) {
+        cache->set_persist_path(QString());
+        cache->clear();
+        write_dc_cache_file(path, srv_name, fake_hosts, expires_at);
+        cache->set_persist_path(path);
+    };
+
+    // Fresh entry is returned as is
+    load_entry(now + 60 * 60 * 1000);
+    QCOMPARE(cache->get_hosts(srv_name), fake_hosts);
+
+    // Expired entry is still returned, but is refreshed in
+    // background
+    load_entry(now - 1000);
+    QCOMPARE(cache->get_hosts(srv_name), fake_hosts);
+    QThreadPool::globalInstance()->waitForDone();
+    const QSet<QString> real_host_set = cache->get_hosts(srv_name).toSet();
+    QVERIFY(!real_host_set.isEmpty());
+    QVERIFY(!real_host_set.contains(fake_hosts[0]));
+
+    // Entry that expired too long ago is refreshed before
+    // returning
+    load_entry(now - (qint64) 2 * 24 * 60 * 60 * 1000);
+    QCOMPARE(cache->get_hosts(srv_name).toSet(), real_host_set);
+
+    // Concurrent refreshes of same name all get the result
+    // of the query
+    cache->set_persist_path(QString());
+    cache->clear();
+    QList<DcCacheRefreshThread *> thread_list;
+    for (int i = 0; i < 4; i++) {
+        DcCacheRefreshThread *thread = new DcCacheRefreshThread();
+        thread->srv_name = srv_name;
+        thread->start();
+        thread_list.append(thread);
+    }
+    for (DcCacheRefreshThread *thread : thread_list) {
+        thread->wait();
+        QCOMPARE(thread->hosts.toSet(), real_host_set);
+    }
+    qDeleteAll(thread_list);
+
+    cache->clear();
+}
+
+void ADMCTestAdInterface::dc_selector_latency() {
+    AdDcSelector *selector = AdDcSelector::instance();
+    selector->clear();
+
+    const QString dc = "dc.test";
+
+    // Without samples, default delay is used
+    QCOMPARE(selector->latency_percentile(dc, 50), (qint64) -1);
+    const qint64 default_delay = selector->hedge_delay_msec(dc);
+    QVERIFY(default_delay > 0);
+
+    // Once there are enough samples, delay follows their
+    // percentile
+    for (int i = 1; i <= 100; i++) {
+        selector->record_latency(dc, i);
+    }
+    QCOMPARE(selector->latency_percentile(dc, 0), (qint64) 1);
+    QCOMPARE(selector->latency_percentile(dc, 100), (qint64) 100);
+    selector->set_hedge_percentile(90);
+    QCOMPARE(selector->hedge_delay_msec(dc), selector->latency_percentile(dc, 90));
+
+    // Old samples are replaced by new ones
+    for (int i = 0; i < 100; i++) {
+        selector->record_latency(dc, 1000);
+    }
+    QCOMPARE(selector->latency_percentile(dc, 0), (qint64) 1000);
+
+    selector->clear();
+}
+
+// NOTE: can't make primary DC slow in a test, so this
+// only checks that reads with hedging enabled return
+// same results and record latency of the DC that responded
+void ADMCTestAdInterface::hedged_read() {
+    AdDcSelector *selector = AdDcSelector::instance();
+    const bool hedging_was_enabled = selector->hedging_enabled();
+    selector->clear();
+    selector->set_hedging_enabled(true);
+
+    const QString domain_dn = g_adconfig->domain_dn();
+    const AdObject object = ad.search_object(domain_dn, {ATTRIBUTE_DN});
+
+    selector->set_hedging_enabled(hedging_was_enabled);
+
+    QVERIFY(!object.is_empty());
+    QCOMPARE(object.get_dn(), domain_dn);
+    QVERIFY(selector->latency_percentile(ad.get_dc(), 50) >= 0);
+
+    selector->clear();
+}
+
+void ADMCTestAdInterface::search_small_pages() {
+    const int object_count = 25;
+    for (int i = 0; i < object_count; i++) {
+        const QString name = QString("%1-%2").arg(TEST_USER).arg(i);
+        const QString dn = test_object_dn(name, CLASS_USER);
+
+        const bool create_success = ad.object_add(dn, CLASS_USER);
+        QVERIFY2(create_success, "Failed to create object");
+    }
+
+    // Pages of 10 entries, growing in adaptive mode,
+    // should still return all objects
+    AdInterface::set_page_size(10);
+    AdInterface::set_adaptive_page_size(true);
+
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_USER);
+    const QHash<QString, AdObject> results = ad.search(test_arena_dn(), SearchScope_Children, filter, {ATTRIBUTE_DN});
+
+    AdInterface::set_page_size(100);
+    AdInterface::set_adaptive_page_size(false);
+
+    QCOMPARE(results.size(), object_count);
+}
+
+void ADMCTestAdInterface::search_async() {
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool create_success = ad.object_add(dn, CLASS_USER);
+    QVERIFY2(create_success, "Failed to create object");
+
+    // Two searches running at the same time should both
+    // return their results
+    const int arena_id = ad.search_async(test_arena_dn(), SearchScope_Children, QString(), {ATTRIBUTE_DN});
+    const int object_id = ad.search_async(dn, SearchScope_Object, QString(), {ATTRIBUTE_DN});
+    QVERIFY(arena_id != -1);
+    QVERIFY(object_id != -1);
+
+    QHash<int, QHash<QString, AdObject>> results_map;
+    QHash<int, bool> finished_map;
+    while (ad.search_async_count() > 0) {
+        ad.search_async_poll(1000, &results_map, &finished_map);
+    }
+
+    QVERIFY(finished_map.value(arena_id));
+    QVERIFY(finished_map.value(object_id));
+    QVERIFY(results_map[arena_id].contains(dn));
+    QCOMPARE(results_map[object_id].keys(), QList<QString>({dn}));
+
+    // Abandoned search shouldn't return anything
+    const int abandoned_id = ad.search_async(test_arena_dn(), SearchScope_Children, QString(), {ATTRIBUTE_DN});
+    ad.search_async_abandon(abandoned_id);
+    QCOMPARE(ad.search_async_count(), 0);
+
+    results_map.clear();
+    finished_map.clear();
+    ad.search_async_poll(100, &results_map, &finished_map);
+    QVERIFY(!results_map.contains(abandoned_id));
+    QVERIFY(!finished_map.contains(abandoned_id));
+}
+
+void ADMCTestAdInterface::search_visit() {
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool create_success = ad.object_add(dn, CLASS_USER);
+    QVERIFY2(create_success, "Failed to create object");
+
+    const QString dn_2 = test_object_dn(TEST_USER_LOGON, CLASS_USER);
+    const bool create_2_success = ad.object_add(dn_2, CLASS_USER);
+    QVERIFY2(create_2_success, "Failed to create object");
+
+    // Visitor should see the same entries as search()
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_OBJECT_CLASS, CLASS_USER);
+    const QList<QString> attributes = {ATTRIBUTE_NAME};
+    const QHash<QString, AdObject> results = ad.search(test_arena_dn(), SearchScope_Children, filter, attributes);
+
+    QHash<QString, QString> visited_map;
+    const bool visit_success = ad.search_visit(test_arena_dn(), SearchScope_Children, filter, attributes, [&](const AdEntryView &entry) {
+        visited_map[entry.get_dn()] = entry.get_string(ATTRIBUTE_NAME);
+
+        return true;
+    });
+    QVERIFY(visit_success);
+    QCOMPARE(visited_map.keys().toSet(), results.keys().toSet());
+    QCOMPARE(visited_map[dn], results[dn].get_string(ATTRIBUTE_NAME));
+
+    // Returning false should stop the search
+    int visit_count = 0;
+    const bool stop_success = ad.search_visit(test_arena_dn(), SearchScope_Children, filter, attributes, [&](const AdEntryView &) {
+        visit_count++;
+
+        return false;
+    });
+    QVERIFY(stop_success);
+    QCOMPARE(visit_count, 1);
+
+    // Handle should still work after stopping
+    const AdObject object = ad.search_object(dn_2);
+    QVERIFY(!object.is_empty());
+}
+
+// Getters that take attribute id's should return same
+// data as the ones that take names
+void ADMCTestAdInterface::attribute_ids() {
+    const QList<QString> attribute_list = {
+        ATTRIBUTE_MEMBER,
+        ATTRIBUTE_MEMBER_OF,
+        ATTRIBUTE_OBJECT_SID,
+        ATTRIBUTE_PWD_LAST_SET,
+        ATTRIBUTE_SAM_ACCOUNT_NAME,
+        ATTRIBUTE_USER_ACCOUNT_CONTROL,
+    };
+
+    for (const QString &attribute : attribute_list) {
+        const int id = g_adconfig->get_attribute_id(attribute);
+        QVERIFY2(id != ATTRIBUTE_ID_NONE, qPrintable(attribute));
+
+        QCOMPARE(g_adconfig->get_attribute_type(id), g_adconfig->get_attribute_type(attribute));
+        QCOMPARE(g_adconfig->get_attribute_large_integer_subtype(id), g_adconfig->get_attribute_large_integer_subtype(attribute));
+        QCOMPARE(g_adconfig->get_attribute_is_number(id), g_adconfig->get_attribute_is_number(attribute));
+        QCOMPARE(g_adconfig->get_attribute_is_single_valued(id), g_adconfig->get_attribute_is_single_valued(attribute));
+        QCOMPARE(g_adconfig->get_attribute_is_system_only(id), g_adconfig->get_attribute_is_system_only(attribute));
+        QCOMPARE(g_adconfig->get_attribute_range_upper(id), g_adconfig->get_attribute_range_upper(attribute));
+        QCOMPARE(g_adconfig->get_attribute_is_backlink(id), g_adconfig->get_attribute_is_backlink(attribute));
+        QCOMPARE(g_adconfig->get_attribute_is_constructed(id), g_adconfig->get_attribute_is_constructed(attribute));
+    }
+
+    // Check some values against what is known about
+    // default schema
+    const int member_id = g_adconfig->get_attribute_id(ATTRIBUTE_MEMBER);
+    QCOMPARE(g_adconfig->get_attribute_type(member_id), AttributeType_DSDN);
+    QVERIFY(!g_adconfig->get_attribute_is_single_valued(member_id));
+    QVERIFY(!g_adconfig->get_attribute_is_backlink(member_id));
+    QVERIFY(g_adconfig->get_attribute_is_backlink(g_adconfig->get_attribute_id(ATTRIBUTE_MEMBER_OF)));
+    QCOMPARE(g_adconfig->get_attribute_type(g_adconfig->get_attribute_id(ATTRIBUTE_OBJECT_SID)), AttributeType_Sid);
+    QCOMPARE(g_adconfig->get_attribute_large_integer_subtype(g_adconfig->get_attribute_id(ATTRIBUTE_PWD_LAST_SET)), LargeIntegerSubtype_Datetime);
+    QVERIFY(g_adconfig->get_attribute_is_number(g_adconfig->get_attribute_id(ATTRIBUTE_USER_ACCOUNT_CONTROL)));
+
+    QCOMPARE(g_adconfig->get_attribute_id("ADMCTEST-not-in-schema"), ATTRIBUTE_ID_NONE);
+
+    // Column id's should match column names
+    const QList<QString> column_list = g_adconfig->get_columns();
+    const QList<int> column_id_list = g_adconfig->get_column_ids();
+    QCOMPARE(column_id_list.size(), column_list.size());
+    for (int i = 0; i < column_list.size(); i++) {
+        QCOMPARE(column_id_list[i], g_adconfig->get_attribute_id(column_list[i]));
+    }
+
+    // Object getters that take id's should match the ones
+    // that take names
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool create_success = ad.object_add(dn, CLASS_USER);
+    QVERIFY2(create_success, "Failed to create object");
+
+    const AdObject object = ad.search_object(dn);
+    for (const QString &attribute : object.attributes()) {
+        const int id = g_adconfig->get_attribute_id(attribute);
+        if (id == ATTRIBUTE_ID_NONE) {
+            continue;
+        }
+
+        QVERIFY(object.contains(id));
+        QCOMPARE(object.get_values(id), object.get_values(attribute));
+        QCOMPARE(object.get_value_count(id), object.get_value_count(attribute));
+        QCOMPARE(object.get_value_view(id), object.get_value(attribute));
+    }
+
+    QVERIFY(!object.contains(g_adconfig->get_attribute_id(ATTRIBUTE_MANAGER)));
+}
+
+void ADMCTestAdInterface::search_objects() {
+    const QString user_dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool user_create_success = ad.object_add(user_dn, CLASS_USER);
+    QVERIFY2(user_create_success, "Failed to create object");
+
+    const QString ou_dn = test_object_dn(TEST_OU, CLASS_OU);
+    const bool ou_create_success = ad.object_add(ou_dn, CLASS_OU);
+    QVERIFY2(ou_create_success, "Failed to create object");
+
+    const QString missing_dn = test_object_dn(TEST_GROUP, CLASS_GROUP);
+
+    const QList<QString> dn_list = {user_dn, missing_dn, ou_dn};
+    const QHash<QString, AdObject> results = ad.search_objects(dn_list, {ATTRIBUTE_NAME});
+
+    QCOMPARE(results.keys().toSet(), QSet<QString>({user_dn, ou_dn}));
+    QCOMPARE(results[user_dn].get_string(ATTRIBUTE_NAME), QString(TEST_USER));
+    QCOMPARE(results[ou_dn].get_string(ATTRIBUTE_NAME), QString(TEST_OU));
+    QVERIFY(!results[user_dn].contains(ATTRIBUTE_OBJECT_CLASS));
+}
+
+void ADMCTestAdInterface::bulk_run() {
+    const QString user_dn = test_object_dn(TEST_USER, CLASS_USER);
+    const QString user_2_dn = test_object_dn(TEST_USER_LOGON, CLASS_USER);
+    const QString group_dn = test_object_dn(TEST_GROUP, CLASS_GROUP);
+    const QString missing_dn = test_object_dn(TEST_OU, CLASS_OU);
+
+    const AdBulkMod class_mod = ad_bulk_mod(AdBulkModType_Add, ATTRIBUTE_OBJECT_CLASS, {CLASS_USER});
+    const AdBulkMod member_mod = ad_bulk_mod(AdBulkModType_Add, ATTRIBUTE_MEMBER, {user_dn.toUtf8()});
+    const AdBulkMod description_mod = ad_bulk_mod(AdBulkModType_Replace, ATTRIBUTE_DESCRIPTION, {"test"});
+
+    const QList<AdBulkOp> op_list = {
+        ad_bulk_add(user_dn, {class_mod}),
+        ad_bulk_add(user_2_dn, {class_mod}),
+        ad_bulk_add(group_dn, {ad_bulk_mod(AdBulkModType_Add, ATTRIBUTE_OBJECT_CLASS, {CLASS_GROUP})}),
+        ad_bulk_modify(group_dn, {member_mod}),
+        ad_bulk_modify(missing_dn, {description_mod}),
+        ad_bulk_delete(user_2_dn),
+    };
+
+    int progress_count = 0;
+    const QList<AdBulkResult> result_list = ad.bulk_run(op_list, false, [&](const int done_count, const int total_count) {
+        progress_count = done_count;
+        QCOMPARE(total_count, op_list.size());
+    });
+
+    QCOMPARE(progress_count, op_list.size());
+    QCOMPARE(result_list.size(), op_list.size());
+    QVERIFY(result_list[0].success);
+    QVERIFY(result_list[1].success);
+    QVERIFY(result_list[2].success);
+    QVERIFY(result_list[3].success);
+    QVERIFY(!result_list[4].success);
+    QVERIFY(!result_list[4].error.isEmpty());
+    QVERIFY(result_list[5].success);
+
+    QVERIFY(object_exists(user_dn));
+    QVERIFY(!object_exists(user_2_dn));
+    const AdObject group = ad.search_object(group_dn, {ATTRIBUTE_MEMBER});
+    QCOMPARE(group.get_strings(ATTRIBUTE_MEMBER), QList<QString>({user_dn}));
+
+    // Operations after first error shouldn't be sent.
+    // Requests that were already in flight still finish,
+    // so use enough of them to fill the window.
+    QList<AdBulkOp> stop_op_list;
+    for (int i = 0; i < 1000; i++) {
+        stop_op_list.append(ad_bulk_modify(missing_dn, {description_mod}));
+    }
+    stop_op_list.append(ad_bulk_delete(user_dn));
+
+    const QList<AdBulkResult> stop_result_list = ad.bulk_run(stop_op_list, true);
+    QVERIFY(!stop_result_list.first().success);
+    QVERIFY(!stop_result_list.last().done);
+    QVERIFY(object_exists(user_dn));
+}
+
+void ADMCTestAdInterface::search_window() {
+    if (!ad.window_search_supported()) {
+        QSKIP("Server doesn't support window search");
+    }
+
+    // NOTE: create users in reverse order to check that
+    // results are sorted by server
+    QList<QString> name_list;
+    for (int i = 4; i >= 0; i--) {
+        const QString name = QString("%1-%2").arg(TEST_USER).arg(i);
+        const QString dn = test_object_dn(name, CLASS_USER);
+        const bool create_success = ad.object_add(dn, CLASS_USER);
+        QVERIFY2(create_success, "Failed to create object");
+
+        name_list.prepend(name);
+    }
+
+    int content_count = 0;
+    QList<AdObject> results;
+    const bool success = ad.search_window(test_arena_dn(), SearchScope_Children, QString(), {ATTRIBUTE_NAME}, ATTRIBUTE_NAME, 1, 2, &results, &content_count);
+    QVERIFY(success);
+    QCOMPARE(content_count, name_list.size());
+    QCOMPARE(results.size(), 2);
+    QCOMPARE(results[0].get_string(ATTRIBUTE_NAME), name_list[1]);
+    QCOMPARE(results[1].get_string(ATTRIBUTE_NAME), name_list[2]);
+
+    // Window past the end is cut short
+    QList<AdObject> last_results;
+    const bool last_success = ad.search_window(test_arena_dn(), SearchScope_Children, QString(), {ATTRIBUTE_NAME}, ATTRIBUTE_NAME, 4, 2, &last_results, &content_count);
+    QVERIFY(last_success);
+    QCOMPARE(last_results.size(), 1);
+    QCOMPARE(last_results[0].get_string(ATTRIBUTE_NAME), name_list[4]);
+
+    // Async window is returned whole, not in results
+    const int window_id = ad.search_async_window(test_arena_dn(), SearchScope_Children, QString(), {ATTRIBUTE_NAME}, ATTRIBUTE_NAME, 1, 2, 0);
+    QVERIFY(window_id != -1);
+
+    QHash<int, QHash<QString, AdObject>> results_map;
+    QHash<int, bool> finished_map;
+    while (ad.search_async_count() > 0) {
+        ad.search_async_poll(1000, &results_map, &finished_map);
+    }
+
+    QVERIFY(finished_map.value(window_id));
+    QVERIFY(!results_map.contains(window_id));
+
+    QList<AdObject> async_results;
+    int async_content_count = 0;
+    const bool take_success = ad.search_async_take_window(window_id, &async_results, &async_content_count);
+    QVERIFY(take_success);
+    QCOMPARE(async_content_count, name_list.size());
+    QCOMPARE(async_results.size(), 2);
+    QCOMPARE(async_results[0].get_string(ATTRIBUTE_NAME), name_list[1]);
+    QCOMPARE(async_results[1].get_string(ATTRIBUTE_NAME), name_list[2]);
+}
+
+void ADMCTestAdInterface::search_visit_deleted() {
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool create_success = ad.object_add(dn, CLASS_USER);
+    QVERIFY2(create_success, "Failed to create object");
+
+    const AdObject object = ad.search_object(dn, {ATTRIBUTE_OBJECT_GUID, ATTRIBUTE_USN_CHANGED});
+    const QByteArray guid = object.get_value(ATTRIBUTE_OBJECT_GUID);
+    const QString usn = object.get_string(ATTRIBUTE_USN_CHANGED);
+
+    const bool delete_success = ad.object_delete(dn);
+    QVERIFY2(delete_success, "Failed to delete object");
+
+    // Tombstone of deleted object should be visible when
+    // searching for changes after creation
+    const QString filter = QString("(%1>=%2)").arg(ATTRIBUTE_USN_CHANGED, usn);
+    const QList<QString> attributes = {ATTRIBUTE_OBJECT_GUID, ATTRIBUTE_IS_DELETED};
+
+    bool found_tombstone = false;
+    const bool visit_success = ad.search_visit_deleted(g_adconfig->domain_dn(), SearchScope_All, filter, attributes, [&](const AdEntryView &entry) {
+        if (entry.get_value(ATTRIBUTE_OBJECT_GUID) == guid) {
+            found_tombstone = (entry.get_string(ATTRIBUTE_IS_DELETED) == LDAP_BOOL_TRUE);
+
+            return false;
+        }
+
+        return true;
+    });
+    QVERIFY(visit_success);
+    QVERIFY(found_tombstone);
+
+    // Regular search shouldn't see it
+    bool found_regular = false;
+    ad.search_visit(g_adconfig->domain_dn(), SearchScope_All, filter, attributes, [&](const AdEntryView &entry) {
+        if (entry.get_value(ATTRIBUTE_OBJECT_GUID) == guid) {
+            found_regular = true;
+        }
+
+        return true;
+    });
+    QVERIFY(!found_regular);
+}
+
+void ADMCTestAdInterface::search_async_notify() {
+    const int search_id = ad.search_async_notify(test_arena_dn(), SearchScope_Children, {ATTRIBUTE_OBJECT_GUID});
+    QVERIFY(search_id != -1);
+
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool create_success = ad.object_add(dn, CLASS_USER);
+    QVERIFY2(create_success, "Failed to create object");
+
+    // Notification for created object should arrive
+    // shortly after creation
+    bool got_notification = false;
+    for (int i = 0; i < 100 && !got_notification; i++) {
+        QHash<int, QHash<QString, AdObject>> results_map;
+        QHash<int, bool> finished_map;
+        ad.search_async_poll(50, &results_map, &finished_map);
+
+        QVERIFY(!finished_map.contains(search_id));
+
+        got_notification = results_map.value(search_id).contains(dn);
+    }
+
+    ad.search_async_abandon(search_id);
+
+    QVERIFY(got_notification);
+}
+
+void ADMCTestAdInterface::attribute_parse_range() {
+    QString attribute;
+    int low;
+    int high;
+
+    QVERIFY(::attribute_parse_range("member;range=0-1499", &attribute, &low, &high));
+    QCOMPARE(attribute, QString("member"));
+    QCOMPARE(low, 0);
+    QCOMPARE(high, 1499);
+
+    QVERIFY(::attribute_parse_range("member;range=1500-*", &attribute, &low, &high));
+    QCOMPARE(low, 1500);
+    QCOMPARE(high, -1);
+
+    QVERIFY(!::attribute_parse_range("member", &attribute, &low, &high));
+    QVERIFY(!::attribute_parse_range("member;range=abc", &attribute, &low, &high));
+}
+
+void ADMCTestAdInterface::search_options() {
+    const QString user_dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool create_user_success = ad.object_add(user_dn, CLASS_USER);
+    QVERIFY2(create_user_success, "Failed to create object");
+
+    const QString ou_dn = test_object_dn(TEST_OU, CLASS_OU);
+    const bool create_ou_success = ad.object_add(ou_dn, CLASS_OU);
+    QVERIFY2(create_ou_success, "Failed to create object");
+
+    // Size limit
+    SearchOptions size_options;
+    size_options.size_limit = 1;
+    const QHash<QString, AdObject> size_results = ad.search(test_arena_dn(), SearchScope_Children, QString(), {ATTRIBUTE_DN}, size_options);
+    QCOMPARE(size_results.size(), 1);
+
+    // Attrs only
+    SearchOptions attrs_only_options;
+    attrs_only_options.attrs_only = true;
+    const AdObject object = ad.search_object(user_dn, {ATTRIBUTE_DN}, attrs_only_options);
+    QVERIFY(!object.is_empty());
+    QVERIFY(object.contains(ATTRIBUTE_DN));
+    QVERIFY(object.get_values(ATTRIBUTE_DN).isEmpty());
+}
+
+void ADMCTestAdInterface::metrics() {
+    QCOMPARE(AdMetrics::filter_template("(&(objectClass=user)(cn=test))"), QString("(&(objectClass=?)(cn=?))"));
+    QCOMPARE(AdMetrics::filter_template("(mail=*)"), QString("(mail=*)"));
+
+    AdMetrics *metrics = AdMetrics::instance();
+    metrics->reset();
+    metrics->set_enabled(true);
+
+    {
+        const AdMetricsAction action("test");
+        ad.search(test_arena_dn(), SearchScope_Children, "(cn=abc)", {ATTRIBUTE_DN});
+        ad.search(test_arena_dn(), SearchScope_Children, "(cn=def)", {ATTRIBUTE_DN});
+    }
+
+    metrics->set_enabled(false);
+
+    // Both searches should end up in one group
+    const QList<AdMetricsEntry> entry_list = metrics->snapshot();
+    QCOMPARE(entry_list.size(), 1);
+
+    const AdMetricsEntry entry = entry_list[0];
+    QCOMPARE(entry.op, AdMetricsOp_Search);
+    QCOMPARE(entry.action, QString("test"));
+    QCOMPARE(entry.base, test_arena_dn());
+    QCOMPARE(entry.filter_template, QString("(cn=?)"));
+    QCOMPARE(entry.count, 2);
+    QCOMPARE(entry.error_count, 0);
+
+    metrics->reset();
+}
+
+void ADMCTestAdInterface::trace() {
+    AdTrace *trace = AdTrace::instance();
+    trace->start();
+
+    ad.search(test_arena_dn(), SearchScope_Children, "(cn=abc)", {ATTRIBUTE_DN});
+
+    trace->stop();
+
+    // Spans recorded after stop should be ignored
+    ad.search(test_arena_dn(), SearchScope_Children, "(cn=def)", {ATTRIBUTE_DN});
+
+    const QJsonDocument document = QJsonDocument::fromJson(trace->to_json());
+    QVERIFY(document.isObject());
+
+    const QJsonArray event_array = document.object()["traceEvents"].toArray();
+
+    int search_count = 0;
+    bool found_thread_name = false;
+    for (const QJsonValue &value : event_array) {
+        const QJsonObject event = value.toObject();
+        const QString phase = event["ph"].toString();
+
+        if (phase == "M") {
+            found_thread_name = true;
+        } else if (phase == "X" && event["name"].toString() == "search") {
+            search_count++;
+
+            QCOMPARE(event["cat"].toString(), QString("ldap"));
+            QVERIFY(event["dur"].toDouble() >= 0);
+        }
+    }
+
+    QCOMPARE(search_count, 1);
+    QVERIFY(found_thread_name);
+}
+
+void ADMCTestAdInterface::search_global_catalog() {
+    const QString user_dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool create_user_success = ad.object_add(user_dn, CLASS_USER);
+    QVERIFY2(create_user_success, "Failed to create object");
+
+    AdInterface gc(AdServer_GlobalCatalog);
+    QVERIFY(gc.is_connected());
+    QCOMPARE(gc.server(), AdServer_GlobalCatalog);
+
+    // Empty base searches whole forest
+    const QString filter = filter_CONDITION(Condition_Equals, ATTRIBUTE_DN, user_dn);
+    const QHash<QString, AdObject> results = gc.search(QString(), SearchScope_All, filter, {ATTRIBUTE_DN, ATTRIBUTE_OBJECT_CLASS});
+    QVERIFY(results.contains(user_dn));
+}
+
+void ADMCTestAdInterface::config_cache() {
+    QTemporaryDir cache_dir;
+    QVERIFY(cache_dir.isValid());
+
+    AdConfig::set_cache_path(cache_dir.path());
+
+    // First load downloads and saves the cache, second
+    // load reads it back
+    AdConfig downloaded_config;
+    downloaded_config.load(ad, QLocale(QLocale::English));
+
+    AdConfig cached_config;
+    cached_config.load(ad, QLocale(QLocale::English));
+
+    AdConfig::set_cache_path(QString());
+
+    QVERIFY(!QDir(cache_dir.path()).isEmpty());
+    QCOMPARE(cached_config.get_columns(), downloaded_config.get_columns());
+    QCOMPARE(cached_config.get_filter_containers(), downloaded_config.get_filter_containers());
+    QCOMPARE(cached_config.get_attribute_display_name(ATTRIBUTE_DESCRIPTION, CLASS_USER), downloaded_config.get_attribute_display_name(ATTRIBUTE_DESCRIPTION, CLASS_USER));
+    QCOMPARE(cached_config.get_attribute_is_single_valued(ATTRIBUTE_MEMBER), downloaded_config.get_attribute_is_single_valued(ATTRIBUTE_MEMBER));
+}
+
+void ADMCTestAdInterface::permissionable_attributes() {
+    // Compare locally derived attributes to what server
+    // returns in constructed allowedAttributes of a user.
+    // NOTE: must read it from an instance of the class.
+    // On the classSchema object, allowedAttributes lists
+    // attributes allowed on the schema entry itself.
+    const QString dn = test_object_dn(TEST_USER, CLASS_USER);
+    const bool create_success = ad.object_add(dn, CLASS_USER);
+    QVERIFY2(create_success, "Failed to create object");
+
+    const AdObject user = ad.search_object(dn, {"allowedAttributes"});
+    QVERIFY(!user.is_empty());
+
+    QStringList expected;
+    for (const QString &attribute : user.get_strings("allowedAttributes")) {
+        if (g_adconfig->get_attribute_is_backlink(attribute) || g_adconfig->get_attribute_is_constructed(attribute) || g_adconfig->get_attribute_is_system_only(attribute)) {
+            continue;
+        }
+
+        expected.append(attribute);
+    }
+    expected.removeDuplicates();
+    expected.sort();
+
+    const QStringList permissionable = g_adconfig->get_permissionable_attributes(CLASS_USER);
+    QVERIFY(permissionable.contains(ATTRIBUTE_DESCRIPTION));
+    QCOMPARE(permissionable, expected);
+}
+
+void ADMCTestAdInterface::config_parallel_load() {
+    AdConfig::set_parallel_load_enabled(false);
+    AdConfig sequential_config;
+    sequential_config.load(ad, QLocale(QLocale::English));
+
+    AdConfig::set_parallel_load_enabled(true);
+    AdConfig parallel_config;
+    parallel_config.load(ad, QLocale(QLocale::English));
+
+    AdConfig::set_parallel_load_enabled(false);
+
+    QCOMPARE(parallel_config.get_columns(), sequential_config.get_columns());
+    QCOMPARE(parallel_config.get_filter_containers(), sequential_config.get_filter_containers());
+    QCOMPARE(parallel_config.get_attribute_display_name(ATTRIBUTE_DESCRIPTION, CLASS_USER), sequential_config.get_attribute_display_name(ATTRIBUTE_DESCRIPTION, CLASS_USER));
+
+    // Deferred phases are waited for by accessors
+    QStringList parallel_rights = parallel_config.get_extended_rights_list({CLASS_USER});
+    QStringList sequential_rights = sequential_config.get_extended_rights_list({CLASS_USER});
+    parallel_rights.sort();
+    sequential_rights.sort();
+    QVERIFY(!parallel_rights.isEmpty());
+    QCOMPARE(parallel_rights, sequential_rights);
+    QCOMPARE(parallel_config.get_permissionable_attributes(CLASS_USER), sequential_config.get_permissionable_attributes(CLASS_USER));
+
+    const QHash<QString, qint64> phase_time_map = parallel_config.get_phase_times();
+    QVERIFY(phase_time_map.contains("download_class_schemas"));
+    QVERIFY(phase_time_map.contains("deferred_total"));
+}
+
+void ADMCTestAdInterface::schema_index() {
+    const QList<QString> user_classes = {CLASS_TOP, CLASS_PERSON, CLASS_ORG_PERSON, CLASS_USER};
+
+    const QList<QString> mandatory = g_adconfig->get_mandatory_attributes(user_classes);
+    QVERIFY(mandatory.contains(ATTRIBUTE_OBJECT_CLASS));
+    QVERIFY(!mandatory.contains(ATTRIBUTE_DESCRIPTION));
+
+    const QList<QString> optional = g_adconfig->get_optional_attributes(user_classes);
+    QVERIFY(optional.contains(ATTRIBUTE_DESCRIPTION));
+    QCOMPARE(optional.toSet().size(), optional.size());
+
+    const QList<QString> superiors = g_adconfig->get_possible_superiors({CLASS_USER});
+    QVERIFY(superiors.contains(CLASS_OU));
+    QVERIFY(superiors.contains(CLASS_CONTAINER));
+
+    // Inferiors go two levels deep, so possible inferiors
+    // of an OU are also inferiors of domain
+    const QList<QString> domain_inferiors = g_adconfig->all_inferiors_list(CLASS_DOMAIN);
+    QVERIFY(domain_inferiors.contains(CLASS_OU));
+    for (const QString &ou_inferior : g_adconfig->get_possible_inferiors(CLASS_OU)) {
+        QVERIFY(domain_inferiors.contains(ou_inferior));
+    }
+
+    // Transitive inferiors go all the way down
+    const QList<QString> domain_transitive_inferiors = g_adconfig->transitive_inferiors_list(CLASS_DOMAIN);
+    for (const QString &ou_inferior : g_adconfig->transitive_inferiors_list(CLASS_OU)) {
+        QVERIFY(domain_transitive_inferiors.contains(ou_inferior));
+    }
+
+    QVERIFY(g_adconfig->get_optional_attributes({"notAClass"}).isEmpty());
+}
+
 QTEST_MAIN(ADMCTestAdInterface)
@@ -35,6 +35,8 @@ private slots:
     void object_add();
     void object_delete();
     void object_move();
+    void object_delete_list();
+    void object_move_list();
     void object_rename();
 
     void group_add_member();
@@ -44,6 +46,29 @@ private slots:
 
     void user_set_account_option();
 
+    void connection_pool_reuse();
+    void dc_cache_expiry();
+    void dc_selector_latency();
+    void hedged_read();
+    void search_small_pages();
+    void search_async();
+    void search_visit();
+    void attribute_ids();
+    void search_objects();
+    void bulk_run();
+    void search_window();
+    void search_visit_deleted();
+    void search_async_notify();
+    void attribute_parse_range();
+    void search_options();
+    void metrics();
+    void trace();
+    void search_global_catalog();
+    void config_cache();
+    void permissionable_attributes();
+    void config_parallel_load();
+    void schema_index();
+
 private:
 };
 
@@ -0,0 +1,244 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "admc_test_ad_object.h"
+
+#include <QThread>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#define BENCHMARK_OBJECT_COUNT 100000
+
+// Returns amount of heap memory currently in use, or 0
+// if it can't be measured on this platform
+size_t heap_used() {
+#if defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 33)
+    const struct mallinfo2 info = mallinfo2();
+
+    return info.uordblks;
+#else
+    const struct mallinfo info = mallinfo();
+
+    return (size_t) info.uordblks;
+#endif
+#else
+    return 0;
+#endif
+}
+
+void ADMCTestAdObject::load() {
+    const QHash<QString, QList<QByteArray>> data = make_user_data(0);
+    const QString dn = make_user_dn(0);
+
+    AdObject object;
+    QVERIFY(object.is_empty());
+
+    object.load(dn, data);
+    QVERIFY(!object.is_empty());
+    QCOMPARE(object.get_dn(), dn);
+    QCOMPARE(object.get_attributes_data(), data);
+    QCOMPARE(object.attributes().toSet(), data.keys().toSet());
+
+    QVERIFY(object.contains(ATTRIBUTE_SAM_ACCOUNT_NAME));
+    QVERIFY(!object.contains(ATTRIBUTE_MANAGER));
+    QVERIFY(!object.contains("ADMCTEST-never-interned"));
+
+    QCOMPARE(object.get_values(ATTRIBUTE_MEMBER_OF), data[ATTRIBUTE_MEMBER_OF]);
+    QCOMPARE(object.get_value_count(ATTRIBUTE_MEMBER_OF), 2);
+    QCOMPARE(object.get_string(ATTRIBUTE_OBJECT_CLASS), QString(CLASS_USER));
+    QCOMPARE(object.get_int(ATTRIBUTE_USER_ACCOUNT_CONTROL), 512);
+    QCOMPARE(object.get_value(ATTRIBUTE_OBJECT_GUID), data[ATTRIBUTE_OBJECT_GUID].first());
+    QCOMPARE(object.get_value(ATTRIBUTE_MANAGER), QByteArray());
+}
+
+void ADMCTestAdObject::copy_shares_data() {
+    AdObject object;
+    object.load(make_user_dn(0), make_user_data(0));
+
+    const AdObject copy = object;
+    QCOMPARE(copy.get_value_view(ATTRIBUTE_CN).constData(), object.get_value_view(ATTRIBUTE_CN).constData());
+
+    // Reloading shouldn't affect copies
+    object.load(make_user_dn(1), make_user_data(1));
+    QCOMPARE(copy.get_dn(), make_user_dn(0));
+    QCOMPARE(copy.get_string(ATTRIBUTE_CN), QString("user0"));
+}
+
+// NOTE: baseline is the layout that objects used to have,
+// a hash of attribute names to lists of separately
+// allocated values, with names allocated per object like
+// they are when read from LDAP messages
+void ADMCTestAdObject::memory_per_object() {
+    if (heap_used() == 0) {
+        QSKIP("Heap usage can't be measured on this platform");
+    }
+
+    auto make_baseline = [&](const int index) {
+        QHash<QString, QList<QByteArray>> out;
+
+        const QHash<QString, QList<QByteArray>> data = make_user_data(index);
+        for (auto it = data.begin(); it != data.end(); it++) {
+            const QString attribute = QString::fromUtf8(it.key().toUtf8());
+
+            QList<QByteArray> values;
+            for (const QByteArray &value : it.value()) {
+                values.append(QByteArray(value.constData(), value.size()));
+            }
+
+            out[attribute] = values;
+        }
+
+        return out;
+    };
+
+    size_t baseline_bytes = 0;
+    {
+        QList<QHash<QString, QList<QByteArray>>> baseline_list;
+        QList<QString> dn_list;
+        baseline_list.reserve(BENCHMARK_OBJECT_COUNT);
+        dn_list.reserve(BENCHMARK_OBJECT_COUNT);
+
+        const size_t before = heap_used();
+        for (int i = 0; i < BENCHMARK_OBJECT_COUNT; i++) {
+            baseline_list.append(make_baseline(i));
+            dn_list.append(make_user_dn(i));
+        }
+        baseline_bytes = heap_used() - before;
+    }
+
+    size_t compact_bytes = 0;
+    {
+        QList<AdObject> object_list;
+        object_list.reserve(BENCHMARK_OBJECT_COUNT);
+
+        const size_t before = heap_used();
+        for (int i = 0; i < BENCHMARK_OBJECT_COUNT; i++) {
+            AdObject object;
+            object.load(make_user_dn(i), make_baseline(i));
+            object_list.append(object);
+        }
+        compact_bytes = heap_used() - before;
+    }
+
+    const double baseline_per_object = (double) baseline_bytes / BENCHMARK_OBJECT_COUNT;
+    const double compact_per_object = (double) compact_bytes / BENCHMARK_OBJECT_COUNT;
+
+    qInfo().noquote() << QString("Bytes per object: hash layout = %1, compact layout = %2").arg(baseline_per_object, 0, 'f', 0).arg(compact_per_object, 0, 'f', 0);
+
+    QVERIFY(compact_bytes < baseline_bytes);
+}
+
+void ADMCTestAdObject::get_string_benchmark() {
+    QList<AdObject> object_list;
+    for (int i = 0; i < BENCHMARK_OBJECT_COUNT; i++) {
+        AdObject object;
+        object.load(make_user_dn(i), make_user_data(i));
+        object_list.append(object);
+    }
+
+    QBENCHMARK {
+        for (const AdObject &object : object_list) {
+            const QString sam_account_name = object.get_string(ATTRIBUTE_SAM_ACCOUNT_NAME);
+            Q_UNUSED(sam_account_name);
+        }
+    }
+}
+
+void ADMCTestAdObject::attribute_table_range() {
+    AdAttributeTable *table = AdAttributeTable::instance();
+
+    const int id = table->intern(ATTRIBUTE_MEMBER);
+    const int size_before = table->size();
+
+    // Ranged names map to the attribute and don't grow the
+    // table
+    QCOMPARE(table->intern("member;range=0-1499"), id);
+    QCOMPARE(table->intern("member;Range=1500-*"), id);
+    QCOMPARE(table->find("member;range=3000-4499"), id);
+    QCOMPARE(table->size(), size_before);
+    QCOMPARE(table->name(id), QString(ATTRIBUTE_MEMBER));
+
+    QCOMPARE(table->find("ADMCTEST-never-interned;range=0-1499"), ATTRIBUTE_ID_NONE);
+}
+
+class InternThread final : public QThread {
+public:
+    QList<int> id_list;
+
+    void run() override {
+        for (int i = 0; i < 100; i++) {
+            id_list.append(AdAttributeTable::instance()->intern(QString("ADMCTEST-thread-%1").arg(i)));
+        }
+    }
+};
+
+// Names interned on one thread should be found on another,
+// which has it's own snapshot of the table
+void ADMCTestAdObject::attribute_table_threads() {
+    AdAttributeTable *table = AdAttributeTable::instance();
+
+    // Load snapshot of main thread before adding names
+    QCOMPARE(table->find("ADMCTEST-thread-0"), ATTRIBUTE_ID_NONE);
+
+    InternThread thread;
+    thread.start();
+    thread.wait();
+    const QList<int> &id_list = thread.id_list;
+
+    for (int i = 0; i < 100; i++) {
+        const QString name = QString("ADMCTEST-thread-%1").arg(i);
+
+        QCOMPARE(table->find(name), id_list[i]);
+        QCOMPARE(table->name(id_list[i]), name);
+        QCOMPARE(table->intern(name), id_list[i]);
+    }
+}
+
+QHash<QString, QList<QByteArray>> ADMCTestAdObject::make_user_data(const int index) const {
+    const QByteArray name = QString("user%1").arg(index).toUtf8();
+    const QByteArray guid = QByteArray(16, (char) (index % 256));
+    const QByteArray sid = QByteArray(28, (char) (index % 128));
+
+    const QHash<QString, QList<QByteArray>> out = {
+        {ATTRIBUTE_OBJECT_CLASS, {"top", "person", "organizationalPerson", CLASS_USER}},
+        {ATTRIBUTE_CN, {name}},
+        {ATTRIBUTE_NAME, {name}},
+        {ATTRIBUTE_SAM_ACCOUNT_NAME, {name}},
+        {ATTRIBUTE_USER_PRINCIPAL_NAME, {name + "@domain.alt"}},
+        {ATTRIBUTE_DISPLAY_NAME, {"User " + name}},
+        {ATTRIBUTE_DESCRIPTION, {"Synthetic user for benchmark"}},
+        {ATTRIBUTE_USER_ACCOUNT_CONTROL, {"512"}},
+        {ATTRIBUTE_OBJECT_GUID, {guid}},
+        {ATTRIBUTE_OBJECT_SID, {sid}},
+        {ATTRIBUTE_WHEN_CREATED, {"20240101000000.0Z"}},
+        {ATTRIBUTE_WHEN_CHANGED, {"20240101000000.0Z"}},
+        {ATTRIBUTE_MEMBER_OF, {"CN=Domain Users,CN=Users,DC=domain,DC=alt", "CN=Bench,OU=bench,DC=domain,DC=alt"}},
+    };
+
+    return out;
+}
+
+QString ADMCTestAdObject::make_user_dn(const int index) const {
+    return QString("CN=user%1,OU=bench,DC=domain,DC=alt").arg(index);
+}
+
+QTEST_MAIN(ADMCTestAdObject)
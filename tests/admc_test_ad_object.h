@@ -0,0 +1,49 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADMC_TEST_AD_OBJECT_H
+#define ADMC_TEST_AD_OBJECT_H
+
+/**
+ * Tests and benchmarks for AdObject storage. Uses
+ * synthetic objects, so unlike other tests this one
+ * doesn't need a domain to connect to.
+ */
+
+#include <QTest>
+
+#include "adldap.h"
+
+class ADMCTestAdObject : public QObject {
+    Q_OBJECT
+
+private slots:
+    void load();
+    void copy_shares_data();
+    void memory_per_object();
+    void get_string_benchmark();
+    void attribute_table_range();
+    void attribute_table_threads();
+
+private:
+    QHash<QString, QList<QByteArray>> make_user_data(const int index) const;
+    QString make_user_dn(const int index) const;
+};
+
+#endif /* ADMC_TEST_AD_OBJECT_H */
@@ -415,4 +415,22 @@ void ADMCTestAdSecurity::load_sd() {
     }();
 }
 
+void ADMCTestAdSecurity::trustee_names() {
+    const QByteArray user_sid = ad.search_object(test_user_dn).get_value(ATTRIBUTE_OBJECT_SID);
+    const QByteArray trustee_sid = ad.search_object(test_trustee_dn).get_value(ATTRIBUTE_OBJECT_SID);
+    const QByteArray everyone_sid = sid_string_to_bytes("S-1-1-0");
+    const QString unknown_sid_string = ad.adconfig()->domain_sid() + "-999999";
+    const QByteArray unknown_sid = sid_string_to_bytes(unknown_sid_string);
+
+    const QHash<QByteArray, QString> name_map = ad_security_get_trustee_names(ad, {user_sid, trustee_sid, everyone_sid, unknown_sid});
+    QCOMPARE(name_map.size(), 4);
+    QVERIFY(name_map[user_sid] != object_sid_display_value(user_sid));
+    QVERIFY(name_map[trustee_sid] != object_sid_display_value(trustee_sid));
+    QCOMPARE(name_map[everyone_sid], ad_security_get_well_known_trustee_name(everyone_sid));
+    QCOMPARE(name_map[unknown_sid], unknown_sid_string);
+
+    // Single lookup gives same name
+    QCOMPARE(ad_security_get_trustee_name(ad, user_sid), name_map[user_sid]);
+}
+
 QTEST_MAIN(ADMCTestAdSecurity)
@@ -56,6 +56,7 @@ private slots:
     void remove_to_unset_superior();
     void add_to_unset_opposite_superior_data();
     void add_to_unset_opposite_superior();
+    void trustee_names();
 
 private:
     QString test_user_dn;
@@ -0,0 +1,69 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "admc_test_ad_utils.h"
+
+#include "ad_utils.h"
+
+#include <memory>
+#include <vector>
+
+void ADMCTestAdUtils::cstring_data() {
+    QTest::addColumn<QString>("string");
+
+    const QString emoji = QString::fromUcs4(U"\U0001F600");
+
+    QTest::newRow("empty") << QString();
+    QTest::newRow("ascii") << "CN=test,DC=domain,DC=alt";
+    QTest::newRow("cyrillic") << QString::fromUtf8("CN=Пользователь,DC=domain,DC=alt");
+    QTest::newRow("surrogate pair") << QString("CN=%1").arg(emoji);
+    QTest::newRow("broken surrogate") << QString("CN=") + QChar(0xD800) + "x";
+    QTest::newRow("longer than buffer") << QString(AD_CSTRING_BUFFER_SIZE * 2, 'a');
+    QTest::newRow("non-ascii longer than buffer") << QString(AD_CSTRING_BUFFER_SIZE, QChar(0x0416));
+}
+
+// Result should be same as toUtf8(), whether string fits in
+// the inline buffer or not
+void ADMCTestAdUtils::cstring() {
+    QFETCH(QString, string);
+
+    const QByteArray expected = string.toUtf8();
+    const AdCString cstring(string);
+
+    QCOMPARE(cstring.size(), expected.size());
+    QCOMPARE(QByteArray(cstring.get(), cstring.size()), expected);
+    QCOMPARE(cstring.get()[cstring.size()], '\0');
+}
+
+// Every string owns it's data, so any amount of them can be
+// used at the same time
+void ADMCTestAdUtils::cstring_many_alive() {
+    const int count = 1000;
+
+    std::vector<std::unique_ptr<AdCString>> cstring_list;
+    for (int i = 0; i < count; i++) {
+        cstring_list.emplace_back(new AdCString(QString("CN=object-%1").arg(i)));
+    }
+
+    for (int i = 0; i < count; i++) {
+        QCOMPARE(QString(cstring_list[i]->get()), QString("CN=object-%1").arg(i));
+    }
+}
+
+QTEST_MAIN(ADMCTestAdUtils)
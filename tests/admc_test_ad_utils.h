@@ -0,0 +1,39 @@
+/*
+ * ADMC - AD Management Center
+ *
+ * Copyright (C) 2020-2024 BaseALT Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADMC_TEST_AD_UTILS_H
+#define ADMC_TEST_AD_UTILS_H
+
+/**
+ * Tests for adldap utilities that don't need a domain to
+ * connect to.
+ */
+
+#include <QTest>
+
+class ADMCTestAdUtils : public QObject {
+    Q_OBJECT
+
+private slots:
+    void cstring_data();
+    void cstring();
+    void cstring_many_alive();
+};
+
+#endif /* ADMC_TEST_AD_UTILS_H */